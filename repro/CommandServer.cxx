@@ -105,6 +105,10 @@ CommandServer::handleRequest(unsigned int connectionId, unsigned int requestId,
       {
          handleSetCongestionToleranceRequest(connectionId, requestId, xml);
       }
+      else if(isEqualNoCase(xml.getTag(), "SetLogLevel"))
+      {
+         handleSetLogLevelRequest(connectionId, requestId, xml);
+      }
       else if(isEqualNoCase(xml.getTag(), "Shutdown"))
       {
          handleShutdownRequest(connectionId, requestId, xml);
@@ -351,6 +355,53 @@ CommandServer::handleSetCongestionToleranceRequest(unsigned int connectionId, un
    }
 }
 
+void 
+CommandServer::handleSetLogLevelRequest(unsigned int connectionId, unsigned int requestId, XMLCursor& xml)
+{
+   InfoLog(<< "CommandServer::handleSetLogLevelRequest");
+
+   Data levelData;
+
+   // Check for Parameters
+   if(xml.firstChild())
+   {
+      if(isEqualNoCase(xml.getTag(), "request"))
+      {
+         if(xml.firstChild())
+         {
+            while(true)
+            {
+               if(isEqualNoCase(xml.getTag(), "level"))
+               {
+                  if(xml.firstChild())
+                  {
+                     levelData = xml.getValue();
+                     xml.parent();
+                  }
+               }
+               if(!xml.nextSibling())
+               {
+                  // break on no more sibilings
+                  break;
+               }
+            }
+            xml.parent();
+         }
+      }
+      xml.parent();
+   }
+
+   if(levelData.empty())
+   {
+      sendResponse(connectionId, requestId, Data::Empty, 400, "No level specified: must be NONE, CRIT, ERR, WARNING, INFO, DEBUG or STACK.");
+      return;
+   }
+
+   // takes effect in every thread on its next log statement
+   Log::setLevel(Log::toLevel(levelData));
+   sendResponse(connectionId, requestId, Data::Empty, 200, "Log level set to " + Log::toString(Log::level()) + ".");
+}
+
 void 
 CommandServer::handleShutdownRequest(unsigned int connectionId, unsigned int requestId, XMLCursor& xml)
 {
@@ -55,6 +55,7 @@ private:
    void handleGetDnsCacheRequest(unsigned int connectionId, unsigned int requestId, resip::XMLCursor& xml);
    void handleGetCongestionStatsRequest(unsigned int connectionId, unsigned int requestId, resip::XMLCursor& xml);
    void handleSetCongestionToleranceRequest(unsigned int connectionId, unsigned int requestId, resip::XMLCursor& xml);
+   void handleSetLogLevelRequest(unsigned int connectionId, unsigned int requestId, resip::XMLCursor& xml);
    void handleShutdownRequest(unsigned int connectionId, unsigned int requestId, resip::XMLCursor& xml);
    void handleGetProxyConfigRequest(unsigned int connectionId, unsigned int requestId, resip::XMLCursor& xml);
    void handleRestartRequest(unsigned int connectionId, unsigned int requestId, resip::XMLCursor& xml);
@@ -44,9 +44,11 @@
 
 #include "resip/dum/InMemorySyncRegDb.hxx"
 #include "resip/dum/InMemorySyncPubDb.hxx"
+#include "resip/dum/PersistentSyncPubDb.hxx"
 #include "resip/dum/MasterProfile.hxx"
 #include "resip/dum/DialogUsageManager.hxx"
 #include "resip/dum/DumThread.hxx"
+#include "resip/dum/NotifyFanout.hxx"
 #include "resip/dum/TlsPeerAuthManager.hxx"
 #include "resip/dum/WsCookieAuthManager.hxx"
 
@@ -91,6 +93,7 @@
 #if defined(USE_SSL)
 #include "repro/stateAgents/CertServer.hxx"
 #include "resip/stack/ssl/Security.hxx"
+#include "resip/stack/ssl/TlsBaseTransport.hxx"
 #define DEFAULT_TLS_METHOD SecurityTypes::SSLv23
 #endif
 
@@ -331,6 +334,12 @@ ReproRunner::run(int argc, char** argv)
                    mProxyConfig->getConfigData("LogFilename", "repro.log", true).c_str(),
                    isEqualNoCase(loggingType, "file") ? &g_ReproLogger : 0, // if logging to file then write WARNINGS, and Errors to console still
                    syslogFacilityName);
+   if(mProxyConfig->getConfigBool("AsyncLogging", false))
+   {
+      Data overflow = mProxyConfig->getConfigData("AsyncLoggingOverflow", "drop", true);
+      Log::enableAsync(isEqualNoCase(overflow, "block") ? Log::BlockOnOverflow : Log::DropOnOverflow,
+                       mProxyConfig->getConfigUnsignedLong("AsyncLoggingBufferSize", 262144));
+   }
 
    InfoLog( << "Starting repro version " << VersionUtils::instance().releaseVersion() << "...");
 
@@ -511,6 +520,8 @@ ReproRunner::shutdown()
    mSipStack->setCongestionManager(0);
 
    cleanupObjects();
+   // write out anything still queued; run() enables it again on restart
+   Log::disableAsync();
    mRunning = false;
 }
 
@@ -709,6 +720,12 @@ ReproRunner::createSipStack()
          "OpenSSLCTXSetOptions", BaseSecurity::OpenSSLCTXSetOptions);
    setOpenSSLCTXOptionsFromConfig(
          "OpenSSLCTXClearOptions", BaseSecurity::OpenSSLCTXClearOptions);
+   BaseSecurity::TlsSessionCacheSize = mProxyConfig->getConfigUnsignedLong("TlsSessionCacheSize", BaseSecurity::TlsSessionCacheSize);
+   BaseSecurity::TlsSessionLifetime = mProxyConfig->getConfigUnsignedLong("TlsSessionLifetime", BaseSecurity::TlsSessionLifetime);
+   BaseSecurity::TlsTicketKeyRotation = mProxyConfig->getConfigUnsignedLong("TlsTicketKeyRotation", BaseSecurity::TlsTicketKeyRotation);
+   TlsBaseTransport::MaxClientSessions = mProxyConfig->getConfigUnsignedLong("TlsClientSessionCacheSize", TlsBaseTransport::MaxClientSessions);
+   TlsBaseTransport::HandshakeThreads = mProxyConfig->getConfigUnsignedLong("TlsHandshakeThreads", TlsBaseTransport::HandshakeThreads);
+   TlsBaseTransport::MaxQueuedHandshakes = mProxyConfig->getConfigUnsignedLong("TlsMaxQueuedHandshakes", TlsBaseTransport::MaxQueuedHandshakes);
    Security::CipherList cipherList = Security::StrongestSuite;
    Data ciphers = mProxyConfig->getConfigData("OpenSSLCipherList", Data::Empty);
    if(!ciphers.empty())
@@ -805,6 +822,12 @@ ReproRunner::createSipStack()
       mSipStack->setEnumDomains(enumDomains);
    }
 
+   // DNS cache memory bound, serve-stale and prefetch
+   mSipStack->getDnsStub().setDnsCacheMaxBytes(mProxyConfig->getConfigUnsignedLong("DNSCacheMaxBytes", 0));
+   mSipStack->getDnsStub().setDnsCacheServeStale(mProxyConfig->getConfigInt("DNSServeStaleSeconds", 0));
+   mSipStack->getDnsStub().setDnsCachePrefetch(mProxyConfig->getConfigInt("DNSPrefetchWindow", 0),
+                                               mProxyConfig->getConfigUnsignedLong("DNSPrefetchMinHits", 10));
+
    // Add External Stats handler
    mSipStack->setExternalStatsHandler(this);
 
@@ -1023,9 +1046,25 @@ ReproRunner::createDatastore()
    if(!mRestarting)  // If we are restarting then we left the InMemorySyncRegDb and InMemorySyncPubDb intact at restart - don't recreate
    {
       resip_assert(!mRegistrationPersistenceManager);
-      mRegistrationPersistenceManager = new InMemorySyncRegDb(mRegSyncPort ? 86400 /* 24 hours */ : 0 /* removeLingerSecs */);  // !slg! could make linger time a setting
+      InMemorySyncRegDb* regDb = new InMemorySyncRegDb(mRegSyncPort ? 86400 /* 24 hours */ : 0 /* removeLingerSecs */);  // !slg! could make linger time a setting
+      unsigned long purgeInterval = mProxyConfig->getConfigUnsignedLong("RegistrationPurgeIntervalMs", 1000);
+      if(purgeInterval > 0)
+      {
+         regDb->startExpirySweeper(purgeInterval, mProxyConfig->getConfigUnsignedLong("RegistrationPurgeBatchSize", 1000));
+      }
+      mRegistrationPersistenceManager = regDb;
       resip_assert(!mPublicationPersistenceManager);
-      mPublicationPersistenceManager = new InMemorySyncPubDb((mRegSyncPort && mProxyConfig->getConfigBool("EnablePublicationReplication", false)) ? true : false);
+      bool pubSync = (mRegSyncPort && mProxyConfig->getConfigBool("EnablePublicationReplication", false)) ? true : false;
+      Data pubDbFile = mProxyConfig->getConfigData("PublicationDatabaseFile", "");
+      if(!pubDbFile.empty())
+      {
+         mPublicationPersistenceManager = new PersistentSyncPubDb(pubDbFile, pubSync, 0 /* default shards */,
+            mProxyConfig->getConfigUnsignedLong("PublicationDatabaseFlushIntervalMs", PersistentSyncPubDb::DefaultFlushIntervalMs));
+      }
+      else
+      {
+         mPublicationPersistenceManager = new InMemorySyncPubDb(pubSync);
+      }
    }
    resip_assert(mRegistrationPersistenceManager);
    resip_assert(mPublicationPersistenceManager);
@@ -1142,6 +1181,10 @@ ReproRunner::createDialogUsageManager()
                                            mProxyConfig->getConfigBool("PresenceUsesRegistrationState", true),
                                            mProxyConfig->getConfigBool("PresenceNotifyClosedStateForNonPublishedUsers", true));
 
+      // Pace the NOTIFYs that go out to the watchers of a published document
+      mDum->getNotifyFanout().setBatchSize(mProxyConfig->getConfigUnsignedLong("PresenceNotifyBatchSize", NotifyFanout::DefaultBatchSize));
+      mDum->getNotifyFanout().setMinInterval(mProxyConfig->getConfigUnsignedLong("PresenceNotifyMinIntervalMs", 0));
+
       // Install rules so that the cert server receives SUBSCRIBEs and PUBLISHs
       MessageFilterRule::MethodList methodList;
       MessageFilterRule::EventList eventList;
@@ -2065,20 +2065,15 @@ WebAdmin::buildRestartSubPage(DataStream& s)
       // since the webadmin thread and server is destroyed on the blocking ReproRunner::restart call
       int sd = 0, rc;
       struct sockaddr_in localAddr, servAddr;
-      struct hostent *h;
-      const char* host = "127.0.0.1";
-      h = gethostbyname(host);
-      if(h!=0) 
+      memset(&servAddr, 0, sizeof(servAddr));
+      // the command server is local - no need to go through the resolver
+      if(DnsUtil::inet_pton("127.0.0.1", servAddr.sin_addr) > 0) 
       {
-         servAddr.sin_family = h->h_addrtype;
-         if(h->h_length <= (int)sizeof(servAddr.sin_addr.s_addr))
-         {
-            memcpy((char *) &servAddr.sin_addr.s_addr, h->h_addr_list[0], h->h_length);
-            servAddr.sin_port = htons(port);
-  
-            // Create TCP Socket
-            sd = (int)socket(AF_INET, SOCK_STREAM, 0);
-         }
+         servAddr.sin_family = AF_INET;
+         servAddr.sin_port = htons(port);
+
+         // Create TCP Socket
+         sd = (int)socket(AF_INET, SOCK_STREAM, 0);
          if(sd > 0) 
          {
             // bind to any local interface/port
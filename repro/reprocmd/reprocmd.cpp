@@ -48,6 +48,7 @@ main (int argc, char** argv)
       cerr << "  /GetCongestionStats - retrieves the stacks congestion manager stats and state" << endl;
       cerr << "  /SetCongestionTolerance metric=<SIZE|WAIT_TIME|TIME_DEPTH> maxTolerance=<value>" << endl;
       cerr << "                          [fifoDescription=<desc>] - sets congestion tolerances" << endl;
+      cerr << "  /SetLogLevel level=<NONE|CRIT|ERR|WARNING|INFO|DEBUG|STACK> - sets the proxy's logging level" << endl;
       cerr << "  /Shutdown - signal the proxy to shut down." << endl;
       cerr << "  /Restart - signal the proxy to restart - leaving active registrations in place." << endl;
       cerr << "  /GetProxyConfig - retrieves the all of configuration file settings currently" << endl;
@@ -4,6 +4,7 @@
 #include "resip/stack/Dispatcher.hxx"
 
 #include <resip/dum/DialogUsageManager.hxx>
+#include <resip/dum/NotifyFanout.hxx>
 #include <resip/dum/PublicationPersistenceManager.hxx>
 #include <resip/dum/RegistrationPersistenceManager.hxx>
 #include <resip/dum/ServerPublication.hxx>
@@ -507,6 +508,39 @@ private:
 void
 PresenceSubscriptionHandler::notifySubscriptions(const Data& documentKey)
 {
+   std::vector<ServerSubscriptionHandle> watchers;
+   mDum.getServerSubscriptions(Symbols::Presence, documentKey, watchers);
+   if (watchers.empty())
+   {
+      return;
+   }
+
+   // Every watcher of a published document gets the same merged document, so 
+   // merge it once and leave the NOTIFYs to the DUM's NotifyFanout
+   try
+   {
+      bool online = true;
+      if (mPresenceUsesRegistrationState)
+      {
+         Uri aor("sip:" + documentKey);
+         online = mRegistrationDb->aorIsRegistered(aor);
+         if (online)
+         {
+            mOnlineAors.insert(aor);
+         }
+      }
+      GenericPidfContents pidf;
+      if (online && mPublicationDb->getMergedETags(Symbols::Presence, documentKey, *this, &pidf))
+      {
+         mDum.getNotifyFanout().notify(Symbols::Presence, documentKey, &pidf);
+         return;
+      }
+   }
+   catch (BaseException& ex)
+   {
+      ErrLog(<< "PresenceSubscriptionHandler::notifySubscriptions: problem creating aor for registration lookup: " << ex);
+   }
+
    PresenceServerSubscriptionFunctor functor(*this);
    mDum.applyToServerSubscriptions<PresenceServerSubscriptionFunctor>(documentKey, Symbols::Presence, functor);
 }
@@ -39,6 +39,7 @@
 #include "resip/dum/KeepAliveManager.hxx"
 #include "resip/dum/KeepAliveTimeout.hxx"
 #include "resip/dum/MasterProfile.hxx"
+#include "resip/dum/NotifyFanout.hxx"
 #include "resip/dum/OutOfDialogReqCreator.hxx"
 #include "resip/dum/PagerMessageCreator.hxx"
 #include "resip/dum/PublicationCreator.hxx"
@@ -115,7 +116,10 @@ DialogUsageManager::DialogUsageManager(SipStack& stack, bool createDefaultFeatur
    mDumShutdownHandler(0),
    mShutdownState(Running),
    mThreadDebugKey(0),
-   mHiddenThreadDebugKey(0)
+   mHiddenThreadDebugKey(0),
+   mPartitionIndex(0),
+   mPartitionCount(1),
+   mNotifyFanout(new NotifyFanout(*this))
 {
    //TODO -- create default features
    mStack.registerTransactionUser(*this);
@@ -195,6 +199,8 @@ DialogUsageManager::~DialogUsageManager()
       delete it->second;
    }
 
+   delete mNotifyFanout;
+
    //InfoLog ( << "~DialogUsageManager done" );
 }
 
@@ -205,6 +211,67 @@ DialogUsageManager::name() const
    return n;
 }
 
+bool
+DialogUsageManager::isForMe(const SipMessage& msg) const
+{
+   if (mPartitionCount > 1 && partitionOf(msg, mPartitionCount) != mPartitionIndex)
+   {
+      return false;
+   }
+   return TransactionUser::isForMe(msg);
+}
+
+void
+DialogUsageManager::setPartition(unsigned int index, unsigned int count)
+{
+   resip_assert(count > 0 && index < count);
+   mPartitionIndex = index;
+   mPartitionCount = count;
+}
+
+unsigned int
+DialogUsageManager::partitionOf(const SipMessage& msg, unsigned int count)
+{
+   if (count <= 1)
+   {
+      return 0;
+   }
+   try
+   {
+      if (msg.isRequest() && msg.method() == PUBLISH)
+      {
+         return (unsigned int)(msg.const_header(h_RequestLine).uri().getAor().hash() % count);
+      }
+      if (msg.exists(h_CallId) && msg.const_header(h_CallId).isWellFormed())
+      {
+         return partitionOf(msg.const_header(h_CallId).value(), count);
+      }
+   }
+   catch (BaseException&)
+   {
+   }
+   // Malformed messages are rejected by whichever DUM gets them.
+   return 0;
+}
+
+unsigned int
+DialogUsageManager::partitionOf(const Data& callId, unsigned int count)
+{
+   return count > 1 ? (unsigned int)(callId.hash() % count) : 0;
+}
+
+Data
+DialogUsageManager::computeCallId() const
+{
+   // Call-IDs are random, so about mPartitionCount tries find one.
+   Data callId = Helper::computeCallId();
+   while (partitionOf(callId, mPartitionCount) != mPartitionIndex)
+   {
+      callId = Helper::computeCallId();
+   }
+   return callId;
+}
+
 void
 DialogUsageManager::addTransport( TransportType protocol,
                                   int port,
@@ -2483,13 +2550,77 @@ DialogUsageManager::applyToAllClientSubscriptions(ClientSubscriptionFunctor* fun
 void 
 DialogUsageManager::endAllServerSubscriptions(TerminateReason reason)
 {
-   // Make a copy of the map - since calling end can cause an immediate delete this on the subscription and thus cause
+   // Collect handles first - since calling end can cause an immediate delete this on the subscription and thus cause
    // the object to remove itself from the mServerSubscriptions map, messing up our iterator
-   ServerSubscriptions tempSubscriptions = mServerSubscriptions;
-   ServerSubscriptions::iterator it = tempSubscriptions.begin();
-   for (; it != tempSubscriptions.end(); it++)
+   std::vector<ServerSubscriptionHandle> handles;
+   for (ServerSubscriptions::const_iterator e = mServerSubscriptions.begin(); e != mServerSubscriptions.end(); ++e)
    {
-      it->second->end(reason);
+      for (ServerSubscriptionsByKey::const_iterator k = e->second.begin(); k != e->second.end(); ++k)
+      {
+         for (ServerSubscriptionList::const_iterator i = k->second.begin(); i != k->second.end(); ++i)
+         {
+            handles.push_back((*i)->getHandle());
+         }
+      }
+   }
+   for (std::vector<ServerSubscriptionHandle>::iterator it = handles.begin(); it != handles.end(); ++it)
+   {
+      if (it->isValid())
+      {
+         (*it)->end(reason);
+      }
+   }
+}
+
+void
+DialogUsageManager::addServerSubscription(ServerSubscription* sub)
+{
+   ServerSubscriptionList& subs = mServerSubscriptions[sub->getEventType()][sub->getDocumentKey()];
+   sub->mIndexPosition = subs.insert(subs.end(), sub);
+}
+
+void
+DialogUsageManager::removeServerSubscription(ServerSubscription* sub)
+{
+   ServerSubscriptions::iterator e = mServerSubscriptions.find(sub->getEventType());
+   resip_assert(e != mServerSubscriptions.end());
+   ServerSubscriptionsByKey::iterator k = e->second.find(sub->getDocumentKey());
+   resip_assert(k != e->second.end());
+   k->second.erase(sub->mIndexPosition);
+   if (k->second.empty())
+   {
+      e->second.erase(k);
+      if (e->second.empty())
+      {
+         mServerSubscriptions.erase(e);
+      }
+   }
+}
+
+const DialogUsageManager::ServerSubscriptionList*
+DialogUsageManager::findServerSubscriptionList(const Data& eventType, const Data& documentKey) const
+{
+   ServerSubscriptions::const_iterator e = mServerSubscriptions.find(eventType);
+   if (e == mServerSubscriptions.end())
+   {
+      return 0;
+   }
+   ServerSubscriptionsByKey::const_iterator k = e->second.find(documentKey);
+   return k == e->second.end() ? 0 : &k->second;
+}
+
+void
+DialogUsageManager::getServerSubscriptions(const Data& eventType, const Data& documentKey,
+                                           std::vector<ServerSubscriptionHandle>& handles) const
+{
+   const ServerSubscriptionList* subs = findServerSubscriptionList(eventType, documentKey);
+   if (subs)
+   {
+      handles.reserve(handles.size() + subs->size());
+      for (ServerSubscriptionList::const_iterator i = subs->begin(); i != subs->end(); ++i)
+      {
+         handles.push_back((*i)->getHandle());
+      }
    }
 }
 
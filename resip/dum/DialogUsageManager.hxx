@@ -1,6 +1,7 @@
 #if !defined(RESIP_DIALOGUSAGEMANAGER_HXX)
 #define RESIP_DIALOGUSAGEMANAGER_HXX
 
+#include <list>
 #include <vector>
 #include <set>
 #include <map>
@@ -17,6 +18,7 @@
 #include "resip/dum/PublicationPersistenceManager.hxx"
 #include "resip/dum/ServerSubscription.hxx"
 #include "rutil/BaseException.hxx"
+#include "rutil/HashMap.hxx"
 #include "rutil/SharedPtr.hxx"
 #include "rutil/ThreadIf.hxx"
 #include "resip/stack/SipStack.hxx"
@@ -75,6 +77,8 @@ class ExternalMessageHandler;
 class DialogEventStateManager;
 class DialogEventHandler;
 
+class NotifyFanout;
+
 class DialogUsageManager : public HandleManager, public TransactionUser
 {
    public:
@@ -314,18 +318,27 @@ class DialogUsageManager : public HandleManager, public TransactionUser
                                                const Data& eventType, 
                                                UnaryFunction applyFn)
       {
-         Data key = eventType + aor;
-         std::pair<ServerSubscriptions::iterator,ServerSubscriptions::iterator> 
-            range = mServerSubscriptions.equal_range(key);
-         
-         for (ServerSubscriptions::iterator i=range.first; i!=range.second; ++i)
+         // applyFn may end subscriptions, so work from handles
+         std::vector<ServerSubscriptionHandle> handles;
+         getServerSubscriptions(eventType, aor, handles);
+         for (std::vector<ServerSubscriptionHandle>::iterator i = handles.begin(); i != handles.end(); ++i)
          {
-            ServerSubscriptionHandle h = i->second->getHandle();
-            applyFn(h);
+            if (i->isValid())
+            {
+               applyFn(*i);
+            }
          }
          return applyFn;         
       }
 
+      /// Appends handles to every ServerSubscription to eventType for 
+      /// documentKey (the subscribed AOR), in the order they were created.
+      void getServerSubscriptions(const Data& eventType, const Data& documentKey,
+                                  std::vector<ServerSubscriptionHandle>& handles) const;
+
+      /// Sends event document changes to many watchers; see NotifyFanout.
+      NotifyFanout& getNotifyFanout() { return *mNotifyFanout; }
+
       //DUM will delete features in its destructor. Feature manipulation should
       //be done before any processing starts.
       //ServerAuthManager is now a DumFeature; setServerAuthManager is a special
@@ -363,10 +376,29 @@ class DialogUsageManager : public HandleManager, public TransactionUser
 
       void setAdvertisedCapabilities(SipMessage& msg, SharedPtr<UserProfile> userProfile);
 
+      // Makes this DUM partition index of count DUMs sharing one SipStack,
+      // each running on its own thread (see DumPartitions). This DUM then
+      // only takes the SIP messages that partitionOf() maps to index, and
+      // starts its dialogs with Call-IDs that map back to it. Must be called
+      // before the stack delivers any messages.
+      void setPartition(unsigned int index, unsigned int count);
+      unsigned int getPartitionIndex() const { return mPartitionIndex; }
+      unsigned int getPartitionCount() const { return mPartitionCount; }
+
+      // Which of count partitions handles msg: by Call-ID, so a dialog set
+      // stays where it began, except PUBLISH which goes by resource so that
+      // refreshes find their ETag.
+      static unsigned int partitionOf(const SipMessage& msg, unsigned int count);
+      static unsigned int partitionOf(const Data& callId, unsigned int count);
+
+      // A new Call-ID, one that partitionOf() maps to this DUM.
+      Data computeCallId() const;
+
    protected:
       virtual void onAllHandlesDestroyed();      
       //TransactionUser virtuals
       virtual const Data& name() const;
+      virtual bool isForMe(const SipMessage& msg) const;
       friend class DumThread;
 
       DumFeatureChain::FeatureList mIncomingFeatureList;
@@ -400,6 +432,7 @@ class DialogUsageManager : public HandleManager, public TransactionUser
       friend class NetworkAssociation;
 
       friend class MergedRequestRemovalCommand;
+      friend class NotifyFanout;
       friend class TargetCommand::Target;
 
       class IncomingTarget : public TargetCommand::Target
@@ -555,10 +588,15 @@ class DialogUsageManager : public HandleManager, public TransactionUser
       ServerPublications mServerPublications;
       typedef std::map<Data, SipMessage*> RequiresCerts;
       RequiresCerts mRequiresCerts;      
-      // from Event-Type+document-aor -> ServerSubscription
+      // from Event-Type, then document-aor -> ServerSubscriptions
       // Managed by ServerSubscription
-      typedef std::multimap<Data, ServerSubscription*> ServerSubscriptions;
+      typedef std::list<ServerSubscription*> ServerSubscriptionList;
+      typedef HashMap<Data, ServerSubscriptionList> ServerSubscriptionsByKey;
+      typedef std::map<Data, ServerSubscriptionsByKey> ServerSubscriptions;
       ServerSubscriptions mServerSubscriptions;
+      void addServerSubscription(ServerSubscription* sub);
+      void removeServerSubscription(ServerSubscription* sub);
+      const ServerSubscriptionList* findServerSubscriptionList(const Data& eventType, const Data& documentKey) const;
 
       IncomingTarget* mIncomingTarget;
       OutgoingTarget* mOutgoingTarget;
@@ -566,6 +604,11 @@ class DialogUsageManager : public HandleManager, public TransactionUser
       ThreadIf::TlsKey mHiddenThreadDebugKey;
 
       EventDispatcher<ConnectionTerminated> mConnectionTerminatedEventDispatcher;
+
+      unsigned int mPartitionIndex;
+      unsigned int mPartitionCount;
+
+      NotifyFanout* mNotifyFanout;
 };
 
 }
@@ -1,25 +1,88 @@
-#if !defined(PARAMETERHASH_HXX)
-#define PARAMETERHASH_HXX
+#include "resip/dum/DumPartitions.hxx"
+#include "resip/dum/DumThread.hxx"
+#include "rutil/Logger.hxx"
+#include "rutil/WinLeakCheck.hxx"
 
-#include "rutil/compat.hxx"
+#define RESIPROCATE_SUBSYSTEM Subsystem::DUM
 
-namespace resip 
+using namespace resip;
+
+DumPartitions::DumPartitions(const std::vector<DialogUsageManager*>& dums)
+   : mDums(dums)
+{
+   resip_assert(!mDums.empty());
+   for (unsigned int i = 0; i < mDums.size(); ++i)
+   {
+      mDums[i]->setPartition(i, size());
+   }
+   InfoLog(<< "DUM partitioned " << size() << " ways");
+}
+
+DumPartitions::~DumPartitions()
+{
+   shutdown();
+   join();
+}
+
+DialogUsageManager&
+DumPartitions::partitionFor(const SipMessage& msg)
+{
+   return *mDums[DialogUsageManager::partitionOf(msg, size())];
+}
+
+DialogUsageManager&
+DumPartitions::partitionFor(const Data& callId)
 {
-struct params { char *name; ParameterTypes::Type type; };
-/* maximum key range = 494, duplicates = 0 */
+   return *mDums[DialogUsageManager::partitionOf(callId, size())];
+}
+
+DialogUsageManager&
+DumPartitions::partitionFor(const CallId& callId)
+{
+   return partitionFor(callId.value());
+}
+
+void
+DumPartitions::run()
+{
+   resip_assert(mThreads.empty());
+   for (std::vector<DialogUsageManager*>::iterator it = mDums.begin(); it != mDums.end(); ++it)
+   {
+      DumThread* thread = new DumThread(**it);
+      thread->run();
+      mThreads.push_back(thread);
+   }
+}
+
+void
+DumPartitions::shutdown()
+{
+   for (std::vector<DumThread*>::iterator it = mThreads.begin(); it != mThreads.end(); ++it)
+   {
+      (*it)->shutdown();
+   }
+}
+
+void
+DumPartitions::join()
+{
+   for (std::vector<DumThread*>::iterator it = mThreads.begin(); it != mThreads.end(); ++it)
+   {
+      (*it)->join();
+      delete *it;
+   }
+   mThreads.clear();
+}
 
-class ParameterHash
+void
+DumPartitions::postToAll(const DumCommand& cmd)
 {
-private:
-  static inline unsigned int hash (const char *str, GPERF_SIZE_TYPE len);
-public:
-  static const struct params *in_word_set (const char *str, GPERF_SIZE_TYPE len);
-};
-// NOTE the cxx file for this class is AUTO GENERATED. DO NOT EDIT IT.
-// This file should match it. BUT THIS FILE IS MANUALLY GENERATED.
+   for (std::vector<DialogUsageManager*>::iterator it = mDums.begin(); it != mDums.end(); ++it)
+   {
+      (*it)->post(cmd.clone());
+   }
 }
 
-#endif
 /* ====================================================================
  * The Vovida Software License, Version 1.0 
  * 
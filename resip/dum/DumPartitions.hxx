@@ -0,0 +1,155 @@
+#ifndef RESIP_DumPartitions__hxx
+#define RESIP_DumPartitions__hxx
+
+#include <vector>
+
+#include "resip/dum/DialogUsageManager.hxx"
+#include "resip/dum/DumCommand.hxx"
+
+namespace resip
+{
+
+class DumThread;
+
+/**
+   Runs several DialogUsageManagers on one SipStack, each on its own
+   DumThread, so that DUM processing is no longer limited to one core.
+
+   Each DUM is a partition that owns a disjoint set of dialog sets: the
+   stack hands it the messages whose Call-ID (or, for PUBLISH, resource)
+   hashes to it, see DialogUsageManager::partitionOf(). A dialog, with
+   its timers and the commands posted to it, is only ever touched on its
+   partition's thread, so DUM itself needs no locking. The application
+   builds the DUMs on the same SipStack and gives each the same handlers
+   and profiles; the handlers are then called on several threads at once.
+
+   Work that spans partitions is marshalled with posted commands. To act
+   on the dialog named by a Replaces or Join header, post a DumCommand to
+   partitionFor(header); applyToServerSubscriptions() runs on each
+   partition's subscriptions to a resource.
+*/
+class DumPartitions
+{
+   public:
+      /// dums[i] becomes partition i of dums.size(); construct this before
+      /// the SipStack starts delivering messages. The DUMs are not owned.
+      explicit DumPartitions(const std::vector<DialogUsageManager*>& dums);
+      ~DumPartitions();
+
+      unsigned int size() const { return (unsigned int)mDums.size(); }
+      DialogUsageManager& operator[](unsigned int index) { return *mDums[index]; }
+
+      DialogUsageManager& partitionFor(const SipMessage& msg);
+      /// The partition of the dialog set with this Call-ID, eg. that of a
+      /// Replaces or Join header.
+      DialogUsageManager& partitionFor(const Data& callId);
+      DialogUsageManager& partitionFor(const CallId& callId);
+
+      /// Starts a DumThread for each partition.
+      void run();
+      void shutdown();
+      void join();
+
+      /// Posts a copy of cmd, made with clone(), to every partition.
+      void postToAll(const DumCommand& cmd);
+
+      /// Calls applyFn on every ServerSubscription to aor for eventType,
+      /// each on the thread of the partition that owns it. Returns
+      /// before the functor has run.
+      template<typename UnaryFunction>
+      void applyToServerSubscriptions(const Data& aor, const Data& eventType, const UnaryFunction& applyFn)
+      {
+         for (std::vector<DialogUsageManager*>::iterator it = mDums.begin(); it != mDums.end(); ++it)
+         {
+            (*it)->post(new ApplyToServerSubscriptionsCommand<UnaryFunction>(**it, aor, eventType, applyFn));
+         }
+      }
+
+   private:
+      template<typename UnaryFunction>
+      class ApplyToServerSubscriptionsCommand : public DumCommandAdapter
+      {
+         public:
+            ApplyToServerSubscriptionsCommand(DialogUsageManager& dum, const Data& aor,
+                                              const Data& eventType, const UnaryFunction& applyFn)
+               : mDum(dum), mAor(aor), mEventType(eventType), mApplyFn(applyFn)
+            {}
+
+            virtual void executeCommand()
+            {
+               mDum.applyToServerSubscriptions(mAor, mEventType, mApplyFn);
+            }
+
+            virtual EncodeStream& encodeBrief(EncodeStream& strm) const
+            {
+               return strm << "ApplyToServerSubscriptionsCommand " << mEventType << " " << mAor;
+            }
+
+         private:
+            DialogUsageManager& mDum;
+            Data mAor;
+            Data mEventType;
+            UnaryFunction mApplyFn;
+      };
+
+      std::vector<DialogUsageManager*> mDums;
+      std::vector<DumThread*> mThreads;
+
+      // no value semantics
+      DumPartitions(const DumPartitions&);
+      DumPartitions& operator=(const DumPartitions&);
+};
+
+}
+
+#endif
+
+/* ====================================================================
+ * The Vovida Software License, Version 1.0 
+ * 
+ * Copyright (c) 2000 Vovida Networks, Inc.  All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 
+ * 3. The names "VOCAL", "Vovida Open Communication Application Library",
+ *    and "Vovida Open Communication Application Library (VOCAL)" must
+ *    not be used to endorse or promote products derived from this
+ *    software without prior written permission. For written
+ *    permission, please contact vocal@vovida.org.
+ *
+ * 4. Products derived from this software may not be called "VOCAL", nor
+ *    may "VOCAL" appear in their name, without prior written
+ *    permission of Vovida Networks, Inc.
+ * 
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESSED OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE, TITLE AND
+ * NON-INFRINGEMENT ARE DISCLAIMED.  IN NO EVENT SHALL VOVIDA
+ * NETWORKS, INC. OR ITS CONTRIBUTORS BE LIABLE FOR ANY DIRECT DAMAGES
+ * IN EXCESS OF $1,000, NOR FOR ANY INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE
+ * USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+ * DAMAGE.
+ * 
+ * ====================================================================
+ * 
+ * This software consists of voluntary contributions made by Vovida
+ * Networks, Inc. and many individuals on behalf of Vovida Networks,
+ * Inc.  For more information on Vovida Networks, Inc., please see
+ * <http://www.vovida.org/>.
+ *
+ */
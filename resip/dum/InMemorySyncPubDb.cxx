@@ -8,12 +8,28 @@ using namespace resip;
 
 #define RESIPROCATE_SUBSYSTEM Subsystem::DUM
 
-InMemorySyncPubDb::InMemorySyncPubDb(bool syncEnabled) : mSyncEnabled(syncEnabled)
+InMemorySyncPubDb::InMemorySyncPubDb(bool syncEnabled, unsigned int numShards) : mSyncEnabled(syncEnabled)
 {
+   mShards.resize(numShards ? numShards : DefaultShards);
+   for(std::vector<Shard*>::iterator it = mShards.begin(); it != mShards.end(); it++)
+   {
+      *it = new Shard;
+   }
 }
 
 InMemorySyncPubDb::~InMemorySyncPubDb()
 {
+   for(std::vector<Shard*>::iterator it = mShards.begin(); it != mShards.end(); it++)
+   {
+      delete *it;
+   }
+}
+
+InMemorySyncPubDb::Shard&
+InMemorySyncPubDb::shardFor(const Data& mapKey) const
+{
+   size_t hash = mapKey.hash();
+   return *mShards[(hash ^ (hash >> 16)) % mShards.size()];
 }
 
 void 
@@ -56,6 +72,7 @@ InMemorySyncPubDb::shouldEraseDocument(PubDocument& document, UInt64 now)
          // Tag document to linger
          document.mLastUpdated = document.mExpirationTime;
          document.mExpirationTime = 0;
+         onDocumentRefreshed(document);
       }
    }
    else
@@ -71,48 +88,55 @@ InMemorySyncPubDb::shouldEraseDocument(PubDocument& document, UInt64 now)
 void
 InMemorySyncPubDb::initialSync(unsigned int connectionId)
 {
-   Lock g(mDatabaseMutex);
    UInt64 now = Timer::getTimeSecs();
 
-   // Iterate through keys
-   KeyToETagMap::iterator keyIt = mPublicationDb.begin();
-   for (; keyIt != mPublicationDb.end(); )
+   for (std::vector<Shard*>::iterator shardIt = mShards.begin(); shardIt != mShards.end(); shardIt++)
    {
-      // Iterator through documents in sub-map
-      ETagToDocumentMap::iterator eTagIt = keyIt->second.begin();
-      for (; eTagIt != keyIt->second.end();)
+      Lock g((*shardIt)->mMutex);
+      KeyToETagMap& documents = (*shardIt)->mDocuments;
+
+      // Iterate through keys
+      KeyToETagMap::iterator keyIt = documents.begin();
+      for (; keyIt != documents.end(); )
       {
-         if (shouldEraseDocument(eTagIt->second, now))
+         // Iterator through documents in sub-map
+         ETagToDocumentMap::iterator eTagIt = keyIt->second.begin();
+         for (; eTagIt != keyIt->second.end();)
          {
-            keyIt->second.erase(eTagIt++);
+            if (shouldEraseDocument(eTagIt->second, now))
+            {
+               onDocumentErased(eTagIt->second.mEventType, eTagIt->second.mDocumentKey, eTagIt->second.mETag);
+               keyIt->second.erase(eTagIt++);
+            }
+            else
+            {
+               invokeOnInitialSyncDocument(connectionId, eTagIt->second.mEventType, eTagIt->second.mDocumentKey, eTagIt->second.mETag, eTagIt->second.mExpirationTime, eTagIt->second.mLastUpdated, eTagIt->second.mContents.get(), eTagIt->second.mSecurityAttributes.get());
+               eTagIt++;
+            }
+         }
+
+         // If there are no more eTags then remove entity
+         if (keyIt->second.size() == 0)
+         {
+            documents.erase(keyIt++);
          }
          else
          {
-            invokeOnInitialSyncDocument(connectionId, eTagIt->second.mEventType, eTagIt->second.mDocumentKey, eTagIt->second.mETag, eTagIt->second.mExpirationTime, eTagIt->second.mLastUpdated, eTagIt->second.mContents.get(), eTagIt->second.mSecurityAttributes.get());
-            eTagIt++;
+            keyIt++;
          }
       }
-
-      // If there are no more eTags then remove entity
-      if (keyIt->second.size() == 0)
-      {
-         mPublicationDb.erase(keyIt++);
-      }
-      else
-      {
-         keyIt++;
-      }
    }
 }
 
 void 
 InMemorySyncPubDb::addUpdateDocument(const PubDocument& document)
 {
-   Lock g(mDatabaseMutex);
    Data mapKey = document.mEventType + document.mDocumentKey;
+   Shard& shard = shardFor(mapKey);
+   Lock g(shard.mMutex);
    bool found = false;
-   KeyToETagMap::iterator keyIt = mPublicationDb.find(mapKey);
-   if (keyIt != mPublicationDb.end())
+   KeyToETagMap::iterator keyIt = shard.mDocuments.find(mapKey);
+   if (keyIt != shard.mDocuments.end())
    {
       // Next find eTag in sub-map
       ETagToDocumentMap::iterator eTagIt = keyIt->second.find(document.mETag);
@@ -152,6 +176,14 @@ InMemorySyncPubDb::addUpdateDocument(const PubDocument& document)
                eTagIt->second = document;
             }
             eTagIt->second.mLingerTime = now + lingerDuration;
+            if (document.mContents.get() == 0)
+            {
+               onDocumentRefreshed(eTagIt->second);
+            }
+            else
+            {
+               onDocumentStored(eTagIt->second);
+            }
             // Only pass sync as true if this update just came from an inbound sync operation
             invokeOnDocumentModified(document.mSyncPublication /* sync publication? */, document.mEventType, document.mDocumentKey, document.mETag, document.mExpirationTime, document.mLastUpdated, contentsForOnDocumentModified.get(), securityAttributesForOnDocumentModified.get());
          }
@@ -165,7 +197,9 @@ InMemorySyncPubDb::addUpdateDocument(const PubDocument& document)
    if (!found && document.mContents.get() != 0)
    {
       // Add new
-      mPublicationDb[mapKey][document.mETag] = document;
+      PubDocument& added = shard.mDocuments[mapKey][document.mETag];
+      added = document;
+      onDocumentStored(added);
       // Only pass sync as true if this update just came from an inbound sync operation
       invokeOnDocumentModified(document.mSyncPublication /* sync publication? */, document.mEventType, document.mDocumentKey, document.mETag, document.mExpirationTime, document.mLastUpdated, document.mContents.get(), document.mSecurityAttributes.get());
    }
@@ -175,11 +209,13 @@ bool
 InMemorySyncPubDb::removeDocument(const Data& eventType, const Data& documentKey, const Data& eTag, UInt64 lastUpdated, bool syncPublication)
 {
    bool result = false;
-   Lock g(mDatabaseMutex);
+   Data mapKey = eventType + documentKey;
+   Shard& shard = shardFor(mapKey);
+   Lock g(shard.mMutex);
 
    // First find entity in map
-   KeyToETagMap::iterator keyIt = mPublicationDb.find(eventType + documentKey);
-   if (keyIt != mPublicationDb.end())
+   KeyToETagMap::iterator keyIt = shard.mDocuments.find(mapKey);
+   if (keyIt != shard.mDocuments.end())
    {
       // Next find eTag in sub-map
       ETagToDocumentMap::iterator eTagIt = keyIt->second.find(eTag);
@@ -195,11 +231,13 @@ InMemorySyncPubDb::removeDocument(const Data& eventType, const Data& documentKey
                // Tag document as expired, but in a linger state
                eTagIt->second.mExpirationTime = 0;
                eTagIt->second.mLastUpdated = Timer::getTimeSecs();
+               onDocumentRefreshed(eTagIt->second);
             }
             else
             {
                // ETag was found - remove it
                keyIt->second.erase(eTagIt);
+               onDocumentErased(eventType, documentKey, eTag);
             }
             // Only pass sync as true if this update just come from an inbound sync operation
             invokeOnDocumentRemoved(syncPublication /* sync? */, eventType, documentKey, eTag, lastUpdated);
@@ -208,7 +246,7 @@ InMemorySyncPubDb::removeDocument(const Data& eventType, const Data& documentKey
       // If there are no more eTags then remove entity
       if (keyIt->second.size() == 0)
       {
-         mPublicationDb.erase(keyIt);
+         shard.mDocuments.erase(keyIt);
       }
    }
    return result;
@@ -217,11 +255,13 @@ InMemorySyncPubDb::removeDocument(const Data& eventType, const Data& documentKey
 bool 
 InMemorySyncPubDb::getMergedETags(const Data& eventType, const Data& documentKey, ETagMerger& merger, Contents* destination)
 {
-   Lock g(mDatabaseMutex);
+   Data mapKey = eventType + documentKey;
+   Shard& shard = shardFor(mapKey);
+   Lock g(shard.mMutex);
 
    // Find entity
-   KeyToETagMap::iterator keyIt = mPublicationDb.find(eventType + documentKey);
-   if (keyIt != mPublicationDb.end())
+   KeyToETagMap::iterator keyIt = shard.mDocuments.find(mapKey);
+   if (keyIt != shard.mDocuments.end())
    {
       bool isFirst = true;
       UInt64 now = Timer::getTimeSecs();
@@ -243,11 +283,12 @@ InMemorySyncPubDb::getMergedETags(const Data& eventType, const Data& documentKey
          else
          {
             // ETag has expired - remove it
+            onDocumentErased(eventType, documentKey, eTagIt->first);
             keyIt->second.erase(eTagIt++);
             // If no more Etags for key, then remove key entry and bail out
             if (keyIt->second.size() == 0)
             {
-               mPublicationDb.erase(keyIt);
+               shard.mDocuments.erase(keyIt);
                break;
             }
          }
@@ -264,11 +305,13 @@ InMemorySyncPubDb::getMergedETags(const Data& eventType, const Data& documentKey
 bool 
 InMemorySyncPubDb::documentExists(const Data& eventType, const Data& documentKey, const Data& eTag)
 {
-   Lock g(mDatabaseMutex);
+   Data mapKey = eventType + documentKey;
+   Shard& shard = shardFor(mapKey);
+   Lock g(shard.mMutex);
 
    // First find entity in map
-   KeyToETagMap::iterator keyIt = mPublicationDb.find(eventType + documentKey);
-   if (keyIt != mPublicationDb.end())
+   KeyToETagMap::iterator keyIt = shard.mDocuments.find(mapKey);
+   if (keyIt != shard.mDocuments.end())
    {
       // Next find eTag in sub-map
       ETagToDocumentMap::iterator eTagIt = keyIt->second.find(eTag);
@@ -292,11 +335,13 @@ InMemorySyncPubDb::documentExists(const Data& eventType, const Data& documentKey
 // expired hasn't been made obsolete due to a new update.
 bool InMemorySyncPubDb::checkExpired(const Data& eventType, const Data& documentKey, const Data& eTag, UInt64 lastUpdated)
 {
-   Lock g(mDatabaseMutex);
+   Data mapKey = eventType + documentKey;
+   Shard& shard = shardFor(mapKey);
+   Lock g(shard.mMutex);
 
    // First find entity in map
-   KeyToETagMap::iterator keyIt = mPublicationDb.find(eventType + documentKey);
-   if (keyIt != mPublicationDb.end())
+   KeyToETagMap::iterator keyIt = shard.mDocuments.find(mapKey);
+   if (keyIt != shard.mDocuments.end())
    {
       // Next find eTag in sub-map
       ETagToDocumentMap::iterator eTagIt = keyIt->second.find(eTag);
@@ -314,15 +359,17 @@ bool InMemorySyncPubDb::checkExpired(const Data& eventType, const Data& document
                // Tag document as expired, but in a linger state
                eTagIt->second.mExpirationTime = 0;
                eTagIt->second.mLastUpdated = now;
+               onDocumentStored(eTagIt->second);
             }
             else
             {
                // ETag was found - remove it
                keyIt->second.erase(eTagIt);
+               onDocumentErased(eventType, documentKey, eTag);
                // If no more Etags for key, then remove key entry
                if (keyIt->second.size() == 0)
                {
-                  mPublicationDb.erase(keyIt);
+                  shard.mDocuments.erase(keyIt);
                }
             }
             invokeOnDocumentRemoved(syncPublication /* sync? */, eventType, documentKey, eTag, now);
@@ -336,19 +383,29 @@ bool InMemorySyncPubDb::checkExpired(const Data& eventType, const Data& document
 void 
 InMemorySyncPubDb::lockDocuments()
 {
-   mDatabaseMutex.lock();
+   // Shards are always locked in the same order, so two callers can't
+   // deadlock
+   for (std::vector<Shard*>::iterator it = mShards.begin(); it != mShards.end(); it++)
+   {
+      (*it)->mMutex.lock();
+      mDocumentsView.insert((*it)->mDocuments.begin(), (*it)->mDocuments.end());
+   }
 }
 
 PublicationPersistenceManager::KeyToETagMap& 
 InMemorySyncPubDb::getDocuments()
 {
-   return mPublicationDb;
+   return mDocumentsView;
 }
 
 void 
 InMemorySyncPubDb::unlockDocuments()
 {
-   mDatabaseMutex.unlock();
+   mDocumentsView.clear();
+   for (std::vector<Shard*>::reverse_iterator it = mShards.rbegin(); it != mShards.rend(); it++)
+   {
+      (*it)->mMutex.unlock();
+   }
 }
 
 void 
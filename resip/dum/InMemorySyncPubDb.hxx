@@ -2,6 +2,7 @@
 #define RESIP_INMEMORYSYNCPUBDB_HXX
 
 #include <list>
+#include <vector>
 
 #include "resip/dum/PublicationPersistenceManager.hxx"
 #include "rutil/Mutex.hxx"
@@ -34,6 +35,15 @@ protected:
   Implementation of a persistence manager. This class keeps
   all publications in memory, and is used for remote replication.
 
+  The documents are spread over a number of shards by event type and
+  document key, each with its own lock, so that publications for
+  different resources, and the getMergedETags() calls that build their
+  NOTIFYs, seldom wait for one another.  Handler callbacks are made with
+  the document's shard locked and must not call back into this class.
+  lockDocuments() locks every shard, and getDocuments() then returns a
+  copy of all the documents taken at that time; changes made to that
+  copy are not stored.
+
   The InMemorySyncPubDbHandler can be used by an external mechanism to 
   transport publication documents to a remote peer for replication.
   See the RegSyncClient and RegSyncServer implementations in the repro
@@ -43,7 +53,8 @@ class InMemorySyncPubDb : public PublicationPersistenceManager
 {
 public:
 
-   InMemorySyncPubDb(bool syncEnabled = false);
+   /// numShards of 0 means the default, DefaultShards
+   InMemorySyncPubDb(bool syncEnabled = false, unsigned int numShards = 0);
    virtual ~InMemorySyncPubDb();
 
    virtual void addHandler(InMemorySyncPubDbHandler* handler);
@@ -60,8 +71,28 @@ public:
    virtual KeyToETagMap& getDocuments();  // Ensure you lock before calling this and unlock when done
    virtual void unlockDocuments();
 
+   static const unsigned int DefaultShards = 64;
+
 protected:
 
+   struct Shard
+   {
+      Mutex mMutex;
+      KeyToETagMap mDocuments;  // keyed by event type + document key
+   };
+   std::vector<Shard*> mShards;
+   Shard& shardFor(const Data& mapKey) const;
+
+   /// Called with the document's shard locked, once it has been stored or
+   /// changed, and once it has been erased; for derived classes that keep
+   /// the documents elsewhere as well.
+   virtual void onDocumentStored(const PubDocument& document) {}
+   virtual void onDocumentErased(const Data& eventType, const Data& documentKey, const Data& eTag) {}
+   /// Called in place of onDocumentStored() when only the document's times
+   /// and sync flag changed: a refresh without a body, or the start of its
+   /// linger.
+   virtual void onDocumentRefreshed(const PubDocument& document) { onDocumentStored(document); }
+
    void invokeOnDocumentModified(bool sync, const Data& eventType, const Data& documentKey, const Data& eTag, UInt64 expirationTime, UInt64 lastUpdated, const Contents* contents, const SecurityAttributes* securityAttributes);
    void invokeOnDocumentRemoved(bool sync, const Data& eventType, const Data& documentKey, const Data& eTag, UInt64 lastUpdated);
    void invokeOnInitialSyncDocument(unsigned int connectionId, const Data& eventType, const Data& documentKey, const Data& eTag, UInt64 expirationTime, UInt64 lastUpdated, const Contents* contents, const SecurityAttributes* securityAttributes);
@@ -71,8 +102,7 @@ protected:
    HandlerList mHandlers;  // use list over set to preserve add order
    Mutex mHandlerMutex;
 
-   KeyToETagMap mPublicationDb;
-   Mutex mDatabaseMutex;
+   KeyToETagMap mDocumentsView;  // filled by lockDocuments() for getDocuments()
 };
 
 }
@@ -1,5 +1,6 @@
 #include "resip/dum/InMemorySyncRegDb.hxx"
 #include "rutil/Timer.hxx"
+#include "rutil/DnsUtil.hxx"
 #include "rutil/Logger.hxx"
 #include "rutil/WinLeakCheck.hxx"
 
@@ -53,19 +54,114 @@ contactsRemoveIfRequired(ContactList& contacts, UInt64& now,
 #endif
 }
 
-InMemorySyncRegDb::InMemorySyncRegDb(unsigned int removeLingerSecs) : 
-   mRemoveLingerSecs(removeLingerSecs)
+const unsigned int InMemorySyncRegDb::DefaultShards;
+
+InMemorySyncRegDb::InMemorySyncRegDb(unsigned int removeLingerSecs, unsigned int numShards) : 
+   mRemoveLingerSecs(removeLingerSecs),
+   mExpirySweeper(0)
 {
+   mShards.resize(numShards ? numShards : DefaultShards);
+   for(std::vector<Shard*>::iterator it = mShards.begin(); it != mShards.end(); it++)
+   {
+      *it = new Shard;
+   }
 }
 
 InMemorySyncRegDb::~InMemorySyncRegDb()
 {
-   for( database_map_t::const_iterator it = mDatabase.begin();
-        it != mDatabase.end(); it++)
+   stopExpirySweeper();
+   for(std::vector<Shard*>::iterator it = mShards.begin(); it != mShards.end(); it++)
+   {
+      for(database_map_t::const_iterator i = (*it)->mDatabase.begin(); 
+          i != (*it)->mDatabase.end(); i++)
+      {
+         for(RecordList::const_iterator r = i->second.begin(); r != i->second.end(); r++)
+         {
+            delete r->mContacts;
+         }
+      }
+      delete *it;
+   }
+   mShards.clear();
+}
+
+size_t
+InMemorySyncRegDb::hashAor(const Uri& aor)
+{
+   // Uri::operator< compares user, user parameters, canonical host and port
+   size_t hash = aor.user().hash();
+   hash = hash * 31 + aor.userParameters().hash();
+   if(DnsUtil::isIpV6Address(aor.host()))
+   {
+      hash = hash * 31 + DnsUtil::canonicalizeIpV6Address(aor.host()).hash();
+   }
+   else
+   {
+      hash = hash * 31 + aor.host().caseInsensitivehash();
+   }
+   return hash * 31 + aor.port();
+}
+
+InMemorySyncRegDb::Shard&
+InMemorySyncRegDb::shardFor(size_t hash) const
+{
+   // The shard's map buckets on the same hash; mix in the high bits so
+   // that the two don't pick the same low bits.
+   return *mShards[(hash ^ (hash >> 16)) % mShards.size()];
+}
+
+InMemorySyncRegDb::Record*
+InMemorySyncRegDb::findRecord(Shard& shard, size_t hash, const Uri& aor)
+{
+   database_map_t::iterator i = shard.mDatabase.find(hash);
+   if(i == shard.mDatabase.end())
+   {
+      return 0;
+   }
+   for(RecordList::iterator r = i->second.begin(); r != i->second.end(); r++)
+   {
+      if(!(r->mAor < aor) && !(aor < r->mAor))
+      {
+         return &(*r);
+      }
+   }
+   return 0;
+}
+
+InMemorySyncRegDb::Record&
+InMemorySyncRegDb::findOrAddRecord(Shard& shard, size_t hash, const Uri& aor)
+{
+   Record* record = findRecord(shard, hash, aor);
+   if(record)
    {
-      delete it->second;
+      return *record;
+   }
+   RecordList& records = shard.mDatabase[hash];
+   records.push_back(Record(aor));
+   return records.back();
+}
+
+void
+InMemorySyncRegDb::eraseRecord(Shard& shard, size_t hash, const Uri& aor)
+{
+   database_map_t::iterator i = shard.mDatabase.find(hash);
+   if(i == shard.mDatabase.end())
+   {
+      return;
+   }
+   for(RecordList::iterator r = i->second.begin(); r != i->second.end(); r++)
+   {
+      if(!(r->mAor < aor) && !(aor < r->mAor))
+      {
+         delete r->mContacts;
+         i->second.erase(r);
+         break;
+      }
+   }
+   if(i->second.empty())
+   {
+      shard.mDatabase.erase(i);
    }
-   mDatabase.clear();
 }
 
 void 
@@ -120,18 +216,24 @@ InMemorySyncRegDb::invokeOnInitialSyncAor(unsigned int connectionId, const resip
 void 
 InMemorySyncRegDb::initialSync(unsigned int connectionId)
 {
-   Lock g(mDatabaseMutex);
    UInt64 now = Timer::getTimeSecs();
-   for(database_map_t::iterator it = mDatabase.begin(); it != mDatabase.end(); it++)
+   for(std::vector<Shard*>::iterator s = mShards.begin(); s != mShards.end(); s++)
    {
-      if(it->second)
+      Lock g((*s)->mMutex);
+      for(database_map_t::iterator it = (*s)->mDatabase.begin(); it != (*s)->mDatabase.end(); it++)
       {
-         ContactList& contacts = *(it->second);
-         if(mRemoveLingerSecs > 0) 
+         for(RecordList::iterator r = it->second.begin(); r != it->second.end(); r++)
          {
-            contactsRemoveIfRequired(contacts, now, mRemoveLingerSecs);
+            if(r->mContacts)
+            {
+               ContactList& contacts = *(r->mContacts);
+               if(mRemoveLingerSecs > 0) 
+               {
+                  contactsRemoveIfRequired(contacts, now, mRemoveLingerSecs);
+               }
+               invokeOnInitialSyncAor(connectionId, r->mAor, contacts);
+            }
          }
-         invokeOnInitialSyncAor(connectionId, it->first, contacts);
       }
    }
 }
@@ -140,22 +242,21 @@ void
 InMemorySyncRegDb::addAor(const Uri& aor,
                           const ContactList& contacts)
 {
-   Lock g(mDatabaseMutex);
-   database_map_t::iterator it = mDatabase.find(aor);
-   if(it != mDatabase.end())
+   size_t hash = hashAor(aor);
+   Shard& shard = shardFor(hash);
+   Lock g(shard.mMutex);
+   Record& record = findOrAddRecord(shard, hash, aor);
+   if(record.mContacts)
    {
-       if(it->second)
-       {
-           *(it->second) = contacts;
-       }
-       else
-       {
-           it->second = new ContactList(contacts);
-       }
+      *(record.mContacts) = contacts;
    }
    else
    {
-       mDatabase[aor] = new ContactList(contacts);
+      record.mContacts = new ContactList(contacts);
+   }
+   for(ContactList::const_iterator it = contacts.begin(); it != contacts.end(); it++)
+   {
+      schedulePurge(shard, hash, record, purgeTime(*it));
    }
    invokeOnAorModified(true /* sync? */, aor, contacts);
 }
@@ -163,35 +264,46 @@ InMemorySyncRegDb::addAor(const Uri& aor,
 void 
 InMemorySyncRegDb::removeAor(const Uri& aor)
 {
-  database_map_t::iterator i;
+   size_t hash = hashAor(aor);
+   Shard& shard = shardFor(hash);
+   Lock g(shard.mMutex);
+   removeAor(shard, hash, aor);
+}
 
-  Lock g(mDatabaseMutex);
-  i = mDatabase.find(aor);
+void 
+InMemorySyncRegDb::removeAor(Shard& shard, size_t hash, const Uri& aor)
+{
+  Record* record = findRecord(shard, hash, aor);
   //DebugLog (<< "Removing registration bindings " << aor);
-  if (i != mDatabase.end())
+  if (record && record->mContacts)
   {
-     if (i->second)
+     if(mRemoveLingerSecs > 0)
      {
-        if(mRemoveLingerSecs > 0)
+        ContactList& contacts = *(record->mContacts);
+        UInt64 now = Timer::getTimeSecs();
+        for(ContactList::iterator it = contacts.begin(); it != contacts.end(); it++)
         {
-           ContactList& contacts = *(i->second);
-           UInt64 now = Timer::getTimeSecs();
-           for(ContactList::iterator it = contacts.begin(); it != contacts.end(); it++)
-           {
-              // Don't delete record - set expires to 0
-              it->mRegExpires = 0;
-              it->mLastUpdated = now;
-           }
-           invokeOnAorModified(true /* sync? */, aor, contacts);
+           // Don't delete record - set expires to 0
+           it->mRegExpires = 0;
+           it->mLastUpdated = now;
+           schedulePurge(shard, hash, *record, purgeTime(*it));
         }
-        else
+        invokeOnAorModified(true /* sync? */, aor, contacts);
+     }
+     else
+     {
+        if(record->mLocked)
         {
-           delete i->second;
+           delete record->mContacts;
            // Setting this to 0 causes it to be removed when we unlock the AOR.
-           i->second = 0;
-           ContactList emptyList;
-           invokeOnAorModified(true /* sync? */, aor, emptyList);
+           record->mContacts = 0;
         }
+        else
+        {
+           eraseRecord(shard, hash, aor);
+        }
+        ContactList emptyList;
+        invokeOnAorModified(true /* sync? */, aor, emptyList);
      }
   }
 }
@@ -200,11 +312,17 @@ void
 InMemorySyncRegDb::getAors(InMemorySyncRegDb::UriList& container)
 {
    container.clear();
-   Lock g(mDatabaseMutex);
-   for( database_map_t::const_iterator it = mDatabase.begin();
-        it != mDatabase.end(); it++)
+   for(std::vector<Shard*>::iterator s = mShards.begin(); s != mShards.end(); s++)
    {
-      container.push_back(it->first);
+      Lock g((*s)->mMutex);
+      for(database_map_t::const_iterator it = (*s)->mDatabase.begin();
+          it != (*s)->mDatabase.end(); it++)
+      {
+         for(RecordList::const_iterator r = it->second.begin(); r != it->second.end(); r++)
+         {
+            container.push_back(r->mAor);
+         }
+      }
    }
 }
 
@@ -217,14 +335,16 @@ InMemorySyncRegDb::aorIsRegistered(const Uri& aor)
 bool 
 InMemorySyncRegDb::aorIsRegistered(const Uri& aor, UInt64* maxExpires)
 {
-   Lock g(mDatabaseMutex);
+   size_t hash = hashAor(aor);
+   Shard& shard = shardFor(hash);
+   Lock g(shard.mMutex);
    bool registered = false;
-   database_map_t::iterator i = mDatabase.find(aor);
-   if (i != mDatabase.end() && i->second != 0)
+   Record* record = findRecord(shard, hash, aor);
+   if (record && record->mContacts)
    {
       if (mRemoveLingerSecs > 0 || maxExpires)
       {
-         ContactList& contacts = *(i->second);
+         ContactList& contacts = *(record->mContacts);
          UInt64 now = Timer::getTimeSecs();
          for(ContactList::iterator it = contacts.begin(); it != contacts.end(); it++)
          {
@@ -253,72 +373,63 @@ InMemorySyncRegDb::aorIsRegistered(const Uri& aor, UInt64* maxExpires)
 void
 InMemorySyncRegDb::lockRecord(const Uri& aor)
 {
-   Lock g2(mLockedRecordsMutex);
+   size_t hash = hashAor(aor);
+   Shard& shard = shardFor(hash);
+   Lock g(shard.mMutex);
 
    DebugLog(<< "InMemorySyncRegDb::lockRecord:  aor=" << aor << " threadid=" << ThreadIf::selfId());
 
+   // This forces insertion if the record does not yet exist.
+   while (findOrAddRecord(shard, hash, aor).mLocked)
    {
-      Lock g1(mDatabaseMutex);
-      // This forces insertion if the record does not yet exist.
-      mDatabase[aor];
+      // The record may be erased while we wait, hence the lookup each time.
+      shard.mRecordUnlocked.wait(shard.mMutex);
    }
 
-   while (mLockedRecords.count(aor))
-   {
-      mRecordUnlocked.wait(mLockedRecordsMutex);
-   }
-
-   mLockedRecords.insert(aor);
+   findRecord(shard, hash, aor)->mLocked = true;
 }
 
 void
 InMemorySyncRegDb::unlockRecord(const Uri& aor)
 {
-   Lock g2(mLockedRecordsMutex);
+   size_t hash = hashAor(aor);
+   Shard& shard = shardFor(hash);
+   Lock g(shard.mMutex);
 
    DebugLog(<< "InMemorySyncRegDb::unlockRecord:  aor=" << aor << " threadid=" << ThreadIf::selfId());
 
-   {
-      Lock g1(mDatabaseMutex);
-      // If the pointer is null, we remove the record from the map.
-      database_map_t::iterator i = mDatabase.find(aor);
+   Record* record = findRecord(shard, hash, aor);
 
-      // The record must have been inserted when we locked it in the first place
-      resip_assert (i != mDatabase.end());
+   // The record must have been inserted when we locked it in the first place
+   resip_assert(record);
 
-      if (i->second == 0)
-      {
-         mDatabase.erase(i);
-      }
+   // If the pointer is null, we remove the record from the map.
+   if (record->mContacts == 0)
+   {
+      eraseRecord(shard, hash, aor);
+   }
+   else
+   {
+      record->mLocked = false;
    }
 
-   mLockedRecords.erase(aor);
-   mRecordUnlocked.broadcast();
+   shard.mRecordUnlocked.broadcast();
 }
 
 RegistrationPersistenceManager::update_status_t 
 InMemorySyncRegDb::updateContact(const resip::Uri& aor, 
                                  const ContactInstanceRecord& rec) 
 {
-   ContactList *contactList = 0;
+   size_t hash = hashAor(aor);
+   Shard& shard = shardFor(hash);
+   Lock g(shard.mMutex);
 
+   Record& record = findOrAddRecord(shard, hash, aor);
+   if (record.mContacts == 0)
    {
-      Lock g(mDatabaseMutex);
-
-      database_map_t::iterator i;
-      i = mDatabase.find(aor);
-      if (i == mDatabase.end() || i->second == 0)
-      {
-         contactList = new ContactList();
-         mDatabase[aor] = contactList;
-      }
-      else
-      {
-         contactList = i->second;
-      }
+      record.mContacts = new ContactList();
    }
-   
-   resip_assert(contactList);
+   ContactList* contactList = record.mContacts;
 
    ContactList::iterator j;
 
@@ -337,6 +448,7 @@ InMemorySyncRegDb::updateContact(const resip::Uri& aor,
             status = CONTACT_CREATED;
          }
          *j=rec;
+         schedulePurge(shard, hash, record, purgeTime(rec));
          // Only pass sync as true if this update didn't just come from an inbound sync operation
          invokeOnAorModified(!rec.mSyncContact /* sync? */, aor, *contactList);
          return status;
@@ -345,6 +457,7 @@ InMemorySyncRegDb::updateContact(const resip::Uri& aor,
 
    // This is a new contact, so we add it to the list.
    contactList->push_back(rec);
+   schedulePurge(shard, hash, record, purgeTime(rec));
    // Only pass sync as true if this update didn't just come from an inbound sync operation
    invokeOnAorModified(!rec.mSyncContact /* sync? */, aor, *contactList);
    return CONTACT_CREATED;
@@ -354,19 +467,16 @@ void
 InMemorySyncRegDb::removeContact(const Uri& aor, 
                                  const ContactInstanceRecord& rec)
 {
-   ContactList *contactList = 0;
+   size_t hash = hashAor(aor);
+   Shard& shard = shardFor(hash);
+   Lock g(shard.mMutex);
 
+   Record* record = findRecord(shard, hash, aor);
+   if (record == 0 || record->mContacts == 0)
    {
-      Lock g(mDatabaseMutex);
-
-      database_map_t::iterator i;
-      i = mDatabase.find(aor);
-      if (i == mDatabase.end() || i->second == 0)
-      {
-         return;
-      }
-      contactList = i->second;
+      return;
    }
+   ContactList* contactList = record->mContacts;
 
    ContactList::iterator j;
 
@@ -379,6 +489,7 @@ InMemorySyncRegDb::removeContact(const Uri& aor,
          {
             j->mRegExpires = 0;
             j->mLastUpdated = Timer::getTimeSecs();
+            schedulePurge(shard, hash, *record, purgeTime(*j));
             // Only pass sync as true if this update didn't just come from an inbound sync operation
             invokeOnAorModified(!rec.mSyncContact /* sync? */, aor, *contactList);
          }
@@ -387,7 +498,7 @@ InMemorySyncRegDb::removeContact(const Uri& aor,
             contactList->erase(j);
             if (contactList->empty())
             {
-               removeAor(aor);
+               removeAor(shard, hash, aor);
             }
             else
             {
@@ -403,16 +514,18 @@ InMemorySyncRegDb::removeContact(const Uri& aor,
 void
 InMemorySyncRegDb::getContacts(const Uri& aor, ContactList& container)
 {
-   Lock g(mDatabaseMutex);
-   database_map_t::iterator i = mDatabase.find(aor);
-   if (i == mDatabase.end() || i->second == 0)
+   size_t hash = hashAor(aor);
+   Shard& shard = shardFor(hash);
+   Lock g(shard.mMutex);
+   Record* record = findRecord(shard, hash, aor);
+   if (record == 0 || record->mContacts == 0)
    {
       container.clear();
       return;
    }
    if(mRemoveLingerSecs > 0)
    {
-      ContactList& contacts = *(i->second);
+      ContactList& contacts = *(record->mContacts);
       UInt64 now = Timer::getTimeSecs();
       contactsRemoveIfRequired(contacts, now, mRemoveLingerSecs);
       container.clear();
@@ -426,21 +539,23 @@ InMemorySyncRegDb::getContacts(const Uri& aor, ContactList& container)
    }
    else
    {
-      container = *(i->second);
+      container = *(record->mContacts);
    }
 }
 
 void
 InMemorySyncRegDb::getContactsFull(const Uri& aor, ContactList& container)
 {
-   Lock g(mDatabaseMutex);
-   database_map_t::iterator i = mDatabase.find(aor);
-   if (i == mDatabase.end() || i->second == 0)
+   size_t hash = hashAor(aor);
+   Shard& shard = shardFor(hash);
+   Lock g(shard.mMutex);
+   Record* record = findRecord(shard, hash, aor);
+   if (record == 0 || record->mContacts == 0)
    {
       container.clear();
       return;
    }
-   ContactList& contacts = *(i->second);
+   ContactList& contacts = *(record->mContacts);
    if(mRemoveLingerSecs > 0)
    {
       UInt64 now = Timer::getTimeSecs();
@@ -449,6 +564,173 @@ InMemorySyncRegDb::getContactsFull(const Uri& aor, ContactList& container)
    container = contacts;
 }
 
+UInt64
+InMemorySyncRegDb::purgeTime(const ContactInstanceRecord& rec) const
+{
+   if(rec.mRegExpires == NeverExpire)
+   {
+      return 0;
+   }
+   if(mRemoveLingerSecs > 0)
+   {
+      // see RemoveIfRequired
+      return resipMax(rec.mRegExpires, rec.mLastUpdated + mRemoveLingerSecs + 1);
+   }
+   // 0 would mean never
+   return rec.mRegExpires ? rec.mRegExpires : 1;
+}
+
+void
+InMemorySyncRegDb::schedulePurge(Shard& shard, size_t hash, Record& record, UInt64 when)
+{
+   // A record has one entry, for its earliest purge time; later times are
+   // picked up when that entry is reached.
+   if(when && (record.mNextPurge == 0 || when < record.mNextPurge))
+   {
+      record.mNextPurge = when;
+      shard.mExpiries.push(ExpiryEntry(when, hash));
+   }
+}
+
+void
+InMemorySyncRegDb::purgeRecord(Shard& shard, size_t hash, Record& record, UInt64 now)
+{
+   record.mNextPurge = 0;
+   if(record.mLocked)
+   {
+      // Being updated; look again shortly.
+      schedulePurge(shard, hash, record, now + 1);
+      return;
+   }
+   if(record.mContacts == 0)
+   {
+      return;
+   }
+
+   ContactList& contacts = *(record.mContacts);
+   bool removed = false;
+   UInt64 next = 0;
+   for(ContactList::iterator it = contacts.begin(); it != contacts.end(); )
+   {
+      UInt64 when = purgeTime(*it);
+      if(when && when <= now)
+      {
+         DebugLog(<< "ContactInstanceRecord purged: " << it->mContact);
+         it = contacts.erase(it);
+         removed = true;
+      }
+      else
+      {
+         if(when && (next == 0 || when < next))
+         {
+            next = when;
+         }
+         ++it;
+      }
+   }
+   schedulePurge(shard, hash, record, next);
+
+   if(contacts.empty())
+   {
+      // may also have been emptied by a lingering-contact cleanup
+      Uri aor(record.mAor);
+      eraseRecord(shard, hash, aor);
+      if(removed)
+      {
+         invokeOnAorModified(true /* sync? */, aor, ContactList());
+      }
+   }
+   else if(removed)
+   {
+      invokeOnAorModified(true /* sync? */, record.mAor, contacts);
+   }
+}
+
+unsigned int
+InMemorySyncRegDb::purgeExpired(unsigned int batchSize)
+{
+   UInt64 now = Timer::getTimeSecs();
+   unsigned int examined = 0;
+   for(std::vector<Shard*>::iterator s = mShards.begin(); s != mShards.end(); s++)
+   {
+      Shard& shard = **s;
+      Lock g(shard.mMutex);
+      unsigned int shardExamined = 0;
+      while(!shard.mExpiries.empty() && shard.mExpiries.top().first <= now &&
+            (batchSize == 0 || shardExamined < batchSize))
+      {
+         ExpiryEntry entry = shard.mExpiries.top();
+         shard.mExpiries.pop();
+
+         // Entries whose record has since been rescheduled, or erased, find
+         // nothing due here.  purgeRecord() either erases the record or
+         // moves its mNextPurge past now, so this terminates.
+         bool found = true;
+         while(found)
+         {
+            found = false;
+            database_map_t::iterator i = shard.mDatabase.find(entry.second);
+            if(i == shard.mDatabase.end())
+            {
+               break;
+            }
+            for(RecordList::iterator r = i->second.begin(); r != i->second.end(); r++)
+            {
+               if(r->mNextPurge && r->mNextPurge <= now)
+               {
+                  purgeRecord(shard, entry.second, *r, now);
+                  ++shardExamined;
+                  found = true;
+                  break;
+               }
+            }
+         }
+      }
+      examined += shardExamined;
+   }
+   return examined;
+}
+
+InMemorySyncRegDb::ExpirySweeper::ExpirySweeper(InMemorySyncRegDb& db, unsigned int intervalMs, unsigned int batchSize) :
+   mDb(db),
+   mIntervalMs(intervalMs),
+   mBatchSize(batchSize)
+{
+}
+
+void
+InMemorySyncRegDb::ExpirySweeper::thread()
+{
+   while(!isShutdown())
+   {
+      // Locks are released between batches, so registrations and lookups
+      // get in while a large backlog is worked through.
+      while(!isShutdown() && mDb.purgeExpired(mBatchSize) > 0)
+      {
+      }
+      waitForShutdown(mIntervalMs);
+   }
+}
+
+void
+InMemorySyncRegDb::startExpirySweeper(unsigned int intervalMs, unsigned int batchSize)
+{
+   stopExpirySweeper();
+   mExpirySweeper = new ExpirySweeper(*this, intervalMs, batchSize);
+   mExpirySweeper->run();
+}
+
+void
+InMemorySyncRegDb::stopExpirySweeper()
+{
+   if(mExpirySweeper)
+   {
+      mExpirySweeper->shutdown();
+      mExpirySweeper->join();
+      delete mExpirySweeper;
+      mExpirySweeper = 0;
+   }
+}
 
 /* ====================================================================
  * The Vovida Software License, Version 1.0 
@@ -1,14 +1,17 @@
 #if !defined(RESIP_INMEMORYSYNCREGDB_HXX)
 #define RESIP_INMEMORYSYNCREGDB_HXX
 
-#include <map>
-#include <set>
+#include <functional>
 #include <list>
+#include <queue>
+#include <vector>
 
 #include "resip/dum/RegistrationPersistenceManager.hxx"
 #include "rutil/Mutex.hxx"
 #include "rutil/Condition.hxx"
 #include "rutil/Lock.hxx"
+#include "rutil/HashMap.hxx"
+#include "rutil/ThreadIf.hxx"
 
 namespace resip
 {
@@ -44,6 +47,20 @@ protected:
   memory immediately and this class behaves very similar to the 
   InMemoryRegistrationDatabase class.
 
+  The AORs are spread over a number of shards, each with its own lock, so
+  that registrations and lookups of different AORs seldom wait for one
+  another.  An AOR's hash is computed once per call and kept with its
+  record; a shard indexes its records by that hash.  Handler callbacks
+  are made with the AOR's shard locked, so they see the changes to an
+  AOR in order and must not call back into this class.
+
+  Each shard also keeps its AORs in a heap ordered by the time their next
+  contact is due for removal: its expiry, or the end of its linger time.
+  purgeExpired() removes due contacts from the front of these heaps, and
+  the expiry sweeper (see startExpirySweeper()) calls it in the
+  background, so that expired bindings don't accumulate and handlers hear
+  of them without waiting for the AOR to be touched again.
+
   The InMemorySyncRegDbHandler can be used by an external mechanism to 
   transport registration bindings to a remote peer for replication.
   See the RegSyncClient and RegSyncServer implementations in the repro
@@ -53,7 +70,8 @@ class InMemorySyncRegDb : public RegistrationPersistenceManager
 {
    public:
 
-      InMemorySyncRegDb(unsigned int removeLingerSecs = 0);
+      /// numShards of 0 means the default, DefaultShards
+      InMemorySyncRegDb(unsigned int removeLingerSecs = 0, unsigned int numShards = 0);
       virtual ~InMemorySyncRegDb();
       
       virtual void addHandler(InMemorySyncRegDbHandler* handler);
@@ -79,15 +97,74 @@ class InMemorySyncRegDb : public RegistrationPersistenceManager
    
       /// return all the AOR in the DB 
       virtual void getAors(UriList& container);
+
+      /// Removes the contacts that are due for removal from up to
+      /// batchSize AORs per shard, 0 for no limit, invoking the handlers
+      /// for each AOR changed; returns the number of AORs examined.
+      unsigned int purgeExpired(unsigned int batchSize = 0);
+
+      /// Starts a thread that calls purgeExpired() in batches of batchSize
+      /// every intervalMs, until stopExpirySweeper() or destruction.
+      void startExpirySweeper(unsigned int intervalMs = 1000, unsigned int batchSize = 1000);
+      void stopExpirySweeper();
       
-   protected:
-      typedef std::map<Uri,ContactList *> database_map_t;
-      database_map_t mDatabase;
-      Mutex mDatabaseMutex;
+      static const unsigned int DefaultShards = 64;
 
-      std::set<Uri> mLockedRecords;
-      Mutex mLockedRecordsMutex;
-      Condition mRecordUnlocked;
+   protected:
+      /// An AOR's entry; mContacts is 0 for a record that exists only
+      /// because it is locked, or was removed while locked.
+      struct Record
+      {
+         Record(const Uri& aor) : mAor(aor), mContacts(0), mLocked(false), mNextPurge(0) {}
+         Uri mAor;
+         ContactList* mContacts;
+         bool mLocked;
+         UInt64 mNextPurge;  // time of this record's entry in mExpiries, or 0
+      };
+      /// Records whose AORs share a hash value; almost always just one.
+      typedef std::vector<Record> RecordList;
+      typedef HashMap<size_t, RecordList> database_map_t;
+      /// (purge time, AOR hash); the records of that hash whose mNextPurge
+      /// has come are purged when it reaches the top.
+      typedef std::pair<UInt64, size_t> ExpiryEntry;
+      typedef std::priority_queue<ExpiryEntry, std::vector<ExpiryEntry>, std::greater<ExpiryEntry> > ExpiryHeap;
+
+      struct Shard
+      {
+         Mutex mMutex;
+         Condition mRecordUnlocked;
+         database_map_t mDatabase;
+         ExpiryHeap mExpiries;
+      };
+      std::vector<Shard*> mShards;
+
+      /// Hash of the parts of aor that Uri::operator< compares, which is
+      /// what tells AORs apart here.
+      static size_t hashAor(const Uri& aor);
+      Shard& shardFor(size_t hash) const;
+      /// The record for aor in shard, or 0; shard must be locked.
+      static Record* findRecord(Shard& shard, size_t hash, const Uri& aor);
+      static Record& findOrAddRecord(Shard& shard, size_t hash, const Uri& aor);
+      static void eraseRecord(Shard& shard, size_t hash, const Uri& aor);
+      void removeAor(Shard& shard, size_t hash, const Uri& aor);
+
+      /// When rec is due for removal, 0 for never.
+      UInt64 purgeTime(const ContactInstanceRecord& rec) const;
+      /// Makes sure record is purged no later than when (0 for never).
+      static void schedulePurge(Shard& shard, size_t hash, Record& record, UInt64 when);
+      void purgeRecord(Shard& shard, size_t hash, Record& record, UInt64 now);
+
+      class ExpirySweeper : public ThreadIf
+      {
+         public:
+            ExpirySweeper(InMemorySyncRegDb& db, unsigned int intervalMs, unsigned int batchSize);
+            virtual void thread();
+
+         private:
+            InMemorySyncRegDb& mDb;
+            unsigned int mIntervalMs;
+            unsigned int mBatchSize;
+      };
 
       void invokeOnAorModified(bool sync, const resip::Uri& aor, const ContactList& contacts);
       void invokeOnInitialSyncAor(unsigned int connectionId, const resip::Uri& aor, const ContactList& contacts);
@@ -95,6 +172,7 @@ class InMemorySyncRegDb : public RegistrationPersistenceManager
       typedef std::list<InMemorySyncRegDbHandler*> HandlerList;
       HandlerList mHandlers;  // use list over set to preserve add order
       Mutex mHandlerMutex;
+      ExpirySweeper* mExpirySweeper;
 };
 
 }
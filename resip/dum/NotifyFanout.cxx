@@ -0,0 +1,287 @@
+#include <string.h>
+
+#include "resip/dum/DialogUsageManager.hxx"
+#include "resip/dum/DumCommand.hxx"
+#include "resip/dum/NotifyFanout.hxx"
+#include "resip/dum/ServerSubscription.hxx"
+#include "resip/stack/Contents.hxx"
+#include "resip/stack/SendData.hxx"
+#include "resip/stack/SipMessage.hxx"
+#include "rutil/Logger.hxx"
+#include "rutil/Timer.hxx"
+#include "rutil/WinLeakCheck.hxx"
+
+#define RESIPROCATE_SUBSYSTEM Subsystem::DUM
+
+using namespace resip;
+
+NotifyBody::NotifyBody(const Contents& document)
+   : mBuffer(new SharedRxBuffers),
+     mStart(0),
+     mLength(0),
+     mType(document.getType()),
+     mHasDisposition(document.exists(h_ContentDisposition)),
+     mHasTransferEncoding(document.exists(h_ContentTransferEncoding)),
+     mHasLanguages(document.exists(h_ContentLanguages))
+{
+   Data text(document.getBodyData());
+   char* buffer = new char[text.size()];
+   memcpy(buffer, text.data(), text.size());
+   mBuffer->mBuffers.push_back(std::make_pair(buffer, (size_t)text.size()));
+   mStart = buffer;
+   mLength = text.size();
+
+   if (mHasDisposition)
+   {
+      mDisposition = document.header(h_ContentDisposition);
+   }
+   if (mHasTransferEncoding)
+   {
+      mTransferEncoding = document.header(h_ContentTransferEncoding);
+   }
+   if (mHasLanguages)
+   {
+      mLanguages = document.header(h_ContentLanguages);
+   }
+}
+
+void
+NotifyBody::applyTo(SipMessage& msg) const
+{
+   msg.setSharedBody(mBuffer, mStart, mLength);
+   msg.header(h_ContentType) = mType;
+   if (mHasDisposition)
+   {
+      msg.header(h_ContentDisposition) = mDisposition;
+   }
+   if (mHasTransferEncoding)
+   {
+      msg.header(h_ContentTransferEncoding) = mTransferEncoding;
+   }
+   if (mHasLanguages)
+   {
+      msg.header(h_ContentLanguages) = mLanguages;
+   }
+}
+
+namespace resip
+{
+
+// Runs one pass of a NotifyFanout on the DUM thread.
+class NotifyFanoutCommand : public DumCommandAdapter
+{
+   public:
+      NotifyFanoutCommand(NotifyFanout& fanout, bool wakeup) : mFanout(fanout), mWakeup(wakeup) {}
+
+      virtual void executeCommand()
+      {
+         mFanout.process(mWakeup);
+      }
+
+      virtual EncodeStream& encodeBrief(EncodeStream& strm) const
+      {
+         return strm << "NotifyFanoutCommand";
+      }
+
+   private:
+      NotifyFanout& mFanout;
+      bool mWakeup;
+};
+
+}
+
+NotifyFanout::NotifyFanout(DialogUsageManager& dum)
+   : mDum(dum),
+     mBatchSize(DefaultBatchSize),
+     mMinInterval(0),
+     mPassPosted(false),
+     mWakeupAt(0)
+{
+}
+
+NotifyFanout::~NotifyFanout()
+{
+}
+
+size_t
+NotifyFanout::notify(const Data& eventType, const Data& documentKey, const Contents* document)
+{
+   SharedPtr<NotifyBody> body;
+   if (document)
+   {
+      body.reset(new NotifyBody(*document));
+   }
+   return notify(eventType, documentKey, body);
+}
+
+size_t
+NotifyFanout::notify(const Data& eventType, const Data& documentKey, const SharedPtr<NotifyBody>& body)
+{
+   size_t queued = 0;
+   const DialogUsageManager::ServerSubscriptionList* watchers = mDum.findServerSubscriptionList(eventType, documentKey);
+   if (watchers)
+   {
+      for (DialogUsageManager::ServerSubscriptionList::const_iterator i = watchers->begin(); i != watchers->end(); ++i)
+      {
+         if (enqueue(**i, body))
+         {
+            ++queued;
+         }
+      }
+   }
+   DebugLog(<< "NotifyFanout: " << eventType << " for " << documentKey << " queued to " << queued
+            << " watchers, " << pending() << " pending");
+   schedule();
+   return queued;
+}
+
+bool
+NotifyFanout::notify(ServerSubscriptionHandle watcher, const SharedPtr<NotifyBody>& body)
+{
+   bool queued = watcher.isValid() && enqueue(*watcher, body);
+   schedule();
+   return queued;
+}
+
+bool
+NotifyFanout::enqueue(ServerSubscription& watcher, const SharedPtr<NotifyBody>& body)
+{
+   // pending watchers may not be authorized to see the document yet
+   if (watcher.mSubscriptionState != Active)
+   {
+      return false;
+   }
+   // a watcher already queued just gets the newer document
+   watcher.mFanoutBody = body;
+   if (!watcher.mFanoutQueued)
+   {
+      watcher.mFanoutQueued = true;
+      mReady.push_back(watcher.getHandle());
+   }
+   return true;
+}
+
+void
+NotifyFanout::process(bool wakeup)
+{
+   if (wakeup)
+   {
+      mWakeupAt = 0;
+   }
+   else
+   {
+      mPassPosted = false;
+   }
+
+   UInt64 now = Timer::getTimeMs();
+   while (!mDeferred.empty() && mDeferred.top().first <= now)
+   {
+      mReady.push_back(mDeferred.top().second);
+      mDeferred.pop();
+   }
+
+   unsigned int sent = 0;
+   while (!mReady.empty() && (mBatchSize == 0 || sent < mBatchSize))
+   {
+      ServerSubscriptionHandle h = mReady.front();
+      mReady.pop_front();
+      if (!h.isValid())
+      {
+         continue;
+      }
+
+      ServerSubscription& watcher = *h;
+      if (mMinInterval && watcher.mLastFanoutNotify && now < watcher.mLastFanoutNotify + mMinInterval)
+      {
+         mDeferred.push(Deferred(watcher.mLastFanoutNotify + mMinInterval, h));
+         continue;
+      }
+
+      SharedPtr<NotifyBody> body = watcher.mFanoutBody;
+      watcher.mFanoutBody.reset();
+      watcher.mFanoutQueued = false;
+      if (watcher.mSubscriptionState == Active)
+      {
+         watcher.mLastFanoutNotify = now;
+         // may delete the watcher, if the send fails at once
+         watcher.sendFanoutNotify(body.get());
+         ++sent;
+      }
+   }
+
+   schedule();
+}
+
+void
+NotifyFanout::schedule()
+{
+   if (!mReady.empty())
+   {
+      if (!mPassPosted)
+      {
+         mPassPosted = true;
+         mDum.post(new NotifyFanoutCommand(*this, false));
+      }
+   }
+   else if (!mDeferred.empty() && !mPassPosted)
+   {
+      UInt64 due = mDeferred.top().first;
+      if (mWakeupAt == 0 || due < mWakeupAt)
+      {
+         UInt64 now = Timer::getTimeMs();
+         mWakeupAt = due;
+         mDum.getSipStack().postMS(std::auto_ptr<ApplicationMessage>(new NotifyFanoutCommand(*this, true)),
+                                   (unsigned int)(due > now ? due - now : 0), &mDum);
+      }
+   }
+}
+
+/* ====================================================================
+ * The Vovida Software License, Version 1.0
+ *
+ * Copyright (c) 2000 Vovida Networks, Inc.  All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ *
+ * 3. The names "VOCAL", "Vovida Open Communication Application Library",
+ *    and "Vovida Open Communication Application Library (VOCAL)" must
+ *    not be used to endorse or promote products derived from this
+ *    software without prior written permission. For written
+ *    permission, please contact vocal@vovida.org.
+ *
+ * 4. Products derived from this software may not be called "VOCAL", nor
+ *    may "VOCAL" appear in their name, without prior written
+ *    permission of Vovida Networks, Inc.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESSED OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE, TITLE AND
+ * NON-INFRINGEMENT ARE DISCLAIMED.  IN NO EVENT SHALL VOVIDA
+ * NETWORKS, INC. OR ITS CONTRIBUTORS BE LIABLE FOR ANY DIRECT DAMAGES
+ * IN EXCESS OF $1,000, NOR FOR ANY INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE
+ * USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+ * DAMAGE.
+ *
+ * ====================================================================
+ *
+ * This software consists of voluntary contributions made by Vovida
+ * Networks, Inc. and many individuals on behalf of Vovida Networks,
+ * Inc.  For more information on Vovida Networks, Inc., please see
+ * <http://www.vovida.org/>.
+ *
+ */
@@ -0,0 +1,179 @@
+#if !defined(RESIP_NOTIFYFANOUT_HXX)
+#define RESIP_NOTIFYFANOUT_HXX
+
+#include <deque>
+#include <queue>
+#include <vector>
+
+#include "resip/dum/Handles.hxx"
+#include "resip/stack/Mime.hxx"
+#include "resip/stack/ParserContainer.hxx"
+#include "resip/stack/StringCategory.hxx"
+#include "resip/stack/Token.hxx"
+#include "rutil/Data.hxx"
+#include "rutil/SharedPtr.hxx"
+
+namespace resip
+{
+
+class Contents;
+class DialogUsageManager;
+class SharedRxBuffers;
+class SipMessage;
+
+/**
+   An event document encoded once, to go out as the body of any number of
+   NOTIFYs. Each NOTIFY references the encoded text (see
+   SipMessage::setSharedBody()) instead of carrying its own copy of the
+   Contents, which would be cloned with every copy of the message and
+   encoded again for every send.
+*/
+class NotifyBody
+{
+   public:
+      explicit NotifyBody(const Contents& document);
+
+      /// Makes this the body of msg, with its content headers.
+      void applyTo(SipMessage& msg) const;
+
+      const Mime& getType() const { return mType; }
+      size_t size() const { return mLength; }
+
+   private:
+      SharedPtr<SharedRxBuffers> mBuffer;
+      const char* mStart;
+      size_t mLength;
+
+      Mime mType;
+      bool mHasDisposition;
+      Token mDisposition;
+      bool mHasTransferEncoding;
+      StringCategory mTransferEncoding;
+      bool mHasLanguages;
+      ParserContainer<Token> mLanguages;
+};
+
+/**
+   Sends a change in an event document to every watcher of the resource,
+   without stalling the DUM thread when there are thousands of them.
+
+   notify() encodes the document once, then queues the watchers: all
+   active ServerSubscriptions to the event for that document key. The
+   NOTIFYs are sent from commands posted to the DUM, at most
+   setBatchSize() of them per command, so that other work the DUM has
+   queued runs between batches. A watcher with a NOTIFY still queued only
+   gets the latest document; and with setMinInterval() a watcher is
+   NOTIFYed at most once per interval, later changes waiting (and
+   coalescing) until the interval has passed.
+
+   The NOTIFYs go through ServerSubscription::send() as usual, so
+   ServerSubscriptionHandler::onReadyToSend() still sees each one. Used
+   from the DUM thread only.
+*/
+class NotifyFanout
+{
+   public:
+      static const unsigned int DefaultBatchSize = 100;
+
+      NotifyFanout(DialogUsageManager& dum);
+      ~NotifyFanout();
+
+      /// Most NOTIFYs sent per command; 0 sends everything at once.
+      void setBatchSize(unsigned int batchSize) { mBatchSize = batchSize; }
+      unsigned int getBatchSize() const { return mBatchSize; }
+
+      /// Least time between NOTIFYs to one watcher, in ms; 0 for no limit.
+      void setMinInterval(unsigned int ms) { mMinInterval = ms; }
+      unsigned int getMinInterval() const { return mMinInterval; }
+
+      /**
+         Queues document, or a NOTIFY without a body if document is 0, for
+         every active ServerSubscription to eventType for documentKey.
+         Returns the number of watchers queued.
+      */
+      size_t notify(const Data& eventType, const Data& documentKey, const Contents* document);
+      /// As above, with a document already encoded.
+      size_t notify(const Data& eventType, const Data& documentKey, const SharedPtr<NotifyBody>& body);
+      /// Queues body for one watcher. Returns false if it is not active.
+      bool notify(ServerSubscriptionHandle watcher, const SharedPtr<NotifyBody>& body);
+
+      /// Number of watchers with a NOTIFY queued.
+      size_t pending() const { return mReady.size() + mDeferred.size(); }
+
+   private:
+      friend class NotifyFanoutCommand;
+
+      bool enqueue(ServerSubscription& watcher, const SharedPtr<NotifyBody>& body);
+      void process(bool wakeup);
+      void schedule();
+
+      DialogUsageManager& mDum;
+      unsigned int mBatchSize;
+      unsigned int mMinInterval;
+
+      // watchers due now, and those held back by mMinInterval, by due time
+      typedef std::pair<UInt64, ServerSubscriptionHandle> Deferred;
+      struct LaterFirst
+      {
+         bool operator()(const Deferred& lhs, const Deferred& rhs) const { return lhs.first > rhs.first; }
+      };
+      std::deque<ServerSubscriptionHandle> mReady;
+      std::priority_queue<Deferred, std::vector<Deferred>, LaterFirst> mDeferred;
+
+      bool mPassPosted;
+      UInt64 mWakeupAt;  // 0 if no delayed pass is posted
+};
+
+}
+
+#endif
+
+/* ====================================================================
+ * The Vovida Software License, Version 1.0
+ *
+ * Copyright (c) 2000 Vovida Networks, Inc.  All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ *
+ * 3. The names "VOCAL", "Vovida Open Communication Application Library",
+ *    and "Vovida Open Communication Application Library (VOCAL)" must
+ *    not be used to endorse or promote products derived from this
+ *    software without prior written permission. For written
+ *    permission, please contact vocal@vovida.org.
+ *
+ * 4. Products derived from this software may not be called "VOCAL", nor
+ *    may "VOCAL" appear in their name, without prior written
+ *    permission of Vovida Networks, Inc.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESSED OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE, TITLE AND
+ * NON-INFRINGEMENT ARE DISCLAIMED.  IN NO EVENT SHALL VOVIDA
+ * NETWORKS, INC. OR ITS CONTRIBUTORS BE LIABLE FOR ANY DIRECT DAMAGES
+ * IN EXCESS OF $1,000, NOR FOR ANY INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE
+ * USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+ * DAMAGE.
+ *
+ * ====================================================================
+ *
+ * This software consists of voluntary contributions made by Vovida
+ * Networks, Inc. and many individuals on behalf of Vovida Networks,
+ * Inc.  For more information on Vovida Networks, Inc., please see
+ * <http://www.vovida.org/>.
+ *
+ */
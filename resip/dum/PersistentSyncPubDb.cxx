@@ -0,0 +1,791 @@
+#include <errno.h>
+#include <string.h>
+#include <time.h>
+#ifdef WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+#include "resip/dum/PersistentSyncPubDb.hxx"
+#include "resip/stack/Contents.hxx"
+#include "resip/stack/SecurityAttributes.hxx"
+#include "rutil/Lock.hxx"
+#include "rutil/Logger.hxx"
+#include "rutil/Timer.hxx"
+#include "rutil/WinLeakCheck.hxx"
+
+#define RESIPROCATE_SUBSYSTEM Subsystem::DUM
+
+using namespace resip;
+
+namespace
+{
+
+// Starts the log, so that an old or foreign file isn't taken for one.
+const char LogMagic[] = "resip-pubdb 1\n";
+const size_t LogMagicSize = sizeof(LogMagic) - 1;
+
+// Each record is a 32 bit length and then the record itself, which starts
+// with its type.  Numbers are little endian; strings are a 32 bit length
+// and then the bytes.
+enum
+{
+   RecordStored = 1,
+   RecordErased = 2,
+   RecordRefreshed = 3  // times and sync flag only
+};
+
+enum
+{
+   HasSync = 1,
+   HasContents = 2,
+   HasSecurityAttributes = 4
+};
+
+void
+putUInt8(Data& out, unsigned int value)
+{
+   char c = (char)(value & 0xff);
+   out.append(&c, 1);
+}
+
+void
+putUInt32(Data& out, UInt32 value)
+{
+   char b[4];
+   for (int i = 0; i < 4; ++i)
+   {
+      b[i] = (char)((value >> (8 * i)) & 0xff);
+   }
+   out.append(b, 4);
+}
+
+void
+putUInt64(Data& out, UInt64 value)
+{
+   char b[8];
+   for (int i = 0; i < 8; ++i)
+   {
+      b[i] = (char)((value >> (8 * i)) & 0xff);
+   }
+   out.append(b, 8);
+}
+
+void
+putString(Data& out, const Data& value)
+{
+   putUInt32(out, (UInt32)value.size());
+   out.append(value.data(), value.size());
+}
+
+// Starts a record in out; endRecord() fills in its length.
+size_t
+beginRecord(Data& out, unsigned int type)
+{
+   size_t start = out.size();
+   putUInt32(out, 0);
+   putUInt8(out, type);
+   return start;
+}
+
+void
+endRecord(Data& out, size_t start)
+{
+   UInt32 length = (UInt32)(out.size() - start - 4);
+   for (int i = 0; i < 4; ++i)
+   {
+      out[start + i] = (char)((length >> (8 * i)) & 0xff);
+   }
+}
+
+// Makes what has been written to f durable.
+bool
+syncFile(FILE* f)
+{
+   if (fflush(f) != 0)
+   {
+      return false;
+   }
+#ifdef WIN32
+   return _commit(_fileno(f)) == 0;
+#else
+   return fsync(fileno(f)) == 0;
+#endif
+}
+
+// Timer's seconds may count from boot; the log keeps wall clock seconds,
+// so that its times mean the same after a restart.  0 means "never" to
+// PubDocument and is kept as is.
+UInt64
+toWallClock(UInt64 secs)
+{
+   if (secs == 0)
+   {
+      return 0;
+   }
+   return secs + (UInt64)time(0) - Timer::getTimeSecs();
+}
+
+UInt64
+fromWallClock(UInt64 secs)
+{
+   if (secs == 0)
+   {
+      return 0;
+   }
+   UInt64 wallNow = (UInt64)time(0);
+   UInt64 now = Timer::getTimeSecs();
+   // a time from before Timer's start has long passed either way
+   return secs + now > wallNow ? secs + now - wallNow : 1;
+}
+
+class RecordReader
+{
+   public:
+      RecordReader(const char* start, const char* end) : mPos(start), mEnd(end) {}
+
+      bool atEnd() const { return mPos == mEnd; }
+
+      bool getUInt8(unsigned int& value)
+      {
+         if (mEnd - mPos < 1)
+         {
+            return false;
+         }
+         value = (unsigned char)*mPos++;
+         return true;
+      }
+
+      bool getUInt32(UInt32& value)
+      {
+         if (mEnd - mPos < 4)
+         {
+            return false;
+         }
+         value = 0;
+         for (int i = 0; i < 4; ++i)
+         {
+            value |= (UInt32)(unsigned char)mPos[i] << (8 * i);
+         }
+         mPos += 4;
+         return true;
+      }
+
+      bool getUInt64(UInt64& value)
+      {
+         if (mEnd - mPos < 8)
+         {
+            return false;
+         }
+         value = 0;
+         for (int i = 0; i < 8; ++i)
+         {
+            value |= (UInt64)(unsigned char)mPos[i] << (8 * i);
+         }
+         mPos += 8;
+         return true;
+      }
+
+      /// value shares the reader's buffer
+      bool getString(Data& value)
+      {
+         UInt32 size;
+         if (!getUInt32(size) || (UInt64)(mEnd - mPos) < size)
+         {
+            return false;
+         }
+         value = Data(Data::Share, mPos, size);
+         mPos += size;
+         return true;
+      }
+
+      /// record reads the next record, without its length
+      bool getRecord(RecordReader& record)
+      {
+         UInt32 size;
+         if (!getUInt32(size) || (UInt64)(mEnd - mPos) < size)
+         {
+            return false;
+         }
+         record = RecordReader(mPos, mPos + size);
+         mPos += size;
+         return true;
+      }
+
+   private:
+      const char* mPos;
+      const char* mEnd;
+};
+
+// Reads a record's type and document; the strings are copied, and the
+// Contents is made from the body without parsing it.  A RecordRefreshed
+// fills in just the times and sync flag.
+bool
+decodeRecord(RecordReader& in, unsigned int& type, PublicationPersistenceManager::PubDocument& document)
+{
+   Data eventType;
+   Data documentKey;
+   Data eTag;
+   if (!in.getUInt8(type) ||
+       !in.getString(eventType) || !in.getString(documentKey) || !in.getString(eTag))
+   {
+      return false;
+   }
+   document.mEventType = eventType;
+   document.mDocumentKey = documentKey;
+   document.mETag = eTag;
+   if (type == RecordErased)
+   {
+      return in.atEnd();
+   }
+   if (type != RecordStored && type != RecordRefreshed)
+   {
+      return false;
+   }
+
+   unsigned int flags;
+   if (!in.getUInt64(document.mExpirationTime) ||
+       !in.getUInt64(document.mLastUpdated) ||
+       !in.getUInt64(document.mLingerTime) ||
+       !in.getUInt8(flags))
+   {
+      return false;
+   }
+   document.mExpirationTime = fromWallClock(document.mExpirationTime);
+   document.mLastUpdated = fromWallClock(document.mLastUpdated);
+   document.mLingerTime = fromWallClock(document.mLingerTime);
+   document.mSyncPublication = (flags & HasSync) != 0;
+   if (type == RecordRefreshed)
+   {
+      return in.atEnd();
+   }
+
+   if (flags & HasContents)
+   {
+      Data mimeType;
+      Data mimeSubType;
+      Data body;
+      if (!in.getString(mimeType) || !in.getString(mimeSubType) || !in.getString(body))
+      {
+         return false;
+      }
+      // body is in the log's buffer, which is about to go; the clone
+      // copies the text but leaves it unparsed
+      Contents* fromLog = Contents::createContents(Mime(mimeType, mimeSubType), body);
+      document.mContents.reset(fromLog->clone());
+      delete fromLog;
+   }
+
+   if (flags & HasSecurityAttributes)
+   {
+      unsigned int encrypted;
+      unsigned int signatureStatus;
+      unsigned int identityStrength;
+      Data signer;
+      Data identity;
+      if (!in.getUInt8(encrypted) || !in.getUInt8(signatureStatus) || !in.getUInt8(identityStrength) ||
+          !in.getString(signer) || !in.getString(identity))
+      {
+         return false;
+      }
+      document.mSecurityAttributes.reset(new SecurityAttributes);
+      if (encrypted)
+      {
+         document.mSecurityAttributes->setEncrypted();
+      }
+      document.mSecurityAttributes->setSignatureStatus((SignatureStatus)signatureStatus);
+      document.mSecurityAttributes->setIdentityStrength((SecurityAttributes::IdentityStrength)identityStrength);
+      document.mSecurityAttributes->setSigner(signer);
+      document.mSecurityAttributes->setIdentity(identity);
+   }
+   return in.atEnd();
+}
+
+}
+
+PersistentSyncPubDb::PersistentSyncPubDb(const Data& path, bool syncEnabled, unsigned int numShards, unsigned int flushIntervalMs) :
+   InMemorySyncPubDb(syncEnabled, numShards),
+   mPath(path),
+   mLoadedCount(0),
+   mLog(0),
+   mLogSize(0),
+   mCompactedSize(0),
+   mWriter(0)
+{
+   load();
+   if (flushIntervalMs > 0)
+   {
+      mWriter = new LogWriter(*this, flushIntervalMs);
+      mWriter->run();
+   }
+}
+
+PersistentSyncPubDb::~PersistentSyncPubDb()
+{
+   if (mWriter)
+   {
+      mWriter->shutdown();
+      mWriter->join();
+      delete mWriter;
+   }
+   Lock lock(mLogMutex);
+   flushLocked();
+   if (mLog)
+   {
+      fclose(mLog);
+   }
+}
+
+bool
+PersistentSyncPubDb::isLive(const PubDocument& document, UInt64 now) const
+{
+   return document.mExpirationTime > now || (mSyncEnabled && document.mLingerTime > now);
+}
+
+void
+PersistentSyncPubDb::load()
+{
+   Data image;
+   try
+   {
+      image = Data::fromFile(mPath);
+   }
+   catch (BaseException&)
+   {
+      InfoLog(<< "PersistentSyncPubDb: no publication log at " << mPath << ", starting empty");
+      compact();
+      return;
+   }
+
+   if (image.size() < LogMagicSize || memcmp(image.data(), LogMagic, LogMagicSize) != 0)
+   {
+      Data aside(mPath + ".bad");
+      ErrLog(<< "PersistentSyncPubDb: " << mPath << " is not a publication log, moving it to " << aside << " and starting empty");
+#ifdef WIN32
+      remove(aside.c_str());
+#endif
+      rename(mPath.c_str(), aside.c_str());
+      compact();
+      return;
+   }
+
+   UInt64 started = Timer::getTimeMs();
+   size_t records = 0;
+   bool torn = false;
+
+   // Nothing else can use the shards yet, so they aren't locked, and the
+   // handlers and onDocument...() aren't called.
+   RecordReader log(image.data() + LogMagicSize, image.data() + image.size());
+   while (!log.atEnd())
+   {
+      RecordReader record(0, 0);
+      unsigned int type;
+      PubDocument document;
+      if (!log.getRecord(record) || !decodeRecord(record, type, document))
+      {
+         torn = true;
+         break;
+      }
+      ++records;
+
+      Data mapKey = document.mEventType + document.mDocumentKey;
+      KeyToETagMap& documents = shardFor(mapKey).mDocuments;
+      if (type == RecordStored)
+      {
+         documents[mapKey][document.mETag] = document;
+      }
+      else if (type == RecordRefreshed)
+      {
+         KeyToETagMap::iterator keyIt = documents.find(mapKey);
+         if (keyIt != documents.end())
+         {
+            ETagToDocumentMap::iterator eTagIt = keyIt->second.find(document.mETag);
+            if (eTagIt != keyIt->second.end())
+            {
+               eTagIt->second.mExpirationTime = document.mExpirationTime;
+               eTagIt->second.mLastUpdated = document.mLastUpdated;
+               eTagIt->second.mLingerTime = document.mLingerTime;
+               eTagIt->second.mSyncPublication = document.mSyncPublication;
+            }
+         }
+      }
+      else
+      {
+         KeyToETagMap::iterator keyIt = documents.find(mapKey);
+         if (keyIt != documents.end())
+         {
+            keyIt->second.erase(document.mETag);
+            if (keyIt->second.empty())
+            {
+               documents.erase(keyIt);
+            }
+         }
+      }
+   }
+
+   // Drop what expired while we were down
+   UInt64 now = Timer::getTimeSecs();
+   for (std::vector<Shard*>::iterator shardIt = mShards.begin(); shardIt != mShards.end(); shardIt++)
+   {
+      KeyToETagMap& documents = (*shardIt)->mDocuments;
+      for (KeyToETagMap::iterator keyIt = documents.begin(); keyIt != documents.end(); )
+      {
+         for (ETagToDocumentMap::iterator eTagIt = keyIt->second.begin(); eTagIt != keyIt->second.end(); )
+         {
+            if (isLive(eTagIt->second, now))
+            {
+               ++mLoadedCount;
+               eTagIt++;
+            }
+            else
+            {
+               keyIt->second.erase(eTagIt++);
+            }
+         }
+         if (keyIt->second.empty())
+         {
+            documents.erase(keyIt++);
+         }
+         else
+         {
+            keyIt++;
+         }
+      }
+   }
+
+   InfoLog(<< "PersistentSyncPubDb: loaded " << mLoadedCount << " documents from " << records 
+           << " records in " << mPath << " in " << Timer::getTimeMs() - started << " ms");
+
+   if (torn)
+   {
+      // Anything appended after the damage would never be read
+      WarningLog(<< "PersistentSyncPubDb: " << mPath << " ends in an incomplete record, rewriting it");
+      compact();
+   }
+   else if (records > 2 * mLoadedCount + 1000)
+   {
+      compact();
+   }
+   else
+   {
+      Lock lock(mLogMutex);
+      openLog();
+      mCompactedSize = mLogSize;
+   }
+}
+
+bool
+PersistentSyncPubDb::openLog()
+{
+   mLog = fopen(mPath.c_str(), "ab");
+   if (mLog == 0)
+   {
+      ErrLog(<< "PersistentSyncPubDb: cannot open " << mPath << " for writing, publications will not be kept");
+      return false;
+   }
+   fseek(mLog, 0, SEEK_END);
+   mLogSize = ftell(mLog);
+   return true;
+}
+
+UInt64
+PersistentSyncPubDb::getLogSize() const
+{
+   Lock lock(mLogMutex);
+   return mLogSize;
+}
+
+void
+PersistentSyncPubDb::flush()
+{
+   Lock lock(mLogMutex);
+   flushLocked();
+}
+
+void
+PersistentSyncPubDb::flushLocked()
+{
+   Data pending;
+   {
+      Lock lock(mPendingMutex);
+      pending.takeBuf(mPending);
+   }
+   if (pending.empty() || mLog == 0)
+   {
+      return;
+   }
+   if (fwrite(pending.data(), 1, pending.size(), mLog) != pending.size() || !syncFile(mLog))
+   {
+      ErrLog(<< "PersistentSyncPubDb: writing to " << mPath << " failed: " << strerror(errno));
+   }
+   mLogSize += pending.size();
+}
+
+bool
+PersistentSyncPubDb::needsCompaction() const
+{
+   Lock lock(mLogMutex);
+   return mLogSize > 2 * mCompactedSize && mLogSize - mCompactedSize >= MinCompactBytes;
+}
+
+void
+PersistentSyncPubDb::compact()
+{
+   Lock lock(mLogMutex);
+   // Changes made while the shards are copied are left in mPending, to be
+   // appended to the new log.  Those made to a shard before it was copied
+   // are then replayed over its newer state, but each record holds the
+   // whole of a document, so the last one for each still wins.
+   flushLocked();
+
+   UInt64 started = Timer::getTimeMs();
+   UInt64 now = Timer::getTimeSecs();
+   size_t count = 0;
+   Data snapshot(LogMagic);
+   for (std::vector<Shard*>::iterator shardIt = mShards.begin(); shardIt != mShards.end(); shardIt++)
+   {
+      Lock g((*shardIt)->mMutex);
+      KeyToETagMap& documents = (*shardIt)->mDocuments;
+      for (KeyToETagMap::const_iterator keyIt = documents.begin(); keyIt != documents.end(); keyIt++)
+      {
+         for (ETagToDocumentMap::const_iterator eTagIt = keyIt->second.begin(); eTagIt != keyIt->second.end(); eTagIt++)
+         {
+            if (isLive(eTagIt->second, now))
+            {
+               encodeStored(snapshot, eTagIt->second);
+               ++count;
+            }
+         }
+      }
+   }
+
+   Data newPath(mPath + ".tmp");
+   FILE* out = fopen(newPath.c_str(), "wb");
+   bool written = out != 0 && fwrite(snapshot.data(), 1, snapshot.size(), out) == snapshot.size() && syncFile(out);
+   if (out != 0 && fclose(out) != 0)
+   {
+      written = false;
+   }
+   if (!written)
+   {
+      ErrLog(<< "PersistentSyncPubDb: writing " << newPath << " failed: " << strerror(errno) << ", keeping " << mPath);
+      remove(newPath.c_str());
+      if (mLog == 0)
+      {
+         openLog();
+      }
+      return;
+   }
+
+   if (mLog)
+   {
+      fclose(mLog);
+      mLog = 0;
+   }
+#ifdef WIN32
+   remove(mPath.c_str());
+#endif
+   if (rename(newPath.c_str(), mPath.c_str()) != 0)
+   {
+      ErrLog(<< "PersistentSyncPubDb: replacing " << mPath << " failed: " << strerror(errno));
+   }
+   openLog();
+   mCompactedSize = mLogSize;
+   InfoLog(<< "PersistentSyncPubDb: compacted " << mPath << " to " << count << " documents, " 
+           << mLogSize << " bytes, in " << Timer::getTimeMs() - started << " ms");
+}
+
+void
+PersistentSyncPubDb::encodeStored(Data& log, const PubDocument& document)
+{
+   size_t start = beginRecord(log, RecordStored);
+   putString(log, document.mEventType);
+   putString(log, document.mDocumentKey);
+   putString(log, document.mETag);
+   putUInt64(log, toWallClock(document.mExpirationTime));
+   putUInt64(log, toWallClock(document.mLastUpdated));
+   putUInt64(log, toWallClock(document.mLingerTime));
+   putUInt8(log, (document.mSyncPublication ? HasSync : 0) |
+                 (document.mContents.get() ? HasContents : 0) |
+                 (document.mSecurityAttributes.get() ? HasSecurityAttributes : 0));
+   if (document.mContents.get())
+   {
+      const Mime& type = document.mContents->getType();
+      putString(log, type.type());
+      putString(log, type.subType());
+      // a body not changed since it was received is written as it came,
+      // without parsing it
+      const HeaderFieldValue* body = document.mContents->getUnmodifiedHeaderField();
+      if (body)
+      {
+         putString(log, Data(Data::Share, body->getBuffer(), body->getLength()));
+      }
+      else
+      {
+         putString(log, document.mContents->getBodyData());
+      }
+   }
+   if (document.mSecurityAttributes.get())
+   {
+      const SecurityAttributes& security = *document.mSecurityAttributes;
+      putUInt8(log, security.isEncrypted() ? 1 : 0);
+      putUInt8(log, security.getSignatureStatus());
+      putUInt8(log, security.getIdentityStrength());
+      putString(log, security.getSigner());
+      putString(log, security.getIdentity());
+   }
+   endRecord(log, start);
+}
+
+void
+PersistentSyncPubDb::encodeErased(Data& log, const Data& eventType, const Data& documentKey, const Data& eTag)
+{
+   size_t start = beginRecord(log, RecordErased);
+   putString(log, eventType);
+   putString(log, documentKey);
+   putString(log, eTag);
+   endRecord(log, start);
+}
+
+void
+PersistentSyncPubDb::encodeRefreshed(Data& log, const PubDocument& document)
+{
+   size_t start = beginRecord(log, RecordRefreshed);
+   putString(log, document.mEventType);
+   putString(log, document.mDocumentKey);
+   putString(log, document.mETag);
+   putUInt64(log, toWallClock(document.mExpirationTime));
+   putUInt64(log, toWallClock(document.mLastUpdated));
+   putUInt64(log, toWallClock(document.mLingerTime));
+   putUInt8(log, document.mSyncPublication ? HasSync : 0);
+   endRecord(log, start);
+}
+
+void
+PersistentSyncPubDb::addHandler(InMemorySyncPubDbHandler* handler)
+{
+   InMemorySyncPubDb::addHandler(handler);
+   if (handler->getMode() != InMemorySyncPubDbHandler::AllChanges)
+   {
+      return;  // sync servers get the documents from initialSync()
+   }
+
+   UInt64 now = Timer::getTimeSecs();
+   for (std::vector<Shard*>::iterator shardIt = mShards.begin(); shardIt != mShards.end(); shardIt++)
+   {
+      Lock g((*shardIt)->mMutex);
+      KeyToETagMap& documents = (*shardIt)->mDocuments;
+      for (KeyToETagMap::const_iterator keyIt = documents.begin(); keyIt != documents.end(); keyIt++)
+      {
+         for (ETagToDocumentMap::const_iterator eTagIt = keyIt->second.begin(); eTagIt != keyIt->second.end(); eTagIt++)
+         {
+            const PubDocument& document = eTagIt->second;
+            if (document.mExpirationTime > now)
+            {
+               handler->onDocumentModified(true, document.mEventType, document.mDocumentKey, document.mETag, 
+                                           document.mExpirationTime, document.mLastUpdated, 
+                                           document.mContents.get(), document.mSecurityAttributes.get());
+            }
+         }
+      }
+   }
+}
+
+void
+PersistentSyncPubDb::onDocumentStored(const PubDocument& document)
+{
+   // encoded before taking the lock, which other shards share
+   Data record;
+   encodeStored(record, document);
+   Lock lock(mPendingMutex);
+   mPending.append(record.data(), record.size());
+}
+
+void
+PersistentSyncPubDb::onDocumentErased(const Data& eventType, const Data& documentKey, const Data& eTag)
+{
+   Data record;
+   encodeErased(record, eventType, documentKey, eTag);
+   Lock lock(mPendingMutex);
+   mPending.append(record.data(), record.size());
+}
+
+void
+PersistentSyncPubDb::onDocumentRefreshed(const PubDocument& document)
+{
+   Data record;
+   encodeRefreshed(record, document);
+   Lock lock(mPendingMutex);
+   mPending.append(record.data(), record.size());
+}
+
+PersistentSyncPubDb::LogWriter::LogWriter(PersistentSyncPubDb& db, unsigned int intervalMs) :
+   mDb(db),
+   mIntervalMs(intervalMs)
+{
+}
+
+void
+PersistentSyncPubDb::LogWriter::thread()
+{
+   while(!isShutdown())
+   {
+      waitForShutdown(mIntervalMs);
+      mDb.flush();
+      if (mDb.needsCompaction())
+      {
+         mDb.compact();
+      }
+   }
+}
+
+/* ====================================================================
+ * The Vovida Software License, Version 1.0
+ *
+ * Copyright (c) 2000 Vovida Networks, Inc.  All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ *
+ * 3. The names "VOCAL", "Vovida Open Communication Application Library",
+ *    and "Vovida Open Communication Application Library (VOCAL)" must
+ *    not be used to endorse or promote products derived from this
+ *    software without prior written permission. For written
+ *    permission, please contact vocal@vovida.org.
+ *
+ * 4. Products derived from this software may not be called "VOCAL", nor
+ *    may "VOCAL" appear in their name, without prior written
+ *    permission of Vovida Networks, Inc.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESSED OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE, TITLE AND
+ * NON-INFRINGEMENT ARE DISCLAIMED.  IN NO EVENT SHALL VOVIDA
+ * NETWORKS, INC. OR ITS CONTRIBUTORS BE LIABLE FOR ANY DIRECT DAMAGES
+ * IN EXCESS OF $1,000, NOR FOR ANY INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE
+ * USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+ * DAMAGE.
+ *
+ * ====================================================================
+ *
+ * This software consists of voluntary contributions made by Vovida
+ * Networks, Inc. and many individuals on behalf of Vovida Networks,
+ * Inc.  For more information on Vovida Networks, Inc., please see
+ * <http://www.vovida.org/>.
+ *
+ */
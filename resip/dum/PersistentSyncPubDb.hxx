@@ -0,0 +1,162 @@
+#if !defined(RESIP_PERSISTENTSYNCPUBDB_HXX)
+#define RESIP_PERSISTENTSYNCPUBDB_HXX
+
+#include <stdio.h>
+
+#include "resip/dum/InMemorySyncPubDb.hxx"
+#include "rutil/Data.hxx"
+#include "rutil/Mutex.hxx"
+#include "rutil/ThreadIf.hxx"
+
+namespace resip
+{
+
+/**
+  An InMemorySyncPubDb that keeps its documents in a log file as well, so
+  that they survive a restart: refreshes of publications made before the
+  restart then find their document, instead of failing and having every
+  client send its full document again at once.
+
+  The log is a sequence of binary records, each the whole state of one
+  document after a change, just the new times of one after a refresh
+  without a body, or the removal of one; bodies are stored as sent,
+  without the XML escaping of PubDocument::stream().  Changes are encoded
+  as they happen and written behind, by a thread that appends them to
+  the log and syncs it to disk every flushIntervalMs, so a crash loses at
+  most the changes of the last interval.  Once the log has grown to more than
+  twice its size after the last compaction (and by at least
+  MinCompactBytes), the same thread rewrites it with just the current
+  documents, taking each shard's lock only while that shard is copied.
+
+  On construction the log is read and replayed.  Bodies are not parsed
+  then; each document's Contents is parsed the first time it is used, as
+  a received body is.  A record cut short by a crash ends the replay.
+  The documents loaded have no ServerPublication to expire them, so each
+  AllChanges handler added later is told about every document stored, as
+  a sync'd publication; PresenceSubscriptionHandler then starts its
+  expiry checks for them as it does for publications from a peer.
+*/
+class PersistentSyncPubDb : public InMemorySyncPubDb
+{
+public:
+
+   /// Loads the documents in the log at path, if there is one.
+   /// flushIntervalMs of 0 starts no writer thread; flush() and compact()
+   /// must then be called by the application.
+   PersistentSyncPubDb(const Data& path, 
+                       bool syncEnabled = false, 
+                       unsigned int numShards = 0, 
+                       unsigned int flushIntervalMs = DefaultFlushIntervalMs);
+   /// Writes the changes not yet written.
+   virtual ~PersistentSyncPubDb();
+
+   /// Appends the changes not yet written to the log.
+   void flush();
+   /// Rewrites the log with just the current documents.
+   void compact();
+
+   /// Number of documents read from the log on construction.
+   size_t getLoadedCount() const { return mLoadedCount; }
+   /// Size of the log file, as of the last flush() or compact().
+   UInt64 getLogSize() const;
+
+   virtual void addHandler(InMemorySyncPubDbHandler* handler);
+
+   static const unsigned int DefaultFlushIntervalMs = 1000;
+   static const unsigned int MinCompactBytes = 1024 * 1024;
+
+protected:
+   virtual void onDocumentStored(const PubDocument& document);
+   virtual void onDocumentErased(const Data& eventType, const Data& documentKey, const Data& eTag);
+   virtual void onDocumentRefreshed(const PubDocument& document);
+
+private:
+   void load();
+   /// Whether document is still of use, and so worth writing out.
+   bool isLive(const PubDocument& document, UInt64 now) const;
+   bool openLog();
+   void flushLocked();
+   bool needsCompaction() const;
+
+   static void encodeStored(Data& log, const PubDocument& document);
+   static void encodeErased(Data& log, const Data& eventType, const Data& documentKey, const Data& eTag);
+   static void encodeRefreshed(Data& log, const PubDocument& document);
+
+   class LogWriter : public ThreadIf
+   {
+      public:
+         LogWriter(PersistentSyncPubDb& db, unsigned int intervalMs);
+         virtual void thread();
+
+      private:
+         PersistentSyncPubDb& mDb;
+         unsigned int mIntervalMs;
+   };
+
+   Data mPath;
+   size_t mLoadedCount;
+
+   Mutex mPendingMutex;  // taken with a shard locked; never the other way around
+   Data mPending;        // encoded changes not yet written
+
+   mutable Mutex mLogMutex;  // the file; held by flush() and compact()
+   FILE* mLog;
+   UInt64 mLogSize;
+   UInt64 mCompactedSize;
+
+   LogWriter* mWriter;
+};
+
+}
+
+#endif
+
+/* ====================================================================
+ * The Vovida Software License, Version 1.0
+ *
+ * Copyright (c) 2000 Vovida Networks, Inc.  All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ *
+ * 3. The names "VOCAL", "Vovida Open Communication Application Library",
+ *    and "Vovida Open Communication Application Library (VOCAL)" must
+ *    not be used to endorse or promote products derived from this
+ *    software without prior written permission. For written
+ *    permission, please contact vocal@vovida.org.
+ *
+ * 4. Products derived from this software may not be called "VOCAL", nor
+ *    may "VOCAL" appear in their name, without prior written
+ *    permission of Vovida Networks, Inc.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESSED OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE, TITLE AND
+ * NON-INFRINGEMENT ARE DISCLAIMED.  IN NO EVENT SHALL VOVIDA
+ * NETWORKS, INC. OR ITS CONTRIBUTORS BE LIABLE FOR ANY DIRECT DAMAGES
+ * IN EXCESS OF $1,000, NOR FOR ANY INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE
+ * USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+ * DAMAGE.
+ *
+ * ====================================================================
+ *
+ * This software consists of voluntary contributions made by Vovida
+ * Networks, Inc. and many individuals on behalf of Vovida Networks,
+ * Inc.  For more information on Vovida Networks, Inc., please see
+ * <http://www.vovida.org/>.
+ *
+ */
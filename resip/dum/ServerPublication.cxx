@@ -54,17 +54,19 @@ ServerPublication::getPublisher() const
 void
 ServerPublication::updateMatchingSubscriptions()
 {
-   Data key = mEventType + mDocumentKey;
-   std::pair<DialogUsageManager::ServerSubscriptions::iterator,DialogUsageManager::ServerSubscriptions::iterator> subs;
-   subs = mDum.mServerSubscriptions.equal_range(key);
+   std::vector<ServerSubscriptionHandle> subs;
+   mDum.getServerSubscriptions(mEventType, mDocumentKey, subs);
    
    ServerSubscriptionHandler* handler = mDum.getServerSubscriptionHandler(mEventType);
-   for (DialogUsageManager::ServerSubscriptions::iterator i=subs.first; i!=subs.second; ++i)
+   for (std::vector<ServerSubscriptionHandle>::iterator i = subs.begin(); i != subs.end(); ++i)
    {
-      handler->onPublished(i->second->getHandle(), 
-                           getHandle(), 
-                           mLastBody.mContents.get(), 
-                           mLastBody.mAttributes.get());
+      if (i->isValid())
+      {
+         handler->onPublished(*i, 
+                              getHandle(), 
+                              mLastBody.mContents.get(), 
+                              mLastBody.mAttributes.get());
+      }
    }
    mLastBody.mContents.reset();
    mLastBody.mAttributes.reset();
@@ -5,6 +5,7 @@
 #include "resip/dum/SubscriptionHandler.hxx"
 #include "resip/dum/UsageUseException.hxx"
 #include "resip/dum/MasterProfile.hxx"
+#include "resip/dum/NotifyFanout.hxx"
 #include "resip/stack/Helper.hxx"
 #include "rutil/Logger.hxx"
 
@@ -26,33 +27,23 @@ ServerSubscription::ServerSubscription(DialogUsageManager& dum,
    : BaseSubscription(dum, dialog, req),
      mSubscriber(req.header(h_From).uri().getAor()),
      mExpires(60),
-     mAbsoluteExpiry(0)
+     mAbsoluteExpiry(0),
+     mFanoutQueued(false),
+     mLastFanoutNotify(0)
 {
    if (req.header(h_RequestLine).method() == REFER && req.header(h_To).exists(p_tag))
    {
       // If this is an in-dialog REFER, then use a subscription id
       mSubscriptionId = Data(req.header(h_CSeq).sequence());
    }   
-   Data key = getEventType() + getDocumentKey();
-   mDum.mServerSubscriptions.insert(DialogUsageManager::ServerSubscriptions::value_type(key, this));
+   mDum.addServerSubscription(this);
 }
 
 ServerSubscription::~ServerSubscription()
 {
    DebugLog(<< "ServerSubscription::~ServerSubscription");
    
-   Data key = getEventType() + getDocumentKey();
-
-   std::pair<DialogUsageManager::ServerSubscriptions::iterator,DialogUsageManager::ServerSubscriptions::iterator> subs;
-   subs = mDum.mServerSubscriptions.equal_range(key);
-   for (DialogUsageManager::ServerSubscriptions::iterator i=subs.first; i!=subs.second; ++i)
-   {
-      if (i->second == this)
-      {
-         mDum.mServerSubscriptions.erase(i);
-         break;
-      }
-   }
+   mDum.removeServerSubscription(this);
    
    mDialog.mServerSubscriptions.remove(this);
 }
@@ -439,6 +430,21 @@ ServerSubscription::update(const Contents* document)
    return mLastRequest;
 }
 
+void
+ServerSubscription::sendFanoutNotify(const NotifyBody* body)
+{
+   makeNotify();
+   if (body)
+   {
+      body->applyTo(*mLastRequest);
+   }
+   else
+   {
+      mLastRequest->setContents(0);
+   }
+   send(mLastRequest);
+}
+
 SharedPtr<SipMessage>
 ServerSubscription::neutralNotify()
 {
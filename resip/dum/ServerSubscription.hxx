@@ -1,6 +1,8 @@
 #if !defined(RESIP_SERVERSUBSCRIPTION_HXX)
 #define RESIP_SERVERSUBSCRIPTION_HXX
 
+#include <list>
+
 #include "resip/stack/Helper.hxx"
 #include "resip/dum/BaseSubscription.hxx"
 
@@ -8,6 +10,7 @@ namespace resip
 {
 
 class DialogUsageManager;
+class NotifyBody;
 class ServerSubscriptionHandler;
 
 //!dcm! -- no Subscription State expires parameter generation yet. 
@@ -56,11 +59,14 @@ class ServerSubscription : public BaseSubscription
       
    private:
       friend class Dialog;
+      friend class DialogUsageManager;
+      friend class NotifyFanout;
       
       ServerSubscription(DialogUsageManager& dum, Dialog& dialog, const SipMessage& req);
 
       void makeNotifyExpires();
       void makeNotify();    
+      void sendFanoutNotify(const NotifyBody* body);
       
       bool shouldDestroyAfterSendingFailure(const SipMessage& msg);      
 
@@ -73,6 +79,15 @@ class ServerSubscription : public BaseSubscription
       ServerSubscription(const ServerSubscription&);
       ServerSubscription& operator=(const ServerSubscription&);
       UInt64 mAbsoluteExpiry;      
+
+      // position in DialogUsageManager::mServerSubscriptions
+      std::list<ServerSubscription*>::iterator mIndexPosition;
+
+      // NotifyFanout's state: the update waiting for this watcher, if any,
+      // and when it was last sent one (ms)
+      bool mFanoutQueued;
+      SharedPtr<NotifyBody> mFanoutBody;
+      UInt64 mLastFanoutNotify;
 };
  
 }
@@ -164,6 +164,12 @@ class TestInviteSessionHandler : public InviteSessionHandler
          InfoLog( << "TestInviteSessionHandler::onRefer" );
       }
 
+      virtual void onReferNoSub(InviteSessionHandle,
+                                const SipMessage& msg)
+      {
+         InfoLog( << "TestInviteSessionHandler::onReferNoSub" );
+      }
+
       virtual void onReferAccepted(InviteSessionHandle,
                                    ClientSubscriptionHandle,
                                    const SipMessage& msg)
@@ -0,0 +1,286 @@
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+#include "resip/stack/EventStackThread.hxx"
+#include "resip/stack/SdpContents.hxx"
+#include "resip/stack/SipStack.hxx"
+#include "resip/stack/Transport.hxx"
+#include "resip/dum/ClientInviteSession.hxx"
+#include "resip/dum/DialogUsageManager.hxx"
+#include "resip/dum/DumCommand.hxx"
+#include "resip/dum/DumPartitions.hxx"
+#include "resip/dum/DumThread.hxx"
+#include "resip/dum/MasterProfile.hxx"
+#include "resip/dum/ServerInviteSession.hxx"
+#include "rutil/Condition.hxx"
+#include "rutil/Lock.hxx"
+#include "rutil/Log.hxx"
+#include "rutil/Mutex.hxx"
+#include "rutil/Timer.hxx"
+
+#include "TestDumHandlers.hxx"
+
+using namespace resip;
+using namespace std;
+
+/*
+   Call-rate benchmark for partitioned DUM: a UAC places calls to a UAS
+   whose DUM is split into N partitions (see DumPartitions), keeping a
+   window of calls in progress. Each call is INVITE/200/ACK then a BYE
+   from the UAC. Every BYE must reach the partition that took the INVITE.
+   Both UAs listen on ephemeral ports on 127.0.0.1.  Being a benchmark,
+   it is built with the tests but not run by make check.
+
+   usage: testDumCallRate [partitions [calls [window]]]
+*/
+
+namespace
+{
+
+const char* sdpText =
+   "v=0\r\n"
+   "o=1900 369696545 369696545 IN IP4 127.0.0.1\r\n"
+   "s=-\r\n"
+   "c=IN IP4 127.0.0.1\r\n"
+   "t=0 0\r\n"
+   "m=audio 8000 RTP/AVP 0\r\n"
+   "a=rtpmap:0 PCMU/8000\r\n";
+
+// Answers every call; one per partition, so only its DUM's thread uses it.
+class Uas : public TestInviteSessionHandler
+{
+   public:
+      Uas() : mCalls(0), mByes(0) {}
+
+      using TestInviteSessionHandler::onNewSession;
+      virtual void onNewSession(ServerInviteSessionHandle sis, InviteSession::OfferAnswerType oat, const SipMessage& msg)
+      {
+         ++mCalls;
+      }
+
+      virtual void onOffer(InviteSessionHandle is, const SipMessage& msg, const SdpContents& sdp)
+      {
+         is->provideAnswer(sdp);
+         ServerInviteSession* sis = dynamic_cast<ServerInviteSession*>(is.get());
+         resip_assert(sis);
+         sis->accept();
+      }
+
+      virtual void onTerminated(InviteSessionHandle, InviteSessionHandler::TerminatedReason reason, const SipMessage* msg)
+      {
+         if (reason == InviteSessionHandler::RemoteBye)
+         {
+            ++mByes;
+         }
+      }
+
+      unsigned int mCalls;
+      unsigned int mByes;
+};
+
+// Places the calls, hanging each up once connected; runs on the UAC's DumThread.
+class Uac : public TestInviteSessionHandler
+{
+   public:
+      Uac(DialogUsageManager& dum, const NameAddr& target, unsigned int calls)
+         : mDum(dum), mTarget(target), mCalls(calls), mStarted(0), mEnded(0), mFailed(0)
+      {
+         HeaderFieldValue hfv(sdpText, (unsigned int)strlen(sdpText));
+         Mime type("application", "sdp");
+         mSdp = new SdpContents(hfv, type);
+         mSdp->checkParsed();
+      }
+
+      ~Uac()
+      {
+         delete mSdp;
+      }
+
+      void startCall()
+      {
+         ++mStarted;
+         mDum.send(mDum.makeInviteSession(mTarget, mSdp));
+      }
+
+      virtual void onConnected(ClientInviteSessionHandle cis, const SipMessage& msg)
+      {
+         cis->end();
+      }
+
+      virtual void onFailure(ClientInviteSessionHandle, const SipMessage& msg)
+      {
+         ++mFailed;
+      }
+
+      virtual void onTerminated(InviteSessionHandle, InviteSessionHandler::TerminatedReason reason, const SipMessage* msg)
+      {
+         if (mStarted < mCalls)
+         {
+            startCall();
+         }
+         Lock lock(mMutex);
+         if (++mEnded == mCalls)
+         {
+            mDone.signal();
+         }
+      }
+
+      bool waitUntilDone(unsigned int ms)
+      {
+         UInt64 end = Timer::getTimeMs() + ms;
+         Lock lock(mMutex);
+         while (mEnded < mCalls)
+         {
+            UInt64 now = Timer::getTimeMs();
+            if (now >= end)
+            {
+               return false;
+            }
+            mDone.wait(mMutex, (unsigned int)(end - now));
+         }
+         return true;
+      }
+
+      DialogUsageManager& mDum;
+      NameAddr mTarget;
+      unsigned int mCalls;
+      unsigned int mStarted;
+      unsigned int mEnded;
+      unsigned int mFailed;
+      SdpContents* mSdp;
+      Mutex mMutex;
+      Condition mDone;
+};
+
+class StartCallsCommand : public DumCommandAdapter
+{
+   public:
+      StartCallsCommand(Uac& uac, unsigned int window) : mUac(uac), mWindow(window) {}
+      virtual void executeCommand()
+      {
+         for (unsigned int i = 0; i < mWindow && mUac.mStarted < mUac.mCalls; ++i)
+         {
+            mUac.startCall();
+         }
+      }
+      virtual EncodeStream& encodeBrief(EncodeStream& strm) const
+      {
+         return strm << "StartCallsCommand";
+      }
+   private:
+      Uac& mUac;
+      unsigned int mWindow;
+};
+
+SharedPtr<MasterProfile>
+makeProfile(const char* from)
+{
+   SharedPtr<MasterProfile> profile(new MasterProfile);
+   profile->setDefaultFrom(NameAddr(from));
+   return profile;
+}
+
+double
+runCalls(unsigned int partitions, unsigned int calls, unsigned int window)
+{
+   // UAS: one stack, one DUM per partition
+   EventStackSimpleMgr uasMgr(0);
+   SipStackOptions uasOptions;
+   SipStack& uasStack = uasMgr.createStack(uasOptions);
+   Transport* uasTransport = uasStack.addTransport(UDP, 0, V4, StunDisabled, "127.0.0.1");
+
+   SharedPtr<MasterProfile> uasProfile = makeProfile("sip:uas@127.0.0.1");
+   vector<DialogUsageManager*> uasDums;
+   vector<Uas*> uasHandlers;
+   for (unsigned int i = 0; i < partitions; ++i)
+   {
+      DialogUsageManager* dum = new DialogUsageManager(uasStack);
+      dum->setMasterProfile(uasProfile);
+      Uas* handler = new Uas;
+      dum->setInviteSessionHandler(handler);
+      uasDums.push_back(dum);
+      uasHandlers.push_back(handler);
+   }
+   DumPartitions uasPartitions(uasDums);
+
+   // UAC: a single DUM
+   EventStackSimpleMgr uacMgr(0);
+   SipStackOptions uacOptions;
+   SipStack& uacStack = uacMgr.createStack(uacOptions);
+   uacStack.addTransport(UDP, 0, V4, StunDisabled, "127.0.0.1");
+
+   DialogUsageManager* uacDum = new DialogUsageManager(uacStack);
+   uacDum->setMasterProfile(makeProfile("sip:uac@127.0.0.1"));
+   Uac uac(*uacDum, NameAddr("sip:uas@127.0.0.1:" + Data(uasTransport->port())), calls);
+   uacDum->setInviteSessionHandler(&uac);
+   DumThread uacDumThread(*uacDum);
+
+   uasPartitions.run();
+   uasMgr.getThread().run();
+   uacDumThread.run();
+   uacMgr.getThread().run();
+
+   UInt64 start = Timer::getTimeMs();
+   uacDum->post(new StartCallsCommand(uac, window));
+   bool done = uac.waitUntilDone(120000);
+   UInt64 elapsed = Timer::getTimeMs() - start;
+
+   uacDumThread.shutdown();
+   uacDumThread.join();
+   uasPartitions.shutdown();
+   uasPartitions.join();
+   uacMgr.getThread().shutdown();
+   uacMgr.getThread().join();
+   uasMgr.getThread().shutdown();
+   uasMgr.getThread().join();
+
+   assert(done);
+   assert(uac.mFailed == 0);
+   unsigned int answered = 0;
+   unsigned int byes = 0;
+   for (unsigned int i = 0; i < partitions; ++i)
+   {
+      // dialog sets are spread over all the partitions, and each gets
+      // the BYEs for the calls it answered
+      assert(uasHandlers[i]->mCalls > 0 || calls < partitions * 10);
+      assert(uasHandlers[i]->mByes == uasHandlers[i]->mCalls);
+      answered += uasHandlers[i]->mCalls;
+      byes += uasHandlers[i]->mByes;
+   }
+   assert(answered == calls);
+   assert(byes == calls);
+
+   delete uacDum;
+   for (unsigned int i = 0; i < partitions; ++i)
+   {
+      delete uasDums[i];
+      delete uasHandlers[i];
+   }
+
+   return double(calls) * 1000 / (elapsed ? elapsed : 1);
+}
+
+}
+
+int
+main(int argc, char* argv[])
+{
+   Log::initialize(Log::Cout, Log::Warning, argv[0]);
+
+   unsigned int partitions = argc > 1 ? atoi(argv[1]) : 4;
+   unsigned int calls = argc > 2 ? atoi(argv[2]) : 2000;
+   unsigned int window = argc > 3 ? atoi(argv[3]) : 50;
+
+   double single = runCalls(1, calls, window);
+   cout << "1 partition: " << (unsigned long)single << " calls/s" << endl;
+   if (partitions > 1)
+   {
+      double partitioned = runCalls(partitions, calls, window);
+      cout << partitions << " partitions: " << (unsigned long)partitioned << " calls/s" << endl;
+   }
+
+   cout << "All OK" << endl;
+   return 0;
+}
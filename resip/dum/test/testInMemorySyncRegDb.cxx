@@ -0,0 +1,290 @@
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+#include "resip/dum/InMemorySyncRegDb.hxx"
+#include "resip/stack/NameAddr.hxx"
+#include "rutil/ThreadIf.hxx"
+#include "rutil/Time.hxx"
+#include "rutil/Timer.hxx"
+
+using namespace resip;
+using namespace std;
+
+namespace
+{
+
+Uri
+makeAor(unsigned int i)
+{
+   return Uri("sip:user" + Data(i) + "@example.com");
+}
+
+ContactInstanceRecord
+makeContact(unsigned int i, UInt64 expires)
+{
+   ContactInstanceRecord rec;
+   rec.mContact = NameAddr("sip:user" + Data(i) + "@192.0.2.1:5060");
+   rec.mRegExpires = expires;
+   rec.mLastUpdated = Timer::getTimeSecs();
+   return rec;
+}
+
+class CountingHandler : public InMemorySyncRegDbHandler
+{
+   public:
+      CountingHandler() : InMemorySyncRegDbHandler(AllChanges), mModified(0) {}
+      virtual void onAorModified(const Uri& aor, const ContactList& contacts) { ++mModified; }
+      unsigned int mModified;
+};
+
+void
+testBasics()
+{
+   InMemorySyncRegDb db(0, 4);
+   CountingHandler handler;
+   db.addHandler(&handler);
+   UInt64 expires = Timer::getTimeSecs() + 3600;
+
+   Uri aor("sip:alice@Example.COM");
+   db.lockRecord(aor);
+   assert(db.updateContact(aor, makeContact(1, expires)) == RegistrationPersistenceManager::CONTACT_CREATED);
+   assert(db.updateContact(aor, makeContact(1, expires)) == RegistrationPersistenceManager::CONTACT_UPDATED);
+   assert(db.updateContact(aor, makeContact(2, expires)) == RegistrationPersistenceManager::CONTACT_CREATED);
+   db.unlockRecord(aor);
+
+   // host compares case insensitively, as it did in the std::map
+   ContactList contacts;
+   db.getContacts(Uri("sip:alice@example.com"), contacts);
+   assert(contacts.size() == 2);
+   assert(db.aorIsRegistered(Uri("sip:alice@example.com")));
+   assert(!db.aorIsRegistered(Uri("sip:alice@example.com:5070")));
+   assert(!db.aorIsRegistered(Uri("sip:Alice@example.com")));
+
+   // removal while locked keeps the record until unlock
+   db.lockRecord(aor);
+   db.removeContact(aor, makeContact(1, expires));
+   db.removeContact(aor, makeContact(2, expires));
+   assert(!db.aorIsRegistered(aor));
+   InMemorySyncRegDb::UriList aors;
+   db.getAors(aors);
+   assert(aors.size() == 1);
+   db.unlockRecord(aor);
+   db.getAors(aors);
+   assert(aors.empty());
+
+   // removal without a lock takes effect at once
+   for (unsigned int i = 0; i < 100; ++i)
+   {
+      ContactList list;
+      list.push_back(makeContact(i, expires));
+      db.addAor(makeAor(i), list);
+   }
+   db.getAors(aors);
+   assert(aors.size() == 100);
+   db.removeAor(makeAor(7));
+   db.getAors(aors);
+   assert(aors.size() == 99);
+   db.getContacts(makeAor(7), contacts);
+   assert(contacts.empty());
+   db.getContacts(makeAor(8), contacts);
+   assert(contacts.size() == 1);
+
+   assert(handler.mModified == 3 + 2 + 100 + 1);
+   db.removeHandler(&handler);
+}
+
+void
+testExpiry()
+{
+   UInt64 now = Timer::getTimeSecs();
+   {
+      InMemorySyncRegDb db(0, 1);
+      CountingHandler handler;
+      db.addHandler(&handler);
+
+      Uri aor("sip:bob@example.com");
+      db.updateContact(aor, makeContact(1, now - 1));
+      db.updateContact(aor, makeContact(2, now + 3600));
+      db.updateContact(Uri("sip:carol@example.com"), makeContact(3, now - 1));
+      db.updateContact(Uri("sip:static@example.com"), makeContact(4, NeverExpire));
+      handler.mModified = 0;
+
+      assert(db.purgeExpired() == 2);
+      assert(handler.mModified == 2);
+      ContactList contacts;
+      db.getContacts(aor, contacts);
+      assert(contacts.size() == 1);
+      InMemorySyncRegDb::UriList aors;
+      db.getAors(aors);
+      assert(aors.size() == 2);
+      assert(db.purgeExpired() == 0);
+
+      // a refresh before expiry keeps the contact
+      db.updateContact(aor, makeContact(5, now - 1));
+      db.updateContact(aor, makeContact(5, now + 3600));
+      assert(db.purgeExpired() == 1);  // examined, and rescheduled
+      db.getContacts(aor, contacts);
+      assert(contacts.size() == 2);
+
+      // batches are bounded per shard
+      for (unsigned int i = 0; i < 250; ++i)
+      {
+         db.updateContact(makeAor(i), makeContact(i, now - 1));
+      }
+      assert(db.purgeExpired(100) == 100);
+      assert(db.purgeExpired(100) == 100);
+      assert(db.purgeExpired(100) == 50);
+      db.getAors(aors);
+      assert(aors.size() == 2);
+      db.removeHandler(&handler);
+   }
+   {
+      // removed contacts linger, then go
+      InMemorySyncRegDb db(10, 1);
+      Uri aor("sip:dave@example.com");
+      db.updateContact(aor, makeContact(1, now + 3600));
+      ContactInstanceRecord old = makeContact(2, now - 100);
+      old.mLastUpdated = now - 100;
+      db.updateContact(aor, old);
+      db.removeContact(aor, makeContact(1, now + 3600));
+      assert(db.purgeExpired() == 1);
+      ContactList contacts;
+      db.getContactsFull(aor, contacts);
+      assert(contacts.size() == 1);
+      assert(!db.aorIsRegistered(aor));
+
+      // and the sweeper finds them without being asked
+      db.updateContact(Uri("sip:erin@example.com"), old);
+      db.startExpirySweeper(10, 10);
+      InMemorySyncRegDb::UriList aors;
+      for (int i = 0; i < 100; ++i)
+      {
+         db.getAors(aors);
+         if (aors.size() == 1)
+         {
+            break;
+         }
+         sleepMs(10);
+      }
+      assert(aors.size() == 1);
+      db.stopExpirySweeper();
+   }
+}
+
+// Registrars lock, update and unlock; proxies only read.
+class Worker : public ThreadIf
+{
+   public:
+      // Uri caches its canonical host on first comparison, so each
+      // worker looks up its own copies.
+      Worker(InMemorySyncRegDb& db, unsigned int id, const vector<Uri>& aors,
+             unsigned int ops, unsigned int writePercent)
+         : mDb(db), mId(id), mAors(aors), mOps(ops), mWritePercent(writePercent)
+      {}
+
+      virtual void thread()
+      {
+         UInt64 expires = Timer::getTimeSecs() + 3600;
+         unsigned int seed = mId * 2654435761u + 1;
+         ContactList contacts;
+         for (unsigned int i = 0; i < mOps; ++i)
+         {
+            seed = seed * 1103515245 + 12345;
+            const Uri& aor = mAors[(seed >> 8) % mAors.size()];
+            if ((seed >> 4) % 100 < mWritePercent)
+            {
+               mDb.lockRecord(aor);
+               mDb.updateContact(aor, makeContact(mId, expires));
+               mDb.unlockRecord(aor);
+            }
+            else
+            {
+               mDb.getContacts(aor, contacts);
+            }
+         }
+      }
+
+   private:
+      InMemorySyncRegDb& mDb;
+      unsigned int mId;
+      vector<Uri> mAors;
+      unsigned int mOps;
+      unsigned int mWritePercent;
+};
+
+double
+runContention(unsigned int numShards, unsigned int numThreads, const vector<Uri>& aorList,
+              unsigned int opsPerThread, unsigned int writePercent)
+{
+   unsigned int numAors = (unsigned int)aorList.size();
+   InMemorySyncRegDb db(0, numShards);
+   UInt64 expires = Timer::getTimeSecs() + 3600;
+   for (unsigned int i = 0; i < numAors; ++i)
+   {
+      ContactList list;
+      list.push_back(makeContact(i, expires));
+      db.addAor(aorList[i], list);
+   }
+
+   vector<Worker*> workers;
+   for (unsigned int i = 0; i < numThreads; ++i)
+   {
+      workers.push_back(new Worker(db, i, aorList, opsPerThread, writePercent));
+   }
+   UInt64 start = Timer::getTimeMs();
+   for (unsigned int i = 0; i < numThreads; ++i)
+   {
+      workers[i]->run();
+   }
+   for (unsigned int i = 0; i < numThreads; ++i)
+   {
+      workers[i]->join();
+      delete workers[i];
+   }
+   UInt64 elapsed = Timer::getTimeMs() - start;
+
+   // every AOR still has its original contact plus at most one per writer
+   InMemorySyncRegDb::UriList aors;
+   db.getAors(aors);
+   assert(aors.size() == numAors);
+   ContactList contacts;
+   db.getContacts(aorList[0], contacts);
+   assert(contacts.size() >= 1 && contacts.size() <= numThreads + 1);
+
+   return double(numThreads) * opsPerThread * 1000 / (elapsed ? elapsed : 1);
+}
+
+}
+
+int
+main(int argc, char* argv[])
+{
+   testBasics();
+   testExpiry();
+
+   // usage: testInMemorySyncRegDb [numAors [opsPerThread [writePercent]]]
+   unsigned int numAors = argc > 1 ? atoi(argv[1]) : 20000;
+   unsigned int opsPerThread = argc > 2 ? atoi(argv[2]) : 20000;
+   unsigned int writePercent = argc > 3 ? atoi(argv[3]) : 20;
+
+   vector<Uri> aors;
+   for (unsigned int i = 0; i < numAors; ++i)
+   {
+      aors.push_back(makeAor(i));
+   }
+
+   cout << numAors << " AORs, " << opsPerThread << " operations per thread, "
+        << writePercent << "% lock/update/unlock" << endl;
+   const unsigned int threadCounts[] = { 1, 2, 4, 8 };
+   for (unsigned int t = 0; t < sizeof(threadCounts) / sizeof(threadCounts[0]); ++t)
+   {
+      double single = runContention(1, threadCounts[t], aors, opsPerThread, writePercent);
+      double sharded = runContention(InMemorySyncRegDb::DefaultShards, threadCounts[t], aors, opsPerThread, writePercent);
+      cout << threadCounts[t] << " threads: 1 shard " << (unsigned long)single << " ops/s, "
+           << InMemorySyncRegDb::DefaultShards << " shards " << (unsigned long)sharded << " ops/s" << endl;
+   }
+
+   cout << "All OK" << endl;
+   return 0;
+}
@@ -0,0 +1,348 @@
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+#include "resip/stack/EventStackThread.hxx"
+#include "resip/stack/PlainContents.hxx"
+#include "resip/stack/SipStack.hxx"
+#include "resip/stack/Transport.hxx"
+#include "resip/dum/ClientSubscription.hxx"
+#include "resip/dum/DialogUsageManager.hxx"
+#include "resip/dum/DumCommand.hxx"
+#include "resip/dum/DumThread.hxx"
+#include "resip/dum/MasterProfile.hxx"
+#include "resip/dum/NotifyFanout.hxx"
+#include "resip/dum/ServerSubscription.hxx"
+#include "resip/dum/SubscriptionHandler.hxx"
+#include "rutil/Condition.hxx"
+#include "rutil/Lock.hxx"
+#include "rutil/Log.hxx"
+#include "rutil/Mutex.hxx"
+#include "rutil/Time.hxx"
+#include "rutil/Timer.hxx"
+
+using namespace resip;
+using namespace std;
+
+/*
+   Fan-out benchmark for NotifyFanout: a watcher UA holds many presence
+   subscriptions to one resource on a notifier UA, and the notifier sends
+   changes to the resource's document to all of them, first a NOTIFY per
+   watcher from a single command (update() and send()), then through
+   NotifyFanout. For each, reports how long the notifier's DUM thread was
+   held up, and how long until every watcher had the change. Also checks
+   that NotifyFanout coalesces changes under a minimum interval.  Both UAs
+   listen on ephemeral ports on 127.0.0.1.  The default, a few dozen
+   watchers, keeps the check quick enough for every test run; give a
+   larger count, say 1000, to benchmark.
+
+   usage: testNotifyFanout [watchers [batchSize]]
+*/
+
+namespace
+{
+
+const char* Event = "presence";
+
+// Accepts every subscription.
+class Notifier : public ServerSubscriptionHandler
+{
+   public:
+      virtual void onNewSubscription(ServerSubscriptionHandle h, const SipMessage& sub)
+      {
+         h->setSubscriptionState(Active);
+         h->send(h->accept(200));
+         h->send(h->neutralNotify());
+      }
+
+      virtual void onTerminated(ServerSubscriptionHandle)
+      {
+      }
+};
+
+// Records the last document each subscription got.
+class Watchers : public ClientSubscriptionHandler
+{
+   public:
+      Watchers() : mActive(0), mNotifies(0) {}
+
+      virtual void onUpdatePending(ClientSubscriptionHandle h, const SipMessage& notify, bool outOfOrder)
+      {
+         h->acceptUpdate();
+      }
+
+      virtual void onUpdateActive(ClientSubscriptionHandle h, const SipMessage& notify, bool outOfOrder)
+      {
+         h->acceptUpdate();
+         Data text;
+         PlainContents* plain = dynamic_cast<PlainContents*>(notify.getContents());
+         if (plain)
+         {
+            text = plain->text();
+         }
+         Lock lock(mMutex);
+         ++mNotifies;
+         const Data& callId = notify.header(h_CallId).value();
+         if (mLast.find(callId) == mLast.end())
+         {
+            ++mActive;
+         }
+         mLast[callId] = text;
+         mChanged.signal();
+      }
+
+      virtual void onUpdateExtension(ClientSubscriptionHandle h, const SipMessage& notify, bool outOfOrder)
+      {
+         h->acceptUpdate();
+      }
+
+      virtual int onRequestRetry(ClientSubscriptionHandle, int retrySeconds, const SipMessage& notify)
+      {
+         return -1;
+      }
+
+      virtual void onTerminated(ClientSubscriptionHandle, const SipMessage* msg)
+      {
+      }
+
+      virtual void onNewSubscription(ClientSubscriptionHandle, const SipMessage& notify)
+      {
+      }
+
+      // waits for that many subscriptions, or, if text is given, for that
+      // many to have text as their document
+      bool waitFor(unsigned int watchers, const Data& text, unsigned int ms)
+      {
+         UInt64 end = Timer::getTimeMs() + ms;
+         Lock lock(mMutex);
+         while (text.empty() ? mActive < watchers : countWith(text) < watchers)
+         {
+            UInt64 now = Timer::getTimeMs();
+            if (now >= end)
+            {
+               return false;
+            }
+            mChanged.wait(mMutex, (unsigned int)(end - now));
+         }
+         return true;
+      }
+
+      unsigned int notifies()
+      {
+         Lock lock(mMutex);
+         return mNotifies;
+      }
+
+   private:
+      unsigned int countWith(const Data& text) const
+      {
+         unsigned int count = 0;
+         for (HashMap<Data, Data>::const_iterator i = mLast.begin(); i != mLast.end(); ++i)
+         {
+            if (i->second == text)
+            {
+               ++count;
+            }
+         }
+         return count;
+      }
+
+      Mutex mMutex;
+      Condition mChanged;
+      HashMap<Data, Data> mLast;
+      unsigned int mActive;
+      unsigned int mNotifies;
+};
+
+class SubscribeCommand : public DumCommandAdapter
+{
+   public:
+      SubscribeCommand(DialogUsageManager& dum, const NameAddr& target, unsigned int count)
+         : mDum(dum), mTarget(target), mCount(count) {}
+      virtual void executeCommand()
+      {
+         for (unsigned int i = 0; i < mCount; ++i)
+         {
+            mDum.send(mDum.makeSubscription(mTarget, Event, 3600));
+         }
+      }
+      virtual EncodeStream& encodeBrief(EncodeStream& strm) const
+      {
+         return strm << "SubscribeCommand";
+      }
+   private:
+      DialogUsageManager& mDum;
+      NameAddr mTarget;
+      unsigned int mCount;
+};
+
+// NOTIFYs text to the resource's watchers, and times itself.
+class ChangeCommand : public DumCommandAdapter
+{
+   public:
+      ChangeCommand(DialogUsageManager& dum, const Data& resource, const Data& text, bool fanout, UInt64& elapsed)
+         : mDum(dum), mResource(resource), mText(text), mFanout(fanout), mElapsed(elapsed) {}
+      virtual void executeCommand()
+      {
+         UInt64 start = Timer::getTimeMicroSec();
+         PlainContents document(mText);
+         if (mFanout)
+         {
+            mDum.getNotifyFanout().notify(Event, mResource, &document);
+         }
+         else
+         {
+            vector<ServerSubscriptionHandle> watchers;
+            mDum.getServerSubscriptions(Event, mResource, watchers);
+            for (vector<ServerSubscriptionHandle>::iterator i = watchers.begin(); i != watchers.end(); ++i)
+            {
+               (*i)->send((*i)->update(&document));
+            }
+         }
+         mElapsed = Timer::getTimeMicroSec() - start;
+      }
+      virtual EncodeStream& encodeBrief(EncodeStream& strm) const
+      {
+         return strm << "ChangeCommand";
+      }
+   private:
+      DialogUsageManager& mDum;
+      Data mResource;
+      Data mText;
+      bool mFanout;
+      UInt64& mElapsed;
+};
+
+// Changes NotifyFanout's settings from the DUM thread, which owns it.
+class MinIntervalCommand : public DumCommandAdapter
+{
+   public:
+      MinIntervalCommand(DialogUsageManager& dum, unsigned int ms) : mDum(dum), mMs(ms) {}
+      virtual void executeCommand()
+      {
+         mDum.getNotifyFanout().setMinInterval(mMs);
+      }
+      virtual EncodeStream& encodeBrief(EncodeStream& strm) const
+      {
+         return strm << "MinIntervalCommand";
+      }
+   private:
+      DialogUsageManager& mDum;
+      unsigned int mMs;
+};
+
+SharedPtr<MasterProfile>
+makeProfile(const char* from)
+{
+   SharedPtr<MasterProfile> profile(new MasterProfile);
+   profile->setDefaultFrom(NameAddr(from));
+   profile->addSupportedMethod(SUBSCRIBE);
+   profile->addSupportedMethod(NOTIFY);
+   profile->addAllowedEvent(Token(Event));
+   profile->addSupportedMimeType(NOTIFY, PlainContents::getStaticType());
+   return profile;
+}
+
+}
+
+int
+main(int argc, char* argv[])
+{
+   Log::initialize(Log::Cout, Log::Warning, argv[0]);
+
+   unsigned int watcherCount = argc > 1 ? atoi(argv[1]) : 50;
+   unsigned int batchSize = argc > 2 ? atoi(argv[2]) : NotifyFanout::DefaultBatchSize;
+
+   EventStackSimpleMgr notifierMgr(0);
+   SipStackOptions notifierOptions;
+   SipStack& notifierStack = notifierMgr.createStack(notifierOptions);
+   Transport* notifierTransport = notifierStack.addTransport(UDP, 0, V4, StunDisabled, "127.0.0.1");
+   // the document key is the AOR the watchers subscribe to
+   const Data resource("presentity@127.0.0.1:" + Data(notifierTransport->port()));
+   DialogUsageManager* notifierDum = new DialogUsageManager(notifierStack);
+   notifierDum->setMasterProfile(makeProfile("sip:presentity@127.0.0.1"));
+   Notifier notifier;
+   notifierDum->addServerSubscriptionHandler(Event, &notifier);
+   notifierDum->getNotifyFanout().setBatchSize(batchSize);
+   DumThread notifierDumThread(*notifierDum);
+
+   EventStackSimpleMgr watcherMgr(0);
+   SipStackOptions watcherOptions;
+   SipStack& watcherStack = watcherMgr.createStack(watcherOptions);
+   watcherStack.addTransport(UDP, 0, V4, StunDisabled, "127.0.0.1");
+   DialogUsageManager* watcherDum = new DialogUsageManager(watcherStack);
+   watcherDum->setMasterProfile(makeProfile("sip:watcher@127.0.0.1"));
+   Watchers watchers;
+   watcherDum->addClientSubscriptionHandler(Event, &watchers);
+   DumThread watcherDumThread(*watcherDum);
+
+   notifierDumThread.run();
+   notifierMgr.getThread().run();
+   watcherDumThread.run();
+   watcherMgr.getThread().run();
+
+   watcherDum->post(new SubscribeCommand(*watcherDum, NameAddr("sip:" + resource), watcherCount));
+   if (!watchers.waitFor(watcherCount, Data::Empty, 60000))
+   {
+      cerr << "FAILED: not every watcher subscribed" << endl;
+      return 1;
+   }
+   cout << watcherCount << " watchers subscribed" << endl;
+
+   // one NOTIFY per watcher, all from one command
+   UInt64 stall = 0;
+   UInt64 start = Timer::getTimeMs();
+   notifierDum->post(new ChangeCommand(*notifierDum, resource, "one", false, stall));
+   if (!watchers.waitFor(watcherCount, "one", 60000))
+   {
+      cerr << "FAILED: not every watcher got the update() NOTIFY" << endl;
+      return 1;
+   }
+   cout << "update() per watcher: DUM thread held " << stall / 1000 << " ms, all watchers notified in "
+        << Timer::getTimeMs() - start << " ms" << endl;
+
+   // through NotifyFanout
+   start = Timer::getTimeMs();
+   notifierDum->post(new ChangeCommand(*notifierDum, resource, "two", true, stall));
+   if (!watchers.waitFor(watcherCount, "two", 60000))
+   {
+      cerr << "FAILED: not every watcher got the NotifyFanout NOTIFY" << endl;
+      return 1;
+   }
+   cout << "NotifyFanout (batches of " << batchSize << "): DUM thread held " << stall / 1000
+        << " ms queueing, all watchers notified in " << Timer::getTimeMs() - start << " ms" << endl;
+
+   // changes within the minimum interval coalesce
+   notifierDum->post(new MinIntervalCommand(*notifierDum, 1000));
+   sleepMs(1000);
+   unsigned int before = watchers.notifies();
+   notifierDum->post(new ChangeCommand(*notifierDum, resource, "three", true, stall));
+   notifierDum->post(new ChangeCommand(*notifierDum, resource, "four", true, stall));
+   notifierDum->post(new ChangeCommand(*notifierDum, resource, "five", true, stall));
+   if (!watchers.waitFor(watcherCount, "five", 60000))
+   {
+      cerr << "FAILED: not every watcher got the last coalesced change" << endl;
+      return 1;
+   }
+   unsigned int sent = watchers.notifies() - before;
+   cout << "3 changes within the minimum interval: " << sent << " NOTIFYs" << endl;
+   if (sent < watcherCount || sent > 2 * watcherCount)
+   {
+      cerr << "FAILED: changes within the minimum interval were not coalesced" << endl;
+      return 1;
+   }
+
+   watcherDumThread.shutdown();
+   watcherDumThread.join();
+   notifierDumThread.shutdown();
+   notifierDumThread.join();
+   watcherMgr.getThread().shutdown();
+   watcherMgr.getThread().join();
+   notifierMgr.getThread().shutdown();
+   notifierMgr.getThread().join();
+   delete watcherDum;
+   delete notifierDum;
+
+   cout << "All OK" << endl;
+   return 0;
+}
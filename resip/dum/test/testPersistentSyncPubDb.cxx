@@ -0,0 +1,496 @@
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+#if defined(__GLIBC__)
+#include <malloc.h>
+#endif
+
+#include "resip/dum/PersistentSyncPubDb.hxx"
+#include "resip/stack/GenericPidfContents.hxx"
+#include "resip/stack/PlainContents.hxx"
+#include "resip/stack/SecurityAttributes.hxx"
+#include "rutil/DataStream.hxx"
+#include "rutil/Log.hxx"
+#include "rutil/ParseBuffer.hxx"
+#include "rutil/ThreadIf.hxx"
+#include "rutil/Timer.hxx"
+#include "rutil/XMLCursor.hxx"
+
+using namespace resip;
+using namespace std;
+
+/*
+   Checks that PersistentSyncPubDb keeps its documents over a restart,
+   then benchmarks a restart with many presence documents: how long the
+   log takes to load, how big it is, and the memory the documents take,
+   compared with the XML that PubDocument::stream() writes for RegSync.
+
+   usage: testPersistentSyncPubDb [documents]
+*/
+
+namespace
+{
+
+const char* LogPath = "testPersistentSyncPubDb.log";
+const Data Presence("presence");
+
+typedef PublicationPersistenceManager::PubDocument PubDocument;
+
+// Joins the documents' text, so a test can see which were merged.
+class TextMerger : public PublicationPersistenceManager::ETagMerger
+{
+   public:
+      virtual bool mergeETag(Contents* eTagDest, Contents* eTagSrc, bool isFirst)
+      {
+         PlainContents* dest = dynamic_cast<PlainContents*>(eTagDest);
+         const PlainContents* src = dynamic_cast<const PlainContents*>(eTagSrc);
+         assert(dest && src);
+         if (!isFirst)
+         {
+            dest->text() += "+";
+         }
+         dest->text() += src->text();
+         return true;
+      }
+};
+
+// Reads each document's presence, which parses it.
+class PresenceReader : public PublicationPersistenceManager::ETagMerger
+{
+   public:
+      PresenceReader() : mOnline(0) {}
+      virtual bool mergeETag(Contents* eTagDest, Contents* eTagSrc, bool isFirst)
+      {
+         GenericPidfContents* pidf = dynamic_cast<GenericPidfContents*>(eTagSrc);
+         assert(pidf);
+         if (pidf->getSimplePresenceOnline())
+         {
+            ++mOnline;
+         }
+         return true;
+      }
+      unsigned int mOnline;
+};
+
+Data
+merged(PersistentSyncPubDb& db, const Data& documentKey)
+{
+   PlainContents result;
+   TextMerger merger;
+   if (!db.getMergedETags(Presence, documentKey, merger, &result))
+   {
+      return Data::Empty;
+   }
+   return result.text();
+}
+
+// through the interface, as DUM stores them
+void
+addUpdate(PublicationPersistenceManager& db, const Data& documentKey, const Data& eTag, UInt64 expires, 
+          const Contents* contents, const SecurityAttributes* security = 0)
+{
+   db.addUpdateDocument(Presence, documentKey, eTag, expires, contents, security);
+}
+
+void
+addText(PersistentSyncPubDb& db, const Data& documentKey, const Data& eTag, UInt64 expires, const Data& text)
+{
+   PlainContents contents(text);
+   addUpdate(db, documentKey, eTag, expires, &contents);
+}
+
+UInt64
+fileSize(const char* path)
+{
+   FILE* f = fopen(path, "rb");
+   if (f == 0)
+   {
+      return 0;
+   }
+   fseek(f, 0, SEEK_END);
+   UInt64 size = ftell(f);
+   fclose(f);
+   return size;
+}
+
+// Heap in use, where the C library tells; 0 elsewhere.
+UInt64
+heapInUse()
+{
+#if defined(__GLIBC__) && __GLIBC_PREREQ(2, 33)
+   struct mallinfo2 info = mallinfo2();
+   return info.uordblks + info.hblkhd;
+#elif defined(__GLIBC__)
+   struct mallinfo info = mallinfo();
+   return (UInt64)(unsigned int)info.uordblks + (unsigned int)info.hblkhd;
+#else
+   return 0;
+#endif
+}
+
+void
+testRestart()
+{
+   remove(LogPath);
+   UInt64 expires = Timer::getTimeSecs() + 3600;
+   {
+      PersistentSyncPubDb db(LogPath, false, 4, 0);
+      assert(db.getLoadedCount() == 0);
+      addText(db, "alice@example.com", "a1", expires, "phone");
+      addText(db, "alice@example.com", "a2", expires, "laptop");
+      addText(db, "bob@example.com", "b1", expires, "desk");
+      addText(db, "carol@example.com", "c1", expires, "gone");
+      addText(db, "dave@example.com", "d1", Timer::getTimeSecs() - 1, "expired");
+
+      // a refresh has no body, and keeps the one stored
+      addUpdate(db, "bob@example.com", "b1", expires + 60, 0);
+      assert(db.removeDocument(Presence, "carol@example.com", "c1", 0));
+
+      SecurityAttributes security;
+      security.setSigner("erin@example.com");
+      security.setSignatureStatus(SignatureTrusted);
+      PlainContents signedText("signed");
+      addUpdate(db, "erin@example.com", "e1", expires, &signedText, &security);
+      // the destructor writes out what flush() hasn't
+   }
+   {
+      PersistentSyncPubDb db(LogPath, false, 8, 0);
+      assert(db.getLoadedCount() == 4);
+      assert(merged(db, "alice@example.com") == "phone+laptop");
+      assert(merged(db, "bob@example.com") == "desk");
+      assert(!db.documentExists(Presence, "carol@example.com", "c1"));
+      assert(!db.documentExists(Presence, "dave@example.com", "d1"));
+
+      PubDocument bob;
+      db.lockDocuments();
+      bob = db.getDocuments()[Presence + "bob@example.com"]["b1"];
+      PubDocument erin = db.getDocuments()[Presence + "erin@example.com"]["e1"];
+      db.unlockDocuments();
+      assert(bob.mExpirationTime >= expires + 59 && bob.mExpirationTime <= expires + 61);
+      assert(erin.mSecurityAttributes.get());
+      assert(erin.mSecurityAttributes->getSigner() == "erin@example.com");
+      assert(erin.mSecurityAttributes->getSignatureStatus() == SignatureTrusted);
+
+      // changes after a restart are kept too
+      assert(db.removeDocument(Presence, "alice@example.com", "a1", 0));
+      db.flush();
+   }
+
+   // a record cut short by a crash is dropped, and the log rewritten
+   FILE* f = fopen(LogPath, "ab");
+   assert(f);
+   fwrite("\x40\x00\x00\x00\x01", 1, 5, f);
+   fclose(f);
+   {
+      PersistentSyncPubDb db(LogPath, false, 0, 0);
+      assert(db.getLoadedCount() == 3);
+      assert(merged(db, "alice@example.com") == "laptop");
+      addText(db, "frank@example.com", "f1", expires, "new");
+   }
+   {
+      PersistentSyncPubDb db(LogPath, false, 0, 0);
+      assert(db.getLoadedCount() == 4);
+      assert(merged(db, "frank@example.com") == "new");
+   }
+   remove(LogPath);
+}
+
+// Counts what an AllChanges handler, like PresenceSubscriptionHandler, is told.
+class ChangeCounter : public InMemorySyncPubDbHandler
+{
+   public:
+      ChangeCounter() : InMemorySyncPubDbHandler(AllChanges), mSyncModified(0), mOtherModified(0) {}
+      virtual void onDocumentModified(bool sync, const Data& eventType, const Data& documentKey, const Data& eTag, 
+                                      UInt64 expirationTime, UInt64 lastUpdated, const Contents* contents, 
+                                      const SecurityAttributes* securityAttributes)
+      {
+         if (sync && contents)
+         {
+            ++mSyncModified;
+         }
+         else
+         {
+            ++mOtherModified;
+         }
+      }
+      virtual void onDocumentRemoved(bool sync, const Data& eventType, const Data& documentKey, const Data& eTag, UInt64 lastUpdated) {}
+      unsigned int mSyncModified;
+      unsigned int mOtherModified;
+};
+
+void
+testRefresh()
+{
+   remove(LogPath);
+   UInt64 expires = Timer::getTimeSecs() + 3600;
+   Data big(Data::Empty);
+   for (int i = 0; i < 1000; ++i)
+   {
+      big += "0123456789";
+   }
+   {
+      PersistentSyncPubDb db(LogPath, false, 0, 0);
+      addText(db, "alice@example.com", "a1", expires, big);
+      addText(db, "bob@example.com", "b1", Timer::getTimeSecs() - 1, "expired");
+      db.flush();
+      UInt64 before = db.getLogSize();
+
+      // a refresh logs the new times, not the body again
+      addUpdate(db, "alice@example.com", "a1", expires + 60, 0);
+      db.flush();
+      assert(db.getLogSize() > before);
+      assert(db.getLogSize() - before < 128);
+   }
+   {
+      PersistentSyncPubDb db(LogPath, false, 0, 0);
+      assert(merged(db, "alice@example.com") == big);
+      db.lockDocuments();
+      PubDocument alice = db.getDocuments()[Presence + "alice@example.com"]["a1"];
+      db.unlockDocuments();
+      assert(alice.mExpirationTime >= expires + 59 && alice.mExpirationTime <= expires + 61);
+
+      // handlers added after the load hear of the live documents, as sync'd
+      // publications, so they can start their expiry checks
+      ChangeCounter counter;
+      db.addHandler(&counter);
+      assert(counter.mSyncModified == 1);
+      assert(counter.mOtherModified == 0);
+      db.removeHandler(&counter);
+   }
+   remove(LogPath);
+}
+
+void
+testCompaction()
+{
+   remove(LogPath);
+   UInt64 expires = Timer::getTimeSecs() + 3600;
+   PersistentSyncPubDb db(LogPath, false, 0, 0);
+   for (unsigned int i = 0; i < 2000; ++i)
+   {
+      addText(db, "alice@example.com", "a1", expires, "version " + Data(i));
+   }
+   db.flush();
+   UInt64 grown = db.getLogSize();
+   assert(grown == fileSize(LogPath));
+   db.compact();
+   assert(db.getLogSize() < grown / 100);
+   assert(db.getLogSize() == fileSize(LogPath));
+   addText(db, "bob@example.com", "b1", expires, "desk");
+   db.flush();
+
+   PersistentSyncPubDb restarted(LogPath, false, 0, 0);
+   assert(restarted.getLoadedCount() == 2);
+   assert(merged(restarted, "alice@example.com") == "version 1999");
+   remove(LogPath);
+}
+
+// Rewrites its own documents over and over.
+class Updater : public ThreadIf
+{
+   public:
+      Updater(PersistentSyncPubDb& db, unsigned int id, unsigned int documents, unsigned int versions)
+         : mDb(db), mId(id), mDocuments(documents), mVersions(versions) {}
+      virtual void thread()
+      {
+         UInt64 expires = Timer::getTimeSecs() + 3600;
+         for (unsigned int v = 0; v < mVersions; ++v)
+         {
+            for (unsigned int d = 0; d < mDocuments; ++d)
+            {
+               addText(mDb, "user" + Data(mId) + "-" + Data(d) + "@example.com", "x", expires, "version " + Data(v));
+            }
+         }
+      }
+   private:
+      PersistentSyncPubDb& mDb;
+      unsigned int mId;
+      unsigned int mDocuments;
+      unsigned int mVersions;
+};
+
+void
+testCompactionWhileWriting()
+{
+   remove(LogPath);
+   const unsigned int threads = 4;
+   const unsigned int documents = 50;
+   const unsigned int versions = 400;
+   {
+      // the writer flushes every 5 ms, and compacts once the log passes
+      // MinCompactBytes
+      PersistentSyncPubDb db(LogPath, false, 0, 5);
+      vector<Updater*> updaters;
+      for (unsigned int t = 0; t < threads; ++t)
+      {
+         updaters.push_back(new Updater(db, t, documents, versions));
+         updaters.back()->run();
+      }
+      for (unsigned int t = 0; t < threads; ++t)
+      {
+         updaters[t]->join();
+         delete updaters[t];
+      }
+   }
+   // far less than the 80000 records written
+   assert(fileSize(LogPath) < PersistentSyncPubDb::MinCompactBytes * 3);
+
+   PersistentSyncPubDb db(LogPath, false, 0, 0);
+   assert(db.getLoadedCount() == threads * documents);
+   for (unsigned int t = 0; t < threads; ++t)
+   {
+      for (unsigned int d = 0; d < documents; ++d)
+      {
+         assert(merged(db, "user" + Data(t) + "-" + Data(d) + "@example.com") == "version " + Data(versions - 1));
+      }
+   }
+   remove(LogPath);
+}
+
+void
+testNotALog()
+{
+   remove(LogPath);
+   Data aside(Data(LogPath) + ".bad");
+   remove(aside.c_str());
+   FILE* f = fopen(LogPath, "wb");
+   fputs("<pubinfo>\r\n", f);
+   fclose(f);
+   {
+      PersistentSyncPubDb db(LogPath, false, 0, 0);
+      assert(db.getLoadedCount() == 0);
+      assert(fileSize(aside.c_str()) > 0);
+   }
+   remove(aside.c_str());
+   remove(LogPath);
+}
+
+Data
+documentKey(unsigned int i)
+{
+   return "user" + Data(i) + "@example.com";
+}
+
+Data
+pidfText(unsigned int i)
+{
+   return "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\r\n"
+          "<presence xmlns=\"urn:ietf:params:xml:ns:pidf\"\r\n"
+          "          entity=\"sip:" + documentKey(i) + "\">\r\n"
+          "  <tuple id=\"t" + Data(i) + "\">\r\n"
+          "     <status><basic>" + ((i % 2) ? "open" : "closed") + "</basic></status>\r\n"
+          "     <note>Working from home</note>\r\n"
+          "  </tuple>\r\n"
+          "</presence>\r\n";
+}
+
+void
+benchmark(unsigned int count)
+{
+   remove(LogPath);
+   UInt64 expires = Timer::getTimeSecs() + 3600;
+   Mime pidfType("application", "pidf+xml");
+
+   // as DUM stores them, from a PUBLISH; the log is written behind
+   UInt64 start = Timer::getTimeMs();
+   {
+      PersistentSyncPubDb db(LogPath);
+      for (unsigned int i = 0; i < count; ++i)
+      {
+         Data body(pidfText(i));
+         Contents* contents = Contents::createContents(pidfType, body);
+         db.addUpdateDocument(PubDocument(Presence, documentKey(i), "etag" + Data(i), expires, contents, 0));
+         delete contents;
+      }
+   }
+   UInt64 stored = Timer::getTimeMs() - start;
+   UInt64 logSize = fileSize(LogPath);
+
+   // the XML that RegSync sends, and restarting from it as its initial sync would
+   UInt64 fromXml = 0;
+   {
+      Data xml;
+      {
+         DataStream stream(xml);
+         for (unsigned int i = 0; i < count; ++i)
+         {
+            Data body(pidfText(i));
+            Contents* contents = Contents::createContents(pidfType, body);
+            PubDocument(Presence, documentKey(i), "etag" + Data(i), expires, contents, 0).stream(stream);
+            delete contents;
+         }
+      }
+      cout << count << " documents stored and written in " << stored << " ms; log "
+           << logSize / count << " bytes per document, as XML " << xml.size() / count << endl;
+
+      start = Timer::getTimeMs();
+      {
+         ParseBuffer pb(xml);
+         vector<PubDocument> documents;
+         documents.reserve(count);
+         while (!pb.eof())
+         {
+            const char* anchor = pb.position();
+            pb.skipToChars("</pubinfo>");
+            pb.skipN(10);
+            pb.skipWhitespace();
+            ParseBuffer one(anchor, pb.position() - anchor);
+            XMLCursor cursor(one);
+            documents.push_back(PubDocument());
+            assert(documents.back().deserialize(cursor));
+         }
+         assert(documents.size() == count);
+      }
+      fromXml = Timer::getTimeMs() - start;
+   }
+
+   // restarting from the log
+   UInt64 before = heapInUse();
+   start = Timer::getTimeMs();
+   PersistentSyncPubDb db(LogPath);
+   UInt64 loaded = Timer::getTimeMs() - start;
+   UInt64 afterLoad = heapInUse();
+   assert(db.getLoadedCount() == count);
+   cout << "restart: from the log " << loaded << " ms, from XML " << fromXml << " ms" << endl;
+
+   // first use parses each document
+   start = Timer::getTimeMs();
+   PresenceReader reader;
+   for (unsigned int i = 0; i < count; ++i)
+   {
+      assert(db.getMergedETags(Presence, documentKey(i), reader, 0));
+   }
+   UInt64 parsed = Timer::getTimeMs() - start;
+   UInt64 afterParse = heapInUse();
+   assert(reader.mOnline == count / 2);
+   cout << "first getMergedETags() of every document: " << parsed << " ms" << endl;
+   if (before)
+   {
+      cout << "memory per 100k documents: " << (afterLoad - before) * 100000 / count / 1024
+           << " KB as loaded, " << (afterParse - before) * 100000 / count / 1024 << " KB once parsed" << endl;
+   }
+   remove(LogPath);
+}
+
+}
+
+int
+main(int argc, char* argv[])
+{
+   Log::initialize(Log::Cout, Log::Warning, argv[0]);
+
+   testRestart();
+   testRefresh();
+   testCompaction();
+   testCompactionWhileWriting();
+   testNotALog();
+
+   unsigned int count = argc > 1 ? atoi(argv[1]) : 100000;
+   benchmark(count);
+
+   cout << "All OK" << endl;
+   return 0;
+}
+
@@ -28,6 +28,7 @@
 using namespace resip;
 
 volatile bool Connection::mEnablePostConnectSocketFuncCall = false;
+Data::size_type Connection::MaxWriteBatchBytes = 64*1024;
 
 #define RESIPROCATE_SUBSYSTEM Subsystem::TRANSPORT
 
@@ -39,6 +40,7 @@ Connection::Connection(Transport* transport,const Tuple& who, Socket socket,
      mInWritable(false),
      mFlowTimerEnabled(false),
      mPollItemHandle(0),
+     mIdleTimerId(0),
      mIsServer(isServer)
 {
    mWho.mFlowKey=(FlowKey)socket;
@@ -79,8 +81,9 @@ Connection::requestWrite(SendData* sendData)
 void 
 Connection::removeFrontOutstandingSend()
 {
-   delete mOutstandingSends.front();
+   SendData* sendData = mOutstandingSends.front();
    mOutstandingSends.pop_front();
+   delete sendData;
 
    if (mOutstandingSends.empty())
    {
@@ -160,6 +163,7 @@ Connection::performWrite()
    else if(mSendingTransmissionFormat == WebSocketData)
    {
       SendData *dataWs, *oldSd;
+      mOutstandingSends.front()->flatten();
       const Data& dataRaw = mOutstandingSends.front()->data;
       UInt64 dataSize = 1 + 1 + dataRaw.size();
       UInt64 lSize = (UInt64)dataRaw.size();
@@ -211,7 +215,7 @@ Connection::performWrite()
       }
 
       memcpy(uBuffer, dataRaw.data(), dataRaw.size());
-      mOutstandingSends.front() = dataWs;
+      mOutstandingSends.replaceFront(dataWs);
       dataWs = 0;
       delete oldSd;
    }
@@ -221,6 +225,7 @@ Connection::performWrite()
    if (mSendingTransmissionFormat == Compressed
        && !(mOutstandingSends.front()->isAlreadyCompressed))
    {
+      mOutstandingSends.front()->flatten();
       const Data& uncompressed = mOutstandingSends.front()->data;
       osc::SigcompMessage *sm = 
         mSigcompStack->compressMessage(uncompressed.data(), uncompressed.size(),
@@ -237,7 +242,7 @@ Connection::performWrite()
                                      oldSd->transactionId,
                                      oldSd->sigcompId,
                                      true);
-      mOutstandingSends.front() = newSd;
+      mOutstandingSends.replaceFront(newSd);
       delete oldSd;
       delete sm;
    }
@@ -249,9 +254,9 @@ Connection::performWrite()
       mFirstWriteAfterConnectedPending = false;  // reset
 
       // Notify all outstanding sends that we are now connected - stops the TCP Connection timer for all transactions
-      for (std::list<SendData*>::iterator it = mOutstandingSends.begin(); it != mOutstandingSends.end(); it++)
+      for (SendData* sd = mOutstandingSends.front(); sd; sd = SendDataQueue::next(sd))
       {
-         mTransport->setTcpConnectState((*it)->transactionId, TcpConnectState::Connected);
+         mTransport->setTcpConnectState(sd->transactionId, TcpConnectState::Connected);
       }
       if (mEnablePostConnectSocketFuncCall)
       {
@@ -259,8 +264,11 @@ Connection::performWrite()
       }
    }
 
-   const Data& data = mOutstandingSends.front()->data;
-   int nBytes = write(data.data() + mSendPos,int(data.size() - mSendPos));
+   // Plain SIP messages can share a write with the ones queued behind them;
+   // compressed and WebSocket framed ones are rewritten one at a time above.
+   Data::size_type budget = 
+      mSendingTransmissionFormat == Uncompressed ? MaxWriteBatchBytes : 0;
+   int nBytes = writeQueue(*mOutstandingSends.front(), mSendPos, budget);
 
    //DebugLog (<< "Tried to send " << data.size() - mSendPos << " bytes, sent " << nBytes << " bytes");
 
@@ -280,9 +288,19 @@ Connection::performWrite()
    {
       // Safe because of the conditional above ( < 0 ).
       Data::size_type bytesWritten = static_cast<Data::size_type>(nBytes);
-      mSendPos += bytesWritten;
-      if (mSendPos == data.size())
+      // The write may have finished any number of queued messages and
+      // stopped part way into the next one.
+      Data::size_type left = bytesWritten;
+      while (left > 0)
       {
+         resip_assert(!mOutstandingSends.empty());
+         Data::size_type rest = mOutstandingSends.front()->size() - mSendPos;
+         if (left < rest)
+         {
+            mSendPos += left;
+            break;
+         }
+         left -= rest;
          mSendPos = 0;
          removeFrontOutstandingSend();
       }
@@ -291,6 +309,34 @@ Connection::performWrite()
 }
 
 
+int
+Connection::writeGather(SendData& data, Data::size_type offset)
+{
+   data.flatten();
+   return write(data.data.data() + offset, int(data.data.size() - offset));
+}
+
+int
+Connection::writeQueue(SendData& first, Data::size_type offset, Data::size_type /* budget */)
+{
+   if (first.isFragmented())
+   {
+      return writeGather(first, offset);
+   }
+   return write(first.data.data() + offset, int(first.data.size() - offset));
+}
+
+SendData*
+Connection::nextBatchable(const SendData& sendData)
+{
+   SendData* next = SendDataQueue::next(&sendData);
+   if (next && next->command == SendData::NoCommand)
+   {
+      return next;
+   }
+   return 0;
+}
+
 bool 
 Connection::performWrites(unsigned int max)
 {
@@ -319,6 +365,19 @@ Connection::ensureWritable()
    }
 }
 
+void
+Connection::suspendPolling()
+{
+   getConnectionManager().suspendPolling(this);
+}
+
+void
+Connection::resumePolling()
+{
+   mInWritable = false;
+   getConnectionManager().resumePolling(this);
+}
+
 ConnectionManager&
 Connection::getConnectionManager() const
 {
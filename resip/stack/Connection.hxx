@@ -103,12 +103,32 @@ class Connection : public ConnectionBase,
       bool mFirstWriteAfterConnectedPending;
       static volatile bool mEnablePostConnectSocketFuncCall;
       static void setEnablePostConnectSocketFuncCall(bool enabled = true) { mEnablePostConnectSocketFuncCall = enabled; }
+
+      /// Most bytes that queued messages are coalesced into per write;
+      /// 0 writes one message at a time.
+      static Data::size_type MaxWriteBatchBytes;
+
       bool isServer()const;
    protected:
       /// pure virtual, but need concrete Connection for book-ends of lists
       virtual int read(char* /* buffer */, const int /* count */) { return 0; }
       /// pure virtual, but need concrete Connection for book-ends of lists
       virtual int write(const char* /* buffer */, const int /* count */) { return 0; }
+      /**
+         Writes data from offset on; returns as write() does. Connections
+         that can gather a fragmented SendData (see SendData::fragments)
+         override this, the default flattens it and calls write().
+      */
+      virtual int writeGather(SendData& data, Data::size_type offset);
+      /**
+         Writes first, the front of the send queue, from offset on, and may
+         carry on into the messages queued behind it (see nextBatchable())
+         while the total stays within budget bytes; returns the number of
+         bytes written as write() does. The default writes first only.
+      */
+      virtual int writeQueue(SendData& first, Data::size_type offset, Data::size_type budget);
+      /// The message after sendData if it may go out in the same write, or 0.
+      static SendData* nextBatchable(const SendData& sendData);
       virtual void onDoubleCRLF();
       virtual void onSingleCRLF();
 
@@ -117,12 +137,20 @@ class Connection : public ConnectionBase,
 
       virtual void invokeAfterSocketCreationFunc() const;
 
+      /// Stops poll events for this connection while another thread works
+      /// on its socket. resumePolling() restores read interest only; call
+      /// ensureWritable() after it if there is something to write.
+      /// FdPollGrp only.
+      void suspendPolling();
+      void resumePolling();
+
    private:
       ConnectionManager& getConnectionManager() const;
       void removeFrontOutstandingSend();
       bool mInWritable;
       bool mFlowTimerEnabled;
       FdPollItemHandle mPollItemHandle;
+      UInt64 mIdleTimerId; // entry in the ConnectionManager's idle wheel
       
       /// no default c'tor
       Connection();
@@ -100,11 +100,11 @@ ConnectionBase::~ConnectionBase()
    while (!mOutstandingSends.empty())
    {
       SendData* sendData = mOutstandingSends.front();
+      mOutstandingSends.pop_front();
       mTransport->fail(sendData->transactionId,
          mFailureReason ? mFailureReason : TransportFailure::ConnectionUnknown,
          mFailureSubCode);
       delete sendData;
-      mOutstandingSends.pop_front();
    }
    delete [] mBuffer;
    delete mMessage;
@@ -272,7 +272,7 @@ ConnectionBase::preparseNewBytes(int bytesRead)
             return true;
          }
 
-         mMessage->addBuffer(mBuffer);
+         mMessage->addBuffer(mBuffer, chunkLength);
          mBuffer=0;
 
          if (scanChunkResult == MsgHeaderScanner::scrNextChunk)
@@ -476,7 +476,7 @@ ConnectionBase::preparseNewBytes(int bytesRead)
             int overHang = mBufferPos - (int)contentLength;
             char *overHangStart = mBuffer + contentLength;
 
-            mMessage->addBuffer(mBuffer);
+            mMessage->addBuffer(mBuffer, mBufferPos);
             mMessage->setBody(mBuffer, (UInt32)contentLength);
             mConnState = NewMessage;
             mBuffer = 0;
@@ -850,7 +850,7 @@ ConnectionBase::wsProcessData(int bytesRead)
       Data::size_type msg_len = msg->size();
       // cast permitted, as it is borrowed:
       char *sipBuffer = (char *)msg->data();
-      mMessage->addBuffer(sipBuffer);
+      mMessage->addBuffer(sipBuffer, msg_len);
       mMsgHeaderScanner.prepareForMessage(mMessage);
       char *unprocessedCharPtr;
       if (mMsgHeaderScanner.scanChunk(sipBuffer,
@@ -936,7 +936,7 @@ ConnectionBase::decompressNewBytes(int bytesRead)
 
     char *sipBuffer = new char[bytesUncompressed];
     memmove(sipBuffer, uncompressed, bytesUncompressed);
-    mMessage->addBuffer(sipBuffer);
+    mMessage->addBuffer(sipBuffer, bytesUncompressed);
     mMsgHeaderScanner.prepareForMessage(mMessage);
     char *unprocessedCharPtr;
     if (mMsgHeaderScanner.scanChunk(sipBuffer,
@@ -179,6 +179,20 @@ ConnectionManager::removeFromWritable(Connection* conn)
    }
 }
 
+void
+ConnectionManager::suspendPolling(Connection* conn)
+{
+   resip_assert(mPollGrp);
+   mPollGrp->modPollItem(conn->mPollItemHandle, 0);
+}
+
+void
+ConnectionManager::resumePolling(Connection* conn)
+{
+   resip_assert(mPollGrp);
+   mPollGrp->modPollItem(conn->mPollItemHandle, FPEM_Read|FPEM_Error);
+}
+
 void
 ConnectionManager::addConnection(Connection* connection)
 {
@@ -199,6 +213,7 @@ ConnectionManager::addConnection(Connection* connection)
       mReadHead->push_back(connection);
    }
    mLRUHead->push_back(connection);
+   connection->mIdleTimerId = mIdleWheel.add(IdleTimer(connection->whenLastUsed(), connection));
 
    // Garbage collect old connections if agressive is enabled
    if(EnableAgressiveGc)
@@ -218,6 +233,8 @@ ConnectionManager::removeConnection(Connection* connection)
 
    mIdMap.erase(connection->mWho.mFlowKey);
    mAddrMap.erase(connection->mWho);
+   idleWheel(connection).cancel(connection->mIdleTimerId);
+   connection->mIdleTimerId = 0;
 
    if ( mPollGrp ) 
    {
@@ -247,50 +264,15 @@ ConnectionManager::gc(UInt64 relThreshold, unsigned int maxToRemove)
    UInt64 threshold = curTimeMs - relThreshold;
    DebugLog(<< "recycling connections not used in last " << relThreshold/1000.0 << " seconds");
 
-   // Look through non-flow-timer connections and close those using the passed in relThreshold
-   unsigned int numRemoved = 0;
-   for (ConnectionLruList::iterator i = mLRUHead->begin();
-        i != mLRUHead->end() &&
-        (maxToRemove == 0 || numRemoved != maxToRemove);)
-   {
-      if ((*i)->whenLastUsed() < threshold)
-      {
-         Connection* discard = *i;
-         InfoLog(<< "recycling connection: " << discard << " " << discard->getSocket());
-         // iterate before removing
-         ++i;
-         delete discard;
-         numRemoved++;
-      }
-      else
-      {
-         break;
-      }
-   }
+   // Close non-flow-timer connections idle for longer than the passed in relThreshold
+   unsigned int numRemoved = expireIdle(mIdleWheel, threshold, maxToRemove, 0);
 
-   // Look through flow-timer connections and close those using the configured FlowTimer 
-   // value + the configured grace period as a threshold
-   if(mFlowTimerLRUHead->begin() != mFlowTimerLRUHead->end())
+   // Close flow-timer connections using the configured FlowTimer value + the
+   // configured grace period as a threshold
+   if(!mFlowTimerIdleWheel.empty())
    {
       threshold = curTimeMs - ((InteropHelper::getFlowTimerSeconds() + InteropHelper::getFlowTimerGracePeriodSeconds()) * 1000);
-      for (FlowTimerLruList::iterator i2 = mFlowTimerLRUHead->begin();
-         i2 != mFlowTimerLRUHead->end() &&
-         (maxToRemove == 0 || numRemoved != maxToRemove);)
-      {  
-         if ((*i2)->whenLastUsed() < threshold)
-         {
-            Connection* discard = *i2;
-            InfoLog(<< "recycling flow-timer enabled connection: " << discard << " " << discard->getSocket());
-            // iterate before removing
-            ++i2;
-            delete discard;
-            numRemoved++;
-         }
-         else
-         {
-            break;
-         }
-      }
+      numRemoved = expireIdle(mFlowTimerIdleWheel, threshold, maxToRemove, numRemoved);
    }
 
    if(MinimumGcHeadroom > 0)
@@ -326,6 +308,51 @@ ConnectionManager::gc(UInt64 relThreshold, unsigned int maxToRemove)
    return numRemoved;
 }
 
+// The wheel files each connection under the time it was last used as of when
+// the entry was made.  touch() does not refile it, so an entry coming due may
+// belong to a connection that has been used since; it is refiled here instead,
+// which costs at most one refile per threshold period for a busy connection
+// rather than a wheel operation on every read.
+unsigned int
+ConnectionManager::expireIdle(IdleWheel& wheel, UInt64 threshold, unsigned int maxToRemove, unsigned int numRemoved)
+{
+   // connections last used before threshold are idle; the wheel is advanced
+   // to just short of it, so anything refiled lands in a future slot
+   const IdleTimer* timer;
+   while ((maxToRemove == 0 || numRemoved != maxToRemove) &&
+          (timer = wheel.peekExpired(threshold - 1)) != 0)
+   {
+      if (timer->getWhen() >= threshold)
+      {
+         // the threshold moved back (a larger age than on the last pass);
+         // nothing filed after this entry can be due yet
+         break;
+      }
+      Connection* connection = timer->getConnection();
+      wheel.popExpired();
+      connection->mIdleTimerId = 0;
+
+      if (connection->whenLastUsed() >= threshold)
+      {
+         connection->mIdleTimerId = wheel.add(IdleTimer(connection->whenLastUsed(), connection));
+      }
+      else
+      {
+         InfoLog(<< "recycling " << (connection->isFlowTimerEnabled() ? "flow-timer enabled " : "")
+                 << "connection: " << connection << " " << connection->getSocket());
+         delete connection;
+         numRemoved++;
+      }
+   }
+   return numRemoved;
+}
+
+ConnectionManager::IdleWheel&
+ConnectionManager::idleWheel(Connection* connection)
+{
+   return connection->isFlowTimerEnabled() ? mFlowTimerIdleWheel : mIdleWheel;
+}
+
 unsigned int
 ConnectionManager::gcWithTarget(unsigned int target)
 {
@@ -388,6 +415,8 @@ ConnectionManager::moveToFlowTimerLru(Connection *connection)
 {
    connection->ConnectionLruList::remove();
    mFlowTimerLRUHead->push_back(connection);
+   mIdleWheel.cancel(connection->mIdleTimerId);
+   connection->mIdleTimerId = mFlowTimerIdleWheel.add(IdleTimer(connection->whenLastUsed(), connection));
 }
 
 void
@@ -1,9 +1,9 @@
 #ifndef RESIP_ConnectionMgr_hxx
 #define RESIP_ConnectionMgr_hxx 
 
-#include <map>
 #include "rutil/HashMap.hxx"
 #include "resip/stack/Connection.hxx"
+#include "resip/stack/TimerWheel.hxx"
 
 namespace resip
 {
@@ -12,9 +12,10 @@ class FdPollGrp;
 /**
    Collection of Connection per Transport. Maintains round-robin
    orders for read and write.  Maintains least-recently-used connections list
-   for garbage collection.
+   for garbage collection, and a timing wheel of idle connections so that
+   expiring them costs time proportional to the number that have gone idle.
 
-   Maintains mapping from Tuple to Connection.
+   Maintains hashed mappings from Tuple and from socket to Connection.
  */
 class ConnectionManager
 {
@@ -49,21 +50,42 @@ class ConnectionManager
 
       virtual void invokeAfterSocketCreationFunc() const;
 
+      /// deletes every connection; lets a transport close them while it
+      /// is still whole, before its own destructor tears down what they use
+      void closeConnections();
+
    private:
       void addToWritable(Connection* conn); // add the specified conn to end
       void removeFromWritable(Connection* conn); // remove the current mWriteMark
-
-      typedef std::map<Tuple, Connection*> AddrMap;
-      typedef std::map<Socket, Connection*> IdMap;
+      void suspendPolling(Connection* conn); // FdPollGrp only
+      void resumePolling(Connection* conn); // read interest only
+
+      typedef HashMap<Tuple, Connection*> AddrMap;
+      typedef HashMap<Socket, Connection*> IdMap;
+
+      /// An idle-GC entry, filed under the time its connection was last used
+      class IdleTimer
+      {
+         public:
+            IdleTimer(UInt64 when, Connection* connection) : mWhen(when), mConnection(connection) {}
+            UInt64 getWhen() const { return mWhen; }
+            Connection* getConnection() const { return mConnection; }
+
+         private:
+            UInt64 mWhen;
+            Connection* mConnection;
+      };
+      typedef TimerWheel<IdleTimer> IdleWheel;
 
       void addConnection(Connection* connection);
       void removeConnection(Connection* connection);
-      void closeConnections();
 
       /// release excessively old connections (free up file descriptors)
       /// set maxToRemove to 0 for no-max
       unsigned int gc(UInt64 threshold, unsigned int maxToRemove);
       unsigned int gcWithTarget(unsigned int target);
+      unsigned int expireIdle(IdleWheel& wheel, UInt64 threshold, unsigned int maxToRemove, unsigned int numRemoved);
+      IdleWheel& idleWheel(Connection* connection);
 
       /// move to youngest 
       void touch(Connection* connection);
@@ -84,6 +106,10 @@ class ConnectionManager
       /// least recently used list for flow timer enabled connections
       FlowTimerLruList* mFlowTimerLRUHead;
 
+      /// idle connections by time last used, one wheel per LRU list above
+      IdleWheel mIdleWheel;
+      IdleWheel mFlowTimerIdleWheel;
+
       /// collection for epoll
       FdPollGrp* mPollGrp;
       //<<---------------------------------
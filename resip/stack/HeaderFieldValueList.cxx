@@ -9,6 +9,7 @@
 #include "resip/stack/HeaderFieldValueList.hxx"
 #include "resip/stack/ParserContainerBase.hxx"
 #include "resip/stack/Embedded.hxx"
+#include "resip/stack/SendData.hxx"
 #include "rutil/WinLeakCheck.hxx"
 
 using namespace resip;
@@ -136,6 +137,70 @@ HeaderFieldValueList::encode(const Data& headerName, EncodeStream& str) const
    return str;
 }
 
+void
+HeaderFieldValueList::encode(int headerEnum, FragmentEncoder& out) const
+{
+   const Data& headerName = Headers::getHeaderName(static_cast<Headers::Type>(headerEnum));
+
+   if (getParserContainer() != 0)
+   {
+      getParserContainer()->encode(headerName, out);
+   }
+   else
+   {
+      EncodeStream& str = out.stream();
+      if (!headerName.empty())
+      {
+         str << headerName << Symbols::COLON[0] << Symbols::SPACE[0];
+      }
+
+      for (HeaderFieldValueList::const_iterator j = begin();
+           j != end(); j++)
+      {
+         if (j != begin())
+         {
+            if (Headers::isCommaEncoding(static_cast<Headers::Type>(headerEnum)))
+            {
+               str << Symbols::COMMA[0] << Symbols::SPACE[0];
+            }
+            else
+            {
+               str << Symbols::CRLF << headerName << Symbols::COLON << Symbols::SPACE;
+            }
+         }
+         out.encode(*j);
+      }
+      str << Symbols::CRLF;
+   }
+}
+
+void
+HeaderFieldValueList::encode(const Data& headerName, FragmentEncoder& out) const
+{
+   if (getParserContainer() != 0)
+   {
+      getParserContainer()->encode(headerName, out);
+   }
+   else
+   {
+      EncodeStream& str = out.stream();
+      if (!headerName.empty())
+      {
+         str << headerName << Symbols::COLON << Symbols::SPACE;
+      }
+      for (HeaderFieldValueList::const_iterator j = begin();
+           j != end(); j++)
+      {
+         if (j != begin())
+         {
+            str << Symbols::COMMA[0] << Symbols::SPACE[0];
+         }
+         out.encode(*j);
+      }
+      str << Symbols::CRLF;
+   }
+}
+
 EncodeStream&
 HeaderFieldValueList::encodeEmbedded(const Data& headerName, EncodeStream& str) const
 {
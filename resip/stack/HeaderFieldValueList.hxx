@@ -13,6 +13,7 @@ namespace resip
 class Data;
 class ParserContainerBase;
 class HeaderFieldValue;
+class FragmentEncoder;
 
 /**
    @internal
@@ -44,6 +45,9 @@ class HeaderFieldValueList
 
       EncodeStream& encode(int headerEnum, EncodeStream& str) const;
       EncodeStream& encode(const Data& headerName, EncodeStream& str) const;
+      /// As encode(), but see SipMessage::encodeFragments().
+      void encode(int headerEnum, FragmentEncoder& out) const;
+      void encode(const Data& headerName, FragmentEncoder& out) const;
       EncodeStream& encodeEmbedded(const Data& headerName, EncodeStream& str) const;
 
       bool empty() const {return mHeaders.empty();}
@@ -65,6 +69,10 @@ class HeaderFieldValueList
       */
       void push_back(const char* buffer, size_t length, bool own) 
       {
+         if(mHeaders.size()==mHeaders.capacity())
+         {
+            grow();
+         }
          mHeaders.push_back(HeaderFieldValue::Empty); 
          mHeaders.back().init(buffer,length,own);
       }
@@ -94,6 +102,20 @@ class HeaderFieldValueList
       const_iterator end() const {return mHeaders.end();}
 
    private:
+      // Letting the vector reallocate would deep-copy every value (see 
+      // HeaderFieldValue's copy c'tor), so we do it ourselves by swapping.
+      void grow()
+      {
+         ListImpl bigger(mHeaders.get_allocator());
+         bigger.reserve(mHeaders.empty() ? 4 : 2*mHeaders.size());
+         bigger.resize(mHeaders.size());
+         for(size_t i=0; i<mHeaders.size(); ++i)
+         {
+            bigger[i].swap(mHeaders[i]);
+         }
+         mHeaders.swap(bigger);
+      }
+
       ListImpl mHeaders;
       PoolBase* mPool;
       ParserContainerBase* mParserContainer;
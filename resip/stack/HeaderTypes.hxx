@@ -11,14 +11,13 @@
 //
 // HeaderTypes.hxx
 // Headers.hxx
-// HeaderHash.gperf
-// Headers.cxx
+// Headers.cxx (including HeaderKeywords)
 // SipMessage.hxx
 // SipMessage.cxx
 //
 //****************************************************************************
 
-// eventually use these macros to automate Headers.hxx, Headers.cxx+gperf
+// eventually use these macros to automate Headers.hxx, Headers.cxx
 #define UNUSED_defineHeader(_enum, _name, _type, _rfc) SAVE##_enum, _enum = UNKNOWN, RESET##enum = SAVE##_enum-1
 #define UNUSED_defineMultiHeader(_enum, _name, _type, _rfc) SAVE##_enum, _enum = UNKNOWN, RESET##enum = SAVE##_enum-1
 #define defineHeader(_enum, _name, _type, _rfc) _enum
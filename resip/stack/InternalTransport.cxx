@@ -133,6 +133,23 @@ InternalTransport::bind()
    DebugLog (<< "Binding to " << Tuple::inet_ntop(mTuple)); 
 #endif
 
+   if ( (mTransportFlags & RESIP_TRANSPORT_FLAG_REUSEPORT)!=0 )
+   {
+#if defined(SO_REUSEPORT)
+      int on = 1;
+      if ( ::setsockopt(mFd, SOL_SOCKET, SO_REUSEPORT, (const char*)&on, sizeof(on)) )
+      {
+         int e = getErrno();
+         error(e);
+         ErrLog (<< "Couldn't set sockoptions SO_REUSEPORT on " << mTuple);
+         throw Transport::Exception("Failed setsockopt SO_REUSEPORT", __FILE__,__LINE__);
+      }
+#else
+      ErrLog (<< "SO_REUSEPORT is not supported on this platform");
+      throw Transport::Exception("SO_REUSEPORT not supported", __FILE__,__LINE__);
+#endif
+   }
+
    if ( ::bind( mFd, &mTuple.getMutableSockaddr(), mTuple.length()) == SOCKET_ERROR )
    {
       int e = getErrno();
@@ -81,6 +81,11 @@ class InternalTransport : public Transport
          }
       }
 
+      virtual void setTxFifoLockFree()
+      {
+         mTxFifo.setLockFree();
+      }
+
       virtual void invokeAfterSocketCreationFunc() const;
 
    protected:
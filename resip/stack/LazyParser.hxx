@@ -95,6 +95,16 @@ class LazyParser
       */
       HeaderFieldValue& getHeaderField() { return mHeaderField; }
 
+      /**
+         @internal
+         @brief Returns the raw text encode() would write, or 0 if this has
+            been modified (or built from scratch) and has to be re-encoded.
+      */
+      const HeaderFieldValue* getUnmodifiedHeaderField() const
+      {
+         return mState == DIRTY ? 0 : &mHeaderField;
+      }
+
       // call (internally) before every access 
       /**
          @internal
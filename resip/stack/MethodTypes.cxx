@@ -9,13 +9,12 @@
 #include "resip/stack/MethodTypes.hxx"
 #include "resip/stack/Symbols.hxx"
 #include "rutil/Data.hxx"
+#include "rutil/PerfectHash.hxx"
 
 using namespace resip;
 
 #define defineMethod(_enum, _name, _rfc) _name
 
-// !dlb! this file will be subsumed by MethodHash.cxx on auto-generate
-// move into MethodHash.cxx -- generated from MethodTypes.hxx -- !ah! indeed, yuck!
 namespace resip{
 
 Data MethodNames[] = 
@@ -39,7 +38,29 @@ Data MethodNames[] =
    defineMethod(UPDATE,"UPDATE", "RFC ????")
 };
 }
-#include "MethodHash.hxx"
+
+// method names are case sensitive (RFC 3261 s7.1)
+static const PerfectHash<MethodTypes>::Entry MethodKeywords[] =
+{
+   { "ACK", ACK },
+   { "BYE", BYE },
+   { "CANCEL", CANCEL },
+   { "INVITE", INVITE },
+   { "NOTIFY", NOTIFY },
+   { "OPTIONS", OPTIONS },
+   { "PRACK", PRACK },
+   { "PUBLISH", PUBLISH },
+   { "REFER", REFER },
+   { "REGISTER", REGISTER },
+   { "SUBSCRIBE", SUBSCRIBE },
+   { "RESPONSE", RESPONSE },
+   { "MESSAGE", MESSAGE },
+   { "INFO", INFO },
+   { "SERVICE", SERVICE },
+   { "UPDATE", UPDATE },
+};
+static const size_t MethodKeywordCount = sizeof(MethodKeywords)/sizeof(MethodKeywords[0]);
+static const PerfectHash<MethodTypes> MethodKeywordHash(MethodKeywords, MethodKeywordCount, true);
 
 const Data&
 resip::getMethodName(MethodTypes t) 
@@ -59,8 +80,13 @@ resip::getMethodType(const Data& name)
 MethodTypes
 resip::getMethodType(const char* name, int len)
 {
-   const struct methods* m = MethodHash::in_word_set(name, len);
-   return m ? m->type : UNKNOWN;
+   if (MethodKeywordHash.size() == 0)
+   {
+      // called from another static initializer before ours has run
+      return PerfectHash<MethodTypes>::linearFind(MethodKeywords, MethodKeywordCount,
+                                                  name, len, true, UNKNOWN);
+   }
+   return MethodKeywordHash.find(name, len, UNKNOWN);
 }
 
 // ?dlb? why aren't we using the lib strncasecmp?
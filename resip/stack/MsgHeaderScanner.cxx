@@ -10,6 +10,24 @@
 #include "resip/stack/MsgHeaderScanner.hxx"
 #include "rutil/WinLeakCheck.hxx"
 
+// Vectorized scanning of header values (see skipSse2()/skipAvx2()). SSE2 is 
+// part of every x86-64 CPU; AVX2 is compiled in where the compiler lets us 
+// target it per function, and only used if the CPU has it.
+#if !defined(RESIP_MSG_HEADER_SCANNER_NO_SIMD)
+#  if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#    define RESIP_MSG_HEADER_SCANNER_SSE2
+#    include <emmintrin.h>
+#    if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__)) && \
+        (defined(__clang__) || __GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 9))
+#      define RESIP_MSG_HEADER_SCANNER_AVX2
+#      include <immintrin.h>
+#    endif
+#    if defined(_MSC_VER)
+#      include <intrin.h>
+#    endif
+#  endif
+#endif
+
 namespace resip 
 {
 
@@ -107,6 +125,174 @@ static void initCharInfoArray()
       MsgHeaderScanner::tpbmContainsParen;
 }
 
+///////////////////////////////////////////////////////////////////////////////
+//   Most of a message header is value text, which leaves the state machine in
+//   the same state until a line break (or, in multi-values, a delimiter) shows
+//   up.  In those states, the characters that can change the state are few
+//   enough to be found 16 or 32 at a time with SIMD compares; everything in
+//   between only contributes to the text property bit mask.  Quoted strings
+//   (because of escapes), field names and line breaks are left to the state
+//   machine.
+
+enum SkipClassEnum
+{
+   skNone,           // Every character goes through the state machine.
+   skToLineBreak,    // Skip to the next CR or LF.
+   skNValue,         // Skip to the next CR, LF, ',', '<' or '"'.
+   skNValueInAngles  // Skip to the next CR, LF or '>'.
+};
+typedef char SkipClass;
+
+// Returns the number of characters from charPtr (but before endPtr) that need 
+// not go through the state machine, and adds their text properties to 
+// textPropBitMask.  Never reads at or beyond endPtr.
+typedef unsigned int (*SkipFunction)(const char* charPtr,
+                                     const char* endPtr,
+                                     SkipClass skipClass,
+                                     MsgHeaderScanner::TextPropBitMask& textPropBitMask);
+
+#if defined(RESIP_MSG_HEADER_SCANNER_SSE2)
+
+static inline unsigned int
+lowestSetBit(unsigned int mask)
+{
+#if defined(_MSC_VER)
+   unsigned long index;
+   _BitScanForward(&index, mask);
+   return index;
+#else
+   return __builtin_ctz(mask);
+#endif
+}
+
+static unsigned int
+skipSse2(const char* charPtr,
+         const char* endPtr,
+         SkipClass skipClass,
+         MsgHeaderScanner::TextPropBitMask& textPropBitMask)
+{
+   const char* startPtr = charPtr;
+   while (endPtr - charPtr >= 16)
+   {
+      const __m128i chars = _mm_loadu_si128(reinterpret_cast<const __m128i*>(charPtr));
+      __m128i stop = _mm_or_si128(_mm_cmpeq_epi8(chars, _mm_set1_epi8('\r')),
+                                  _mm_cmpeq_epi8(chars, _mm_set1_epi8('\n')));
+      if (skipClass == skNValue)
+      {
+         stop = _mm_or_si128(stop, _mm_cmpeq_epi8(chars, _mm_set1_epi8(',')));
+         stop = _mm_or_si128(stop, _mm_cmpeq_epi8(chars, _mm_set1_epi8('<')));
+         stop = _mm_or_si128(stop, _mm_cmpeq_epi8(chars, _mm_set1_epi8('"')));
+      }
+      else if (skipClass == skNValueInAngles)
+      {
+         stop = _mm_or_si128(stop, _mm_cmpeq_epi8(chars, _mm_set1_epi8('>')));
+      }
+      unsigned int stopMask = (unsigned int)_mm_movemask_epi8(stop);
+      // Only the characters before the first stop character are skipped.
+      unsigned int skipMask = stopMask ? (stopMask & (0u - stopMask)) - 1 : 0xFFFFu;
+      if (skipMask)
+      {
+         if (_mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(chars, _mm_set1_epi8(' ')),
+                                            _mm_cmpeq_epi8(chars, _mm_set1_epi8('\t')))) & skipMask)
+         {
+            textPropBitMask |= MsgHeaderScanner::tpbmContainsWhitespace;
+         }
+         if (_mm_movemask_epi8(_mm_cmpeq_epi8(chars, _mm_set1_epi8('\\'))) & skipMask)
+         {
+            textPropBitMask |= MsgHeaderScanner::tpbmContainsBackslash;
+         }
+         if (_mm_movemask_epi8(_mm_cmpeq_epi8(chars, _mm_set1_epi8('%'))) & skipMask)
+         {
+            textPropBitMask |= MsgHeaderScanner::tpbmContainsPercent;
+         }
+         if (_mm_movemask_epi8(_mm_cmpeq_epi8(chars, _mm_set1_epi8(';'))) & skipMask)
+         {
+            textPropBitMask |= MsgHeaderScanner::tpbmContainsSemicolon;
+         }
+         if (_mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(chars, _mm_set1_epi8('(')),
+                                            _mm_cmpeq_epi8(chars, _mm_set1_epi8(')')))) & skipMask)
+         {
+            textPropBitMask |= MsgHeaderScanner::tpbmContainsParen;
+         }
+      }
+      if (stopMask)
+      {
+         return (unsigned int)(charPtr - startPtr) + lowestSetBit(stopMask);
+      }
+      charPtr += 16;
+   }
+   return (unsigned int)(charPtr - startPtr);
+}
+
+#endif // RESIP_MSG_HEADER_SCANNER_SSE2
+
+#if defined(RESIP_MSG_HEADER_SCANNER_AVX2)
+
+// Same as skipSse2(), 32 characters at a time.
+__attribute__((target("avx2")))
+static unsigned int
+skipAvx2(const char* charPtr,
+         const char* endPtr,
+         SkipClass skipClass,
+         MsgHeaderScanner::TextPropBitMask& textPropBitMask)
+{
+   const char* startPtr = charPtr;
+   while (endPtr - charPtr >= 32)
+   {
+      const __m256i chars = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(charPtr));
+      __m256i stop = _mm256_or_si256(_mm256_cmpeq_epi8(chars, _mm256_set1_epi8('\r')),
+                                     _mm256_cmpeq_epi8(chars, _mm256_set1_epi8('\n')));
+      if (skipClass == skNValue)
+      {
+         stop = _mm256_or_si256(stop, _mm256_cmpeq_epi8(chars, _mm256_set1_epi8(',')));
+         stop = _mm256_or_si256(stop, _mm256_cmpeq_epi8(chars, _mm256_set1_epi8('<')));
+         stop = _mm256_or_si256(stop, _mm256_cmpeq_epi8(chars, _mm256_set1_epi8('"')));
+      }
+      else if (skipClass == skNValueInAngles)
+      {
+         stop = _mm256_or_si256(stop, _mm256_cmpeq_epi8(chars, _mm256_set1_epi8('>')));
+      }
+      unsigned int stopMask = (unsigned int)_mm256_movemask_epi8(stop);
+      unsigned int skipMask = stopMask ? (stopMask & (0u - stopMask)) - 1 : 0xFFFFFFFFu;
+      if (skipMask)
+      {
+         if ((unsigned int)_mm256_movemask_epi8(_mm256_or_si256(_mm256_cmpeq_epi8(chars, _mm256_set1_epi8(' ')),
+                                                                _mm256_cmpeq_epi8(chars, _mm256_set1_epi8('\t')))) & skipMask)
+         {
+            textPropBitMask |= MsgHeaderScanner::tpbmContainsWhitespace;
+         }
+         if ((unsigned int)_mm256_movemask_epi8(_mm256_cmpeq_epi8(chars, _mm256_set1_epi8('\\'))) & skipMask)
+         {
+            textPropBitMask |= MsgHeaderScanner::tpbmContainsBackslash;
+         }
+         if ((unsigned int)_mm256_movemask_epi8(_mm256_cmpeq_epi8(chars, _mm256_set1_epi8('%'))) & skipMask)
+         {
+            textPropBitMask |= MsgHeaderScanner::tpbmContainsPercent;
+         }
+         if ((unsigned int)_mm256_movemask_epi8(_mm256_cmpeq_epi8(chars, _mm256_set1_epi8(';'))) & skipMask)
+         {
+            textPropBitMask |= MsgHeaderScanner::tpbmContainsSemicolon;
+         }
+         if ((unsigned int)_mm256_movemask_epi8(_mm256_or_si256(_mm256_cmpeq_epi8(chars, _mm256_set1_epi8('(')),
+                                                                _mm256_cmpeq_epi8(chars, _mm256_set1_epi8(')')))) & skipMask)
+         {
+            textPropBitMask |= MsgHeaderScanner::tpbmContainsParen;
+         }
+      }
+      if (stopMask)
+      {
+         return (unsigned int)(charPtr - startPtr) + __builtin_ctz(stopMask);
+      }
+      charPtr += 32;
+   }
+   // Let SSE2 have a go at what is left.
+   return (unsigned int)(charPtr - startPtr) + skipSse2(charPtr, endPtr, skipClass, textPropBitMask);
+}
+
+#endif // RESIP_MSG_HEADER_SCANNER_AVX2
+
+static SkipFunction skipFunction = 0;
+
 ///////////////////////////////////////////////////////////////////////////////
 //   States marked '1' scan normal values.  States marked 'N' scan multi-values.
 
@@ -181,6 +367,8 @@ struct TransitionInfo
 
 static TransitionInfo stateMachine[numStates][numCharCategories];
 
+static SkipClass stateSkipClass[numStates];
+
 inline void specTransition(State state,
                            CharCategory charCategory,
                            TransitionAction action,
@@ -410,6 +598,17 @@ static void initStateMachine()
                   ccLineFeed,
                   taEndHeader,
                   sMsgStart); // Arbitrary but possibly handy.
+
+   // States that only a few characters get out of; these must agree with the
+   // transitions above.
+   for (int state = 0; state < numStates; ++state)
+   {
+      stateSkipClass[state] = skNone;
+   }
+   stateSkipClass[c2i(sScanStatusLine)] = skToLineBreak;
+   stateSkipClass[c2i(sScan1Value)] = skToLineBreak;
+   stateSkipClass[c2i(sScanNValue)] = skNValue;
+   stateSkipClass[c2i(sScanNValueInAngles)] = skNValueInAngles;
 }
 
 // Debug follows
@@ -874,6 +1073,7 @@ processMsgHeaderFieldNameAndValue(SipMessage * msg,
 #endif //!defined(RESIP_MSG_HEADER_SCANNER_DEBUG) }
 
 bool MsgHeaderScanner::mInitialized = false;
+MsgHeaderScanner::SimdLevel MsgHeaderScanner::mSimdLevel = MsgHeaderScanner::simdNone;
 
 MsgHeaderScanner::MsgHeaderScanner()
 {
@@ -917,6 +1117,7 @@ MsgHeaderScanner::scanChunk(char * chunk,
    MsgHeaderScanner::ScanChunkResult result;
    CharInfo* localCharInfoArray = charInfoArray;
    TransitionInfo (*localStateMachine)[numCharCategories] = stateMachine;
+   SkipFunction localSkipFunction = skipFunction;
    State localState = mState;
    char *charPtr = chunk + mPrevScanChunkNumSavedTextChars;
    char *termCharPtr = chunk + chunkLength;
@@ -935,6 +1136,13 @@ MsgHeaderScanner::scanChunk(char * chunk,
    --charPtr;  // The loop starts by advancing "charPtr", so pre-adjust it.
    for (;;)
    {
+      if (localSkipFunction && stateSkipClass[(unsigned)localState] != skNone)
+      {
+         charPtr += localSkipFunction(charPtr + 1,
+                                      termCharPtr,
+                                      stateSkipClass[(unsigned)localState],
+                                      localTextPropBitMask);
+      }
       // BEGIN message header character scan block BEGIN
       // The code in this block is executed once per message header character.
       // This entire file is designed specifically to minimize this block's size.
@@ -1067,9 +1275,59 @@ MsgHeaderScanner::initialize()
 {
    initCharInfoArray();
    initStateMachine();
+   setSimdLevel(getMaxSimdLevel());
    return true;
 }
 
+MsgHeaderScanner::SimdLevel
+MsgHeaderScanner::getMaxSimdLevel()
+{
+#if defined(RESIP_MSG_HEADER_SCANNER_AVX2)
+   __builtin_cpu_init();
+   if (__builtin_cpu_supports("avx2"))
+   {
+      return simdAvx2;
+   }
+#endif
+#if defined(RESIP_MSG_HEADER_SCANNER_SSE2)
+   return simdSse2;
+#else
+   return simdNone;
+#endif
+}
+
+void
+MsgHeaderScanner::setSimdLevel(SimdLevel level)
+{
+   if (!mInitialized)
+   {
+      mInitialized = true;
+      initCharInfoArray();
+      initStateMachine();
+   }
+   if (level > getMaxSimdLevel())
+   {
+      level = getMaxSimdLevel();
+   }
+   switch (level)
+   {
+#if defined(RESIP_MSG_HEADER_SCANNER_AVX2)
+      case simdAvx2:
+         skipFunction = skipAvx2;
+         break;
+#endif
+#if defined(RESIP_MSG_HEADER_SCANNER_SSE2)
+      case simdSse2:
+         skipFunction = skipSse2;
+         break;
+#endif
+      default:
+         skipFunction = 0;
+         break;
+   }
+   mSimdLevel = level;
+}
+
 
 } //namespace resip
 
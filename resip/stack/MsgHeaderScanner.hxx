@@ -68,6 +68,21 @@ class MsgHeaderScanner
     
       inline unsigned int getHeaderCount() const { return mNumHeaders;} 
 
+      // Runs of value text (and the status line) are scanned with SIMD 
+      // instructions where available; the best level this CPU supports is 
+      // selected when the first scanner is constructed.
+      enum SimdLevel
+      {
+         simdNone,  // Character by character through the state machine.
+         simdSse2,  // 16 characters at a time.
+         simdAvx2   // 32 characters at a time.
+      };
+      static SimdLevel getMaxSimdLevel();
+      static SimdLevel getSimdLevel() { return mSimdLevel; }
+      // For testing and benchmarking; not thread safe with respect to 
+      // scanners in use.  Levels above getMaxSimdLevel() are lowered to it.
+      static void setSimdLevel(SimdLevel level);
+
    private:
     
       // Fields:
@@ -133,6 +148,7 @@ class MsgHeaderScanner
       // Automatically called when 1st MsgHeaderScanner constructed.
       bool initialize();
       static bool mInitialized;
+      static SimdLevel mSimdLevel;
 
 
 };
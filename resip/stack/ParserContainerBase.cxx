@@ -2,6 +2,7 @@
 
 #include "resip/stack/ParserContainerBase.hxx"
 #include "resip/stack/Embedded.hxx"
+#include "resip/stack/SendData.hxx"
 
 using namespace resip;
 using namespace std;;
@@ -114,6 +115,51 @@ ParserContainerBase::encode(const Data& headerName,
    return str;
 }
 
+void
+ParserContainerBase::encode(const Data& headerName, 
+                            FragmentEncoder& out) const
+{
+   if (!mParsers.empty())
+   {
+      EncodeStream& str = out.stream();
+      if (!headerName.empty())
+      {
+         str << headerName << Symbols::COLON[0] << Symbols::SPACE[0];
+      }
+         
+      for (Parsers::const_iterator i = mParsers.begin(); 
+           i != mParsers.end(); ++i)
+      {
+         if (i != mParsers.begin())
+         {
+            if (Headers::isCommaEncoding(mType))
+            {
+               str << Symbols::COMMA[0] << Symbols::SPACE[0];
+            }
+            else
+            {
+               str << Symbols::CRLF << headerName << Symbols::COLON[0] << Symbols::SPACE[0];
+            }
+         }
+
+         if (i->pc == 0)
+         {
+            out.encode(i->hfv);
+         }
+         else if (const HeaderFieldValue* raw = i->pc->getUnmodifiedHeaderField())
+         {
+            out.encode(*raw);
+         }
+         else
+         {
+            i->pc->encode(str);
+         }
+      }
+
+      str << Symbols::CRLF;
+   }
+}
+
 EncodeStream&
 ParserContainerBase::encodeEmbedded(const Data& headerName, 
                                     EncodeStream& str) const
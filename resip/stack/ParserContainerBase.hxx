@@ -13,6 +13,7 @@ namespace resip
 {
 
 class HeaderFieldValueList;
+class FragmentEncoder;
 class PoolBase;
 
 /**
@@ -92,6 +93,13 @@ class ParserContainerBase
         */
       std::ostream& encode(Headers::Type type,std::ostream& str) const;
 
+      /**
+        @internal
+        @brief as encode(), but lets out reference values that have not
+         been modified since they were received
+        */
+      void encode(const Data& headerName, FragmentEncoder& out) const;
+
       /**
         @internal
         @brief the actual mechanics of parsing
@@ -0,0 +1,248 @@
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#ifndef WIN32
+#include <sys/uio.h>
+#endif
+
+#include "resip/stack/SendData.hxx"
+#include "resip/stack/HeaderFieldValue.hxx"
+
+using namespace resip;
+
+SharedRxBuffers::~SharedRxBuffers()
+{
+   for (Buffers::iterator i = mBuffers.begin(); i != mBuffers.end(); ++i)
+   {
+      delete [] i->first;
+   }
+}
+
+bool
+SharedRxBuffers::contains(const char* start, size_t length) const
+{
+   for (Buffers::const_iterator i = mBuffers.begin(); i != mBuffers.end(); ++i)
+   {
+      if (start >= i->first && start + length <= i->first + i->second)
+      {
+         return true;
+      }
+   }
+   return false;
+}
+
+Data::size_type
+SendData::size() const
+{
+   if (fragments.empty())
+   {
+      return data.size();
+   }
+
+   Data::size_type total = 0;
+   for (Fragments::const_iterator i = fragments.begin(); i != fragments.end(); ++i)
+   {
+      total += i->length;
+   }
+   return total;
+}
+
+Data
+SendData::toData() const
+{
+   if (fragments.empty())
+   {
+      return data;
+   }
+
+   Data result(Data::size_type(size()), Data::Preallocate);
+   for (Fragments::const_iterator i = fragments.begin(); i != fragments.end(); ++i)
+   {
+      result.append(i->external ? i->external : data.data() + i->offset, i->length);
+   }
+   return result;
+}
+
+void
+SendData::appendTo(Data& dest, Data::size_type offset) const
+{
+   if (fragments.empty())
+   {
+      if (offset < data.size())
+      {
+         dest.append(data.data() + offset, data.size() - offset);
+      }
+      return;
+   }
+
+   for (Fragments::const_iterator i = fragments.begin(); i != fragments.end(); ++i)
+   {
+      if (offset >= i->length)
+      {
+         offset -= i->length;
+         continue;
+      }
+      const char* start = i->external ? i->external : data.data() + i->offset;
+      dest.append(start + offset, i->length - offset);
+      offset = 0;
+   }
+}
+
+void
+SendData::flatten()
+{
+   if (!fragments.empty())
+   {
+      data = toData();
+      fragments.clear();
+      rxBuffers.reset();
+   }
+}
+
+#ifndef WIN32
+int
+SendData::fillIovecs(struct iovec* iov, int max, Data::size_type offset) const
+{
+   if (fragments.empty())
+   {
+      if (max < 1 || offset >= data.size())
+      {
+         return 0;
+      }
+      iov[0].iov_base = const_cast<char*>(data.data() + offset);
+      iov[0].iov_len = data.size() - offset;
+      return 1;
+   }
+
+   int count = 0;
+   for (Fragments::const_iterator i = fragments.begin(); 
+        i != fragments.end() && count < max; ++i)
+   {
+      if (offset >= i->length)
+      {
+         offset -= i->length;
+         continue;
+      }
+      const char* start = i->external ? i->external : data.data() + i->offset;
+      iov[count].iov_base = const_cast<char*>(start + offset);
+      iov[count].iov_len = i->length - offset;
+      offset = 0;
+      ++count;
+   }
+   return count;
+}
+#endif
+
+FragmentEncoder::FragmentEncoder(SendData& send, 
+                                 const SharedPtr<SharedRxBuffers>& rxBuffers)
+   : mSend(send),
+     mStream(send.data),
+     mFreshStart(send.data.size())
+{
+   mSend.fragments.clear();
+   mSend.rxBuffers = rxBuffers;
+}
+
+void
+FragmentEncoder::closeFresh()
+{
+   mStream.flush();
+   if (mSend.data.size() > mFreshStart)
+   {
+      SendData::Fragment fragment;
+      fragment.external = 0;
+      fragment.offset = mFreshStart;
+      fragment.length = mSend.data.size() - mFreshStart;
+      mSend.fragments.push_back(fragment);
+      mFreshStart = mSend.data.size();
+   }
+}
+
+void
+FragmentEncoder::encode(const HeaderFieldValue& hfv)
+{
+   // room for this one, the fresh text before it and the fresh text after
+   // the last one
+   if (hfv.getLength() >= MinReferenceSize &&
+       mSend.fragments.size() + 3 <= SendData::MaxFragments &&
+       mSend.rxBuffers.get() &&
+       mSend.rxBuffers->contains(hfv.getBuffer(), hfv.getLength()))
+   {
+      closeFresh();
+      SendData::Fragment fragment;
+      fragment.external = hfv.getBuffer();
+      fragment.offset = 0;
+      fragment.length = hfv.getLength();
+      mSend.fragments.push_back(fragment);
+   }
+   else
+   {
+      hfv.encode(mStream);
+   }
+}
+
+void
+FragmentEncoder::finish()
+{
+   closeFresh();
+   if (mSend.fragments.empty() ||
+       (mSend.fragments.size() == 1 && 
+        mSend.fragments.front().external == 0 &&
+        mSend.fragments.front().offset == 0))
+   {
+      // nothing was referenced; data already holds the whole message
+      mSend.fragments.clear();
+      mSend.rxBuffers.reset();
+   }
+}
+
+/* ====================================================================
+ * The Vovida Software License, Version 1.0 
+ * 
+ * Copyright (c) 2000 Vovida Networks, Inc.  All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 
+ * 3. The names "VOCAL", "Vovida Open Communication Application Library",
+ *    and "Vovida Open Communication Application Library (VOCAL)" must
+ *    not be used to endorse or promote products derived from this
+ *    software without prior written permission. For written
+ *    permission, please contact vocal@vovida.org.
+ *
+ * 4. Products derived from this software may not be called "VOCAL", nor
+ *    may "VOCAL" appear in their name, without prior written
+ *    permission of Vovida Networks, Inc.
+ * 
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESSED OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE, TITLE AND
+ * NON-INFRINGEMENT ARE DISCLAIMED.  IN NO EVENT SHALL VOVIDA
+ * NETWORKS, INC. OR ITS CONTRIBUTORS BE LIABLE FOR ANY DIRECT DAMAGES
+ * IN EXCESS OF $1,000, NOR FOR ANY INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE
+ * USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+ * DAMAGE.
+ * 
+ * ====================================================================
+ * 
+ * This software consists of voluntary contributions made by Vovida
+ * Networks, Inc. and many individuals on behalf of Vovida Networks,
+ * Inc.  For more information on Vovida Networks, Inc., please see
+ * <http://www.vovida.org/>.
+ *
+ */
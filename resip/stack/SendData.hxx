@@ -1,12 +1,45 @@
 #ifndef RESIP_SendData_HXX
 #define RESIP_SendData_HXX
 
+#include <vector>
+
 #include "rutil/Data.hxx"
+#include "rutil/DataStream.hxx"
+#include "rutil/SharedPtr.hxx"
 #include "resip/stack/Tuple.hxx"
 
+struct iovec;
+
 namespace resip
 {
 
+class HeaderFieldValue;
+class SendData;
+
+/**
+   @internal
+   Receive buffers handed over by a SipMessage (see
+   SipMessage::encodeFragments()), kept alive for as long as some SendData
+   still references text inside them.
+*/
+class SharedRxBuffers
+{
+   public:
+      typedef std::vector<std::pair<char*, size_t> > Buffers;
+
+      SharedRxBuffers() {}
+      ~SharedRxBuffers();
+
+      /// true if [start, start+length) lies entirely within one of the buffers
+      bool contains(const char* start, size_t length) const;
+
+      Buffers mBuffers;
+
+   private:
+      SharedRxBuffers(const SharedRxBuffers&);
+      SharedRxBuffers& operator=(const SharedRxBuffers&);
+};
+
 /**
    @internal
 */
@@ -56,13 +89,61 @@ class SendData
       void clear()
       {
          data.clear();
+         fragments.clear();
+         rxBuffers.reset();
       }
 
       bool empty() const
       {
-         return data.empty();
+         return data.empty() && fragments.empty();
       }
 
+      /**
+         A piece of the message as it goes on the wire: length bytes at
+         external, which points into rxBuffers, or, if external is 0, length
+         bytes at offset in data.
+      */
+      struct Fragment
+      {
+         const char* external;
+         Data::size_type offset;
+         Data::size_type length;
+      };
+      typedef std::vector<Fragment> Fragments;
+
+      /// Upper bound on fragments.size(), so transports can gather a whole
+      /// message with a fixed number of iovecs.
+      static const unsigned int MaxFragments = 32;
+
+      /// true if the message is made up of fragments, rather than being
+      /// held in data in its entirety
+      bool isFragmented() const { return !fragments.empty(); }
+
+      /// Number of bytes that go on the wire.
+      Data::size_type size() const;
+
+      /**
+         Gathers the fragments into data, so that data holds the whole
+         message again. Used wherever a contiguous buffer is needed
+         (compression, TLS, WebSocket framing, logging).
+      */
+      void flatten();
+
+      /// Copy of the whole message, fragmented or not.
+      Data toData() const;
+
+      /// Appends the message, minus its first offset bytes, to dest.
+      void appendTo(Data& dest, Data::size_type offset=0) const;
+
+#ifndef WIN32
+      /**
+         Describes the message, minus its first offset bytes, with at most
+         max iovecs (MaxFragments always suffice). Returns the number of
+         iovecs filled in.
+      */
+      int fillIovecs(struct iovec* iov, int max, Data::size_type offset=0) const;
+#endif
+
       Tuple destination;
       Data data;
       Data transactionId;
@@ -71,6 +152,125 @@ class SendData
 
       // .bwc. Used for special commands: ie. to close connections, and enable flow timers
       SendDataCommand command;
+
+      // If non-empty, the message is these pieces in order, and data holds
+      // only the freshly encoded ones.
+      Fragments fragments;
+      SharedPtr<SharedRxBuffers> rxBuffers;
+
+   private:
+      friend class SendDataQueue;
+
+      // Link for SendDataQueue; copies of a SendData start out unlinked.
+      class QueueLink
+      {
+         public:
+            QueueLink() : mNext(0) {}
+            QueueLink(const QueueLink&) : mNext(0) {}
+            QueueLink& operator=(const QueueLink&) { return *this; }
+            SendData* mNext;
+      };
+      QueueLink mQueueLink;
+};
+
+/**
+   @internal
+   FIFO of SendData linked through the SendData themselves, so that queueing
+   a message on a connection doesn't allocate, and a connection can walk
+   everything it has pending when gathering writes. A SendData can be on at
+   most one queue; the queue does not own its entries.
+*/
+class SendDataQueue
+{
+   public:
+      SendDataQueue() : mHead(0), mTail(0), mSize(0) {}
+
+      bool empty() const { return mHead == 0; }
+      size_t size() const { return mSize; }
+      SendData* front() const { return mHead; }
+
+      /// The entry queued after sendData, or 0 if it is the last.
+      static SendData* next(const SendData* sendData) { return sendData->mQueueLink.mNext; }
+
+      void push_back(SendData* sendData)
+      {
+         sendData->mQueueLink.mNext = 0;
+         if (mTail)
+         {
+            mTail->mQueueLink.mNext = sendData;
+         }
+         else
+         {
+            mHead = sendData;
+         }
+         mTail = sendData;
+         ++mSize;
+      }
+
+      void pop_front()
+      {
+         SendData* head = mHead;
+         mHead = head->mQueueLink.mNext;
+         head->mQueueLink.mNext = 0;
+         if (mHead == 0)
+         {
+            mTail = 0;
+         }
+         --mSize;
+      }
+
+      /// Puts replacement where the front entry was; the old one is unlinked.
+      void replaceFront(SendData* replacement)
+      {
+         SendData* head = mHead;
+         replacement->mQueueLink.mNext = head->mQueueLink.mNext;
+         head->mQueueLink.mNext = 0;
+         mHead = replacement;
+         if (mTail == head)
+         {
+            mTail = replacement;
+         }
+      }
+
+   private:
+      SendData* mHead;
+      SendData* mTail;
+      size_t mSize;
+
+      SendDataQueue(const SendDataQueue&);
+      SendDataQueue& operator=(const SendDataQueue&);
+};
+
+/**
+   @internal
+   Builds a fragmented SendData: text written to stream() is appended to
+   SendData::data, while header values that still sit unmodified in one of
+   the message's receive buffers are referenced rather than copied. See
+   SipMessage::encodeFragments().
+*/
+class FragmentEncoder
+{
+   public:
+      /// Values shorter than this are copied; for those, an extra iovec
+      /// costs more than the copy.
+      static const Data::size_type MinReferenceSize = 64;
+
+      FragmentEncoder(SendData& send, const SharedPtr<SharedRxBuffers>& rxBuffers);
+
+      EncodeStream& stream() { return mStream; }
+
+      /// Encodes hfv, by reference if possible.
+      void encode(const HeaderFieldValue& hfv);
+
+      /// Must be called once everything has been encoded.
+      void finish();
+
+   private:
+      void closeFresh();
+
+      SendData& mSend;
+      DataStream mStream;
+      Data::size_type mFreshStart;
 };
 
 }
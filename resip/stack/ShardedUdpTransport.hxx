@@ -0,0 +1,127 @@
+#if !defined(RESIP_SHARDEDUDPTRANSPORT_HXX)
+#define RESIP_SHARDEDUDPTRANSPORT_HXX
+
+#include <vector>
+#include "resip/stack/UdpTransport.hxx"
+
+namespace resip
+{
+class TransportThread;
+
+/**
+   @ingroup transports
+
+   @brief A UdpTransport spread over several SO_REUSEPORT sockets bound to
+   the same address, each serviced by its own TransportThread (and so its
+   own FdPollGrp).
+
+   The kernel distributes inbound datagrams across the shards by hashing
+   the sender's address, and every shard feeds the same TransactionController
+   fifo. Only this object (shard 0) is known to the TransportSelector, so
+   the Via/Record-Route address is unchanged and received messages from any
+   shard carry this transport's key. Outbound messages are handed to the
+   shard picked by hashing the destination Tuple, so a given peer is always
+   served by the same shard.
+
+   Created through SipStack::addShardedUdpTransport(). The transport always
+   runs with RESIP_TRANSPORT_FLAG_OWNTHREAD; unlike other transports with
+   that flag, it creates and runs its TransportThreads itself, from
+   startOwnProcessing().
+*/
+class ShardedUdpTransport : public UdpTransport
+{
+public:
+   RESIP_HeapCount(ShardedUdpTransport);
+   /**
+      @param numShards total number of sockets/threads, including this one
+      @see UdpTransport::UdpTransport() for the other parameters
+   */
+   ShardedUdpTransport(Fifo<TransactionMessage>& fifo,
+                       int portNum,
+                       IpVersion version,
+                       const Data& interfaceObj,
+                       unsigned int numShards,
+                       AfterSocketCreationFuncPtr socketFunc = 0,
+                       Compression &compression = Compression::Disabled,
+                       unsigned transportFlags = 0);
+   virtual ~ShardedUdpTransport();
+
+   virtual void send(std::auto_ptr<SendData> data);
+   virtual void poke();
+   virtual void startOwnProcessing();
+   virtual void shutdown();
+   virtual bool isFinished() const;
+
+   virtual unsigned int getFifoSize() const;
+   virtual void setCongestionManager(CongestionManager* manager);
+   virtual void setSipMessageLoggingHandler(SharedPtr<SipMessageLoggingHandler> handler);
+   virtual void invokeAfterSocketCreationFunc() const;
+   virtual void setRcvBufLen(int buflen);
+   virtual void sumBatchSizes(unsigned int* rxBatches, unsigned int* txBatches) const;
+
+   unsigned int numShards() const { return (unsigned int)mShards.size() + 1; }
+
+private:
+   // shards 1..numShards-1; shard 0 is this object
+   std::vector<UdpTransport*> mShards;
+   std::vector<TransportThread*> mThreads;
+
+   // dis-allowed by not implemented
+   ShardedUdpTransport(const ShardedUdpTransport&);
+   ShardedUdpTransport& operator=(const ShardedUdpTransport&);
+};
+
+}
+
+#endif
+
+/* ====================================================================
+ * The Vovida Software License, Version 1.0
+ *
+ * Copyright (c) 2000 Vovida Networks, Inc.  All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ *
+ * 3. The names "VOCAL", "Vovida Open Communication Application Library",
+ *    and "Vovida Open Communication Application Library (VOCAL)" must
+ *    not be used to endorse or promote products derived from this
+ *    software without prior written permission. For written
+ *    permission, please contact vocal@vovida.org.
+ *
+ * 4. Products derived from this software may not be called "VOCAL", nor
+ *    may "VOCAL" appear in their name, without prior written
+ *    permission of Vovida Networks, Inc.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESSED OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE, TITLE AND
+ * NON-INFRINGEMENT ARE DISCLAIMED.  IN NO EVENT SHALL VOVIDA
+ * NETWORKS, INC. OR ITS CONTRIBUTORS BE LIABLE FOR ANY DIRECT DAMAGES
+ * IN EXCESS OF $1,000, NOR FOR ANY INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE
+ * USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+ * DAMAGE.
+ *
+ * ====================================================================
+ *
+ * This software consists of voluntary contributions made by Vovida
+ * Networks, Inc. and many individuals on behalf of Vovida Networks,
+ * Inc.  For more information on Vovida Networks, Inc., please see
+ * <http://www.vovida.org/>.
+ *
+ * vi: set shiftwidth=3 expandtab:
+ */
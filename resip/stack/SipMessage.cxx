@@ -7,6 +7,7 @@
 #include "resip/stack/OctetContents.hxx"
 #include "resip/stack/HeaderFieldValueList.hxx"
 #include "resip/stack/SipMessage.hxx"
+#include "resip/stack/SendData.hxx"
 #include "resip/stack/ExtensionHeader.hxx"
 #include "rutil/Coders.hxx"
 #include "rutil/CountStream.hxx"
@@ -17,6 +18,7 @@
 #include "rutil/Coders.hxx"
 #include "rutil/Random.hxx"
 #include "rutil/ParseBuffer.hxx"
+#include "rutil/PerfectHash.hxx"
 #include "resip/stack/MsgHeaderScanner.hxx"
 //#include "rutil/WinLeakCheck.hxx"  // not compatible with placement new used below
 
@@ -26,6 +28,7 @@ using namespace std;
 #define RESIPROCATE_SUBSYSTEM Subsystem::SIP
 
 bool SipMessage::checkContentLength=true;
+size_t SipMessage::arenaMaxBytes=0;
 
 SipMessage::SipMessage(const Tuple *receivedTransportTuple)
    : mIsDecorated(false),
@@ -37,6 +40,7 @@ SipMessage::SipMessage(const Tuple *receivedTransportTuple)
 #else
      mUnknownHeaders(),
 #endif
+     mBufferList(StlPoolAllocator<Buffer, PoolBase>(&mPool)),
      mRequest(false),
      mResponse(false),
      mInvalid(false),
@@ -47,6 +51,7 @@ SipMessage::SipMessage(const Tuple *receivedTransportTuple)
    {
        mReceivedTransportTuple = *receivedTransportTuple;
    }
+   mPool.setArenaLimit(arenaMaxBytes);
    // !bwc! TODO make this tunable
    mHeaders.reserve(16);
    clear();
@@ -59,8 +64,10 @@ SipMessage::SipMessage(const SipMessage& from)
 #else
      mUnknownHeaders(),
 #endif
+     mBufferList(StlPoolAllocator<Buffer, PoolBase>(&mPool)),
      mCreatedTime(Timer::getTimeMicroSec())
 {
+   mPool.setArenaLimit(arenaMaxBytes);
    init(from);
 }
 
@@ -85,9 +92,9 @@ SipMessage::~SipMessage()
 {
 //#define DINKYPOOL_PROFILING
 #ifdef DINKYPOOL_PROFILING
-   if (mPool.getHeapBytes() > 0)
+   if (mPool.getHeapBytes() > 0 || mPool.getArenaBytes() > 0)
    {
-       InfoLog(<< "SipMessage mPool filled up and used " << mPool.getHeapBytes() << " bytes on the heap, consider increasing the mPool size (sizeof SipMessage is " << sizeof(SipMessage) << " bytes): msg="
+       InfoLog(<< "SipMessage mPool filled up and used " << mPool.getArenaBytes() << " bytes of arena and " << mPool.getHeapBytes() << " bytes on the heap, consider increasing the mPool size (sizeof SipMessage is " << sizeof(SipMessage) << " bytes): msg="
            << std::endl << *this);
    }
    else
@@ -110,13 +117,17 @@ SipMessage::clear(bool leaveResponseStuff)
       // !bwc! The "invalid" 0 index.
       mHeaders.push_back(getEmptyHfvl());
       mBufferList.clear();
+      mSharedBuffers.reset();
    }
 
    mUnknownHeaders.clear();
+   mUnknownHeaderCount = 0;
+   mUnknownHeaderIndex.clear();
 
    mStartLine = 0;
    mContents = 0;
    mContentsHfv.clear();
+   mSharedBody.reset();
    mForceTarget = 0;
    mReason=0;
    mOutboundDecorators.clear();
@@ -160,15 +171,20 @@ SipMessage::init(const SipMessage& rhs)
    for (UnknownHeaders::const_iterator i = rhs.mUnknownHeaders.begin();
         i != rhs.mUnknownHeaders.end(); i++)
    {
-      mUnknownHeaders.push_back(pair<Data, HeaderFieldValueList*>(
-                                   i->first,
-                                   getCopyHfvl(*i->second)));
+      addUnknownHeader(i->first, getCopyHfvl(*i->second));
    }
    if (rhs.mStartLine != 0)
    {
       mStartLine = rhs.mStartLine->clone(mStartLineMem);
    }
-   if (rhs.mContents != 0)
+   if (rhs.mSharedBody.get() && rhs.mContentsHfv.getBuffer() != 0 &&
+       (rhs.mContents == 0 || rhs.mContents->getUnmodifiedHeaderField() != 0))
+   {
+      // still as shared, so share it again rather than copy
+      mSharedBody = rhs.mSharedBody;
+      mContentsHfv.init(rhs.mContentsHfv.getBuffer(), rhs.mContentsHfv.getLength(), false);
+   }
+   else if (rhs.mContents != 0)
    {
       mContents = rhs.mContents->clone();
    }
@@ -232,11 +248,12 @@ SipMessage::freeMem(bool leaveResponseStuff)
    {
       clearHeaders();
 
-      for (vector<char*>::iterator i = mBufferList.begin();
+      for (BufferList::iterator i = mBufferList.begin();
            i != mBufferList.end(); i++)
       {
-         delete [] *i;
+         delete [] i->first;
       }
+      mSharedBuffers.reset();
    }
 
    if(mStartLine)
@@ -276,7 +293,7 @@ SipMessage::make(const Data& data, bool isExternal)
    size_t len = data.size();
    char *buffer = new char[len + 5];
 
-   msg->addBuffer(buffer);
+   msg->addBuffer(buffer, len);
    memcpy(buffer,data.data(), len);
    MsgHeaderScanner msgHeaderScanner;
    msgHeaderScanner.prepareForMessage(msg);
@@ -776,6 +793,81 @@ SipMessage::encode(EncodeStream& str, bool isSipFrag) const
    return str;
 }
 
+void
+SipMessage::encodeFragments(SendData& send)
+{
+   // Once handed to send, the receive buffers live for as long as
+   // anything still references them.
+   if (!mBufferList.empty())
+   {
+      if (!mSharedBuffers.get())
+      {
+         mSharedBuffers.reset(new SharedRxBuffers);
+      }
+      mSharedBuffers->mBuffers.insert(mSharedBuffers->mBuffers.end(),
+                                      mBufferList.begin(), mBufferList.end());
+      mBufferList.clear();
+   }
+
+   // a shared body is referenced in the same way, when there are no 
+   // receive buffers
+   FragmentEncoder out(send, mSharedBuffers.get() ? mSharedBuffers : mSharedBody);
+   EncodeStream& str = out.stream();
+
+   if (mStartLine != 0)
+   {
+      mStartLine->encode(str);
+      str << "\r\n";
+   }
+
+   // the body is referenced as received unless it has been modified
+   const HeaderFieldValue* body = 0;
+   Data contents;
+   if (mContents != 0)
+   {
+      body = mContents->getUnmodifiedHeaderField();
+      if (body == 0)
+      {
+         oDataStream temp(contents);
+         mContents->encode(temp);
+      }
+   }
+   else if (mContentsHfv.getBuffer() != 0)
+   {
+      body = &mContentsHfv;
+   }
+
+   for (UInt8 i = 0; i < Headers::MAX_HEADERS; i++)
+   {
+      if (i != Headers::ContentLength)
+      {
+         if (mHeaderIndices[i] > 0)
+         {
+            mHeaders[mHeaderIndices[i]]->encode(i, out);
+         }
+      }
+   }
+
+   for (UnknownHeaders::const_iterator i = mUnknownHeaders.begin(); 
+        i != mUnknownHeaders.end(); i++)
+   {
+      i->second->encode(i->first, out);
+   }
+
+   str << "Content-Length: " << (body ? body->getLength() : contents.size()) << "\r\n";
+   str << Symbols::CRLF;
+
+   if (body)
+   {
+      out.encode(*body);
+   }
+   else
+   {
+      str << contents;
+   }
+   out.finish();
+}
+
 EncodeStream&
 SipMessage::encodeSingleHeader(Headers::Type type, EncodeStream& str) const
 {
@@ -862,7 +954,13 @@ SipMessage::encodeEmbedded(EncodeStream& str) const
 void
 SipMessage::addBuffer(char* buf)
 {
-   mBufferList.push_back(buf);
+   mBufferList.push_back(Buffer(buf, 0));
+}
+
+void
+SipMessage::addBuffer(char* buf, size_t size)
+{
+   mBufferList.push_back(Buffer(buf, size));
 }
 
 void 
@@ -989,6 +1087,15 @@ SipMessage::setRawBody(const HeaderFieldValue& body)
    mContentsHfv = body;
 }
 
+void
+SipMessage::setSharedBody(const SharedPtr<SharedRxBuffers>& body, const char* start, size_t length)
+{
+   resip_assert(body.get() && body->contains(start, length));
+   setContents(0);
+   mSharedBody = body;
+   mContentsHfv.init(start, length, false);
+}
+
 
 void
 SipMessage::setContents(auto_ptr<Contents> contents)
@@ -998,6 +1105,7 @@ SipMessage::setContents(auto_ptr<Contents> contents)
    delete mContents;
    mContents = 0;
    mContentsHfv.clear();
+   mSharedBody.reset();
 
    if (contentsP == 0)
    {
@@ -1123,19 +1231,17 @@ SipMessage::releaseContents()
 const StringCategories& 
 SipMessage::header(const ExtensionHeader& headerName) const
 {
-   for (UnknownHeaders::const_iterator i = mUnknownHeaders.begin();
-        i != mUnknownHeaders.end(); i++)
-   {      
-      if (isEqualNoCase(i->first, headerName.getName()))
+   const Data& name = headerName.getName();
+   UnknownHeaders::const_iterator i = findUnknownHeader(name.data(), name.size());
+   if (i != mUnknownHeaders.end())
+   {
+      HeaderFieldValueList* hfvs = i->second;
+      if (hfvs->getParserContainer() == 0)
       {
-         HeaderFieldValueList* hfvs = i->second;
-         if (hfvs->getParserContainer() == 0)
-         {
-            SipMessage* nc_this(const_cast<SipMessage*>(this));
-            hfvs->setParserContainer(nc_this->makeParserContainer<StringCategory>(hfvs, Headers::RESIP_DO_NOT_USE));
-         }
-         return *dynamic_cast<ParserContainer<StringCategory>*>(hfvs->getParserContainer());
+         SipMessage* nc_this(const_cast<SipMessage*>(this));
+         hfvs->setParserContainer(nc_this->makeParserContainer<StringCategory>(hfvs, Headers::RESIP_DO_NOT_USE));
       }
+      return *dynamic_cast<ParserContainer<StringCategory>*>(hfvs->getParserContainer());
    }
    // missing extension header
    resip_assert(false);
@@ -1146,54 +1252,136 @@ SipMessage::header(const ExtensionHeader& headerName) const
 StringCategories& 
 SipMessage::header(const ExtensionHeader& headerName)
 {
-   for (UnknownHeaders::iterator i = mUnknownHeaders.begin();
-        i != mUnknownHeaders.end(); i++)
+   const Data& name = headerName.getName();
+   UnknownHeaders::iterator i = findUnknownHeader(name.data(), name.size());
+   if (i != mUnknownHeaders.end())
    {
-      if (isEqualNoCase(i->first, headerName.getName()))
+      HeaderFieldValueList* hfvs = i->second;
+      if (hfvs->getParserContainer() == 0)
       {
-         HeaderFieldValueList* hfvs = i->second;
-         if (hfvs->getParserContainer() == 0)
-         {
-            hfvs->setParserContainer(makeParserContainer<StringCategory>(hfvs, Headers::RESIP_DO_NOT_USE));
-         }
-         return *dynamic_cast<ParserContainer<StringCategory>*>(hfvs->getParserContainer());
+         hfvs->setParserContainer(makeParserContainer<StringCategory>(hfvs, Headers::RESIP_DO_NOT_USE));
       }
+      return *dynamic_cast<ParserContainer<StringCategory>*>(hfvs->getParserContainer());
    }
 
    // create the list empty
    HeaderFieldValueList* hfvs = getEmptyHfvl();
    hfvs->setParserContainer(makeParserContainer<StringCategory>(hfvs, Headers::RESIP_DO_NOT_USE));
-   mUnknownHeaders.push_back(make_pair(headerName.getName(), hfvs));
+   addUnknownHeader(name, hfvs);
    return *dynamic_cast<ParserContainer<StringCategory>*>(hfvs->getParserContainer());
 }
 
 bool
 SipMessage::exists(const ExtensionHeader& symbol) const
 {
-   for (UnknownHeaders::const_iterator i = mUnknownHeaders.begin();
-        i != mUnknownHeaders.end(); i++)
+   const Data& name = symbol.getName();
+   return findUnknownHeader(name.data(), name.size()) != mUnknownHeaders.end();
+}
+
+void
+SipMessage::remove(const ExtensionHeader& headerName)
+{
+   const Data& name = headerName.getName();
+   UnknownHeaders::iterator i = findUnknownHeader(name.data(), name.size());
+   if (i != mUnknownHeaders.end())
    {
-      if (isEqualNoCase(i->first, symbol.getName()))
+      freeHfvl(i->second);
+      mUnknownHeaders.erase(i);
+      --mUnknownHeaderCount;
+      if (!mUnknownHeaderIndex.empty())
       {
-         return true;
+         indexUnknownHeaders();
       }
    }
-   return false;
+}
+
+SipMessage::UnknownHeaders::iterator
+SipMessage::findUnknownHeader(const char* name, size_t len)
+{
+   if (mUnknownHeaderIndex.empty())
+   {
+      for (UnknownHeaders::iterator i = mUnknownHeaders.begin();
+           i != mUnknownHeaders.end(); i++)
+      {
+         if (i->first.size() == len &&
+             strncasecmp(i->first.data(), name, len) == 0)
+         {
+            return i;
+         }
+      }
+      return mUnknownHeaders.end();
+   }
+
+   const UInt32 hash = UInt32(PerfectHashBase::hashNoCase(name, len));
+   const size_t mask = mUnknownHeaderIndex.size() - 1;
+   for (size_t slot = hash & mask; mUnknownHeaderIndex[slot].used; slot = (slot + 1) & mask)
+   {
+      const UnknownHeaderSlot& entry = mUnknownHeaderIndex[slot];
+      if (entry.hash == hash &&
+          entry.header->first.size() == len &&
+          strncasecmp(entry.header->first.data(), name, len) == 0)
+      {
+         return entry.header;
+      }
+   }
+   return mUnknownHeaders.end();
 }
 
 void
-SipMessage::remove(const ExtensionHeader& headerName)
+SipMessage::addUnknownHeader(const Data& name, HeaderFieldValueList* hfvs)
 {
-   for (UnknownHeaders::iterator i = mUnknownHeaders.begin();
-        i != mUnknownHeaders.end(); i++)
+   mUnknownHeaders.push_back(pair<Data, HeaderFieldValueList*>(name, hfvs));
+   ++mUnknownHeaderCount;
+   if (mUnknownHeaderIndex.empty())
    {
-      if (isEqualNoCase(i->first, headerName.getName()))
+      if (mUnknownHeaderCount > UnknownHeaderIndexThreshold)
       {
-         freeHfvl(i->second);
-         mUnknownHeaders.erase(i);
-         return;
+         indexUnknownHeaders();
       }
    }
+   else if (2*mUnknownHeaderCount > mUnknownHeaderIndex.size())
+   {
+      indexUnknownHeaders();
+   }
+   else
+   {
+      indexUnknownHeader(--mUnknownHeaders.end());
+   }
+}
+
+void
+SipMessage::indexUnknownHeaders()
+{
+   // start out at most a quarter full; addUnknownHeader rebuilds at half
+   size_t slots = 4*UnknownHeaderIndexThreshold;
+   while (slots < 4*mUnknownHeaderCount)
+   {
+      slots *= 2;
+   }
+   UnknownHeaderSlot empty;
+   empty.hash = 0;
+   empty.used = false;
+   mUnknownHeaderIndex.assign(slots, empty);
+   for (UnknownHeaders::iterator i = mUnknownHeaders.begin();
+        i != mUnknownHeaders.end(); i++)
+   {
+      indexUnknownHeader(i);
+   }
+}
+
+void
+SipMessage::indexUnknownHeader(UnknownHeaders::iterator header)
+{
+   const UInt32 hash = UInt32(PerfectHashBase::hashNoCase(header->first.data(), header->first.size()));
+   const size_t mask = mUnknownHeaderIndex.size() - 1;
+   size_t slot = hash & mask;
+   while (mUnknownHeaderIndex[slot].used)
+   {
+      slot = (slot + 1) & mask;
+   }
+   mUnknownHeaderIndex[slot].header = header;
+   mUnknownHeaderIndex[slot].hash = hash;
+   mUnknownHeaderIndex[slot].used = true;
 }
 
 void
@@ -1254,19 +1442,15 @@ SipMessage::addHeader(Headers::Type header, const char* headerName, int headerLe
    else
    {
       resip_assert(headerLen >= 0);
-      for (UnknownHeaders::iterator i = mUnknownHeaders.begin();
-           i != mUnknownHeaders.end(); i++)
+      UnknownHeaders::iterator i = findUnknownHeader(headerName, headerLen);
+      if (i != mUnknownHeaders.end())
       {
-         if (i->first.size() == (unsigned int)headerLen &&
-             strncasecmp(i->first.data(), headerName, headerLen) == 0)
+         // add to end of list
+         if (len)
          {
-            // add to end of list
-            if (len)
-            {
-               i->second->push_back(start, len, false);
-            }
-            return;
+            i->second->push_back(start, len, false);
          }
+         return;
       }
 
       // didn't find it, add an entry
@@ -1275,8 +1459,7 @@ SipMessage::addHeader(Headers::Type header, const char* headerName, int headerLe
       {
          hfvs->push_back(start, len, false);
       }
-      mUnknownHeaders.push_back(pair<Data, HeaderFieldValueList*>(Data(headerName, headerLen),
-                                                                  hfvs));
+      addUnknownHeader(Data(headerName, headerLen), hfvs);
    }
 }
 
@@ -33,6 +33,8 @@ namespace resip
 class Contents;
 class ExtensionHeader;
 class SecurityAttributes;
+class SendData;
+class SharedRxBuffers;
 
 /**
    @ingroup resip_crit
@@ -196,6 +198,19 @@ class SipMessage : public TransactionMessage
       
       static bool checkContentLength;
 
+      /** @brief When non-zero, header storage, parser containers, parsed 
+          headers and their parameters that do not fit in a message's 
+          built-in pool are carved out of a per-message arena of up to this 
+          many bytes, freed in one go with the message, rather than being 
+          allocated on the heap one by one. Applies to messages constructed 
+          after it is set. 0 (the default) disables this.
+          
+          The arena never reuses memory freed before the message goes away, 
+          so set the limit with long-lived, repeatedly modified messages in 
+          mind (once it is reached, the heap is used as before).
+      */
+      static size_t arenaMaxBytes;
+
       /**
       @brief Base exception for SipMessage related exceptions
       */
@@ -272,6 +287,20 @@ class SipMessage : public TransactionMessage
       virtual EncodeStream& encodeBrief(EncodeStream& str) const;
       EncodeStream& encodeSingleHeader(Headers::Type type, EncodeStream& str) const;
 
+      /** @brief Encodes the message for the wire into send, as encode() 
+          would, except that header values and bodies that are still 
+          unmodified in the buffers the message was received in are 
+          referenced rather than copied (see SendData::fragments). The 
+          receive buffers become shared with send, so the message may go 
+          away before send is transmitted.
+
+          Values shorter than FragmentEncoder::MinReferenceSize, values 
+          that have been accessed through a non-const accessor, and 
+          everything in messages that were not received with a known 
+          buffer size (see addBuffer()) are copied as usual.
+      */
+      void encodeFragments(SendData& send);
+
       /// Returns true if message is a request, false otherwise
       inline bool isRequest() const {return mRequest;}
       /// Returns true if message is a response, false otherwise
@@ -485,6 +514,18 @@ class SipMessage : public TransactionMessage
       **/
       void setRawBody(const HeaderFieldValue& body);
 
+      /**
+         Remove any existing body/contents, and set the body to the 
+         {length} bytes at {start}, which must lie within one of the
+         buffers of {body}. The bytes are not copied: this message, its
+         copies and whatever encodeFragments() makes of it share {body}
+         instead. This lets one encoded document go out in many messages.
+         Content headers are left to the caller.
+
+         This is a low-level interface; see setContents() for higher level.
+      **/
+      void setSharedBody(const SharedPtr<SharedRxBuffers>& body, const char* start, size_t length);
+
       /** @brief Retrieves the body of a SIP message.
         * 
         *   In the case of an INVITE request containing SDP, the body would 
@@ -535,6 +576,10 @@ class SipMessage : public TransactionMessage
       Tuple& getDestination() { return mDestination; }
 
       void addBuffer(char* buf);
+      /// As addBuffer(char*), for a buffer holding size bytes of message 
+      /// text. Only text within such buffers is referenced by 
+      /// encodeFragments().
+      void addBuffer(char* buf, size_t size);
 
       UInt64 getCreatedTimeMicroSec() const {return mCreatedTime;}
 
@@ -622,6 +667,15 @@ class SipMessage : public TransactionMessage
 
       void throwHeaderMissing(Headers::Type type) const;
 
+      UnknownHeaders::iterator findUnknownHeader(const char* name, size_t len);
+      UnknownHeaders::const_iterator findUnknownHeader(const char* name, size_t len) const
+      {
+         return const_cast<SipMessage*>(this)->findUnknownHeader(name, len);
+      }
+      void addUnknownHeader(const Data& name, HeaderFieldValueList* hfvs);
+      void indexUnknownHeaders();
+      void indexUnknownHeader(UnknownHeaders::iterator header);
+
       inline HeaderFieldValueList* getEmptyHfvl()
       {
          void* ptr(mPool.allocate(sizeof(HeaderFieldValueList)));
@@ -667,6 +721,7 @@ class SipMessage : public TransactionMessage
       // To profile current sizing, enable DINKYPOOL_PROFILING in SipMessage.cxx 
       // and look for DebugLog message in SipMessage destructor to know when heap
       // allocations are occuring and how much of the pool is used.
+      // See also arenaMaxBytes.
       DinkyPool<3732> mPool;
 
       typedef std::vector<HeaderFieldValueList*, 
@@ -680,6 +735,20 @@ class SipMessage : public TransactionMessage
 
       // raw text corresponding to each unknown header
       UnknownHeaders mUnknownHeaders;
+      size_t mUnknownHeaderCount;
+
+      // Open addressed index over mUnknownHeaders, keyed on the
+      // case-insensitive hash of the name. Only built once a message carries
+      // more than UnknownHeaderIndexThreshold distinct unknown headers; below
+      // that, the list is searched directly.
+      struct UnknownHeaderSlot
+      {
+         UnknownHeaders::iterator header;
+         UInt32 hash;
+         bool used;
+      };
+      std::vector<UnknownHeaderSlot> mUnknownHeaderIndex;
+      static const size_t UnknownHeaderIndexThreshold = 8;
 
       // For messages received from the wire, this indicates information about 
       // the transport the message was received on
@@ -693,7 +762,13 @@ class SipMessage : public TransactionMessage
       Tuple mDestination;
       
       // Raw buffers coming from the Transport. message manages the memory
-      std::vector<char*> mBufferList;
+      typedef std::pair<char*, size_t> Buffer;
+      typedef std::vector<Buffer, StlPoolAllocator<Buffer, PoolBase> > BufferList;
+      BufferList mBufferList;
+
+      // Buffers moved out of mBufferList by encodeFragments(), which may 
+      // outlive the message
+      SharedPtr<SharedRxBuffers> mSharedBuffers;
 
       // special case for the first line of message
       StartLine* mStartLine;
@@ -702,6 +777,10 @@ class SipMessage : public TransactionMessage
       // raw text for the contents (all of them)
       HeaderFieldValue mContentsHfv;
 
+      // Holds the text of mContentsHfv if it is shared with other 
+      // messages (see setSharedBody())
+      SharedPtr<SharedRxBuffers> mSharedBody;
+
       // lazy parser for the contents
       mutable Contents* mContents;
 
@@ -28,6 +28,7 @@
 #include "rutil/Inserter.hxx"
 #include "resip/stack/StatisticsManager.hxx"
 #include "rutil/AsyncProcessHandler.hxx"
+#include "resip/stack/ShardedUdpTransport.hxx"
 #include "resip/stack/TcpTransport.hxx"
 #include "resip/stack/UdpTransport.hxx"
 #include "resip/stack/WsTransport.hxx"
@@ -192,7 +193,12 @@ SipStack::init(const SipStackOptions& options)
                 ? *options.mExtraNameserverList : DnsStub::EmptyNameserverList,
          options.mSocketFunc,
          mAsyncProcessHandler,
-         mPollGrp);
+         mPollGrp,
+         options.mDnsCache);
+   if (options.mDnsResolverThreads > 0)
+   {
+      mDnsStub->startResolverThreads(options.mDnsResolverThreads);
+   }
    mDnsThread = 0;
 
    mCompression = options.mCompression
@@ -204,6 +210,18 @@ SipStack::init(const SipStackOptions& options)
    // grab the security, DnsStub, compression and statsManager
    mTransactionController = new TransactionController(*this, mAsyncProcessHandler, options.mUseDnsVip);
    mTransactionController->transportSelector().setPollGrp(mPollGrp);
+   mTransactionController->createShards(options.mTransactionControllerShards);
+
+   mLockFreeFifos = options.mLockFreeFifos;
+   if(mLockFreeFifos & SipStackOptions::StateMacFifo)
+   {
+      mTransactionController->setStateMacFifoLockFree();
+   }
+   if(mLockFreeFifos & SipStackOptions::TuFifo)
+   {
+      mTUFifo.setLockFree();
+   }
+   mTUFifo.setDwellHistogram(&mStatsManager.getTuFifoDwell());
    mTransactionControllerThread = 0;
    mTransportSelectorThread = 0;
 
@@ -228,6 +246,12 @@ SipStack::~SipStack()
    mDnsThread=0;
    delete mTransactionControllerThread;
    mTransactionControllerThread=0;
+   for(std::vector<TransactionControllerThread*>::iterator i=mTransactionShardThreads.begin();
+       i!=mTransactionShardThreads.end(); ++i)
+   {
+      delete *i;
+   }
+   mTransactionShardThreads.clear();
    delete mTransportSelectorThread;
    mTransportSelectorThread=0;
 
@@ -265,6 +289,19 @@ SipStack::run()
    mDnsThread=new DnsThread(*mDnsStub);
    mDnsThread->run();
 
+   for(std::vector<TransactionControllerThread*>::iterator i=mTransactionShardThreads.begin();
+       i!=mTransactionShardThreads.end(); ++i)
+   {
+      delete *i;
+   }
+   mTransactionShardThreads.clear();
+   for(unsigned int i=0; i < mTransactionController->numShards(); ++i)
+   {
+      mTransactionShardThreads.push_back(new TransactionControllerThread(mTransactionController->shard(i)));
+      mTransactionShardThreads.back()->run();
+   }
+   mTransactionController->setShardsHaveOwnThreads(!mTransactionShardThreads.empty());
+
    delete mTransactionControllerThread;
    mTransactionControllerThread=new TransactionControllerThread(*mTransactionController);
    mTransactionControllerThread->run();
@@ -303,6 +340,13 @@ SipStack::shutdownAndJoinThreads()
       mTransactionControllerThread->join();
    }
 
+   for(std::vector<TransactionControllerThread*>::iterator i=mTransactionShardThreads.begin();
+       i!=mTransactionShardThreads.end(); ++i)
+   {
+      (*i)->shutdown();
+      (*i)->join();
+   }
+
    if(mTransportSelectorThread)
    {
       mTransportSelectorThread->shutdown();
@@ -472,6 +516,44 @@ SipStack::addTransport( TransportType protocol,
    return transport;
 }
 
+Transport*
+SipStack::addShardedUdpTransport(int port,
+                                 unsigned int numShards,
+                                 IpVersion version,
+                                 const Data& ipInterface,
+                                 unsigned transportFlags)
+{
+   resip_assert(!mShuttingDown);
+   resip_assert(numShards > 0);
+
+   if(!ipInterface.empty() &&
+      !(version == V6 ? DnsUtil::isIpV6Address(ipInterface) : DnsUtil::isIpV4Address(ipInterface)))
+   {
+      ErrLog(<< "Failed to create sharded transport, invalid ipInterface specified (IP address required): "
+             << (version == V4 ? "V4" : "V6") << " UDP " << port << " on " << ipInterface.c_str());
+      throw Transport::Exception("Invalid ipInterface specified (IP address required)", __FILE__,__LINE__);
+   }
+
+   Transport* transport=0;
+   try
+   {
+      transport = new ShardedUdpTransport(mTransactionController->transportSelector().stateMacFifo(),
+                                          port, version, ipInterface, numShards,
+                                          mSocketFunc, *mCompression, transportFlags);
+   }
+   catch (BaseException& e)
+   {
+      ErrLog(<< "Failed to create sharded transport: "
+             << (version == V4 ? "V4" : "V6") << " UDP " << port << " on "
+             << (ipInterface.empty() ? "ANY" : ipInterface.c_str())
+             << " shards=" << numShards
+             << ": " << e);
+      throw;
+   }
+   addTransport(std::auto_ptr<Transport>(transport));
+   return transport;
+}
+
 void
 SipStack::addTransport(std::auto_ptr<Transport> transport)
 {
@@ -545,6 +627,11 @@ SipStack::addTransport(std::auto_ptr<Transport> transport)
       mPorts[transport->port()]++;  // add port / increment reference count
    }
 
+   if(mLockFreeFifos & SipStackOptions::TransportTxFifos)
+   {
+       transport->setTxFifoLockFree();
+   }
+
    // Add to CongestionManager if required
    if(mCongestionManager)
    {
@@ -1149,6 +1236,7 @@ SipStack::pollStatistics()
 void
 SipStack::registerTransactionUser(TransactionUser& tu, const bool front)
 {
+   tu.setFifoDwellHistogram(&mStatsManager.getTransactionUserFifoDwell());
    mTuSelector.registerTransactionUser(tu, front);
 }
 
@@ -1163,6 +1251,7 @@ void
 SipStack::unregisterTransactionUser(TransactionUser& tu)
 {
    mTuSelector.unregisterTransactionUser(tu);
+   tu.setFifoDwellHistogram(0);
    checkAsyncProcessHandler();
 }
 
@@ -1241,13 +1330,13 @@ SipStack::dump(EncodeStream& strm)  const
       strm << "domains: " << Inserter(this->mDomains) << std::endl;
    }
    strm << " TUFifo size=" << this->mTUFifo.size() << std::endl
-        << " Timers size=" << this->mTransactionController->mTimers.size() << std::endl;
+        << " Timers size=" << this->mTransactionController->getTimerQueueSize() << std::endl;
    {
       Lock lock(mAppTimerMutex);
       strm << " AppTimers size=" << this->mAppTimers.size() << std::endl;
    }
-   strm << " ServerTransactionMap size=" << this->mTransactionController->mServerTransactionMap.size() << std::endl
-        << " ClientTransactionMap size=" << this->mTransactionController->mClientTransactionMap.size() << std::endl
+   strm << " ServerTransactionMap size=" << this->mTransactionController->getNumServerTransactions() << std::endl
+        << " ClientTransactionMap size=" << this->mTransactionController->getNumClientTransactions() << std::endl
         // !slg! TODO - There is technically a threading concern with the following three lines and the runtime addTransport or removeTransport call
         << " Exact interface / Specific port=" << Inserter(this->mTransactionController->mTransportSelector.mExactTransports) << std::endl
         << " Any interface / Specific port=" << Inserter(this->mTransactionController->mTransportSelector.mAnyInterfaceTransports) << std::endl
@@ -6,6 +6,7 @@
 #endif
 
 #include <set>
+#include <vector>
 #include <iosfwd>
 
 #include "rutil/CongestionManager.hxx"
@@ -101,6 +102,32 @@ class FdPollGrp;
            Set to true to enable Whitelisting of DNS entries.  A feature
            that usually desired by UA's that want to stick to a known
            good server / dns result.
+
+        mTransactionControllerShards
+           Number of TransactionController shards to split transaction
+           processing across. Messages are assigned to a shard by their
+           transaction id, and each shard owns its own transaction maps,
+           timers and fifo. When run() is used each shard gets its own
+           thread. Values below 2 disable sharding. Default 0.
+
+        mLockFreeFifos
+           Bitmask of LockFreeFifo values naming the stack fifos that
+           should run lock-free (see AbstractFifo::setLockFree()). Adding
+           to such a fifo takes no lock, and its reader is only signalled
+           when it goes from empty to non-empty. A lock-free fifo must only
+           be read from one thread; for TuFifo that means
+           SipStack::receive() and friends. Default 0, all fifos locked.
+
+        mDnsCache
+           RRCache for the stack's DnsStub. Stacks in one process that are
+           given the same cache share DNS answers instead of each resolving
+           the same names. Empty (the default) gives the stack its own cache.
+
+        mDnsResolverThreads
+           Number of resolver threads, each with its own DNS channel, that the
+           stack's DnsStub spreads its queries over (hashed by target). Answers
+           are still processed on the DNS thread (or the stack thread).
+           Default 0: queries go out on the DnsStub's own channel.
 **/
 class SipStackOptions
 {
@@ -109,10 +136,18 @@ class SipStackOptions
          : mSecurity(0), mExtraNameserverList(0),
            mAsyncProcessHandler(0), mStateless(false),
            mSocketFunc(0), mCompression(0), mPollGrp(0),
-           mUseDnsVip(false)
+           mUseDnsVip(false), mTransactionControllerShards(0),
+           mLockFreeFifos(0), mDnsResolverThreads(0)
       {
       }
 
+      typedef enum
+      {
+         StateMacFifo = 0x1,      ///< TransactionController's (and shards') state machine fifo
+         TransportTxFifos = 0x2,  ///< the outgoing fifo of each transport
+         TuFifo = 0x4             ///< the SipStack's own TU fifo
+      } LockFreeFifo;
+
       Security* mSecurity;
       const DnsStub::NameserverList* mExtraNameserverList;
       AsyncProcessHandler* mAsyncProcessHandler;
@@ -121,6 +156,10 @@ class SipStackOptions
       Compression *mCompression;
       FdPollGrp* mPollGrp;
       bool mUseDnsVip;
+      unsigned int mTransactionControllerShards;
+      unsigned int mLockFreeFifos;
+      SharedPtr<RRCache> mDnsCache;
+      unsigned int mDnsResolverThreads;
 };
 
 
@@ -353,6 +392,35 @@ class SipStack : public FdSetIOObserver
                               const Data& netns = Data::Empty
                              );
 
+      /**
+          Adds a UDP transport whose socket is sharded across numShards
+          SO_REUSEPORT sockets bound to the same address, each with its own
+          TransportThread, so inbound load spreads across cores while the
+          advertised address stays the same.  Outbound messages are assigned
+          to a shard by hashing the destination.  The transport runs its own
+          threads; see ShardedUdpTransport.
+
+          @param port         port to bind (0 for an ephemeral port shared by
+                              all shards)
+
+          @param numShards    number of sockets/threads (at least 1)
+
+          @param version      IP version
+
+          @param ipInterface  IP address to bind to, or empty for ANY
+
+          @param transportFlags  as for addTransport();
+                              RESIP_TRANSPORT_FLAG_REUSEPORT and
+                              RESIP_TRANSPORT_FLAG_OWNTHREAD are implied
+
+          @return A pointer to the created transport
+      */
+      Transport* addShardedUdpTransport(int port,
+                                        unsigned int numShards,
+                                        IpVersion version=V4,
+                                        const Data& ipInterface = Data::Empty,
+                                        unsigned transportFlags = 0);
+
       /**
           Used to plug-in custom transports.  Adds the transport to the Transport
           Selector.
@@ -947,7 +1015,7 @@ class SipStack : public FdSetIOObserver
       */
       void setFixBadDialogIdentifiers(bool pFixBadDialogIdentifiers) 
       {
-         mTransactionController->mFixBadDialogIdentifiers = pFixBadDialogIdentifiers;
+         mTransactionController->setFixBadDialogIdentifiers(pFixBadDialogIdentifiers);
       }
 
       inline bool getFixBadCSeqNumbers() const
@@ -1140,6 +1208,7 @@ class SipStack : public FdSetIOObserver
       TransactionController* mTransactionController;
 
       TransactionControllerThread* mTransactionControllerThread;
+      std::vector<TransactionControllerThread*> mTransactionShardThreads;
       TransportSelectorThread* mTransportSelectorThread;
       bool mInternalThreadsRunning;
       bool mProcessingHasStarted; 
@@ -1176,6 +1245,9 @@ class SipStack : public FdSetIOObserver
 
       SharedPtr<Transport::SipMessageLoggingHandler> mTransportSipMessageLoggingHandler;
 
+      /// SipStackOptions::mLockFreeFifos, applied to each transport as it is added
+      unsigned int mLockFreeFifos;
+
       friend class Executive;
       friend class StatelessHandler;
       friend class StatisticsManager;
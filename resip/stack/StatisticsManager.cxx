@@ -2,12 +2,15 @@
 #include "config.h"
 #endif
 
+#include "rutil/Lock.hxx"
 #include "rutil/Logger.hxx"
 #include "resip/stack/StatisticsManager.hxx"
 #include "resip/stack/SipMessage.hxx"
 #include "resip/stack/TransactionController.hxx"
 #include "resip/stack/SipStack.hxx"
 
+#include <string.h>
+
 using namespace resip;
 using std::vector;
 
@@ -20,7 +23,10 @@ StatisticsManager::StatisticsManager(SipStack& stack, unsigned long intervalSecs
      mNextPoll(Timer::getTimeMs() + mInterval),
      mExternalHandler(NULL),
      mPublicPayload(NULL)
-{}
+{
+   memset(mUdpRxBatchBase, 0, sizeof(mUdpRxBatchBase));
+   memset(mUdpTxBatchBase, 0, sizeof(mUdpTxBatchBase));
+}
 
 StatisticsManager::~StatisticsManager()
 {
@@ -34,6 +40,57 @@ StatisticsManager::setInterval(unsigned long intervalSecs)
    mInterval = intervalSecs * 1000;
 }
 
+void
+StatisticsManager::enableConcurrentUpdates()
+{
+   if(!mCountersMutex.get())
+   {
+      mCountersMutex.reset(new Mutex);
+   }
+}
+
+void
+StatisticsManager::zeroOut()
+{
+   {
+      PtrLock lock(mCountersMutex.get());
+      StatisticsMessage::Payload::zeroOut();
+   }
+   for (int t = 0; t < MaxLatencyType; ++t)
+   {
+      for (int m = 0; m < MAX_METHODS; ++m)
+      {
+         mServerLatency[t][m].reset();
+         mClientLatency[t][m].reset();
+      }
+   }
+   mTuFifoDwell.reset();
+   mTransactionUserFifoDwell.reset();
+
+   memset(mUdpRxBatchBase, 0, sizeof(mUdpRxBatchBase));
+   memset(mUdpTxBatchBase, 0, sizeof(mUdpTxBatchBase));
+   mStack.mTransactionController->sumTransportBatchSizes(mUdpRxBatchBase, mUdpTxBatchBase);
+}
+
+static unsigned int
+clampLatency(UInt64 us)
+{
+   return us > 0xFFFFFFFFULL ? 0xFFFFFFFFU : (unsigned int)us;
+}
+
+void
+StatisticsManager::summarize(const LatencyHistogram& histogram, LatencySummary& summary)
+{
+   LatencyHistogram::Snapshot snap;
+   histogram.snapshot(snap);
+   summary.count = clampLatency(snap.getCount());
+   summary.p50 = clampLatency(snap.percentile(50.0));
+   summary.p90 = clampLatency(snap.percentile(90.0));
+   summary.p99 = clampLatency(snap.percentile(99.0));
+   summary.p999 = clampLatency(snap.percentile(99.9));
+   summary.max = clampLatency(snap.max());
+}
+
 void 
 StatisticsManager::poll()
 {
@@ -44,6 +101,32 @@ StatisticsManager::poll()
    activeTimers = mStack.mTransactionController->getTimerQueueSize();
    activeClientTransactions = mStack.mTransactionController->getNumClientTransactions();
    activeServerTransactions = mStack.mTransactionController->getNumServerTransactions();
+   // batch histograms and TLS handshake counts are cumulative counters
+   // owned by the transports; the histograms are reported since zeroOut()
+   memset(udpRxBatchSizes, 0, sizeof(udpRxBatchSizes));
+   memset(udpTxBatchSizes, 0, sizeof(udpTxBatchSizes));
+   mStack.mTransactionController->sumTransportBatchSizes(udpRxBatchSizes, udpTxBatchSizes);
+   for (int b = 0; b < MaxBatchBucket; ++b)
+   {
+      // a transport removed since zeroOut() takes its counts with it
+      udpRxBatchSizes[b] = udpRxBatchSizes[b] > mUdpRxBatchBase[b] ? udpRxBatchSizes[b] - mUdpRxBatchBase[b] : 0;
+      udpTxBatchSizes[b] = udpTxBatchSizes[b] > mUdpTxBatchBase[b] ? udpTxBatchSizes[b] - mUdpTxBatchBase[b] : 0;
+   }
+   tlsFullHandshakes = 0;
+   tlsResumedHandshakes = 0;
+   tlsSessionCacheEvictions = 0;
+   mStack.mTransactionController->sumTransportTlsSessionStats(tlsFullHandshakes, tlsResumedHandshakes, 
+                                                              tlsSessionCacheEvictions);
+   for (int t = 0; t < MaxLatencyType; ++t)
+   {
+      for (int m = 0; m < MAX_METHODS; ++m)
+      {
+         summarize(mServerLatency[t][m], serverLatency[t][m]);
+         summarize(mClientLatency[t][m], clientLatency[t][m]);
+      }
+   }
+   summarize(mTuFifoDwell, tuFifoDwell);
+   summarize(mTransactionUserFifoDwell, transactionUserFifoDwell);
 
    // .kw. At last check payload was > 146kB, which seems too large
    // to alloc on stack. Also, the post'd message has reference
@@ -54,7 +137,10 @@ StatisticsManager::poll()
        mPublicPayload = new StatisticsMessage::AtomicPayload;
        // re-used each time, free'd in destructor
    }
-   mPublicPayload->loadIn(*this);
+   {
+      PtrLock lock(mCountersMutex.get());
+      mPublicPayload->loadIn(*this);
+   }
 
    bool postToStack = true;
    StatisticsMessage msg(*mPublicPayload);
@@ -93,6 +179,7 @@ StatisticsManager::process()
 bool
 StatisticsManager::sent(SipMessage* msg)
 {
+   PtrLock lock(mCountersMutex.get());
    MethodTypes met = msg->method();
 
    if (msg->isRequest())
@@ -121,6 +208,7 @@ StatisticsManager::retransmitted(MethodTypes met,
                                  bool request, 
                                  unsigned int code)
 {
+   PtrLock lock(mCountersMutex.get());
    if(request)
    {
       ++requestsRetransmitted;
@@ -138,6 +226,7 @@ StatisticsManager::retransmitted(MethodTypes met,
 bool
 StatisticsManager::received(SipMessage* msg)
 {
+   PtrLock lock(mCountersMutex.get());
    MethodTypes met = msg->header(h_CSeq).method();
 
    if (msg->isRequest())
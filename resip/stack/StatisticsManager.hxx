@@ -3,6 +3,10 @@
 
 #include "rutil/Timer.hxx"
 #include "rutil/Data.hxx"
+#include "rutil/Mutex.hxx"
+#include "rutil/LatencyHistogram.hxx"
+
+#include <memory>
 #include "resip/stack/StatisticsMessage.hxx"
 #include "resip/stack/StatisticsHandler.hxx"
 
@@ -50,11 +54,30 @@ class StatisticsManager : public StatisticsMessage::Payload
          mExternalHandler = handler;
       }
 
+      // Called when several TransactionController shards count messages 
+      // concurrently; must be called before the stack starts processing.
+      void enableConcurrentUpdates();
+
+      /// Resets the counters and the latency histograms.
+      void zeroOut();
+
+      // Histograms for the dwell time of messages in the fifo from the stack
+      // to the TU, and in the fifos of registered TransactionUsers. Both are
+      // attached by the SipStack.
+      LatencyHistogram& getTuFifoDwell() { return mTuFifoDwell; }
+      LatencyHistogram& getTransactionUserFifoDwell() { return mTransactionUserFifoDwell; }
+
    private:
       friend class TransactionState;
       bool sent(SipMessage* msg);
       bool retransmitted(MethodTypes type, bool request, unsigned int code);
       bool received(SipMessage* msg);
+      // lock-free; may be called from any transaction shard
+      void transactionLatency(bool client, MethodTypes method, LatencyType type, UInt64 us)
+      {
+         (client ? mClientLatency : mServerLatency)[type][method].record(us);
+      }
+      static void summarize(const LatencyHistogram& histogram, LatencySummary& summary);
 
       void poll(); // force an update
 
@@ -69,6 +92,19 @@ class StatisticsManager : public StatisticsMessage::Payload
       // published thru both ExternalHandler and posted to stack as message.
       // This payload is mutex protected.
       StatisticsMessage::AtomicPayload *mPublicPayload;
+
+      // only allocated by enableConcurrentUpdates()
+      std::auto_ptr<Mutex> mCountersMutex;
+
+      LatencyHistogram mServerLatency[MaxLatencyType][MAX_METHODS];
+      LatencyHistogram mClientLatency[MaxLatencyType][MAX_METHODS];
+      LatencyHistogram mTuFifoDwell;
+      LatencyHistogram mTransactionUserFifoDwell;
+
+      // the transports' batch histograms at the last zeroOut(); they only
+      // ever count up, so poll() reports the difference
+      unsigned int mUdpRxBatchBase[MaxBatchBucket];
+      unsigned int mUdpTxBatchBase[MaxBatchBucket];
 };
 
 }
@@ -89,6 +89,18 @@ StatisticsMessage::Payload::sumErrOut(MethodTypes method) const
    return ret;
 }
 
+unsigned int
+StatisticsMessage::Payload::batchBucket(unsigned int batchSize)
+{
+   unsigned int bucket = 0;
+   while (batchSize > 1 && bucket < MaxBatchBucket-1)
+   {
+      batchSize >>= 1;
+      ++bucket;
+   }
+   return bucket;
+}
+
 void 
 StatisticsMessage::logStats(const resip::Subsystem& subsystem, 
                             const StatisticsMessage::Payload& stats)
@@ -137,6 +149,15 @@ StatisticsMessage::Payload::zeroOut()
    memset(responsesSentByMethodByCode, 0, sizeof(responsesSentByMethodByCode));
    memset(responsesRetransmittedByMethodByCode, 0, sizeof(responsesRetransmittedByMethodByCode));
    memset(responsesReceivedByMethodByCode, 0, sizeof(responsesReceivedByMethodByCode));
+   memset(udpRxBatchSizes, 0, sizeof(udpRxBatchSizes));
+   memset(udpTxBatchSizes, 0, sizeof(udpTxBatchSizes));
+   tlsFullHandshakes = 0;
+   tlsResumedHandshakes = 0;
+   tlsSessionCacheEvictions = 0;
+   memset(serverLatency, 0, sizeof(serverLatency));
+   memset(clientLatency, 0, sizeof(clientLatency));
+   memset(&tuFifoDwell, 0, sizeof(tuFifoDwell));
+   memset(&transactionUserFifoDwell, 0, sizeof(transactionUserFifoDwell));
 }
 
 StatisticsMessage::Payload&
@@ -171,6 +192,15 @@ StatisticsMessage::Payload::operator=(const StatisticsMessage::Payload& rhs)
       memcpy(responsesSentByMethodByCode, rhs.responsesSentByMethodByCode, sizeof(responsesSentByMethodByCode));
       memcpy(responsesRetransmittedByMethodByCode, rhs.responsesRetransmittedByMethodByCode, sizeof(responsesRetransmittedByMethodByCode));
       memcpy(responsesReceivedByMethodByCode, rhs.responsesReceivedByMethodByCode, sizeof(responsesReceivedByMethodByCode));
+      memcpy(udpRxBatchSizes, rhs.udpRxBatchSizes, sizeof(udpRxBatchSizes));
+      memcpy(udpTxBatchSizes, rhs.udpTxBatchSizes, sizeof(udpTxBatchSizes));
+      tlsFullHandshakes = rhs.tlsFullHandshakes;
+      tlsResumedHandshakes = rhs.tlsResumedHandshakes;
+      tlsSessionCacheEvictions = rhs.tlsSessionCacheEvictions;
+      memcpy(serverLatency, rhs.serverLatency, sizeof(serverLatency));
+      memcpy(clientLatency, rhs.clientLatency, sizeof(clientLatency));
+      tuFifoDwell = rhs.tuFifoDwell;
+      transactionUserFifoDwell = rhs.transactionUserFifoDwell;
    }
 
    return *this;
@@ -199,6 +229,41 @@ StatisticsMessage::AtomicPayload::loadOut(Payload& payload) const
    payload = (*this);
 }
 
+static void
+encodeLatency(EncodeStream& strm, const char* label, const StatisticsMessage::Payload::LatencySummary& latency)
+{
+   strm << label << latency.count
+        << " p50 " << latency.p50
+        << " p90 " << latency.p90
+        << " p99 " << latency.p99
+        << " p99.9 " << latency.p999
+        << " max " << latency.max;
+}
+
+static void
+encodeLatencies(EncodeStream& strm, const char* side, 
+                const StatisticsMessage::Payload::LatencySummary latencies[][MAX_METHODS])
+{
+   static const char* const names[StatisticsMessage::Payload::MaxLatencyType] = {"1xx", "final", "lifetime"};
+   for (int m = 0; m < MAX_METHODS; ++m)
+   {
+      if (latencies[StatisticsMessage::Payload::TransactionLifetime][m].count == 0)
+      {
+         continue;
+      }
+      strm << std::endl << "Latency(us) " << side << " " << getMethodName((MethodTypes)m) << ":";
+      for (int t = 0; t < StatisticsMessage::Payload::MaxLatencyType; ++t)
+      {
+         if (latencies[t][m].count)
+         {
+            strm << " [";
+            encodeLatency(strm, names[t], latencies[t][m]);
+            strm << "]";
+         }
+      }
+   }
+}
+
 EncodeStream& 
 resip::operator<<(EncodeStream& strm, const StatisticsMessage::Payload& stats)
 {
@@ -273,6 +338,42 @@ resip::operator<<(EncodeStream& strm, const StatisticsMessage::Payload& stats)
         << " PRAx " << stats.requestsRetransmittedByMethod[PRACK]
         << " SERx " << stats.requestsRetransmittedByMethod[SERVICE]
         << " UPDx " << stats.requestsRetransmittedByMethod[UPDATE];
+
+   unsigned int batches = 0;
+   for (int b = 0; b < StatisticsMessage::Payload::MaxBatchBucket; ++b)
+   {
+      batches += stats.udpRxBatchSizes[b] + stats.udpTxBatchSizes[b];
+   }
+   if (batches)
+   {
+      strm << std::endl << "UDP batches (1/2/4/8/16/32/64/128+): rx";
+      for (int b = 0; b < StatisticsMessage::Payload::MaxBatchBucket; ++b)
+      {
+         strm << (b ? "/" : " ") << stats.udpRxBatchSizes[b];
+      }
+      strm << " tx";
+      for (int b = 0; b < StatisticsMessage::Payload::MaxBatchBucket; ++b)
+      {
+         strm << (b ? "/" : " ") << stats.udpTxBatchSizes[b];
+      }
+   }
+
+   if (stats.tlsFullHandshakes || stats.tlsResumedHandshakes)
+   {
+      strm << std::endl << "TLS handshakes: full " << stats.tlsFullHandshakes
+           << " resumed " << stats.tlsResumedHandshakes
+           << " (session cache evictions " << stats.tlsSessionCacheEvictions << ")";
+   }
+
+   encodeLatencies(strm, "server", stats.serverLatency);
+   encodeLatencies(strm, "client", stats.clientLatency);
+   if (stats.tuFifoDwell.count || stats.transactionUserFifoDwell.count)
+   {
+      strm << std::endl << "Fifo dwell(us): ";
+      encodeLatency(strm, "TU ", stats.tuFifoDwell);
+      strm << " ";
+      encodeLatency(strm, "TransactionUser ", stats.transactionUserFifoDwell);
+   }
    strm.flush();
    return strm;
 }
@@ -24,6 +24,29 @@ class StatisticsMessage : public ApplicationMessage
       struct Payload
       {
             enum {MaxCode = 700};
+            // batch size histograms are bucketed by powers of two:
+            // bucket n counts batches of [2^n, 2^(n+1)) messages
+            enum {MaxBatchBucket = 8};
+            // transaction latencies, measured from the request being
+            // received (server) or first sent (client)
+            enum LatencyType
+            {
+               FirstProvisionalLatency,
+               FinalResponseLatency,
+               TransactionLifetime,
+               MaxLatencyType
+            };
+
+            // percentiles of a latency histogram, in microseconds
+            struct LatencySummary
+            {
+               unsigned int count;
+               unsigned int p50;
+               unsigned int p90;
+               unsigned int p99;
+               unsigned int p999;
+               unsigned int max;
+            };
 
             Payload();
             
@@ -56,6 +79,20 @@ class StatisticsMessage : public ApplicationMessage
             unsigned int responsesRetransmittedByMethodByCode[MAX_METHODS][MaxCode];
             unsigned int responsesReceivedByMethodByCode[MAX_METHODS][MaxCode];
 
+            unsigned int udpRxBatchSizes[MaxBatchBucket]; // datagrams per recvmmsg()
+            unsigned int udpTxBatchSizes[MaxBatchBucket]; // datagrams per sendmmsg()
+
+            unsigned int tlsFullHandshakes;
+            unsigned int tlsResumedHandshakes; // by session id or ticket
+            unsigned int tlsSessionCacheEvictions;
+
+            LatencySummary serverLatency[MaxLatencyType][MAX_METHODS];
+            LatencySummary clientLatency[MaxLatencyType][MAX_METHODS];
+            LatencySummary tuFifoDwell; // SipStack -> TU fifo
+            LatencySummary transactionUserFifoDwell; // summed over registered TransactionUsers
+
+            static unsigned int batchBucket(unsigned int batchSize);
+
             unsigned int sum2xxIn(MethodTypes method) const;
             unsigned int sumErrIn(MethodTypes method) const;
             unsigned int sum2xxOut(MethodTypes method) const;
@@ -2,10 +2,15 @@
 #include "config.h"
 #endif
 
+#ifndef WIN32
+#include <sys/uio.h>
+#endif
+
 #include "rutil/Logger.hxx"
 #include "rutil/Socket.hxx"
 #include "resip/stack/TcpConnection.hxx"
 #include "resip/stack/Tuple.hxx"
+#include "resip/stack/SendData.hxx"
 
 using namespace resip;
 
@@ -108,6 +113,74 @@ TcpConnection::write( const char* buf, const int count )
    return bytesWritten;
 }
 
+int 
+TcpConnection::writeGather(SendData& data, Data::size_type offset)
+{
+#if defined(WIN32)
+   return Connection::writeGather(data, offset);
+#else
+   struct iovec iov[SendData::MaxFragments];
+   int iovCount = data.fillIovecs(iov, SendData::MaxFragments, offset);
+   resip_assert(iovCount > 0);
+
+   int bytesWritten = ::writev(getSocket(), iov, iovCount);
+
+   if (bytesWritten == INVALID_SOCKET)
+   {
+      int e = getErrno();
+      if (e == EAGAIN || e == EWOULDBLOCK)
+      {
+          return 0;
+      }
+      InfoLog (<< "Failed write on " << getSocket() << " " << strerror(e));
+      Transport::error(e);
+      return -1;
+   }
+   
+   return bytesWritten;
+#endif
+}
+
+int
+TcpConnection::writeQueue(SendData& first, Data::size_type offset, Data::size_type budget)
+{
+#if defined(WIN32)
+   return Connection::writeQueue(first, offset, budget);
+#else
+   // One writev() for as much of the queue as fits; whatever the kernel
+   // doesn't take is picked up from the bookkeeping in performWrite().
+   static const int MaxIovecs = 2*SendData::MaxFragments;
+   struct iovec iov[MaxIovecs];
+   int iovCount = first.fillIovecs(iov, MaxIovecs, offset);
+   resip_assert(iovCount > 0);
+   Data::size_type total = first.size() - offset;
+
+   for (SendData* next = nextBatchable(first); 
+        next && iovCount < MaxIovecs && total + next->size() <= budget;
+        next = nextBatchable(*next))
+   {
+      iovCount += next->fillIovecs(iov + iovCount, MaxIovecs - iovCount);
+      total += next->size();
+   }
+
+   int bytesWritten = ::writev(getSocket(), iov, iovCount);
+
+   if (bytesWritten == INVALID_SOCKET)
+   {
+      int e = getErrno();
+      if (e == EAGAIN || e == EWOULDBLOCK)
+      {
+          return 0;
+      }
+      InfoLog (<< "Failed write on " << getSocket() << " " << strerror(e));
+      Transport::error(e);
+      return -1;
+   }
+   
+   return bytesWritten;
+#endif
+}
+
 bool 
 TcpConnection::hasDataToRead()
 {
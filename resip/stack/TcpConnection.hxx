@@ -15,6 +15,8 @@ class TcpConnection : public Connection
       
       int read( char* buf, const int count );
       int write( const char* buf, const int count );
+      virtual int writeGather(SendData& data, Data::size_type offset);
+      virtual int writeQueue(SendData& first, Data::size_type offset, Data::size_type budget);
       virtual bool hasDataToRead(); // has data that can be read 
       virtual bool isGood(); // has valid connection
       virtual bool isWritable();
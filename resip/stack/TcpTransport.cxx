@@ -46,6 +46,16 @@ TcpTransport::~TcpTransport()
 {
 }
 
+bool
+TcpTransport::canSendFragments() const
+{
+#if defined(WIN32)
+   return false;
+#else
+   return (mTransportFlags & RESIP_TRANSPORT_FLAG_TXGATHER)!=0;
+#endif
+}
+
 Connection*
 TcpTransport::createConnection(const Tuple& who, Socket fd, bool server)
 {
@@ -22,6 +22,8 @@ class TcpTransport : public TcpBaseTransport
                    const Data& netNs = Data::Empty);
       virtual  ~TcpTransport();
 
+      virtual bool canSendFragments() const;
+
    protected:
       Connection* createConnection(const Tuple& who, Socket fd, bool server=false);
 };
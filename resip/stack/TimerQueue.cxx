@@ -19,66 +19,77 @@ using namespace std;
 
 #define RESIPROCATE_SUBSYSTEM Subsystem::TRANSACTION
 
-TransactionTimerQueue::TransactionTimerQueue(Fifo<TimerMessage>& fifo)
-   : mFifo(fifo)
+TimerQueueBase::Implementation TimerQueueBase::DefaultImplementation = TimerQueueBase::Heap;
+
+TransactionTimerQueue::TransactionTimerQueue(Fifo<TimerMessage>& fifo,
+                                             Implementation impl)
+   : TimerQueue<TransactionTimer>(impl),
+     mFifo(fifo)
 {
 }
 
 #ifdef USE_DTLS
 
-DtlsTimerQueue::DtlsTimerQueue( Fifo<DtlsMessage>& fifo )
-    : mFifo( fifo )
+DtlsTimerQueue::DtlsTimerQueue( Fifo<DtlsMessage>& fifo, Implementation impl )
+    : TimerQueue<TimerWithPayload>( impl ),
+      mFifo( fifo )
 {
 }
 
 DtlsTimerQueue::~DtlsTimerQueue()
 {
-   while(!mTimers.empty())
-   {
-      delete mTimers.top().getMessage();
-      mTimers.pop();
-   }
+   clearTimers();
 }
 
 #endif
 
-UInt64
+TransactionTimerQueue::Id
 TransactionTimerQueue::add(Timer::Type type, const Data& transactionId, unsigned long msOffset)
 {
    TransactionTimer t(msOffset, type, transactionId);
-   mTimers.push(t);
    DebugLog (<< "Adding timer: " << Timer::toData(type) << " tid=" << transactionId << " ms=" << msOffset);
-   return mTimers.top().getWhen();
+   return addTimer(t);
 }
 
 #ifdef USE_DTLS
 
-UInt64
+DtlsTimerQueue::Id
 DtlsTimerQueue::add( SSL *ssl, unsigned long msOffset )
 {
    TimerWithPayload t( msOffset, new DtlsMessage( ssl ) ) ;
-   mTimers.push( t ) ;
-   return mTimers.top().getWhen();
+   return addTimer( t ) ;
+}
+
+void
+DtlsTimerQueue::discardTimer(const TimerWithPayload& timer)
+{
+   delete timer.getMessage();
 }
 
 #endif
 
+BaseTimeLimitTimerQueue::BaseTimeLimitTimerQueue(Implementation impl)
+   : TimerQueue<TimerWithPayload>(impl)
+{
+}
+
 BaseTimeLimitTimerQueue::~BaseTimeLimitTimerQueue()
 {
-   while(!mTimers.empty())
-   {
-      delete mTimers.top().getMessage();
-      mTimers.pop();
-   }
+   clearTimers();
 }
 
-UInt64
+BaseTimeLimitTimerQueue::Id
 BaseTimeLimitTimerQueue::add(unsigned int timeMs,Message* payload)
 {
    resip_assert(payload);
    DebugLog(<< "Adding application timer: " << payload->brief() << " ms=" << timeMs);
-   mTimers.push(TimerWithPayload(timeMs,payload));
-   return mTimers.top().getWhen();
+   return addTimer(TimerWithPayload(timeMs,payload));
+}
+
+void
+BaseTimeLimitTimerQueue::discardTimer(const TimerWithPayload& timer)
+{
+   delete timer.getMessage();
 }
 
 void
@@ -96,7 +107,10 @@ TransactionTimerQueue::processTimer(const TransactionTimer& timer)
                               timer.getDuration()));
 }
 
-TimeLimitTimerQueue::TimeLimitTimerQueue(TimeLimitFifo<Message>& fifo) : mFifo(fifo)
+TimeLimitTimerQueue::TimeLimitTimerQueue(TimeLimitFifo<Message>& fifo,
+                                         Implementation impl)
+   : BaseTimeLimitTimerQueue(impl),
+     mFifo(fifo)
 {}
 
 void
@@ -105,25 +119,29 @@ TimeLimitTimerQueue::addToFifo(Message*msg, TimeLimitFifo<Message>::DepthUsage d
    mFifo.add(msg, d);
 }
 
-TuSelectorTimerQueue::TuSelectorTimerQueue(TuSelector& sel) : mFifoSelector(sel)
+TuSelectorTimerQueue::TuSelectorTimerQueue(TuSelector& sel,
+                                           Implementation impl)
+   : TimerQueue<TimerWithPayload>(impl),
+     mFifoSelector(sel)
 {}
 
 TuSelectorTimerQueue::~TuSelectorTimerQueue()
 {
-   while(!mTimers.empty())
-   {
-      delete mTimers.top().getMessage();
-      mTimers.pop();
-   }
+   clearTimers();
 }
 
-UInt64
+TuSelectorTimerQueue::Id
 TuSelectorTimerQueue::add(unsigned int timeMs,Message* payload)
 {
    resip_assert(payload);
    DebugLog(<< "Adding application timer: " << payload->brief() << " ms=" << timeMs);
-   mTimers.push(TimerWithPayload(timeMs,payload));
-   return mTimers.top().getWhen();
+   return addTimer(TimerWithPayload(timeMs,payload));
+}
+
+void
+TuSelectorTimerQueue::discardTimer(const TimerWithPayload& timer)
+{
+   delete timer.getMessage();
 }
 
 void
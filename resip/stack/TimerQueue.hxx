@@ -11,14 +11,11 @@
 #include <iosfwd>
 #include "resip/stack/TimerMessage.hxx"
 #include "resip/stack/DtlsMessage.hxx"
+#include "resip/stack/TimerWheel.hxx"
 #include "rutil/Fifo.hxx"
 #include "rutil/TimeLimitFifo.hxx"
 #include "rutil/Timer.hxx"
 
-// .dlb. 
-// to do: timer wheel for transaction-bound timers and a heap for
-// everything longer.
-
 namespace resip
 {
 
@@ -26,32 +23,84 @@ class Message;
 class TransactionMessage;
 class TuSelector;
 
+/**
+  * @internal
+  * @brief Non-template part of TimerQueue; selects the container used to
+  * hold pending timers.
+  */
+class TimerQueueBase
+{
+   public:
+      typedef enum
+      {
+         Heap,  ///< binary heap; O(log n) insert, cancel is not supported
+         Wheel  ///< hierarchical timing wheel; O(1) insert and cancel
+      } Implementation;
+
+      /** The implementation used by queues constructed without an explicit
+          one. Must be set before the queues (ie. the SipStack) are created.
+          Defaults to Heap. */
+      static Implementation DefaultImplementation;
+};
+
 /**
   * @internal
   * @brief This class takes a fifo as a place to where you can write your stuff.
   * When using this in the main loop, call process() on this.
   * During Transaction processing, TimerMessages and SIP messages are generated.
-  * 
-    @todo .dlb. timer wheel for transaction-bound timers and a heap for 
-      everything longer.
+  *
+  * Pending timers are kept either in a heap or in a TimerWheel, see
+  * TimerQueueBase::Implementation. Only the wheel can cancel a timer; with
+  * the heap, add() returns 0 and cancel() does nothing, so the timer fires
+  * as it always did.
   */
 template <class T>
-class TimerQueue
+class TimerQueue : public TimerQueueBase
 {
    public:
+      typedef typename TimerWheel<T>::Id Id;
+
+      TimerQueue(Implementation impl=DefaultImplementation)
+         : mWheel(impl == Wheel ? new TimerWheel<T>() : 0)
+      {
+      }
+
       // This is the logic that runs when a timer goes off. This is the only
       // thing subclasses must implement.
       virtual void processTimer(const T& timer)=0;
 
-      /// @brief deletes the message associated with the timer as well.
+      /// @brief subclasses that own a payload must call clearTimers() from
+      /// their destructor
       virtual ~TimerQueue()
       {
-         //xkd-2004-11-4
-         // delete the message associated with the timer
-         while (!mTimers.empty())
+         delete mWheel;
+      }
+
+      /// @brief removes a pending timer without firing it
+      /// @retval true if the timer was pending
+      bool cancel(Id id)
+      {
+         if (mWheel)
          {
-            mTimers.pop();
+            const T* timer = mWheel->find(id);
+            if (timer)
+            {
+               discardTimer(*timer);
+               return mWheel->cancel(id);
+            }
          }
+         return false;
+      }
+
+      bool isPending(Id id) const
+      {
+         return mWheel && mWheel->isPending(id);
+      }
+
+      /// @retval true if cancel() can remove timers, i.e. this is a Wheel
+      bool canCancel() const
+      {
+         return mWheel != 0;
       }
 
       /// @brief provides the time in milliseconds before the next timer will fire
@@ -61,9 +110,9 @@ class TimerQueue
       ///
       unsigned int msTillNextTimer()
       {
-         if (!mTimers.empty())
+         if (!empty())
          {
-            UInt64 next = mTimers.top().getWhen();
+            UInt64 next = nextWhen();
             UInt64 now = Timer::getTimeMs();
             if (now > next) 
             {
@@ -93,7 +142,24 @@ class TimerQueue
       /// machine fifo and application messages into the TU fifo
       virtual UInt64 process()
       {
-         if (!mTimers.empty())
+         if (mWheel)
+         {
+            // keep the wheel's clock moving even while it is empty, so that
+            // the next add() is filed relative to the current time
+            UInt64 now=Timer::getTimeMs();
+            const T* timer;
+            while ((timer = mWheel->peekExpired(now)) != 0)
+            {
+               processTimer(*timer);
+               mWheel->popExpired();
+            }
+
+            if(!mWheel->empty())
+            {
+               return mWheel->nextWhen();
+            }
+         }
+         else if (!mTimers.empty())
          {
             UInt64 now=Timer::getTimeMs();
             while (!mTimers.empty() && !(mTimers.top().getWhen() > now))
@@ -112,20 +178,20 @@ class TimerQueue
 
       int size() const
       {
-         return (int)mTimers.size();
+         return mWheel ? (int)mWheel->size() : (int)mTimers.size();
       }
 
       bool empty() const
       {
-         return mTimers.empty();
+         return mWheel ? mWheel->empty() : mTimers.empty();
       }
 
       std::ostream& encode(std::ostream& str) const
       {
-         if(mTimers.size() > 0)
+         if(size() > 0)
          {
-            return str << "TimerQueue[ size =" << mTimers.size() 
-                       << " top=" << mTimers.top() << "]" ;
+            return str << "TimerQueue[ size =" << size() 
+                       << " top=" << top() << "]" ;
          }
          else
          {
@@ -136,10 +202,10 @@ class TimerQueue
 #ifndef RESIP_USE_STL_STREAMS
       EncodeStream& encode(EncodeStream& str) const
       {
-         if(mTimers.size() > 0)
+         if(size() > 0)
          {
-            return str << "TimerQueue[ size =" << mTimers.size() 
-                       << " top=" << mTimers.top() << "]" ;
+            return str << "TimerQueue[ size =" << size() 
+                       << " top=" << top() << "]" ;
          }
          else
          {
@@ -149,8 +215,62 @@ class TimerQueue
 #endif
 
    protected:
+      Id addTimer(const T& timer)
+      {
+         if (mWheel)
+         {
+            return mWheel->add(timer);
+         }
+         mTimers.push(timer);
+         return 0;
+      }
+
+      /// @brief releases anything the timer owns when it is cancelled or
+      /// destroyed without firing
+      virtual void discardTimer(const T& timer)
+      {
+      }
+
+      /// @brief discards all pending timers
+      void clearTimers()
+      {
+         if (mWheel)
+         {
+            const T* timer;
+            while ((timer = mWheel->peekAny()) != 0)
+            {
+               discardTimer(*timer);
+               mWheel->popAny();
+            }
+         }
+         else
+         {
+            while (!mTimers.empty())
+            {
+               discardTimer(mTimers.top());
+               mTimers.pop();
+            }
+         }
+      }
+
+      UInt64 nextWhen() const
+      {
+         return mWheel ? mWheel->nextWhen() : mTimers.top().getWhen();
+      }
+
+      const T& top() const
+      {
+         return mWheel ? *mWheel->peekNext() : mTimers.top();
+      }
+
       typedef std::vector<T, std::allocator<T> > TimerVector;
       std::priority_queue<T, TimerVector, std::greater<T> > mTimers;
+      TimerWheel<T>* mWheel;
+
+   private:
+      // disabled
+      TimerQueue(const TimerQueue&);
+      TimerQueue& operator=(const TimerQueue&);
 };
 
 /**
@@ -159,11 +279,13 @@ class TimerQueue
 class BaseTimeLimitTimerQueue : public TimerQueue<TimerWithPayload>
 {
    public:
+      BaseTimeLimitTimerQueue(Implementation impl=DefaultImplementation);
       ~BaseTimeLimitTimerQueue();
-      UInt64 add(unsigned int timeMs,Message* payload);
+      Id add(unsigned int timeMs,Message* payload);
       virtual void processTimer(const TimerWithPayload& timer);
    protected:
       virtual void addToFifo(Message*, TimeLimitFifo<Message>::DepthUsage)=0;      
+      virtual void discardTimer(const TimerWithPayload& timer);
 };
 
 
@@ -173,7 +295,8 @@ class BaseTimeLimitTimerQueue : public TimerQueue<TimerWithPayload>
 class TimeLimitTimerQueue : public BaseTimeLimitTimerQueue
 {
    public:
-      TimeLimitTimerQueue(TimeLimitFifo<Message>& fifo);
+      TimeLimitTimerQueue(TimeLimitFifo<Message>& fifo,
+                          Implementation impl=DefaultImplementation);
    protected:
       virtual void addToFifo(Message*, TimeLimitFifo<Message>::DepthUsage);
    private:
@@ -187,10 +310,13 @@ class TimeLimitTimerQueue : public BaseTimeLimitTimerQueue
 class TuSelectorTimerQueue : public TimerQueue<TimerWithPayload>
 {
    public:
-      TuSelectorTimerQueue(TuSelector& sel);
+      TuSelectorTimerQueue(TuSelector& sel,
+                           Implementation impl=DefaultImplementation);
       ~TuSelectorTimerQueue();
-      UInt64 add(unsigned int timeMs,Message* payload);
+      Id add(unsigned int timeMs,Message* payload);
       virtual void processTimer(const TimerWithPayload& timer);
+   protected:
+      virtual void discardTimer(const TimerWithPayload& timer);
    private:
       TuSelector& mFifoSelector;
 };
@@ -202,8 +328,9 @@ class TuSelectorTimerQueue : public TimerQueue<TimerWithPayload>
 class TransactionTimerQueue : public TimerQueue<TransactionTimer>
 {
    public:
-      TransactionTimerQueue(Fifo<TimerMessage>& fifo);
-      UInt64 add(Timer::Type type, const Data& transactionId, unsigned long msOffset);
+      TransactionTimerQueue(Fifo<TimerMessage>& fifo,
+                            Implementation impl=DefaultImplementation);
+      Id add(Timer::Type type, const Data& transactionId, unsigned long msOffset);
       virtual void processTimer(const TransactionTimer& timer);
    private:
       Fifo<TimerMessage>& mFifo;
@@ -219,11 +346,15 @@ class TransactionTimerQueue : public TimerQueue<TransactionTimer>
 class DtlsTimerQueue : public TimerQueue<TimerWithPayload>
 {
    public:
-      DtlsTimerQueue(Fifo<DtlsMessage>& fifo);
+      DtlsTimerQueue(Fifo<DtlsMessage>& fifo,
+                     Implementation impl=DefaultImplementation);
       ~DtlsTimerQueue();
-      UInt64 add(SSL *, unsigned long msOffset);
+      Id add(SSL *, unsigned long msOffset);
       virtual void processTimer(const TimerWithPayload& timer) ;
-      
+
+   protected:
+      virtual void discardTimer(const TimerWithPayload& timer);
+
    private:
       Fifo<DtlsMessage>& mFifo ;
 };
@@ -0,0 +1,559 @@
+#if !defined(RESIP_TIMERWHEEL_HXX)
+#define RESIP_TIMERWHEEL_HXX
+
+#include <new>
+#include <vector>
+#include <limits.h>
+
+#include "rutil/compat.hxx"
+#include "rutil/ResipAssert.h"
+#include "rutil/Timer.hxx"
+
+namespace resip
+{
+
+/**
+  * @internal
+  * @brief Hierarchical timing wheel keyed on millisecond expiry times.
+  *
+  * The first level has 256 one millisecond slots; four more levels of 64
+  * slots each cover 2^14, 2^20, 2^26 and 2^32 ms. A timer is filed in the
+  * lowest level whose range covers its distance from the wheel's notion of
+  * "now", and is moved down a level each time the wheel passes the start of
+  * its slot (the scheme used by the Linux kernel). Timers further out than
+  * the top level are parked in it and refiled until they fit.
+  *
+  * Entries live in a pool of nodes that is grown in fixed size blocks and
+  * never shrinks, so insertion, cancellation and expiry are all O(1) and do
+  * not touch the heap in steady state. Each add() returns an Id made of the
+  * node index and a generation count; once the timer has fired or been
+  * cancelled the Id goes stale and cancel()/isPending() ignore it.
+  *
+  * T must provide UInt64 getWhen() const and be copy constructible.
+  */
+template <class T>
+class TimerWheel
+{
+   public:
+      /// Identifies a pending timer; 0 is never a valid Id.
+      typedef UInt64 Id;
+
+      explicit TimerWheel(UInt64 now=Timer::getTimeMs())
+         : mNow(now),
+           mSize(0),
+           mFreeList(Nil),
+           mNextWhen(0),
+           mNextWhenValid(false),
+           mDrainSlot(0)
+      {
+         for (unsigned int s = 0; s < NumSlots; ++s)
+         {
+            mHead[s] = Nil;
+            mTail[s] = Nil;
+            mSlotMinValid[s] = false;
+         }
+         for (unsigned int l = 0; l < NumLevels; ++l)
+         {
+            mLevelSize[l] = 0;
+         }
+      }
+
+      ~TimerWheel()
+      {
+         while (peekAny())
+         {
+            popAny();
+         }
+         for (typename std::vector<Node*>::iterator i = mBlocks.begin(); i != mBlocks.end(); ++i)
+         {
+            delete [] *i;
+         }
+      }
+
+      Id add(const T& timer)
+      {
+         UInt32 index = allocNode();
+         Node& n = node(index);
+         new (n.mStorage.mBytes) T(timer);
+         n.mInUse = true;
+         link(index, timer.getWhen());
+         ++mSize;
+
+         if (mSize == 1 || (mNextWhenValid && timer.getWhen() < mNextWhen))
+         {
+            mNextWhen = timer.getWhen();
+            mNextWhenValid = true;
+         }
+         return (UInt64(n.mGeneration) << 32) | (UInt64(index) + 1);
+      }
+
+      /// @retval true if the timer was still pending and has been removed
+      bool cancel(Id id)
+      {
+         UInt32 index;
+         if (!lookup(id, index))
+         {
+            return false;
+         }
+         release(index);
+         return true;
+      }
+
+      bool isPending(Id id) const
+      {
+         UInt32 index;
+         return lookup(id, index);
+      }
+
+      /// @return the pending timer identified by id, or 0 if it is stale
+      const T* find(Id id) const
+      {
+         UInt32 index;
+         return lookup(id, index) ? &node(index).timer() : 0;
+      }
+
+      /** Returns a timer that is due at or before now, advancing the wheel as
+          far as now if none is due yet. The timer stays in the wheel until
+          popExpired() is called, so it may be processed in place. */
+      const T* peekExpired(UInt64 now)
+      {
+         for (;;)
+         {
+            UInt32 head = mHead[mNow & Level0Mask];
+            if (head != Nil)
+            {
+               return &node(head).timer();
+            }
+            if (mNow >= now)
+            {
+               return 0;
+            }
+            if (mSize == 0)
+            {
+               mNow = now;
+               return 0;
+            }
+            if (mLevelSize[0] == 0)
+            {
+               // Nothing can fire before the next cascade; skip straight to it.
+               UInt64 next = (mNow | Level0Mask) + 1;
+               if (next > now)
+               {
+                  mNow = now;
+                  return 0;
+               }
+               mNow = next;
+            }
+            else
+            {
+               ++mNow;
+            }
+            if ((mNow & Level0Mask) == 0)
+            {
+               cascade();
+            }
+         }
+      }
+
+      /// Removes the timer last returned by peekExpired().
+      void popExpired()
+      {
+         UInt32 head = mHead[mNow & Level0Mask];
+         resip_assert(head != Nil);
+         release(head);
+      }
+
+      /** @return the earliest expiry time of any pending timer; only
+          meaningful if !empty(). */
+      UInt64 nextWhen() const
+      {
+         if (!mNextWhenValid)
+         {
+            recomputeNextWhen();
+         }
+         return mNextWhen;
+      }
+
+      /// @return the pending timer with the earliest expiry, or 0 if empty
+      const T* peekNext() const
+      {
+         if (mSize == 0)
+         {
+            return 0;
+         }
+         UInt64 when = nextWhen();
+         for (unsigned int s = 0; s < NumSlots; ++s)
+         {
+            if (mHead[s] == Nil || slotMin(s) != when)
+            {
+               continue;
+            }
+            for (UInt32 i = mHead[s]; i != Nil; i = node(i).mNext)
+            {
+               if (node(i).timer().getWhen() == when)
+               {
+                  return &node(i).timer();
+               }
+            }
+         }
+         resip_assert(0);
+         return 0;
+      }
+
+      /** Returns some pending timer, in no particular order, or 0 if the
+          wheel is empty. Together with popAny() this drains the wheel
+          without advancing it. */
+      const T* peekAny()
+      {
+         if (mSize == 0)
+         {
+            return 0;
+         }
+         while (mHead[mDrainSlot] == Nil)
+         {
+            mDrainSlot = (mDrainSlot + 1) % NumSlots;
+         }
+         return &node(mHead[mDrainSlot]).timer();
+      }
+
+      /// Removes the timer last returned by peekAny().
+      void popAny()
+      {
+         resip_assert(mHead[mDrainSlot] != Nil);
+         release(mHead[mDrainSlot]);
+      }
+
+      size_t size() const
+      {
+         return mSize;
+      }
+
+      bool empty() const
+      {
+         return mSize == 0;
+      }
+
+   private:
+      enum
+      {
+         Level0Bits = 8,
+         LevelBits = 6,
+         NumLevels = 5,
+         Level0Size = 1 << Level0Bits,
+         Level0Mask = Level0Size - 1,
+         LevelSize = 1 << LevelBits,
+         LevelMask = LevelSize - 1,
+         NumSlots = Level0Size + (NumLevels - 1) * LevelSize,
+         BlockBits = 10,
+         BlockSize = 1 << BlockBits
+      };
+
+      static const UInt32 Nil = 0xFFFFFFFF;
+
+      struct Node
+      {
+         UInt32 mPrev;
+         UInt32 mNext;
+         UInt32 mGeneration;
+         UInt16 mSlot;
+         bool mInUse;
+         union
+         {
+            char mBytes[sizeof(T)];
+            UInt64 mAlignInt;
+            double mAlignDouble;
+            void* mAlignPtr;
+         } mStorage;
+
+         T& timer() { return *reinterpret_cast<T*>(mStorage.mBytes); }
+         const T& timer() const { return *reinterpret_cast<const T*>(mStorage.mBytes); }
+      };
+
+      Node& node(UInt32 index)
+      {
+         return mBlocks[index >> BlockBits][index & (BlockSize - 1)];
+      }
+
+      const Node& node(UInt32 index) const
+      {
+         return mBlocks[index >> BlockBits][index & (BlockSize - 1)];
+      }
+
+      bool lookup(Id id, UInt32& index) const
+      {
+         UInt32 low = UInt32(id & 0xFFFFFFFF);
+         if (low == 0 || low > mBlocks.size() * BlockSize)
+         {
+            return false;
+         }
+         index = low - 1;
+         const Node& n = node(index);
+         return n.mInUse && n.mGeneration == UInt32(id >> 32);
+      }
+
+      UInt32 allocNode()
+      {
+         if (mFreeList == Nil)
+         {
+            UInt32 base = UInt32(mBlocks.size() * BlockSize);
+            Node* block = new Node[BlockSize];
+            mBlocks.push_back(block);
+            for (UInt32 i = 0; i < BlockSize; ++i)
+            {
+               block[i].mGeneration = 0;
+               block[i].mInUse = false;
+               block[i].mNext = (i + 1 < BlockSize) ? base + i + 1 : Nil;
+            }
+            mFreeList = base;
+         }
+         UInt32 index = mFreeList;
+         mFreeList = node(index).mNext;
+         return index;
+      }
+
+      void release(UInt32 index)
+      {
+         Node& n = node(index);
+         unlink(index);
+         if (mNextWhenValid && n.timer().getWhen() == mNextWhen)
+         {
+            mNextWhenValid = false;
+         }
+         n.timer().~T();
+         n.mInUse = false;
+         ++n.mGeneration;
+         n.mNext = mFreeList;
+         mFreeList = index;
+         --mSize;
+      }
+
+      static unsigned int levelOf(unsigned int slot)
+      {
+         return slot < Level0Size ? 0 : 1 + (slot - Level0Size) / LevelSize;
+      }
+
+      unsigned int slotFor(UInt64 when) const
+      {
+         if (when <= mNow)
+         {
+            return unsigned(mNow & Level0Mask);
+         }
+         UInt64 delta = when - mNow;
+         if (delta < Level0Size)
+         {
+            return unsigned(when & Level0Mask);
+         }
+         for (unsigned int l = 1; l < NumLevels; ++l)
+         {
+            unsigned int shift = Level0Bits + l * LevelBits;
+            if (delta < (UInt64(1) << shift) || l == NumLevels - 1)
+            {
+               if (delta >= (UInt64(1) << shift))
+               {
+                  // beyond the top level; park it in the last slot it reaches
+                  when = mNow + (UInt64(1) << shift) - 1;
+               }
+               return Level0Size + (l - 1) * LevelSize +
+                  unsigned((when >> (shift - LevelBits)) & LevelMask);
+            }
+         }
+         resip_assert(0);
+         return 0;
+      }
+
+      void link(UInt32 index, UInt64 when)
+      {
+         unsigned int slot = slotFor(when);
+         Node& n = node(index);
+         n.mSlot = UInt16(slot);
+         n.mNext = Nil;
+         n.mPrev = mTail[slot];
+         if (mTail[slot] == Nil)
+         {
+            mHead[slot] = index;
+         }
+         else
+         {
+            node(mTail[slot]).mNext = index;
+         }
+         mTail[slot] = index;
+         ++mLevelSize[levelOf(slot)];
+
+         if (n.mPrev == Nil)
+         {
+            mSlotMin[slot] = when;
+            mSlotMinValid[slot] = true;
+         }
+         else if (mSlotMinValid[slot] && when < mSlotMin[slot])
+         {
+            mSlotMin[slot] = when;
+         }
+      }
+
+      void unlink(UInt32 index)
+      {
+         Node& n = node(index);
+         if (n.mPrev == Nil)
+         {
+            mHead[n.mSlot] = n.mNext;
+         }
+         else
+         {
+            node(n.mPrev).mNext = n.mNext;
+         }
+         if (n.mNext == Nil)
+         {
+            mTail[n.mSlot] = n.mPrev;
+         }
+         else
+         {
+            node(n.mNext).mPrev = n.mPrev;
+         }
+         --mLevelSize[levelOf(n.mSlot)];
+
+         if (mSlotMinValid[n.mSlot] && n.timer().getWhen() == mSlotMin[n.mSlot])
+         {
+            mSlotMinValid[n.mSlot] = false;
+         }
+      }
+
+      // Called each time mNow crosses a level 0 boundary: moves the timers of
+      // the slot just reached in each higher level down to where they belong.
+      void cascade()
+      {
+         for (unsigned int l = 1; l < NumLevels; ++l)
+         {
+            unsigned int shift = Level0Bits + (l - 1) * LevelBits;
+            unsigned int index = unsigned((mNow >> shift) & LevelMask);
+            unsigned int slot = Level0Size + (l - 1) * LevelSize + index;
+            UInt32 i = mHead[slot];
+            mHead[slot] = Nil;
+            mTail[slot] = Nil;
+            while (i != Nil)
+            {
+               UInt32 next = node(i).mNext;
+               --mLevelSize[l];
+               link(i, node(i).timer().getWhen());
+               i = next;
+            }
+            if (index != 0)
+            {
+               break;
+            }
+         }
+      }
+
+      // earliest expiry in a non-empty slot; walks the slot only if the
+      // previous minimum has been removed from it
+      UInt64 slotMin(unsigned int slot) const
+      {
+         if (!mSlotMinValid[slot])
+         {
+            UInt32 i = mHead[slot];
+            UInt64 best = node(i).timer().getWhen();
+            for (i = node(i).mNext; i != Nil; i = node(i).mNext)
+            {
+               if (node(i).timer().getWhen() < best)
+               {
+                  best = node(i).timer().getWhen();
+               }
+            }
+            mSlotMin[slot] = best;
+            mSlotMinValid[slot] = true;
+         }
+         return mSlotMin[slot];
+      }
+
+      void recomputeNextWhen() const
+      {
+         bool found = false;
+         for (unsigned int s = 0; s < NumSlots; ++s)
+         {
+            if (mHead[s] == Nil)
+            {
+               continue;
+            }
+            UInt64 when = slotMin(s);
+            if (!found || when < mNextWhen)
+            {
+               mNextWhen = when;
+               found = true;
+            }
+         }
+         mNextWhenValid = found;
+      }
+
+      UInt64 mNow;
+      size_t mSize;
+      std::vector<Node*> mBlocks;
+      UInt32 mFreeList;
+      UInt32 mHead[NumSlots];
+      UInt32 mTail[NumSlots];
+      size_t mLevelSize[NumLevels];
+      mutable UInt64 mSlotMin[NumSlots];
+      mutable bool mSlotMinValid[NumSlots];
+      mutable UInt64 mNextWhen;
+      mutable bool mNextWhenValid;
+      unsigned int mDrainSlot;
+
+      // disabled
+      TimerWheel(const TimerWheel&);
+      TimerWheel& operator=(const TimerWheel&);
+};
+
+template <class T>
+const UInt32 TimerWheel<T>::Nil;
+
+}
+
+#endif
+
+/* ====================================================================
+ * The Vovida Software License, Version 1.0 
+ * 
+ * Copyright (c) 2000 Vovida Networks, Inc.  All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 
+ * 3. The names "VOCAL", "Vovida Open Communication Application Library",
+ *    and "Vovida Open Communication Application Library (VOCAL)" must
+ *    not be used to endorse or promote products derived from this
+ *    software without prior written permission. For written
+ *    permission, please contact vocal@vovida.org.
+ *
+ * 4. Products derived from this software may not be called "VOCAL", nor
+ *    may "VOCAL" appear in their name, without prior written
+ *    permission of Vovida Networks, Inc.
+ * 
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESSED OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE, TITLE AND
+ * NON-INFRINGEMENT ARE DISCLAIMED.  IN NO EVENT SHALL VOVIDA
+ * NETWORKS, INC. OR ITS CONTRIBUTORS BE LIABLE FOR ANY DIRECT DAMAGES
+ * IN EXCESS OF $1,000, NOR FOR ANY INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE
+ * USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+ * DAMAGE.
+ * 
+ * ====================================================================
+ * 
+ * This software consists of voluntary contributions made by Vovida
+ * Networks, Inc. and many individuals on behalf of Vovida Networks,
+ * Inc.  For more information on Vovida Networks, Inc., please see
+ * <http://www.vovida.org/>.
+ *
+ */
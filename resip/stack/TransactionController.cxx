@@ -11,6 +11,9 @@
 #include "resip/stack/TerminateFlow.hxx"
 #include "resip/stack/EnableFlowTimer.hxx"
 #include "resip/stack/InvokeAfterSocketCreationFunc.hxx"
+#include "resip/stack/KeepAliveMessage.hxx"
+#include "resip/stack/KeepAlivePong.hxx"
+#include "resip/stack/ConnectionTerminated.hxx"
 #include "resip/stack/ZeroOutStatistics.hxx"
 #include "resip/stack/PollStatistics.hxx"
 #include "resip/stack/ShutdownMessage.hxx"
@@ -26,6 +29,9 @@
 #include "resip/stack/SipStack.hxx"
 #include "rutil/WinLeakCheck.hxx"
 
+#include <limits.h>
+#include <string.h>
+
 using namespace resip;
 
 #define RESIPROCATE_SUBSYSTEM Subsystem::TRANSACTION
@@ -48,25 +54,69 @@ TransactionController::TransactionController(SipStack& stack,
    mStateMacFifoOutBuffer(mStateMacFifo),
    mCongestionManager(0),
    mTuSelector(stack.mTuSelector),
-   mTransportSelector(mStateMacFifo,
-                      stack.getSecurity(),
-                      stack.getDnsStub(),
-                      stack.getCompression(),
-                      useDnsVip),
+   mOwnTransportSelector(new TransportSelector(mStateMacFifo,
+                                               stack.getSecurity(),
+                                               stack.getDnsStub(),
+                                               stack.getCompression(),
+                                               useDnsVip)),
+   mTransportSelector(*mOwnTransportSelector),
    mTimers(mTimerFifo),
    mShuttingDown(false),
    mStatsManager(stack.mStatsManager),
-   mHostname(DnsUtil::getLocalHostName())
+   mHostname(DnsUtil::getLocalHostName()),
+   mInterruptor(handler),
+   mShardsHaveOwnThreads(false),
+   mIsShard(false),
+   mShardIndex(0),
+   mNumShards(0),
+   mPublishedClientTransactions(0),
+   mPublishedServerTransactions(0),
+   mPublishedTimerQueueSize(0)
 {
    mStateMacFifo.setDescription("TransactionController::mStateMacFifo");
 }
 
+TransactionController::TransactionController(TransactionController& primary,
+                                             unsigned int shardIndex,
+                                             unsigned int numShards) :
+   mStack(primary.mStack),
+   mDiscardStrayResponses(primary.mDiscardStrayResponses),
+   mFixBadDialogIdentifiers(primary.mFixBadDialogIdentifiers),
+   mFixBadCSeqNumbers(primary.mFixBadCSeqNumbers),
+   mStateMacFifo(primary.mInterruptor),
+   mStateMacFifoOutBuffer(mStateMacFifo),
+   mCongestionManager(0),
+   mTuSelector(primary.mTuSelector),
+   mOwnTransportSelector(0),
+   mTransportSelector(primary.mTransportSelector),
+   mTimers(mTimerFifo),
+   mShuttingDown(false),
+   mStatsManager(primary.mStatsManager),
+   mHostname(primary.mHostname),
+   mInterruptor(primary.mInterruptor),
+   mShardsHaveOwnThreads(false),
+   mIsShard(true),
+   mShardIndex(shardIndex),
+   mNumShards(numShards),
+   mPublishedClientTransactions(0),
+   mPublishedServerTransactions(0),
+   mPublishedTimerQueueSize(0)
+{
+   mStateMacFifo.setDescription("TransactionController::mStateMacFifo[" + Data(shardIndex) + "]");
+}
+
 #if defined(WIN32) && !defined(__GNUC__)
 #pragma warning( default : 4355 )
 #endif
 
 TransactionController::~TransactionController()
 {
+   for(std::vector<TransactionController*>::iterator i=mShards.begin(); i!=mShards.end(); ++i)
+   {
+      delete *i;
+   }
+   mShards.clear();
+
    if(mClientTransactionMap.size())
    {
       WarningLog(<< "On shutdown, there are Client TransactionStates remaining!");
@@ -89,15 +139,120 @@ void
 TransactionController::shutdown()
 {
    mShuttingDown = true;
+   for(std::vector<TransactionController*>::iterator i=mShards.begin(); i!=mShards.end(); ++i)
+   {
+      (*i)->mShuttingDown = true;
+   }
    mTransportSelector.shutdown();
 }
 
+void
+TransactionController::setCongestionManager(CongestionManager* manager)
+{
+   resip_assert(!mIsShard);
+   mTransportSelector.setCongestionManager(manager);
+   if(mCongestionManager)
+   {
+      mCongestionManager->unregisterFifo(&mStateMacFifo);
+      for(std::vector<TransactionController*>::iterator i=mShards.begin(); i!=mShards.end(); ++i)
+      {
+         mCongestionManager->unregisterFifo(&(*i)->mStateMacFifo);
+      }
+   }
+   mCongestionManager=manager;
+   for(std::vector<TransactionController*>::iterator i=mShards.begin(); i!=mShards.end(); ++i)
+   {
+      (*i)->mCongestionManager=manager;
+   }
+   if(mCongestionManager)
+   {
+      // The shards' fifos are where the work waits; ours only dispatches.
+      mCongestionManager->registerFifo(&mStateMacFifo);
+      for(std::vector<TransactionController*>::iterator i=mShards.begin(); i!=mShards.end(); ++i)
+      {
+         mCongestionManager->registerFifo(&(*i)->mStateMacFifo);
+      }
+   }
+}
+
+time_t
+TransactionController::expectedWaitTimeMilliSec() const
+{
+   time_t longest=mStateMacFifo.expectedWaitTimeMilliSec();
+   for(std::vector<TransactionController*>::const_iterator i=mShards.begin(); i!=mShards.end(); ++i)
+   {
+      longest=resipMax(longest, (*i)->mStateMacFifo.expectedWaitTimeMilliSec());
+   }
+   return longest;
+}
+
+CongestionManager::RejectionBehavior
+TransactionController::getRejectionBehavior() const
+{
+   if(!mCongestionManager)
+   {
+      return CongestionManager::NORMAL;
+   }
+   CongestionManager::RejectionBehavior worst=mCongestionManager->getRejectionBehavior(&mStateMacFifo);
+   for(std::vector<TransactionController*>::const_iterator i=mShards.begin(); i!=mShards.end(); ++i)
+   {
+      CongestionManager::RejectionBehavior behavior=(*i)->getRejectionBehavior();
+      if(behavior > worst)
+      {
+         worst=behavior;
+      }
+   }
+   return worst;
+}
+
+void
+TransactionController::createShards(unsigned int numShards)
+{
+   resip_assert(mShards.empty());
+   resip_assert(!mIsShard);
+   if(numShards < 2)
+   {
+      return;
+   }
+
+   // The shards transmit concurrently through our TransportSelector, and
+   // count messages in the shared StatisticsManager.
+   mTransportSelector.enableConcurrentTransmit();
+   mStatsManager.enableConcurrentUpdates();
+
+   for(unsigned int i=0; i < numShards; ++i)
+   {
+      TransactionController* shard=new TransactionController(*this, i, numShards);
+      shard->mShuttingDown=mShuttingDown;
+      shard->mCongestionManager=mCongestionManager;
+      if(mCongestionManager)
+      {
+         mCongestionManager->registerFifo(&shard->mStateMacFifo);
+      }
+      mShards.push_back(shard);
+   }
+   InfoLog(<< "Transaction processing split across " << numShards << " shards");
+}
+
+void
+TransactionController::setStateMacFifoLockFree()
+{
+   mStateMacFifo.setLockFree();
+   for(std::vector<TransactionController*>::iterator i=mShards.begin(); i!=mShards.end(); ++i)
+   {
+      (*i)->setStateMacFifoLockFree();
+   }
+}
+
 void
 TransactionController::process(int timeout)
 {
+   // The primary tells the TU once every shard is idle as well.
    if (mShuttingDown && 
+       !mIsShard &&
        //mTimers.empty() && 
        !mStateMacFifoOutBuffer.messageAvailable() && // !dcm! -- see below 
+       shardsIdle() &&
        !mStack.mTUFifo.messageAvailable() &&
        mTransportSelector.isFinished())
 // !dcm! -- why would one wait for the Tu's fifo to be empty before delivering a
@@ -106,6 +261,10 @@ TransactionController::process(int timeout)
       //!dcm! -- send to all?
       mTuSelector.add(new ShutdownMessage, TimeLimitFifo<Message>::InternalElement);
    }
+   else if(!mShards.empty())
+   {
+      processShards(timeout);
+   }
    else
    {
       unsigned int nextTimer(mTimers.msTillNextTimer());
@@ -118,7 +277,7 @@ TransactionController::process(int timeout)
 
       // Check if Statistics Manager needs to be polled - note:  all statistic manager polls should happen from the 
       // TransactionController thread / process loop
-      if(mStack.mStatisticsManagerEnabled)
+      if(mStack.mStatisticsManagerEnabled && !mIsShard)
       {
          mStatsManager.process();
       }
@@ -160,9 +319,150 @@ TransactionController::process(int timeout)
 
          mTransportSelector.poke();
       }
+
+      if(mIsShard)
+      {
+         publishSizes();
+      }
    }
 }
 
+void
+TransactionController::publishSizes()
+{
+   AtomicOps::store(mPublishedClientTransactions, (UInt32)mClientTransactionMap.size());
+   AtomicOps::store(mPublishedServerTransactions, (UInt32)mServerTransactionMap.size());
+   AtomicOps::store(mPublishedTimerQueueSize, (UInt32)mTimers.size());
+}
+
+void
+TransactionController::processShards(int timeout)
+{
+   if(!mShardsHaveOwnThreads)
+   {
+      // The shards are run inline below; don't wait past their next timer.
+      timeout=resipMin((int)getTimeTillNextProcessMS(), timeout);
+   }
+   if(timeout==0)
+   {
+      timeout=-1;
+   }
+
+   if(mStack.mStatisticsManagerEnabled)
+   {
+      mStatsManager.process();
+   }
+
+   // Dispatching is much cheaper than running the state machines, so take
+   // bigger bites of the fifo than process() does when the shards have
+   // threads of their own. Inline, keep to process()'s budget so the
+   // transports still get cycles often enough.
+   TransactionMessage* message=mStateMacFifoOutBuffer.getNext(timeout);
+   int runs=mShardsHaveOwnThreads ? 256 : 16;
+   while(message)
+   {
+      dispatchToShard(message);
+      if(--runs==0)
+      {
+         break;
+      }
+      message = mStateMacFifoOutBuffer.getNext(-1);
+   }
+
+   if(!mShardsHaveOwnThreads)
+   {
+      for(std::vector<TransactionController*>::iterator i=mShards.begin(); i!=mShards.end(); ++i)
+      {
+         (*i)->process(0);
+      }
+   }
+}
+
+void
+TransactionController::dispatchToShard(TransactionMessage* message)
+{
+   // Transport control and statistics messages don't belong to a 
+   // transaction, and touch state the shards don't own; handle them here.
+   if(dynamic_cast<KeepAliveMessage*>(message) ||
+      dynamic_cast<KeepAlivePong*>(message) ||
+      dynamic_cast<ConnectionTerminated*>(message) ||
+      dynamic_cast<TerminateFlow*>(message) ||
+      dynamic_cast<EnableFlowTimer*>(message) ||
+      dynamic_cast<ZeroOutStatistics*>(message) ||
+      dynamic_cast<PollStatistics*>(message) ||
+      dynamic_cast<AddTransport*>(message) ||
+      dynamic_cast<RemoveTransport*>(message) ||
+      dynamic_cast<InvokeAfterSocketCreationFunc*>(message))
+   {
+      TransactionState::process(*this, message);
+      return;
+   }
+
+   unsigned int index=0;
+   try
+   {
+      index=shardFor(message->getTransactionId());
+   }
+   catch(resip::BaseException&)
+   {
+      // TransactionState::process() drops messages without a usable tid; 
+      // any shard will do for that.
+   }
+   mShards[index]->mStateMacFifo.add(message);
+}
+
+unsigned int
+TransactionController::shardFor(const Data& tid) const
+{
+   // Client CANCEL transactions are keyed "<INVITE tid>cancel"; failures 
+   // reported against them must reach the shard that owns the INVITE.
+   Data::size_type len=tid.size();
+   if(len > 6 && memcmp(tid.data()+len-6, "cancel", 6)==0)
+   {
+      len-=6;
+   }
+
+   // Stateless transactions are numbered by the shard that sends them (see
+   // statelessTid()); a number is routed by its value.
+   if(len > 0 && len < 20)
+   {
+      UInt64 value=0;
+      Data::size_type i=0;
+      for(; i < len && tid.data()[i] >= '0' && tid.data()[i] <= '9'; ++i)
+      {
+         value=value*10 + (tid.data()[i] - '0');
+      }
+      if(i == len)
+      {
+         return (unsigned int)(value % mShards.size());
+      }
+   }
+   return (unsigned int)(Data(Data::Share, tid.data(), len).hash() % mShards.size());
+}
+
+Data
+TransactionController::statelessTid(UInt32 sequence) const
+{
+   if(!mIsShard)
+   {
+      return Data(sequence);
+   }
+   return Data((UInt64)sequence * mNumShards + mShardIndex);
+}
+
+bool
+TransactionController::shardsIdle() const
+{
+   for(std::vector<TransactionController*>::const_iterator i=mShards.begin(); i!=mShards.end(); ++i)
+   {
+      if((*i)->mStateMacFifo.messageAvailable())
+      {
+         return false;
+      }
+   }
+   return true;
+}
+
 unsigned int 
 TransactionController::getTimeTillNextProcessMS()
 {
@@ -170,6 +470,19 @@ TransactionController::getTimeTillNextProcessMS()
    {
       return 0;
    }
+
+   if(!mShards.empty())
+   {
+      unsigned int next=INT_MAX;
+      if(!mShardsHaveOwnThreads)
+      {
+         for(std::vector<TransactionController*>::iterator i=mShards.begin(); i!=mShards.end(); ++i)
+         {
+            next=resipMin(next, (*i)->getTimeTillNextProcessMS());
+         }
+      }
+      return next;
+   }
    return mTimers.msTillNextTimer();
 } 
 
@@ -182,7 +495,7 @@ TransactionController::send(SipMessage* msg)
    {
       // Need to 503 this.
       SipMessage* resp(Helper::makeResponse(*msg, 503));
-      resp->header(h_RetryAfter).value()=(UInt32)mStateMacFifo.expectedWaitTimeMilliSec()/1000;
+      resp->header(h_RetryAfter).value()=(UInt32)expectedWaitTimeMilliSec()/1000;
       resp->setTransactionUser(msg->getTransactionUser());
       mTuSelector.add(resp, TimeLimitFifo<Message>::InternalElement);
       delete msg;
@@ -204,30 +517,67 @@ TransactionController::sumTransportFifoSizes() const
    return mTransportSelector.sumTransportFifoSizes();
 }
 
+void
+TransactionController::sumTransportBatchSizes(unsigned int* rxBatches, unsigned int* txBatches) const
+{
+   mTransportSelector.sumTransportBatchSizes(rxBatches, txBatches);
+}
+
+void
+TransactionController::sumTransportTlsSessionStats(unsigned int& fullHandshakes, 
+                                                   unsigned int& resumedHandshakes,
+                                                   unsigned int& sessionCacheEvictions) const
+{
+   mTransportSelector.sumTransportTlsSessionStats(fullHandshakes, resumedHandshakes, sessionCacheEvictions);
+}
+
 unsigned int 
 TransactionController::getTransactionFifoSize() const
 {
    // Should we include the stuff in mStateMacFifoOutBuffer here too? This is
    // likely to be called from other threads...
-   return mStateMacFifo.size();
+   unsigned int size=mStateMacFifo.size();
+   for(std::vector<TransactionController*>::const_iterator i=mShards.begin(); i!=mShards.end(); ++i)
+   {
+      size+=(*i)->mStateMacFifo.size();
+   }
+   return size;
 }
 
+// The shards' own maps and timer queues belong to their threads; add up 
+// the sizes they last published instead.
+
 unsigned int 
 TransactionController::getNumClientTransactions() const
 {
-   return mClientTransactionMap.size();
+   unsigned int num=mClientTransactionMap.size();
+   for(std::vector<TransactionController*>::const_iterator i=mShards.begin(); i!=mShards.end(); ++i)
+   {
+      num+=AtomicOps::load((*i)->mPublishedClientTransactions);
+   }
+   return num;
 }
 
 unsigned int 
 TransactionController::getNumServerTransactions() const
 {
-   return mServerTransactionMap.size();
+   unsigned int num=mServerTransactionMap.size();
+   for(std::vector<TransactionController*>::const_iterator i=mShards.begin(); i!=mShards.end(); ++i)
+   {
+      num+=AtomicOps::load((*i)->mPublishedServerTransactions);
+   }
+   return num;
 }
 
 unsigned int 
 TransactionController::getTimerQueueSize() const
 {
-   return mTimers.size();
+   unsigned int size=mTimers.size();
+   for(std::vector<TransactionController*>::const_iterator i=mShards.begin(); i!=mShards.end(); ++i)
+   {
+      size+=AtomicOps::load((*i)->mPublishedTimerQueueSize);
+   }
+   return size;
 }
 
 void 
@@ -292,7 +642,18 @@ TransactionController::enableFlowTimer(const resip::Tuple& flow)
 void 
 TransactionController::setInterruptor(AsyncProcessHandler* handler)
 {
+   mInterruptor=handler;
    mStateMacFifo.setInterruptor(handler);
+
+   // Shards that are run inline by process() must wake the same loop that 
+   // runs us; DNS results and the like are posted straight to their fifos.
+   if(!mShardsHaveOwnThreads)
+   {
+      for(std::vector<TransactionController*>::iterator i=mShards.begin(); i!=mShards.end(); ++i)
+      {
+         (*i)->setInterruptor(handler);
+      }
+   }
 }
 
 void
@@ -5,10 +5,14 @@
 #include "resip/stack/TransactionMap.hxx"
 #include "resip/stack/TransportSelector.hxx"
 #include "resip/stack/TimerQueue.hxx"
+#include "rutil/AtomicOps.hxx"
 #include "rutil/CongestionManager.hxx"
 
 #include "rutil/ConsumerFifoBuffer.hxx"
 
+#include <memory>
+#include <vector>
+
 namespace resip
 {
 
@@ -33,6 +37,27 @@ class TransactionController
       void process(int timeout=0);
       unsigned int getTimeTillNextProcessMS();
 
+      /**
+         Splits transaction processing across numShards controllers. Each 
+         shard owns its own transaction maps, timer queue and state machine 
+         fifo; this controller keeps the fifo the transports and the TU post 
+         to, and hands every message to the shard that owns its transaction 
+         id. Responses, CANCELs and non-2xx ACKs carry the branch of the 
+         transaction they belong to, so they land on the same shard. Must be 
+         called before the stack starts processing.
+      */
+      void createShards(unsigned int numShards);
+      unsigned int numShards() const { return (unsigned int)mShards.size(); }
+      TransactionController& shard(unsigned int index) { return *mShards[index]; }
+
+      // Set when every shard is driven by its own TransactionControllerThread;
+      // otherwise process() runs the shards inline after dispatching.
+      void setShardsHaveOwnThreads(bool ownThreads) { mShardsHaveOwnThreads = ownThreads; }
+
+      // Puts the state machine fifo (and those of the shards, so call it
+      // after createShards()) in lock-free mode; see AbstractFifo::setLockFree().
+      void setStateMacFifoLockFree();
+
       // graceful shutdown (eventually)
       void shutdown();
 
@@ -45,6 +70,10 @@ class TransactionController
 
       unsigned int getTuFifoSize() const;
       unsigned int sumTransportFifoSizes() const;
+      void sumTransportBatchSizes(unsigned int* rxBatches, unsigned int* txBatches) const;
+      void sumTransportTlsSessionStats(unsigned int& fullHandshakes, 
+                                       unsigned int& resumedHandshakes,
+                                       unsigned int& sessionCacheEvictions) const;
       unsigned int getTransactionFifoSize() const;
       unsigned int getNumClientTransactions() const;
       unsigned int getNumServerTransactions() const;
@@ -52,28 +81,11 @@ class TransactionController
       void zeroOutStatistics();
       void pollStatistics();
       
-      void setCongestionManager( CongestionManager *manager ) 
-      { 
-         mTransportSelector.setCongestionManager(manager);
-         if(mCongestionManager)
-         {
-            mCongestionManager->unregisterFifo(&mStateMacFifo);
-         }
-         mCongestionManager=manager;
-         if(mCongestionManager)
-         {
-            mCongestionManager->registerFifo(&mStateMacFifo);
-         }
-      }
+      /// Registers our state machine fifo, and each shard's, with manager.
+      void setCongestionManager( CongestionManager *manager );
 
-      CongestionManager::RejectionBehavior getRejectionBehavior() const
-      {
-         if(mCongestionManager)
-         {
-            return mCongestionManager->getRejectionBehavior(&mStateMacFifo);
-         }
-         return CongestionManager::NORMAL;
-      }
+      /// The worst behavior asked for by our fifo or any shard's.
+      CongestionManager::RejectionBehavior getRejectionBehavior() const;
 
       void registerMarkListener(MarkListener* listener);
       void unregisterMarkListener(MarkListener* listener);
@@ -86,12 +98,20 @@ class TransactionController
       inline void setFixBadDialogIdentifiers(bool pFixBadDialogIdentifiers) 
       {
          mFixBadDialogIdentifiers = pFixBadDialogIdentifiers;
+         for(std::vector<TransactionController*>::iterator i=mShards.begin(); i!=mShards.end(); ++i)
+         {
+            (*i)->mFixBadDialogIdentifiers = pFixBadDialogIdentifiers;
+         }
       }
 
       inline bool getFixBadCSeqNumbers() const { return mFixBadCSeqNumbers;} 
       inline void setFixBadCSeqNumbers(bool pFixBadCSeqNumbers)
       {
          mFixBadCSeqNumbers = pFixBadCSeqNumbers;
+         for(std::vector<TransactionController*>::iterator i=mShards.begin(); i!=mShards.end(); ++i)
+         {
+            (*i)->mFixBadCSeqNumbers = pFixBadCSeqNumbers;
+         }
       }
 
       void abandonServerTransaction(const Data& tid);
@@ -108,6 +128,24 @@ class TransactionController
    private:
       TransactionController(const TransactionController& rhs);
       TransactionController& operator=(const TransactionController& rhs);
+
+      // Creates a shard of primary; shares the stack, TuSelector and 
+      // TransportSelector of the primary.
+      TransactionController(TransactionController& primary, unsigned int shardIndex, unsigned int numShards);
+
+      void processShards(int timeout);
+      void dispatchToShard(TransactionMessage* message);
+      unsigned int shardFor(const Data& tid) const;
+      bool shardsIdle() const;
+      /// The longest expected wait of our fifo and the shards'.
+      time_t expectedWaitTimeMilliSec() const;
+      // Transaction id for the sequence'th stateless transaction. A shard 
+      // picks a number shardFor() maps back to it.
+      Data statelessTid(UInt32 sequence) const;
+      // Copies a shard's map and timer queue sizes to where other threads 
+      // can read them.
+      void publishSizes();
+
       SipStack& mStack;
       
       // If true, indicate to the Transaction to ignore responses for which
@@ -139,22 +177,39 @@ class TransactionController
       // from the sipstack (for convenience)
       TuSelector& mTuSelector;
 
-      // Used to decide which transport to send a sip message on. 
-      TransportSelector mTransportSelector;
+      // Used to decide which transport to send a sip message on. Owned by 
+      // the primary controller; shards refer to the primary's.
+      std::auto_ptr<TransportSelector> mOwnTransportSelector;
+      TransportSelector& mTransportSelector;
+
+      // timers associated with the transactions. When a timer fires, it is
+      // placed in the mStateMacFifo. Declared ahead of the transaction maps
+      // since TransactionStates cancel their timers on destruction
+      TransactionTimerQueue  mTimers;
 
       // stores all of the transactions that are currently active in this stack 
       TransactionMap mClientTransactionMap;
       TransactionMap mServerTransactionMap;
 
-      // timers associated with the transactions. When a timer fires, it is
-      // placed in the mStateMacFifo
-      TransactionTimerQueue  mTimers;
-
       bool mShuttingDown;
       
       StatisticsManager& mStatsManager;
       
       Data mHostname;
+
+      AsyncProcessHandler* mInterruptor;
+
+      // empty unless createShards() was called
+      std::vector<TransactionController*> mShards;
+      bool mShardsHaveOwnThreads;
+      bool mIsShard;
+      unsigned int mShardIndex;
+      unsigned int mNumShards; // of the primary this is a shard of
+
+      // a shard's sizes, as of the end of its last process() call
+      volatile UInt32 mPublishedClientTransactions;
+      volatile UInt32 mPublishedServerTransactions;
+      volatile UInt32 mPublishedTimerQueueSize;
       
       friend class SipStack; // for debug only
       friend class StatelessHandler;
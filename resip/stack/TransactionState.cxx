@@ -36,6 +36,7 @@
 #include "resip/stack/InteropHelper.hxx"
 #include "resip/stack/KeepAliveMessage.hxx"
 #include "rutil/ResipAssert.h"
+#include "rutil/AtomicOps.hxx"
 #include "rutil/DnsUtil.hxx"
 #include "rutil/Logger.hxx"
 #include "rutil/MD5Stream.hxx"
@@ -48,7 +49,7 @@ using namespace resip;
 #define RESIPROCATE_SUBSYSTEM Subsystem::TRANSACTION
 
 UInt64 TransactionState::DnsGreylistDurationMs = 32000;  // default to 32 seconds, application can override
-UInt32 TransactionState::StatelessIdCounter = 0;
+volatile UInt32 TransactionState::StatelessIdCounter = 0;
 
 TransactionState::TransactionState(TransactionController& controller, Machine m, 
                                    State s, const Data& id, MethodTypes method, const Data& methodText, TransactionUser* tu) : 
@@ -70,7 +71,10 @@ TransactionState::TransactionState(TransactionController& controller, Machine m,
    mTransactionUser(tu),
    mFailureReason(TransportFailure::None),
    mFailureSubCode(0),
-   mTcpConnectTimerStarted(false)
+   mTcpConnectTimerStarted(false),
+   mStartUs(controller.mStack.statisticsManagerEnabled() ? Timer::getTimeMicroSec() : 0),
+   mProvisionalSeen(false),
+   mFinalSeen(false)
 {
    StackLog (<< "Creating new TransactionState: " << *this);
 }
@@ -109,7 +113,7 @@ TransactionState::handleInternalCancel(SipMessage* cancel,
    cancel->header(h_Vias).front().param(p_branch) = clientInvite.mNextTransmission->const_header(h_Vias).front().param(p_branch);
    state->processClientNonInvite(cancel);
    // for the INVITE in case we never get a 487
-   clientInvite.mController.mTimers.add(Timer::TimerCleanUp, clientInvite.mId, 128*Timer::T1);
+   clientInvite.addTimer(Timer::TimerCleanUp, 128*Timer::T1);
 }
 
 bool
@@ -159,6 +163,22 @@ TransactionState::~TransactionState()
 
    //StackLog (<< "Deleting TransactionState " << mId << " : " << this);
    erase(mId);
+
+   if (mStartUs && mMachine != ClientStale && mMachine != ServerStale && mMachine != Stateless)
+   {
+      mController.mStatsManager.transactionLatency(mMachine == ClientNonInvite || mMachine == ClientInvite,
+                                                   mMethod,
+                                                   StatisticsManager::TransactionLifetime,
+                                                   Timer::getTimeMicroSec() - mStartUs);
+   }
+
+   if (mController.mTimers.canCancel())
+   {
+      for (std::vector<UInt64>::const_iterator i = mTimerIds.begin(); i != mTimerIds.end(); ++i)
+      {
+         mController.mTimers.cancel(*i);
+      }
+   }
    
    delete mNextTransmission;
    delete mMethodText;
@@ -170,6 +190,29 @@ TransactionState::~TransactionState()
    mState = Bogus;
 }
 
+void
+TransactionState::addTimer(Timer::Type type, unsigned long msOffset)
+{
+   TransactionTimerQueue::Id id = mController.mTimers.add(type, mId, msOffset);
+   if (!mController.mTimers.canCancel())
+   {
+      // the heap can't cancel; its timers fire into a missing transaction
+      return;
+   }
+   resip_assert(id);
+
+   // reuse the slot of a timer that has already fired
+   for (std::vector<UInt64>::iterator i = mTimerIds.begin(); i != mTimerIds.end(); ++i)
+   {
+      if (!mController.mTimers.isPending(*i))
+      {
+         *i = id;
+         return;
+      }
+   }
+   mTimerIds.push_back(id);
+}
+
 bool
 TransactionState::processSipMessageAsNew(SipMessage* sip, TransactionController& controller, const Data& tid)
 {
@@ -243,7 +286,7 @@ TransactionState::processSipMessageAsNew(SipMessage* sip, TransactionController&
             else
             {
                //StackLog(<<" adding T100 timer (INV)");
-               controller.mTimers.add(Timer::TimerTrying, tid, Timer::T100);
+               state->addTimer(Timer::TimerTrying, Timer::T100);
             }
             state->sendToTU(sip);
             return true;
@@ -270,7 +313,7 @@ TransactionState::processSipMessageAsNew(SipMessage* sip, TransactionController&
             {
                resip_assert(matchingInvite);
                TransactionState* state = TransactionState::makeCancelTransaction(matchingInvite, ServerNonInvite, tid);
-               state->startServerNonInviteTimerTrying(*sip,tid);
+               state->startServerNonInviteTimerTrying(*sip);
                state->sendToTU(sip);
                return true;
             }
@@ -289,7 +332,7 @@ TransactionState::processSipMessageAsNew(SipMessage* sip, TransactionController&
             state->mResponseTarget.setPort(Helper::getPortForReply(*sip));
             state->add(tid);
             state->mIsReliable = isReliable(state->mResponseTarget.getType());
-            state->startServerNonInviteTimerTrying(*sip,tid);
+            state->startServerNonInviteTimerTrying(*sip);
             state->sendToTU(sip);
             return true;
          }
@@ -322,7 +365,7 @@ TransactionState::processSipMessageAsNew(SipMessage* sip, TransactionController&
                                                             Data::Empty,
                                                             tu);
             state->add(state->mId);
-            state->mController.mTimers.add(Timer::TimerStateless, state->mId, Timer::TS );
+            state->addTimer(Timer::TimerStateless, Timer::TS );
             state->processStateless(sip);
          }
          else if (method == CANCEL)
@@ -389,12 +432,12 @@ TransactionState::processSipMessageAsNew(SipMessage* sip, TransactionController&
             new TransactionState(controller, 
                                  Stateless, 
                                  Calling, 
-                                 Data(StatelessIdCounter++), 
+                                 controller.statelessTid(AtomicOps::add(StatelessIdCounter, 1)), 
                                  method,
                                  sip->methodStr(),
                                  tu);
          state->add(state->mId);
-         state->mController.mTimers.add(Timer::TimerStateless, state->mId, Timer::TS );
+         state->addTimer(Timer::TimerStateless, Timer::TS );
          state->processStateless(sip);
       }
    }
@@ -840,7 +883,11 @@ TransactionState::processTimer(TransactionController& controller,
 {
    Data tid = message->getTransactionId();
 
-   if(controller.getRejectionBehavior()==CongestionManager::REJECTING_NON_ESSENTIAL)
+   TransactionState* state = 0;
+   if (message->isClientTransaction()) state = controller.mClientTransactionMap.find(tid);
+   else state = controller.mServerTransactionMap.find(tid);
+
+   if(state && controller.getRejectionBehavior()==CongestionManager::REJECTING_NON_ESSENTIAL)
    {
       // .bwc. State machine fifo is backed up; we probably should not be 
       // retransmitting anything right now. If we have a retransmit timer, 
@@ -848,23 +895,20 @@ TransactionState::processTimer(TransactionController& controller,
       switch(message->getType())
       {
          case Timer::TimerA: // doubling
-            controller.mTimers.add(Timer::TimerA, 
-                                    tid, 
-                                    message->getDuration()*2);
+            state->addTimer(Timer::TimerA, 
+                            message->getDuration()*2);
             delete message;
             return;
          case Timer::TimerE1:// doubling, until T2
          case Timer::TimerG: // doubling, until T2
-            controller.mTimers.add(message->getType(), 
-                                    tid, 
-                                    resipMin(message->getDuration()*2,
-                                             Timer::T2));
+            state->addTimer(message->getType(), 
+                            resipMin(message->getDuration()*2,
+                                     Timer::T2));
             delete message;
             return;
          case Timer::TimerE2:// just reset
-            controller.mTimers.add(Timer::TimerE2, 
-                                    tid, 
-                                    Timer::T2);
+            state->addTimer(Timer::TimerE2, 
+                            Timer::T2);
             delete message;
             return;
          default:
@@ -872,10 +916,6 @@ TransactionState::processTimer(TransactionController& controller,
       }
    }
 
-   TransactionState* state = 0;
-   if (message->isClientTransaction()) state = controller.mClientTransactionMap.find(tid);
-   else state = controller.mServerTransactionMap.find(tid);
-   
    if (state) // found transaction for timer
    {
       StackLog (<< "Found matching transaction for " << message->brief() << " -> " << *state);
@@ -917,7 +957,7 @@ TransactionState::processTimer(TransactionController& controller,
 }
 
 void
-TransactionState::startServerNonInviteTimerTrying(SipMessage& sip, const Data& tid)
+TransactionState::startServerNonInviteTimerTrying(SipMessage& sip)
 {
    unsigned int duration = 3500;
    if(Timer::T1 != 500) // optimzed for T1 == 500
@@ -927,7 +967,7 @@ TransactionState::startServerNonInviteTimerTrying(SipMessage& sip, const Data& t
       while(duration*2<Timer::T2) duration = duration * 2;
    }
    resetNextTransmission(make100(&sip));  // Store for use when timer expires
-   mController.mTimers.add(Timer::TimerTrying, tid, duration );  // Start trying timer so that we can send 100 to NITs as recommened in RFC4320
+   addTimer(Timer::TimerTrying, duration );  // Start trying timer so that we can send 100 to NITs as recommened in RFC4320
 }
 
 void
@@ -1030,7 +1070,7 @@ TransactionState::processClientNonInvite(TransactionMessage* msg)
       SipMessage* sip = dynamic_cast<SipMessage*>(msg);
       resetNextTransmission(sip);
       saveOriginalContactAndVia(*sip);
-      mController.mTimers.add(Timer::TimerF, mId, Timer::TF);
+      addTimer(Timer::TimerF, Timer::TF);
       sendCurrentToWire();
    }
    else if (isResponse(msg) && isFromWire(msg)) // from the wire
@@ -1047,7 +1087,7 @@ TransactionState::processClientNonInvite(TransactionMessage* msg)
             // Should we restart the E2 timer though?  If so, we need to use somekind of timer sequence number so that previous E2 timers get discarded.
             if (!mIsReliable && mState == Trying)
             {
-               mController.mTimers.add(Timer::TimerE2, mId, Timer::T2 );
+               addTimer(Timer::TimerE2, Timer::T2 );
             }
             mState = Proceeding;
             sendToTU(msg); // don't delete            
@@ -1083,7 +1123,7 @@ TransactionState::processClientNonInvite(TransactionMessage* msg)
          else if (mState != Completed) // prevent TimerK reproduced
          {
             mState = Completed;
-            mController.mTimers.add(Timer::TimerK, mId, Timer::T4 );
+            addTimer(Timer::TimerK, Timer::T4 );
             // !bwc! Got final response in NIT. We don't need to do anything
             // except quietly absorb retransmissions. Dump all state.
             if(mDnsResult)
@@ -1113,7 +1153,7 @@ TransactionState::processClientNonInvite(TransactionMessage* msg)
             {
                unsigned long d = timer->getDuration();
                if (d < Timer::T2) d *= 2;
-               mController.mTimers.add(Timer::TimerE1, mId, d);
+               addTimer(Timer::TimerE1, d);
                StackLog (<< "Transmitting current message");
                sendCurrentToWire();
                delete timer;
@@ -1128,7 +1168,7 @@ TransactionState::processClientNonInvite(TransactionMessage* msg)
          case Timer::TimerE2:
             if (mState == Proceeding)
             {
-               mController.mTimers.add(Timer::TimerE2, mId, Timer::T2);
+               addTimer(Timer::TimerE2, Timer::T2);
                StackLog (<< "Transmitting current message");
                sendCurrentToWire();
                delete timer;
@@ -1228,7 +1268,7 @@ TransactionState::processClientInvite(TransactionMessage* msg)
             {
                resetNextTransmission(sip);
                saveOriginalContactAndVia(*sip);
-               mController.mTimers.add(Timer::TimerB, mId, Timer::TB );
+               addTimer(Timer::TimerB, Timer::TB );
                sendCurrentToWire();
             }
             else
@@ -1320,7 +1360,7 @@ TransactionState::processClientInvite(TransactionMessage* msg)
                }
                StackLog (<< "Received 2xx on client invite transaction");
                StackLog (<< *this);
-               mController.mTimers.add(Timer::TimerStaleClient, mId, Timer::TS );
+               addTimer(Timer::TimerStaleClient, Timer::TS );
             }
             else if (code >= 300)
             {
@@ -1358,7 +1398,7 @@ TransactionState::processClientInvite(TransactionMessage* msg)
                      // reliable, if transport is Unreliable then Fire the Timer D which 
                      // take care of re-Transmission of ACK 
                      mState = Completed;
-                     mController.mTimers.add(Timer::TimerD, mId, Timer::TD );
+                     addTimer(Timer::TimerD, Timer::TD );
                      SipMessage* ack = Helper::makeFailureAck(*mNextTransmission, *sip);
                      mNextTransmission->copyOutboundDecoratorsToStackFailureAck(*ack);
                      resetNextTransmission(ack);
@@ -1425,7 +1465,7 @@ TransactionState::processClientInvite(TransactionMessage* msg)
                unsigned long d = timer->getDuration()*2;
                // TimerA is supposed to double with each retransmit RFC3261 17.1.1          
 
-               mController.mTimers.add(Timer::TimerA, mId, d);
+               addTimer(Timer::TimerA, d);
                DebugLog (<< "Retransmitting INVITE ");
                sendCurrentToWire();
             }
@@ -1628,7 +1668,7 @@ TransactionState::processServerNonInvite(TransactionMessage* msg)
             if (mState == Trying || mState == Proceeding)
             {
                mState = Completed;
-               mController.mTimers.add(Timer::TimerJ, mId, 64*Timer::T1 );
+               addTimer(Timer::TimerJ, 64*Timer::T1 );
                resetNextTransmission(sip);
                sendCurrentToWire();
             }
@@ -1718,7 +1758,7 @@ TransactionState::processServerNonInvite(TransactionMessage* msg)
             // retransmission comes in. In the meantime, set up timers for
             // transaction termination.
             mState = Completed;
-            mController.mTimers.add(Timer::TimerJ, mId, 64*Timer::T1 );
+            addTimer(Timer::TimerJ, 64*Timer::T1 );
          }
       }
       delete msg;
@@ -1753,10 +1793,10 @@ TransactionState::processServerInvite(TransactionMessage* msg)
                mAckIsValid=true;
                resetNextTransmission(Helper::makeResponse(*sip, 500));
                mState = Completed;
-               mController.mTimers.add(Timer::TimerH, mId, Timer::TH );
+               addTimer(Timer::TimerH, Timer::TH );
                if (!mIsReliable)
                {
-                  mController.mTimers.add(Timer::TimerG, mId, Timer::T1 );
+                  addTimer(Timer::TimerG, Timer::T1 );
                }
                sendCurrentToWire();
                delete msg;
@@ -1807,7 +1847,7 @@ TransactionState::processServerInvite(TransactionMessage* msg)
                {
                   //StackLog (<< "Received ACK in Completed (unreliable) - confirmed, start Timer I");
                   mState = Confirmed;
-                  mController.mTimers.add(Timer::TimerI, mId, Timer::T4 );
+                  addTimer(Timer::TimerI, Timer::T4 );
                   // !bwc! Got an ACK/failure; we can stop retransmitting
                   // our failure response now.
                   resetNextTransmission(0);
@@ -1882,7 +1922,7 @@ TransactionState::processServerInvite(TransactionMessage* msg)
                   // source Tuple that the request was received on. 
                   //terminateServerTransaction(mId);
                   mMachine = ServerStale;
-                  mController.mTimers.add(Timer::TimerStaleServer, mId, Timer::TS );
+                  addTimer(Timer::TimerStaleServer, Timer::TS );
                }
                else
                {
@@ -1908,10 +1948,10 @@ TransactionState::processServerInvite(TransactionMessage* msg)
                   StackLog (<< "Received failed response in Trying or Proceeding. Start Timer H, move to completed." << *this);
                   resetNextTransmission(sip);
                   mState = Completed;
-                  mController.mTimers.add(Timer::TimerH, mId, Timer::TH );
+                  addTimer(Timer::TimerH, Timer::TH );
                   if (!mIsReliable)
                   {
-                     mController.mTimers.add(Timer::TimerG, mId, Timer::T1 );
+                     addTimer(Timer::TimerG, Timer::T1 );
                   }
                   sendCurrentToWire(); // don't delete msg
                }
@@ -1949,7 +1989,7 @@ TransactionState::processServerInvite(TransactionMessage* msg)
             {
                StackLog (<< "TimerG fired. retransmit, and re-add TimerG");
                sendCurrentToWire();
-               mController.mTimers.add(Timer::TimerG, mId, resipMin(Timer::T2, timer->getDuration()*2) );  //  TimerG is supposed to double - up until a max of T2 RFC3261 17.2.1
+               addTimer(Timer::TimerG, resipMin(Timer::T2, timer->getDuration()*2) );  //  TimerG is supposed to double - up until a max of T2 RFC3261 17.2.1
             }
             break;
 
@@ -2018,10 +2058,10 @@ TransactionState::processServerInvite(TransactionMessage* msg)
             mAckIsValid=true;
             StackLog (<< "Received failed response in Trying or Proceeding. Start Timer H, move to completed." << *this);
             mState = Completed;
-            mController.mTimers.add(Timer::TimerH, mId, Timer::TH );
+            addTimer(Timer::TimerH, Timer::TH );
             if (!mIsReliable)
             {
-               mController.mTimers.add(Timer::TimerG, mId, Timer::T1 );
+               addTimer(Timer::TimerG, Timer::T1 );
             }
          }
          else
@@ -2428,7 +2468,7 @@ TransactionState::processTcpConnectState(TransactionMessage* msg)
        (mState == Trying || mState == Calling))
    {
       // Start Timer
-      mController.mTimers.add(Timer::TcpConnectTimer, mId, Timer::TcpConnectTimeout);
+      addTimer(Timer::TcpConnectTimer, Timer::TcpConnectTimeout);
       mTcpConnectTimerStarted = true;
    }
    else if (tcpConnectState->getState() == TcpConnectState::Connected &&
@@ -2520,11 +2560,11 @@ TransactionState::processReliability(TransportType type)
             switch (mMachine)
             {
                case ClientNonInvite:
-                  mController.mTimers.add(Timer::TimerE1, mId, Timer::T1 );
+                  addTimer(Timer::TimerE1, Timer::T1 );
                   break;
                   
                case ClientInvite:
-                  mController.mTimers.add(Timer::TimerA, mId, Timer::T1 );
+                  addTimer(Timer::TimerA, Timer::T1 );
                   break;
 
                default:
@@ -2724,6 +2764,10 @@ TransactionState::onSendSuccess()
    if(sip->isResponse())
    {
       mCurrentResponseCode = sip->const_header(h_StatusLine).statusCode();
+      if (mMachine == ServerNonInvite || mMachine == ServerInvite)
+      {
+         recordResponseLatency(mCurrentResponseCode);
+      }
    }
 
    // !bwc! If mNextTransmission is a non-ACK request, we need to save the
@@ -2736,10 +2780,47 @@ TransactionState::onSendSuccess()
    }
 }
 
+void
+TransactionState::recordResponseLatency(int code)
+{
+   if (!mStartUs || code < 100)
+   {
+      return;
+   }
+
+   StatisticsManager::LatencyType type;
+   if (code < 200)
+   {
+      if (mProvisionalSeen)
+      {
+         return;
+      }
+      mProvisionalSeen = true;
+      type = StatisticsManager::FirstProvisionalLatency;
+   }
+   else
+   {
+      if (mFinalSeen)
+      {
+         return;
+      }
+      mFinalSeen = true;
+      type = StatisticsManager::FinalResponseLatency;
+   }
+   mController.mStatsManager.transactionLatency(mMachine == ClientNonInvite || mMachine == ClientInvite,
+                                                mMethod, type, 
+                                                Timer::getTimeMicroSec() - mStartUs);
+}
+
 void
 TransactionState::sendToTU(TransactionMessage* msg)
 {
    SipMessage* sipMsg = dynamic_cast<SipMessage*>(msg);
+   if (sipMsg && sipMsg->isResponse() && 
+       (mMachine == ClientNonInvite || mMachine == ClientInvite))
+   {
+      recordResponseLatency(sipMsg->const_header(h_StatusLine).statusCode());
+   }
    if (sipMsg && sipMsg->isResponse() && mDnsResult)
    {
       // whitelisting rules.
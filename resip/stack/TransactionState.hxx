@@ -3,10 +3,12 @@
 
 #include <iosfwd>
 #include <memory>
+#include <vector>
 #include "rutil/dns/DnsHandler.hxx"
 #include "resip/stack/MethodTypes.hxx"
 #include "resip/stack/SipMessage.hxx"
 #include "resip/stack/Transport.hxx"
+#include "rutil/Timer.hxx"
 #include "rutil/HeapInstanceCounter.hxx"
 
 namespace resip
@@ -115,12 +117,16 @@ class TransactionState : public DnsHandler
       static void sendToTU(TransactionUser* tu, TransactionController& controller, TransactionMessage* msg);
       void sendCurrentToWire();
       void onSendSuccess();
+      void recordResponseLatency(int code);
       SipMessage* make100(SipMessage* request) const;
       void terminateClientTransaction(const Data& tid); 
       void terminateServerTransaction(const Data& tid); 
       const Data& tid(SipMessage* sip) const;
 
-      void startServerNonInviteTimerTrying(SipMessage& sip, const Data& tid);
+      void startServerNonInviteTimerTrying(SipMessage& sip);
+
+      /// starts a timer for this transaction; see mTimerIds
+      void addTimer(Timer::Type type, unsigned long msOffset);
 
       static TransactionState* makeCancelTransaction(TransactionState* tran, Machine machine, const Data& tid);
       static void handleInternalCancel(SipMessage* cancel,
@@ -194,7 +200,20 @@ class TransactionState : public DnsHandler
       int mFailureSubCode;
       bool mTcpConnectTimerStarted;
 
-      static UInt32 StatelessIdCounter;
+      // For the StatisticsManager's latency histograms; mStartUs is 0 when
+      // statistics are disabled.
+      UInt64 mStartUs;
+      bool mProvisionalSeen;
+      bool mFinalSeen;
+
+      // Ids of the timers we have started, so that they can be cancelled when
+      // we go away instead of firing into nothing. Slots of timers that have
+      // fired are reused, so this stays at the handful of timers a state
+      // machine has pending at once. Stays empty unless the timer queue is a
+      // Wheel, since the heap cannot cancel.
+      std::vector<UInt64> mTimerIds;
+
+      static volatile UInt32 StatelessIdCounter; // shared by every stack and shard
       
       friend EncodeStream& operator<<(EncodeStream& strm, const TransactionState& state);
       friend class TransactionController;
@@ -167,6 +167,16 @@ class TransactionUser
       }
 
       const TimeLimitFifo<Message>* getFifo() { return(&mFifo); } const
+
+      /**
+         @internal
+         @brief Set by the SipStack on registration, so that the time messages
+            wait in mFifo is reported in the stack statistics.
+      */
+      void setFifoDwellHistogram(LatencyHistogram* histogram)
+      {
+         mFifo.setDwellHistogram(histogram);
+      }
       
       virtual UInt16 getExpectedWait() const
       {
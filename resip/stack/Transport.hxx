@@ -52,6 +52,25 @@ class FdPollGrp;
  *    Specifies whether this Transport object has its own thread (ie; if
  *    set, the TransportSelector should not run the select/poll loop for
  *    this transport, since that is another thread's job)
+ * RXBATCH:
+ *    On datagram transports that support it (UDP, where the platform has
+ *    recvmmsg()), pull up to a batch of datagrams out of the socket per
+ *    system call, using one receive arena shared across the batch.
+ *    Combine with RXALL to keep reading batches until the socket is drained.
+ * TXBATCH:
+ *    On datagram transports that support it (UDP, where the platform has
+ *    sendmmsg()), hand a batch of queued messages to the socket per system
+ *    call. Combine with TXALL to flush the whole transmit queue.
+ * REUSEPORT:
+ *    Set SO_REUSEPORT on the socket before binding, so that several
+ *    sockets can share one address and the kernel spreads inbound traffic
+ *    across them. Used by ShardedUdpTransport.
+ * TXGATHER:
+ *    On transports that support it (UDP and TCP, where the platform has
+ *    sendmsg() and writev()), encode outgoing messages with
+ *    SipMessage::encodeFragments() and gather the pieces when writing, so
+ *    header values and bodies forwarded unmodified are not copied out of
+ *    the buffers they were received in. Not used for SigComp.
  */
 #define RESIP_TRANSPORT_FLAG_NOBIND      (1<<0)
 #define RESIP_TRANSPORT_FLAG_RXALL       (1<<1)
@@ -59,6 +78,10 @@ class FdPollGrp;
 #define RESIP_TRANSPORT_FLAG_KEEP_BUFFER (1<<3)
 #define RESIP_TRANSPORT_FLAG_TXNOW       (1<<4)
 #define RESIP_TRANSPORT_FLAG_OWNTHREAD   (1<<5)
+#define RESIP_TRANSPORT_FLAG_RXBATCH     (1<<6)
+#define RESIP_TRANSPORT_FLAG_TXBATCH     (1<<7)
+#define RESIP_TRANSPORT_FLAG_REUSEPORT   (1<<8)
+#define RESIP_TRANSPORT_FLAG_TXGATHER    (1<<9)
 
 /**
    @brief The base class for Transport classes.
@@ -86,7 +109,7 @@ class Transport : public FdSetIOObserver
           virtual void inboundMessage(const Tuple& source, const Tuple& destination, const SipMessage &msg) = 0;
       };
 
-      void setSipMessageLoggingHandler(SharedPtr<SipMessageLoggingHandler> handler) { mSipMessageLoggingHandler = handler; }
+      virtual void setSipMessageLoggingHandler(SharedPtr<SipMessageLoggingHandler> handler) { mSipMessageLoggingHandler = handler; }
       SipMessageLoggingHandler* getSipMessageLoggingHandler() { return 0 != mSipMessageLoggingHandler.get() ? mSipMessageLoggingHandler.get() : 0; }
 
       /**
@@ -264,6 +287,13 @@ class Transport : public FdSetIOObserver
       virtual bool isReliable() const =0;
       virtual bool isDatagram() const =0;
 
+      /**
+         @return true if SendData passed to send() may be fragmented (see
+         SipMessage::encodeFragments()), i.e. RESIP_TRANSPORT_FLAG_TXGATHER
+         is set and supported by this transport.
+      */
+      virtual bool canSendFragments() const { return false; }
+
       /// @return net namespace in which Transport is bound
       const Data& netNs() const { return(mTuple.getNetNs()); }
 
@@ -344,6 +374,19 @@ class Transport : public FdSetIOObserver
       //# queued messages on this transport
       virtual unsigned int getFifoSize() const=0;
 
+      /// Adds this transport's receive/transmit batch-size histograms (see
+      /// RESIP_TRANSPORT_FLAG_RXBATCH/TXBATCH) into rxBatches and txBatches,
+      /// each StatisticsMessage::Payload::MaxBatchBucket entries long.
+      /// Transports that do not batch contribute nothing.
+      virtual void sumBatchSizes(unsigned int* rxBatches, unsigned int* txBatches) const {}
+
+      /// Adds this transport's TLS handshakes, split into full and resumed,
+      /// and the TLS sessions its caches have evicted for lack of room.
+      /// Transports that do not do TLS contribute nothing.
+      virtual void sumTlsSessionStats(unsigned int& fullHandshakes, 
+                                      unsigned int& resumedHandshakes,
+                                      unsigned int& sessionCacheEvictions) const {}
+
       void callSocketFunc(Socket sock);
       virtual void invokeAfterSocketCreationFunc() const = 0;  //used to invoke the after socket creation func immeidately for all existing sockets - can be used to modify QOS settings at runtime
 
@@ -352,6 +395,10 @@ class Transport : public FdSetIOObserver
          mCongestionManager=manager;
       }
 
+      /// Switches the outgoing fifo, if the transport has one, to lock-free
+      /// mode. Only valid before the transport is added to the stack.
+      virtual void setTxFifoLockFree() {}
+
       CongestionManager::RejectionBehavior getRejectionBehaviorForIncoming() const
       {
          if(mCongestionManager)
@@ -32,6 +32,7 @@
 #include "rutil/DataStream.hxx"
 #include "rutil/DnsUtil.hxx"
 #include "rutil/Inserter.hxx"
+#include "rutil/Lock.hxx"
 #include "rutil/Logger.hxx"
 #include "rutil/Socket.hxx"
 #include "rutil/FdPoll.hxx"
@@ -166,6 +167,7 @@ TransportSelector::isFinished() const
 void
 TransportSelector::addTransport(std::auto_ptr<Transport> autoTransport, bool isStackRunning)
 {
+   PtrLock lock(mTransportsMutex.get(), VOCAL_WRITELOCK);
    Transport* transport = autoTransport.release();
 
    // !bwc! This is a multimap from TransportType/IpVersion to Transport*.
@@ -296,6 +298,7 @@ TransportSelector::addTransport(std::auto_ptr<Transport> autoTransport, bool isS
 void
 TransportSelector::removeTransport(unsigned int transportKey)
 {
+   PtrLock lock(mTransportsMutex.get(), VOCAL_WRITELOCK);
    Transport* transportToRemove = 0;
 
    // Find transport in global map and remove it
@@ -532,6 +535,7 @@ TransportSelector::checkTransportAddRemoveQueue()
 void 
 TransportSelector::poke()
 {
+   PtrLock lock(mTransportsMutex.get(), VOCAL_READLOCK);
    for(TransportList::iterator it = mHasOwnProcessTransports.begin(); it != mHasOwnProcessTransports.end(); it++)
    {
       try
@@ -577,6 +581,7 @@ void
 TransportSelector::dnsResolve(DnsResult* result,
                               SipMessage* msg)
 {
+   PtrLock lock(mTransportsMutex.get(), VOCAL_READLOCK);
    // Picking the target destination:
    //   - for request, use forced target if set
    //     otherwise use loose routing behaviour (route or, if none, request-uri)
@@ -757,6 +762,7 @@ TransportSelector::findTransportByVia(SipMessage* msg, const Tuple& target, Tupl
 Tuple
 TransportSelector::determineSourceInterface(SipMessage* msg, const Tuple& target) const
 {
+   PtrLock lock(mSourceInterfaceMutex.get());
    resip_assert(msg->exists(h_Vias));
    resip_assert(!msg->header(h_Vias).empty());
    const Via& via = msg->header(h_Vias).front();
@@ -926,6 +932,7 @@ TransportSelector::determineSourceInterface(SipMessage* msg, const Tuple& target
 TransportSelector::TransmitState
 TransportSelector::transmit(SipMessage* msg, Tuple& target, SendData* sendData)
 {
+   PtrLock lock(mTransportsMutex.get(), VOCAL_READLOCK);
    resip_assert(msg);
 
    if(msg->mIsDecorated)
@@ -1318,20 +1325,29 @@ TransportSelector::transmit(SipMessage* msg, Tuple& target, SendData* sendData)
 
          send->data.reserve(mAvgBufferSize + mAvgBufferSize/4);
 
-         DataStream str(send->data);
-         msg->encode(str);
-         str.flush();
+         if(transport->canSendFragments() && remoteSigcompId.empty())
+         {
+            // Unmodified parts of a forwarded message are handed to the
+            // transport where they sit, rather than copied.
+            msg->encodeFragments(*send);
+         }
+         else
+         {
+            DataStream str(send->data);
+            msg->encode(str);
+            str.flush();
+         }
 
          // !bwc! Moving average of message size. (Used to intelligently
          // predict how much space to reserve in the buffer, to minimize
          // dynamic resizing.)
          mAvgBufferSize = (255*mAvgBufferSize + send->data.size()+128)/256;
 
-         resip_assert(!send->data.empty());
+         resip_assert(!send->empty());
          DebugLog (<< "Transmitting to " << target
                    << " tlsDomain=" << msg->getTlsDomain()
                    << " via " << source
-                   << std::endl << std::endl << send->data.escaped()
+                   << std::endl << std::endl << send->toData().escaped()
                    << "sigcomp id=" << remoteSigcompId);
 
          if(sendData)
@@ -1360,6 +1376,7 @@ TransportSelector::transmit(SipMessage* msg, Tuple& target, SendData* sendData)
 void
 TransportSelector::retransmit(const SendData& data)
 {
+   PtrLock lock(mTransportsMutex.get(), VOCAL_READLOCK);
    resip_assert(data.destination.mTransportKey);
    Transport* transport = findTransportByDest(data.destination);
 
@@ -1392,7 +1409,16 @@ TransportSelector::retransmit(const SendData& data)
       Transport::SipMessageLoggingHandler* handler = transport->getSipMessageLoggingHandler();
       if(handler)
       {
-         handler->outboundRetransmit(transport->getTuple(), data.destination, data);
+         if(data.isFragmented())
+         {
+            SendData flat(data);
+            flat.flatten();
+            handler->outboundRetransmit(transport->getTuple(), data.destination, flat);
+         }
+         else
+         {
+            handler->outboundRetransmit(transport->getTuple(), data.destination, data);
+         }
       }
        
       transport->send(std::auto_ptr<SendData>(data.clone()));
@@ -1402,6 +1428,7 @@ TransportSelector::retransmit(const SendData& data)
 void 
 TransportSelector::closeConnection(const Tuple& peer)
 {
+   PtrLock lock(mTransportsMutex.get(), VOCAL_READLOCK);
    Transport* t = findTransportByDest(peer);
    if(t)
    {
@@ -1425,6 +1452,26 @@ TransportSelector::sumTransportFifoSizes() const
    return sum;
 }
 
+void
+TransportSelector::sumTransportBatchSizes(unsigned int* rxBatches, unsigned int* txBatches) const
+{
+   for(TransportKeyMap::const_iterator it = mTransports.begin(); it != mTransports.end(); it++)
+   {
+      it->second->sumBatchSizes(rxBatches, txBatches);
+   }
+}
+
+void
+TransportSelector::sumTransportTlsSessionStats(unsigned int& fullHandshakes, 
+                                               unsigned int& resumedHandshakes,
+                                               unsigned int& sessionCacheEvictions) const
+{
+   for(TransportKeyMap::const_iterator it = mTransports.begin(); it != mTransports.end(); it++)
+   {
+      it->second->sumTlsSessionStats(fullHandshakes, resumedHandshakes, sessionCacheEvictions);
+   }
+}
+
 void 
 TransportSelector::terminateFlow(const resip::Tuple& flow)
 {
@@ -1434,6 +1481,7 @@ TransportSelector::terminateFlow(const resip::Tuple& flow)
 void 
 TransportSelector::enableFlowTimer(const resip::Tuple& flow)
 {
+   PtrLock lock(mTransportsMutex.get(), VOCAL_READLOCK);
    Transport* t = findTransportByDest(flow);
    if(t)
    {
@@ -1446,6 +1494,16 @@ TransportSelector::enableFlowTimer(const resip::Tuple& flow)
    }
 }
 
+void
+TransportSelector::enableConcurrentTransmit()
+{
+   if(!mTransportsMutex.get())
+   {
+      mTransportsMutex.reset(new RWMutex);
+      mSourceInterfaceMutex.reset(new Mutex);
+   }
+}
+
 void 
 TransportSelector::invokeAfterSocketCreationFunc(TransportType type)
 {
@@ -12,6 +12,8 @@
 #include "rutil/Data.hxx"
 #include "rutil/Fifo.hxx"
 #include "rutil/GenericIPAddress.hxx"
+#include "rutil/Mutex.hxx"
+#include "rutil/RWMutex.hxx"
 #include "resip/stack/Transport.hxx"
 #include "resip/stack/DnsInterface.hxx"
 #include "rutil/SelectInterruptor.hxx"
@@ -54,7 +56,10 @@ the TransactionController Thread.  The TransportSelectorThread itself is used
 to provide cycles to the actual transports for sending data in their Fifo's and
 receiving data from the wire.  The mSharedProcessTransports list is one member that
 is expected to be accessed from TransportSelector processing loop only , all other 
-members are accessed from the TransactionController processing loop.
+members are accessed from the TransactionController processing loop.  When the
+TransactionController is sharded, every shard transmits through the same
+TransportSelector; enableConcurrentTransmit() makes the transmit paths safe
+for that.
 */
 class TransportSelector
 {
@@ -122,6 +127,10 @@ class TransportSelector
       void closeConnection(const Tuple& peer);
 
       unsigned int sumTransportFifoSizes() const;
+      void sumTransportBatchSizes(unsigned int* rxBatches, unsigned int* txBatches) const;
+      void sumTransportTlsSessionStats(unsigned int& fullHandshakes, 
+                                       unsigned int& resumedHandshakes,
+                                       unsigned int& sessionCacheEvictions) const;
 
       unsigned int getTimeTillNextProcessMS();
       Fifo<TransactionMessage>& stateMacFifo() { return mStateMacFifo; }
@@ -155,6 +164,11 @@ class TransportSelector
 
       void invokeAfterSocketCreationFunc(TransportType type);
 
+      /// Allows transmit(), retransmit(), dnsResolve(), closeConnection(),
+      /// enableFlowTimer() and poke() to be called from several threads at
+      /// once. Must be called before the stack starts processing.
+      void enableConcurrentTransmit();
+
       /**
          @internal - public only for stream operator access
       */
@@ -241,6 +255,12 @@ class TransportSelector
       mutable HashMap<Data, Socket> mSockets;
       mutable HashMap<Data, Socket> mSocket6s;
 
+      // Only allocated by enableConcurrentTransmit(). The transmit paths hold
+      // mTransportsMutex for read, adding/removing transports holds it for
+      // write; mSourceInterfaceMutex serializes use of the fake sockets.
+      std::auto_ptr<RWMutex> mTransportsMutex;
+      std::auto_ptr<Mutex> mSourceInterfaceMutex;
+
       // An AF_UNSPEC addr_in for rapid unconnect
       GenericIPAddress mUnspecified;
       GenericIPAddress mUnspecified6;
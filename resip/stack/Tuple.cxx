@@ -771,32 +771,38 @@ size_t
 Tuple::hash() const
 {
    // !dlb! do not include the connection
+   // Folds the address words, port and transport in with a multiplicative
+   // hash, so v6 addresses are hashed in place and nearby v4 addresses or
+   // ports don't land in neighbouring buckets.
+   static const UInt32 Mult = 0x9E3779B1;
+   UInt32 h = mTransportType;
 #ifdef USE_IPV6
    if (mSockaddr.sa_family == AF_INET6)
    {
       const sockaddr_in6& in6 =
          reinterpret_cast<const sockaddr_in6&>(mSockaddr);
-
-      return size_t(Data(Data::Share, (const char *)&in6.sin6_addr.s6_addr, sizeof(in6.sin6_addr.s6_addr)).hash() +
-#ifdef USE_NETNS
-                    mNetNs.hash() +
-#endif
-                    5*in6.sin6_port +
-                    25*mTransportType);
+      UInt32 words[4];
+      memcpy(words, &in6.sin6_addr, sizeof(words));
+      for (int i = 0; i < 4; ++i)
+      {
+         h = (h ^ words[i]) * Mult;
+      }
+      h = (h ^ in6.sin6_port) * Mult;
    }
    else
 #endif
    {
       const sockaddr_in& in4 =
          reinterpret_cast<const sockaddr_in&>(mSockaddr);
-         
-      return size_t(in4.sin_addr.s_addr +
+      h = (h ^ UInt32(in4.sin_addr.s_addr)) * Mult;
+      h = (h ^ in4.sin_port) * Mult;
+   }
+   h ^= h >> 16;
 #ifdef USE_NETNS
-                    mNetNs.hash() +
+   return size_t(h) + mNetNs.hash();
+#else
+   return size_t(h);
 #endif
-                    5*in4.sin_port +
-                    25*mTransportType);
-   }    
 }
 
 HashValueImp(resip::Tuple, data.hash());
@@ -38,12 +38,38 @@ UdpTransport::UdpTransport(Fifo<TransactionMessage>& fifo,
    : InternalTransport(fifo, portNum, version, pinterface, socketFunc, compression, transportFlags),
      mSigcompStack(0),
      mRxBuffer(0),
+     mRxArena(0),
      mExternalUnknownDatagramHandler(0),
      mInWritable(false)
 {
    mPollEventCnt = 0;
    mTxTryCnt = mTxMsgCnt = mTxFailCnt = 0;
    mRxTryCnt = mRxMsgCnt = mRxKeepaliveCnt = mRxTransactionCnt = 0;
+   for ( int b = 0; b < StatisticsMessage::Payload::MaxBatchBucket; ++b )
+   {
+      mRxBatchSizes[b] = mTxBatchSizes[b] = 0;
+   }
+#if !defined(HAVE_RECVMMSG)
+   if ( (mTransportFlags & RESIP_TRANSPORT_FLAG_RXBATCH)!=0 )
+   {
+      WarningLog(<< "recvmmsg() not available, ignoring RESIP_TRANSPORT_FLAG_RXBATCH");
+      mTransportFlags &= ~RESIP_TRANSPORT_FLAG_RXBATCH;
+   }
+#endif
+#if !defined(HAVE_SENDMMSG)
+   if ( (mTransportFlags & RESIP_TRANSPORT_FLAG_TXBATCH)!=0 )
+   {
+      WarningLog(<< "sendmmsg() not available, ignoring RESIP_TRANSPORT_FLAG_TXBATCH");
+      mTransportFlags &= ~RESIP_TRANSPORT_FLAG_TXBATCH;
+   }
+#endif
+#if defined(WIN32)
+   if ( (mTransportFlags & RESIP_TRANSPORT_FLAG_TXGATHER)!=0 )
+   {
+      WarningLog(<< "sendmsg() not available, ignoring RESIP_TRANSPORT_FLAG_TXGATHER");
+      mTransportFlags &= ~RESIP_TRANSPORT_FLAG_TXGATHER;
+   }
+#endif
    mTuple.setType(UDP);
    mFd = InternalTransport::socket(transport(), version);
    mTuple.mFlowKey=(FlowKey)mFd;
@@ -91,6 +117,7 @@ UdpTransport::~UdpTransport()
    {
       delete[] mRxBuffer;
    }
+   delete[] mRxArena;
    setPollGrp(0);
 }
 
@@ -221,9 +248,21 @@ UdpTransport::process(FdSet& fdset)
  * to specify one of these. Limited testing shows limited performance
  * gain from either of these: the socket-event overhead appears tiny.
  */
+bool
+UdpTransport::canSendFragments() const
+{
+   return (mTransportFlags & RESIP_TRANSPORT_FLAG_TXGATHER)!=0;
+}
+
 void
 UdpTransport::processTxAll()
 {
+   if ( (mTransportFlags & RESIP_TRANSPORT_FLAG_TXBATCH)!=0 )
+   {
+      processTxBatch();
+      return;
+   }
+
    SendData *msg;
    ++mTxTryCnt;
    while ( (msg=mTxFifoOutBuffer.getNext(RESIP_FIFO_NOWAIT)) != NULL )
@@ -237,6 +276,116 @@ UdpTransport::processTxAll()
    }
 }
 
+/**
+ * Batched variant of processTxAll() for RESIP_TRANSPORT_FLAG_TXBATCH: drains
+ * up to MaxBatchSize messages from the transmit queue and hands them to the
+ * kernel with a single sendmmsg(). Messages that need per-message handling
+ * (SendData commands, SigComp) end the batch and go through processTxOne().
+ */
+void
+UdpTransport::processTxBatch()
+{
+#if defined(HAVE_SENDMMSG)
+   // fragmented messages (RESIP_TRANSPORT_FLAG_TXGATHER) take several
+   // iovecs each; one that does not fit in what is left is sent on its own
+   static const int MaxBatchIovecs = MaxBatchSize*4;
+   struct mmsghdr msgs[MaxBatchSize];
+   struct iovec iovs[MaxBatchIovecs];
+   size_t expected[MaxBatchSize];
+   SendData* batch[MaxBatchSize];
+
+   ++mTxTryCnt;
+   for (;;)
+   {
+      int count = 0;
+      int iovCount = 0;
+      SendData* unbatchable = 0;
+      SendData* data;
+      while ( count < MaxBatchSize &&
+              (data=mTxFifoOutBuffer.getNext(RESIP_FIFO_NOWAIT)) != NULL )
+      {
+         bool compress = false;
+#ifdef USE_SIGCOMP
+         compress = mSigcompStack &&
+                    data->sigcompId.size() > 0 &&
+                    !data->isAlreadyCompressed;
+#endif
+         int needed = data->isFragmented() ? (int)data->fragments.size() : 1;
+         if ( data->command != SendData::NoCommand || compress ||
+              iovCount + needed > MaxBatchIovecs )
+         {
+            unbatchable = data;
+            break;
+         }
+         resip_assert( data->destination.getPort() != 0 );
+
+         memset(&msgs[count], 0, sizeof(msgs[count]));
+         msgs[count].msg_hdr.msg_name = const_cast<sockaddr*>(&data->destination.getSockaddr());
+         msgs[count].msg_hdr.msg_namelen = data->destination.length();
+         msgs[count].msg_hdr.msg_iov = &iovs[iovCount];
+         msgs[count].msg_hdr.msg_iovlen = data->fillIovecs(&iovs[iovCount], needed);
+         iovCount += (int)msgs[count].msg_hdr.msg_iovlen;
+         expected[count] = data->size();
+         batch[count++] = data;
+      }
+
+      if ( count > 0 )
+      {
+         AtomicOps::add(mTxBatchSizes[StatisticsMessage::Payload::batchBucket(count)], 1);
+         mTxMsgCnt += count;
+
+         int done = 0;
+         while ( done < count )
+         {
+            int sent = sendmmsg(mFd, &msgs[done], count - done, 0);
+            if ( sent <= 0 )
+            {
+               // the error belongs to the first unsent datagram; skip it and
+               // carry on with the rest of the batch
+               int e = getErrno();
+               error(e);
+               InfoLog (<< "Failed (" << e << ") sending to " << batch[done]->destination);
+               fail(batch[done]->transactionId);
+               ++mTxFailCnt;
+               ++done;
+               continue;
+            }
+            for ( int i = done; i < done + sent; ++i )
+            {
+               if ( msgs[i].msg_len != expected[i] )
+               {
+                  ErrLog (<< "UDPTransport - send buffer full" );
+                  fail(batch[i]->transactionId);
+               }
+            }
+            done += sent;
+         }
+
+         for ( int i = 0; i < count; ++i )
+         {
+            delete batch[i];
+         }
+      }
+
+      if ( unbatchable )
+      {
+         processTxOne(unbatchable);
+      }
+      else if ( count < MaxBatchSize )
+      {
+         break;   // queue drained
+      }
+
+      if ( (mTransportFlags & RESIP_TRANSPORT_FLAG_TXALL)==0 )
+      {
+         break;
+      }
+   }
+#else
+   resip_assert(0);
+#endif
+}
+
 void
 UdpTransport::processTxOne(SendData *data)
 {
@@ -262,6 +411,7 @@ UdpTransport::processTxOne(SendData *data)
        sendData->sigcompId.size() > 0 &&
        !sendData->isAlreadyCompressed )
    {
+       sendData->flatten();
        osc::SigcompMessage *sm = mSigcompStack->compressMessage
          (sendData->data.data(), sendData->data.size(),
           sendData->sigcompId.data(), sendData->sigcompId.size(),
@@ -281,6 +431,22 @@ UdpTransport::processTxOne(SendData *data)
        delete sm;
    }
    else
+#endif
+#ifndef WIN32
+   if (sendData->isFragmented())
+   {
+       struct iovec iov[SendData::MaxFragments];
+       struct msghdr msg;
+       memset(&msg, 0, sizeof(msg));
+       msg.msg_name = const_cast<sockaddr*>(&addr);
+       msg.msg_namelen = sendData->destination.length();
+       msg.msg_iov = iov;
+       msg.msg_iovlen = sendData->fillIovecs(iov, SendData::MaxFragments);
+
+       expected = (int)sendData->size();
+       count = sendmsg(mFd, &msg, 0);
+   }
+   else
 #endif
    {
        expected = (int)sendData->data.size();
@@ -319,6 +485,12 @@ UdpTransport::processTxOne(SendData *data)
 void
 UdpTransport::processRxAll()
 {
+   if ( (mTransportFlags & RESIP_TRANSPORT_FLAG_RXBATCH)!=0 )
+   {
+      processRxBatch();
+      return;
+   }
+
    char *buffer = mRxBuffer;
    mRxBuffer = NULL;
    ++mRxTryCnt;
@@ -353,6 +525,93 @@ UdpTransport::processRxAll()
    }
 }
 
+/**
+ * Batched variant of processRxAll() for RESIP_TRANSPORT_FLAG_RXBATCH: reads
+ * up to MaxBatchSize datagrams per recvmmsg() into mRxArena, then copies
+ * each one into a buffer of its actual size for the SipMessage to own. The
+ * arena itself is never handed out, so it is reused by every batch and
+ * in-flight messages no longer pin MaxBufferSize bytes apiece.
+ */
+void
+UdpTransport::processRxBatch()
+{
+#if defined(HAVE_RECVMMSG)
+   struct mmsghdr msgs[MaxBatchSize];
+   struct iovec iovs[MaxBatchSize];
+   struct sockaddr_storage names[MaxBatchSize];
+
+   if ( mRxArena == NULL )
+   {
+      mRxArena = new char[MaxBatchSize * MaxBufferSize];
+   }
+
+   ++mRxTryCnt;
+   for (;;)
+   {
+      for ( int i = 0; i < MaxBatchSize; ++i )
+      {
+         iovs[i].iov_base = mRxArena + i * MaxBufferSize;
+         iovs[i].iov_len = MaxBufferSize;
+         memset(&msgs[i], 0, sizeof(msgs[i]));
+         msgs[i].msg_hdr.msg_name = &names[i];
+         msgs[i].msg_hdr.msg_namelen = sizeof(names[i]);
+         msgs[i].msg_hdr.msg_iov = &iovs[i];
+         msgs[i].msg_hdr.msg_iovlen = 1;
+      }
+
+      int count = recvmmsg(mFd, msgs, MaxBatchSize, 0, 0);
+      if ( count == SOCKET_ERROR )
+      {
+         int err = getErrno();
+         if ( err != EAGAIN && err != EWOULDBLOCK )
+         {
+            error( err );
+         }
+         break;
+      }
+      if ( count == 0 )
+      {
+         break;
+      }
+      AtomicOps::add(mRxBatchSizes[StatisticsMessage::Payload::batchBucket(count)], 1);
+
+      for ( int i = 0; i < count; ++i )
+      {
+         int len = (int)msgs[i].msg_len;
+         if ( len+1 >= MaxBufferSize )
+         {
+            InfoLog(<<"Datagram exceeded max length "<<MaxBufferSize);
+            continue;
+         }
+         if ( len == 0 )
+         {
+            continue;
+         }
+         ++mRxMsgCnt;
+
+         Tuple sender(mTuple);
+         memcpy(&sender.getMutableSockaddr(), &names[i],
+                resipMin((socklen_t)msgs[i].msg_hdr.msg_namelen, sender.length()));
+
+         char* buffer = MsgHeaderScanner::allocateBuffer(len);
+         memcpy(buffer, iovs[i].iov_base, len);
+         if ( !processRxParse(buffer, len, sender) )
+         {
+            delete[] buffer;
+         }
+      }
+
+      if ( count < MaxBatchSize ||
+           (mTransportFlags & RESIP_TRANSPORT_FLAG_RXALL) == 0 )
+      {
+         break;
+      }
+   }
+#else
+   resip_assert(0);
+#endif
+}
+
 /*
  * Receive from socket and store results into {buffer}. Updates
  * {buffer} with actual buffer (in case allocation required),
@@ -583,7 +842,7 @@ UdpTransport::processRxParse(char *buffer, int len, Tuple& sender)
 
    // Tell the SipMessage about this datagram buffer.
    // WATCHOUT: below here buffer is consumed by message
-   message->addBuffer(buffer);
+   message->addBuffer(buffer, len);
 
    mMsgHeaderScanner.prepareForMessage(message);
 
@@ -708,6 +967,16 @@ UdpTransport::processRxParse(char *buffer, int len, Tuple& sender)
 
 
 
+void
+UdpTransport::sumBatchSizes(unsigned int* rxBatches, unsigned int* txBatches) const
+{
+   for ( int b = 0; b < StatisticsMessage::Payload::MaxBatchBucket; ++b )
+   {
+      rxBatches[b] += AtomicOps::load(mRxBatchSizes[b]);
+      txBatches[b] += AtomicOps::load(mTxBatchSizes[b]);
+   }
+}
+
 bool
 UdpTransport::stunSendTest(const Tuple&  dest)
 {
@@ -4,7 +4,9 @@
 #include <memory>
 #include "resip/stack/InternalTransport.hxx"
 #include "resip/stack/MsgHeaderScanner.hxx"
+#include "resip/stack/StatisticsMessage.hxx"
 #include "rutil/HeapInstanceCounter.hxx"
+#include "rutil/AtomicOps.hxx"
 #include "resip/stack/Compression.hxx"
 
 namespace osc { class Stack; }
@@ -68,6 +70,7 @@ public:
 
    virtual bool isReliable() const { return false; }
    virtual bool isDatagram() const { return true; }
+   virtual bool canSendFragments() const;
 
    virtual void process(FdSet& fdset);
    virtual void process();
@@ -75,12 +78,15 @@ public:
    virtual void buildFdSet( FdSet& fdset);
    virtual void setPollGrp(FdPollGrp *grp);
    virtual void setRcvBufLen(int buflen);
+   virtual void sumBatchSizes(unsigned int* rxBatches, unsigned int* txBatches) const;
 
    // FdPollItemIf
    // virtual Socket getPollSocket() const;
    virtual void processPollEvent(FdPollEventMask mask);
 
    static const int MaxBufferSize = 8192;
+   /// Most datagrams moved per recvmmsg()/sendmmsg() in batched mode
+   static const int MaxBatchSize = 32;
 
    // STUN client functionality
    bool stunSendTest(const Tuple& dest);
@@ -96,6 +102,8 @@ protected:
    bool processRxParse(char *buffer, int len, Tuple& sender);
    void processTxAll();
    void processTxOne(SendData *data);
+   void processRxBatch();
+   void processTxBatch();
    void updateEvents();
 
    osc::Stack *mSigcompStack;
@@ -109,8 +117,14 @@ protected:
    unsigned mRxMsgCnt;
    unsigned mRxKeepaliveCnt;
    unsigned mRxTransactionCnt;
+   // cumulative; read by the StatisticsManager from another thread
+   volatile UInt32 mRxBatchSizes[StatisticsMessage::Payload::MaxBatchBucket];
+   volatile UInt32 mTxBatchSizes[StatisticsMessage::Payload::MaxBatchBucket];
 private:
    char* mRxBuffer;
+   // receive arena for RESIP_TRANSPORT_FLAG_RXBATCH; MaxBatchSize slots of
+   // MaxBufferSize bytes, allocated on first use and reused for every batch
+   char* mRxArena;
    MsgHeaderScanner mMsgHeaderScanner;
    mutable resip::Mutex  myMutex;
    Tuple mStunMappedAddress;
@@ -56,6 +56,12 @@
 #include <openssl/x509.h>
 #include <openssl/x509v3.h>
 #include <openssl/ssl.h>
+#include <openssl/hmac.h>
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+#include <openssl/core_names.h>
+#include <openssl/params.h>
+#endif
+#include <openssl/rand.h>
 
 #if OPENSSL_VERSION_NUMBER < 0x10100000L
 
@@ -156,6 +162,10 @@ BaseSecurity::CipherList BaseSecurity::StrongestSuite("HIGH:-COMPLEMENTOFDEFAULT
 long BaseSecurity::OpenSSLCTXSetOptions = SSL_OP_NO_SSLv2 | SSL_OP_NO_SSLv3;
 long BaseSecurity::OpenSSLCTXClearOptions = 0;
 
+long BaseSecurity::TlsSessionCacheSize = 20480;
+long BaseSecurity::TlsSessionLifetime = 3600;
+long BaseSecurity::TlsTicketKeyRotation = 12*3600;
+
 Security::Security(const CipherList& cipherSuite, const Data& defaultPrivateKeyPassPhrase, const Data& dHParamsFilename) :
    BaseSecurity(cipherSuite, defaultPrivateKeyPassPhrase, dHParamsFilename)
 {
@@ -457,6 +467,7 @@ Security::createDomainCtx(const SSL_METHOD* method, const Data& domain, const Da
    setDHParams(ctx);
    SSL_CTX_set_options(ctx, BaseSecurity::OpenSSLCTXSetOptions);
    SSL_CTX_clear_options(ctx, BaseSecurity::OpenSSLCTXClearOptions);
+   setSessionCaching(ctx, domain);
 
    return ctx;
 }
@@ -1152,6 +1163,7 @@ BaseSecurity::BaseSecurity (const CipherList& cipherSuite, const Data& defaultPr
    mRootSslCerts(0)
 { 
    DebugLog(<< "BaseSecurity::BaseSecurity");
+   memset(mTicketKeys, 0, sizeof(mTicketKeys));
    
    int ret;
    initialize(); 
@@ -1181,6 +1193,7 @@ BaseSecurity::BaseSecurity (const CipherList& cipherSuite, const Data& defaultPr
    setDHParams(mTlsCtx);
    SSL_CTX_set_options(mTlsCtx, BaseSecurity::OpenSSLCTXSetOptions);
    SSL_CTX_clear_options(mTlsCtx, BaseSecurity::OpenSSLCTXClearOptions);
+   setSessionCaching(mTlsCtx, Data::Empty);
    
    mSslCtx = SSL_CTX_new( SSLv23_method() );
    resip_assert(mSslCtx);
@@ -1192,6 +1205,7 @@ BaseSecurity::BaseSecurity (const CipherList& cipherSuite, const Data& defaultPr
    setDHParams(mSslCtx);
    SSL_CTX_set_options(mSslCtx, BaseSecurity::OpenSSLCTXSetOptions);
    SSL_CTX_clear_options(mSslCtx, BaseSecurity::OpenSSLCTXClearOptions);
+   setSessionCaching(mSslCtx, Data::Empty);
 }
 
 
@@ -3185,6 +3199,160 @@ BaseSecurity::setDHParams(SSL_CTX* ctx)
    }
 }
 
+// SSL_CTX ex_data slot pointing back at the BaseSecurity that set it up,
+// for onTicketKey()
+static int
+securityExDataIndex()
+{
+   static int index = SSL_CTX_get_ex_new_index(0, 0, 0, 0, 0);
+   return index;
+}
+
+void
+BaseSecurity::setSessionCaching(SSL_CTX* ctx, const Data& sessionIdContext)
+{
+   // A server that asks for client certificates won't resume a session
+   // unless a session id context is set; the md5 in hex is exactly
+   // SSL_MAX_SID_CTX_LENGTH long.
+   Data sidCtx = (Data("resip:") + sessionIdContext).md5();
+   SSL_CTX_set_session_id_context(ctx, (const unsigned char*)sidCtx.data(), (unsigned int)sidCtx.size());
+
+   if (TlsSessionCacheSize > 0)
+   {
+      SSL_CTX_set_session_cache_mode(ctx, SSL_SESS_CACHE_SERVER);
+      SSL_CTX_sess_set_cache_size(ctx, TlsSessionCacheSize);
+   }
+   else
+   {
+      SSL_CTX_set_session_cache_mode(ctx, SSL_SESS_CACHE_OFF);
+   }
+   SSL_CTX_set_timeout(ctx, TlsSessionLifetime);
+
+   bool tickets = false;
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L || defined(SSL_CTX_set_tlsext_ticket_key_cb)
+   if (TlsTicketKeyRotation > 0)
+   {
+      SSL_CTX_set_ex_data(ctx, securityExDataIndex(), this);
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+      SSL_CTX_set_tlsext_ticket_key_evp_cb(ctx, onTicketKey);
+#else
+      SSL_CTX_set_tlsext_ticket_key_cb(ctx, onTicketKey);
+#endif
+      tickets = true;
+   }
+#endif
+   if (!tickets)
+   {
+      SSL_CTX_set_options(ctx, SSL_OP_NO_TICKET);
+   }
+}
+
+void
+BaseSecurity::rotateTicketKeys(UInt64 now)
+{
+   // called with mTicketKeyMutex held
+   UInt64 period = (UInt64)TlsTicketKeyRotation * 1000;
+   if (mTicketKeys[0].createdMs != 0 && now - mTicketKeys[0].createdMs < period)
+   {
+      return;
+   }
+
+   mTicketKeys[1] = mTicketKeys[0];
+   if (now - mTicketKeys[1].createdMs >= 2 * period)
+   {
+      // nothing has been issued for a whole period; the old key is done too
+      memset(&mTicketKeys[1], 0, sizeof(mTicketKeys[1]));
+   }
+
+   TicketKey& key = mTicketKeys[0];
+   if (RAND_bytes(key.name, sizeof(key.name)) != 1 ||
+       RAND_bytes(key.aesKey, sizeof(key.aesKey)) != 1 ||
+       RAND_bytes(key.hmacKey, sizeof(key.hmacKey)) != 1)
+   {
+      ErrLog(<< "Unable to generate a TLS session ticket key");
+      memset(&key, 0, sizeof(key));
+      return;
+   }
+   key.createdMs = now;
+   InfoLog(<< "Rotated TLS session ticket key");
+}
+
+int
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+BaseSecurity::onTicketKey(SSL* ssl, unsigned char* keyName, unsigned char* iv,
+                          EVP_CIPHER_CTX* cipherCtx, EVP_MAC_CTX* macCtx, int encrypt)
+#else
+BaseSecurity::onTicketKey(SSL* ssl, unsigned char* keyName, unsigned char* iv,
+                          EVP_CIPHER_CTX* cipherCtx, HMAC_CTX* hmacCtx, int encrypt)
+#endif
+{
+   BaseSecurity* security = 
+      static_cast<BaseSecurity*>(SSL_CTX_get_ex_data(SSL_get_SSL_CTX(ssl), securityExDataIndex()));
+   if (!security)
+   {
+      return -1;
+   }
+
+   TicketKey key;
+   int ret = 1;
+   {
+      Lock lock(security->mTicketKeyMutex);
+      security->rotateTicketKeys(Timer::getTimeMs());
+      if (encrypt)
+      {
+         key = security->mTicketKeys[0];
+         if (key.createdMs == 0)
+         {
+            return -1;
+         }
+      }
+      else
+      {
+         int i = 0;
+         for (; i < 2; ++i)
+         {
+            if (security->mTicketKeys[i].createdMs != 0 &&
+                memcmp(keyName, security->mTicketKeys[i].name, sizeof(key.name)) == 0)
+            {
+               break;
+            }
+         }
+         if (i == 2)
+         {
+            return 0; // unknown or retired key: do a full handshake
+         }
+         key = security->mTicketKeys[i];
+         ret = (i == 0) ? 1 : 2; // 2 has OpenSSL issue a ticket under the current key
+      }
+   }
+
+   if (encrypt)
+   {
+      if (RAND_bytes(iv, EVP_CIPHER_iv_length(EVP_aes_128_cbc())) != 1)
+      {
+         return -1;
+      }
+      memcpy(keyName, key.name, sizeof(key.name));
+      EVP_EncryptInit_ex(cipherCtx, EVP_aes_128_cbc(), 0, key.aesKey, iv);
+   }
+   else
+   {
+      EVP_DecryptInit_ex(cipherCtx, EVP_aes_128_cbc(), 0, key.aesKey, iv);
+   }
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+   OSSL_PARAM params[2];
+   params[0] = OSSL_PARAM_construct_utf8_string(OSSL_MAC_PARAM_DIGEST, const_cast<char*>("SHA256"), 0);
+   params[1] = OSSL_PARAM_construct_end();
+   if (EVP_MAC_init(macCtx, key.hmacKey, sizeof(key.hmacKey), params) != 1)
+   {
+      return -1;
+   }
+#else
+   HMAC_Init_ex(hmacCtx, key.hmacKey, sizeof(key.hmacKey), EVP_sha256(), 0);
+#endif
+   return ret;
+}
+
 #endif
 
 
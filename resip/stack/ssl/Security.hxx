@@ -12,6 +12,7 @@
 
 #include "rutil/Socket.hxx"
 #include "rutil/BaseException.hxx"
+#include "rutil/Mutex.hxx"
 #include "resip/stack/SecurityTypes.hxx"
 #include "resip/stack/SecurityAttributes.hxx"
 
@@ -90,6 +91,25 @@ class BaseSecurity
       static long OpenSSLCTXSetOptions;
       static long OpenSSLCTXClearOptions;
 
+      /**
+       * Session resumption, set up on every SSL_CTX this class creates.
+       *
+       * TlsSessionCacheSize bounds the sessions each context keeps for
+       * resumption by session id; once it is full OpenSSL evicts the
+       * oldest. 0 turns the server-side cache off.
+       *
+       * TlsSessionLifetime is how many seconds a session, cached or
+       * carried in a ticket, can be resumed for.
+       *
+       * TlsTicketKeyRotation is how many seconds a session ticket key is
+       * used to issue tickets. Tickets under the key before it are still
+       * accepted, and renewed, for one more period. 0 turns session
+       * tickets off.
+       */
+      static long TlsSessionCacheSize;
+      static long TlsSessionLifetime;
+      static long TlsTicketKeyRotation;
+
       BaseSecurity(const CipherList& cipherSuite = StrongestSuite, const Data& defaultPrivateKeyPassPhrase = Data::Empty, const Data& dHParamsFilename = Data::Empty);
       virtual ~BaseSecurity();
 
@@ -261,6 +281,27 @@ class BaseSecurity
       static bool mAllowWildcardCertificates;
 
       void setDHParams(SSL_CTX* ctx);
+      void setSessionCaching(SSL_CTX* ctx, const Data& sessionIdContext);
+
+   private:
+      struct TicketKey
+      {
+         unsigned char name[16];
+         unsigned char aesKey[16];
+         unsigned char hmacKey[32];
+         UInt64 createdMs; // 0 if never generated
+      };
+      TicketKey mTicketKeys[2]; // issuing key, then the one it replaced
+      Mutex mTicketKeyMutex;
+
+      void rotateTicketKeys(UInt64 now);
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+      static int onTicketKey(SSL* ssl, unsigned char* keyName, unsigned char* iv,
+                             EVP_CIPHER_CTX* cipherCtx, EVP_MAC_CTX* macCtx, int encrypt);
+#else
+      static int onTicketKey(SSL* ssl, unsigned char* keyName, unsigned char* iv,
+                             EVP_CIPHER_CTX* cipherCtx, HMAC_CTX* hmacCtx, int encrypt);
+#endif
 };
 
 class Security : public BaseSecurity
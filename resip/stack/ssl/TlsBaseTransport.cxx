@@ -9,10 +9,12 @@
 
 #include "rutil/compat.hxx"
 #include "rutil/Data.hxx"
+#include "rutil/Lock.hxx"
 #include "rutil/Socket.hxx"
 #include "rutil/Logger.hxx"
 #include "resip/stack/ssl/TlsBaseTransport.hxx"
 #include "resip/stack/ssl/TlsConnection.hxx"
+#include "resip/stack/ssl/TlsHandshakePool.hxx"
 #include "resip/stack/ssl/Security.hxx"
 #include "rutil/WinLeakCheck.hxx"
 
@@ -21,6 +23,10 @@
 using namespace std;
 using namespace resip;
 
+unsigned int TlsBaseTransport::MaxClientSessions = 1000;
+unsigned int TlsBaseTransport::HandshakeThreads = 0;
+unsigned int TlsBaseTransport::MaxQueuedHandshakes = 1000;
+
 TlsBaseTransport::TlsBaseTransport(Fifo<TransactionMessage>& fifo, 
                            int portNum, 
                            IpVersion version,
@@ -42,7 +48,11 @@ TlsBaseTransport::TlsBaseTransport(Fifo<TransactionMessage>& fifo,
    mSslType(sslType),
    mDomainCtx(0),
    mClientVerificationMode(cvm),
-   mUseEmailAsSIP(useEmailAsSIP)
+   mUseEmailAsSIP(useEmailAsSIP),
+   mHandshakePool(0),
+   mFullHandshakes(0),
+   mResumedHandshakes(0),
+   mClientSessionEvictions(0)
 {
    setTlsDomain(sipDomain);   
    mTuple.setType(transportType);
@@ -67,11 +77,37 @@ TlsBaseTransport::TlsBaseTransport(Fifo<TransactionMessage>& fifo,
          throw invalid_argument("Unrecognised SecurityTypes::SSLType value");
       }
    }
+
+   if (MaxClientSessions > 0)
+   {
+      // Sessions for outbound connections come back through
+      // TlsConnection::onNewSession() once the peer has sent them, which
+      // with TLS 1.3 is only after the handshake.
+      SSL_CTX* ctx = getCtx();
+      SSL_CTX_set_session_cache_mode(ctx, SSL_CTX_get_session_cache_mode(ctx) | SSL_SESS_CACHE_CLIENT);
+      SSL_CTX_sess_set_new_cb(ctx, TlsConnection::onNewSession);
+   }
+
+   if (HandshakeThreads > 0)
+   {
+      mHandshakePool = new TlsHandshakePool(HandshakeThreads, MaxQueuedHandshakes);
+   }
 }
 
 
 TlsBaseTransport::~TlsBaseTransport()
 {
+   // Close the connections while this transport is still whole: a
+   // TlsConnection's destructor takes its handshake pool from here, and
+   // must cancel its handshake there before the pool goes.
+   getConnectionManager().closeConnections();
+   delete mHandshakePool;
+   mHandshakePool = 0;
+
+   for (ClientSessionMap::iterator i = mClientSessions.begin(); i != mClientSessions.end(); ++i)
+   {
+      SSL_SESSION_free(i->second.session);
+   }
    if (mDomainCtx)
    {
       SSL_CTX_free(mDomainCtx);mDomainCtx=0;
@@ -114,6 +150,78 @@ TlsBaseTransport::setPeerCertificateVerificationCallback(
    return true;
 }
 
+void
+TlsBaseTransport::setPollGrp(FdPollGrp *grp)
+{
+   if (mHandshakePool)
+   {
+      mHandshakePool->setPollGrp(grp);
+   }
+   TcpBaseTransport::setPollGrp(grp);
+}
+
+bool
+TlsBaseTransport::offerClientSession(const Data& key, SSL* ssl) const
+{
+   Lock lock(mClientSessionMutex);
+   ClientSessionMap::const_iterator i = mClientSessions.find(key);
+   // SSL_set_session() takes its own reference
+   return i != mClientSessions.end() && SSL_set_session(ssl, i->second.session) == 1;
+}
+
+void
+TlsBaseTransport::storeClientSession(const Data& key, SSL_SESSION* session)
+{
+   Lock lock(mClientSessionMutex);
+   ClientSessionMap::iterator i = mClientSessions.find(key);
+   if (i != mClientSessions.end())
+   {
+      SSL_SESSION_free(i->second.session);
+      i->second.session = session;
+      mClientSessionOrder.splice(mClientSessionOrder.end(), mClientSessionOrder, i->second.order);
+      return;
+   }
+
+   while (!mClientSessionOrder.empty() && mClientSessions.size() >= MaxClientSessions)
+   {
+      ClientSessionMap::iterator oldest = mClientSessions.find(mClientSessionOrder.front());
+      resip_assert(oldest != mClientSessions.end());
+      SSL_SESSION_free(oldest->second.session);
+      mClientSessions.erase(oldest);
+      mClientSessionOrder.pop_front();
+      ++mClientSessionEvictions;
+   }
+
+   ClientSession& entry = mClientSessions[key];
+   entry.session = session;
+   entry.order = mClientSessionOrder.insert(mClientSessionOrder.end(), key);
+}
+
+void
+TlsBaseTransport::onHandshakeDone(bool resumed)
+{
+   AtomicOps::add(resumed ? mResumedHandshakes : mFullHandshakes, 1);
+}
+
+void
+TlsBaseTransport::sumTlsSessionStats(unsigned int& fullHandshakes, 
+                                     unsigned int& resumedHandshakes,
+                                     unsigned int& sessionCacheEvictions) const
+{
+   fullHandshakes += AtomicOps::load(mFullHandshakes);
+   resumedHandshakes += AtomicOps::load(mResumedHandshakes);
+   {
+      Lock lock(mClientSessionMutex);
+      sessionCacheEvictions += mClientSessionEvictions;
+   }
+   // Only transports serving a domain accept connections, and each of those
+   // has a context, and so a server-side cache, of its own.
+   if (mDomainCtx)
+   {
+      sessionCacheEvictions += (unsigned int)SSL_CTX_sess_cache_full(mDomainCtx);
+   }
+}
+
 Connection* 
 TlsBaseTransport::createConnection(const Tuple& who, Socket fd, bool server)
 {
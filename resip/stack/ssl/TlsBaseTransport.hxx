@@ -9,8 +9,12 @@
 #include "resip/stack/TcpBaseTransport.hxx"
 #include "resip/stack/SecurityTypes.hxx"
 #include "rutil/HeapInstanceCounter.hxx"
+#include "rutil/Mutex.hxx"
+#include "rutil/AtomicOps.hxx"
 #include "resip/stack/Compression.hxx"
 
+#include <list>
+#include <map>
 #include <openssl/ssl.h>
 
 namespace resip
@@ -19,6 +23,7 @@ namespace resip
 class Connection;
 class Message;
 class Security;
+class TlsHandshakePool;
 
 class TlsBaseTransport : public TcpBaseTransport
 {
@@ -44,6 +49,35 @@ class TlsBaseTransport : public TcpBaseTransport
 
       SSL_CTX* getCtx() const;
 
+      /// Most sessions kept for resuming outbound connections, one per
+      /// destination and SNI name; the one stored longest ago is evicted
+      /// to make room. 0 turns client-side resumption off.
+      static unsigned int MaxClientSessions;
+
+      /// Worker threads that take TLS handshakes (and the peer certificate
+      /// checks at their end) off the transport's thread; 0 handshakes
+      /// inline. Only used when the transport is in an FdPollGrp.
+      static unsigned int HandshakeThreads;
+      /// Most connections queued to or in a handshake step on those
+      /// threads; any more step inline until the queue drains.
+      static unsigned int MaxQueuedHandshakes;
+
+      virtual void setPollGrp(FdPollGrp *grp);
+      /// 0 unless HandshakeThreads was set when this was constructed
+      TlsHandshakePool* getHandshakePool() const { return mHandshakePool; }
+
+      virtual void sumTlsSessionStats(unsigned int& fullHandshakes, 
+                                      unsigned int& resumedHandshakes,
+                                      unsigned int& sessionCacheEvictions) const;
+
+      /// Sets ssl up to resume the session stored under key; false if there
+      /// is none.
+      bool offerClientSession(const Data& key, SSL* ssl) const;
+      /// Keeps session, taking over the caller's reference. Thread-safe,
+      /// as OpenSSL may hand sessions over during a pooled handshake.
+      void storeClientSession(const Data& key, SSL_SESSION* session);
+      void onHandshakeDone(bool resumed);
+
       SecurityTypes::TlsClientVerificationMode getClientVerificationMode() 
          { return mClientVerificationMode; };
       bool isUseEmailAsSIP()
@@ -85,6 +119,26 @@ class TlsBaseTransport : public TcpBaseTransport
          as if it were a SIP URI.  This is convenient because many commercial
          CAs offer email certificates but not sip: certificates */
       bool mUseEmailAsSIP;
+
+   private:
+      typedef std::list<Data> ClientSessionOrder; // oldest first
+      struct ClientSession
+      {
+         SSL_SESSION* session;
+         ClientSessionOrder::iterator order;
+      };
+      typedef std::map<Data, ClientSession> ClientSessionMap;
+      ClientSessionMap mClientSessions;
+      ClientSessionOrder mClientSessionOrder;
+      mutable Mutex mClientSessionMutex;
+
+      TlsHandshakePool* mHandshakePool;
+
+      // cumulative; counted by the handshake threads and read by the
+      // StatisticsManager
+      volatile UInt32 mFullHandshakes;
+      volatile UInt32 mResumedHandshakes;
+      unsigned int mClientSessionEvictions;
 };
 
 }
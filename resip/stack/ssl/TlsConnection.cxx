@@ -6,6 +6,7 @@
 
 #include "resip/stack/ssl/TlsConnection.hxx"
 #include "resip/stack/ssl/TlsTransport.hxx"
+#include "resip/stack/ssl/TlsHandshakePool.hxx"
 #include "resip/stack/ssl/Security.hxx"
 #include "rutil/Logger.hxx"
 #include "resip/stack/Uri.hxx"
@@ -99,6 +100,15 @@ TlsConnection::TlsConnection( Transport* transport, const Tuple& tuple,
    
    mSsl = SSL_new(ctx);
    resip_assert(mSsl);
+   SSL_set_app_data(mSsl, this);
+
+   if (!mServer)
+   {
+      if (t->offerClientSession(clientSessionKey(), mSsl))
+      {
+         DebugLog(<< "Offering to resume TLS session with " << who());
+      }
+   }
 
    resip_assert( mSecurity );
 
@@ -137,6 +147,8 @@ TlsConnection::TlsConnection( Transport* transport, const Tuple& tuple,
 
    mTlsState = Initial;
    mHandShakeWantsRead = false;
+   mHandShakeWantsWrite = false;
+   mHandshakeOffloaded = false;
 
 #endif // USE_SSL   
 }
@@ -144,6 +156,11 @@ TlsConnection::TlsConnection( Transport* transport, const Tuple& tuple,
 TlsConnection::~TlsConnection()
 {
 #if defined(USE_SSL)
+   if (mHandshakeOffloaded && handshakePool())
+   {
+      // waits out a worker still in SSL_do_handshake() on our socket
+      handshakePool()->cancel(this);
+   }
    ERR_clear_error();
    int ret = SSL_shutdown(mSsl);
    if(ret < 0)
@@ -189,11 +206,25 @@ TlsConnection::checkState()
 #if defined(USE_SSL)
    //DebugLog(<<"state is " << fromTlsState(mTlsState));
 
+   if (mHandshakeOffloaded)
+   {
+      return Handshaking; // a worker is on it
+   }
    if (mTlsState == Up || mTlsState == Broken)
    {
       return mTlsState;
    }
-   
+
+   handshakeStep();
+   completeHandshakeStep();
+#endif // USE_SSL   
+   return mTlsState;
+}
+
+void
+TlsConnection::handshakeStep()
+{
+#if defined(USE_SSL)
    int ok=0;
    
    ERR_clear_error();
@@ -223,6 +254,7 @@ TlsConnection::checkState()
    }
 
    mHandShakeWantsRead = false;
+   mHandShakeWantsWrite = false;
    ok = SSL_do_handshake(mSsl);
       
    if ( ok <= 0 )
@@ -234,30 +266,30 @@ TlsConnection::checkState()
          case SSL_ERROR_WANT_READ:
             StackLog( << "TLS handshake want read" );
             mHandShakeWantsRead = true;
-            return mTlsState;
+            return;
 
          case SSL_ERROR_WANT_WRITE:
             StackLog( << "TLS handshake want write" );
-            ensureWritable();
-            return mTlsState;
+            mHandShakeWantsWrite = true;
+            return;
 
          case SSL_ERROR_ZERO_RETURN:
             StackLog( << "TLS connection closed cleanly");
-            return mTlsState;
+            return;
 
          case SSL_ERROR_WANT_CONNECT:
             StackLog( << "BIO not connected, try later");
-            return mTlsState;
+            return;
 
 #if  ( OPENSSL_VERSION_NUMBER >= 0x0090702fL )
          case SSL_ERROR_WANT_ACCEPT:
             StackLog( << "TLS connection want accept" );
-            return mTlsState;
+            return;
 #endif
 
          case SSL_ERROR_WANT_X509_LOOKUP:
             DebugLog( << "Try later / SSL_ERROR_WANT_X509_LOOKUP");
-            return mTlsState;
+            return;
 
          default:
             if(err == SSL_ERROR_SYSCALL)
@@ -271,7 +303,7 @@ TlsConnection::checkState()
                   case EWOULDBLOCK:  // Treat EGAIN and EWOULDBLOCK as the same: http://stackoverflow.com/questions/7003234/which-systems-define-eagain-and-ewouldblock-as-different-values
 #endif
                      StackLog( << "try later");
-                     return mTlsState;
+                     return;
                }
                ErrLog( << "socket error " << e);
                Transport::error(e);
@@ -330,7 +362,7 @@ TlsConnection::checkState()
             handleOpenSSLErrorQueue(ok, err, "SSL_do_handshake");
             mBio = NULL;
             mTlsState = Broken;
-            return mTlsState;
+            return;
       }
    }
    else // ok > 1
@@ -362,18 +394,97 @@ TlsConnection::checkState()
                  << "> remote cert domain(s) are <" 
                  << getPeerNamesData() << ">" );
          mFailureReason = TransportFailure::CertNameMismatch;         
-         return mTlsState;
+         return;
       }
    }
 
-   InfoLog( << "TLS handshake done for peer " << getPeerNamesData()); 
+   InfoLog( << "TLS handshake done for peer " << getPeerNamesData() << (SSL_session_reused(mSsl) ? " (resumed)" : "")); 
    mTlsState = Up;
-   if (!mOutstandingSends.empty())
+#endif // USE_SSL   
+}
+
+void
+TlsConnection::completeHandshakeStep()
+{
+#if defined(USE_SSL)
+   if (mTlsState == Handshaking && mHandShakeWantsWrite)
    {
       ensureWritable();
    }
+   else if (mTlsState == Up)
+   {
+      if (!mPeerCertDer.empty())
+      {
+         // add the certificate to the Security store
+         for(std::list<BaseSecurity::PeerName>::iterator it = mPeerNames.begin(); it != mPeerNames.end(); it++)
+         {
+            if ( !mSecurity->hasDomainCert( it->mName ) )
+            {
+               mSecurity->addDomainCertDER(it->mName,mPeerCertDer);
+            }
+         }
+         mPeerCertDer.clear();
+      }
+      static_cast<TlsBaseTransport*>(transport())->onHandshakeDone(SSL_session_reused(mSsl) != 0);
+      if (!mOutstandingSends.empty())
+      {
+         ensureWritable();
+      }
+   }
 #endif // USE_SSL   
-   return mTlsState;
+}
+
+void
+TlsConnection::finishHandshakeStep()
+{
+   mHandshakeOffloaded = false;
+   resumePolling();
+   completeHandshakeStep();
+   switch(mTlsState)
+   {
+      case Broken:
+         delete this;
+         break;
+      case Up:
+         // the peer may have sent data behind its last handshake message
+         performReads();
+         break;
+      default:
+         break;
+   }
+}
+
+TlsHandshakePool*
+TlsConnection::handshakePool() const
+{
+   return static_cast<TlsBaseTransport*>(mTransport)->getHandshakePool();
+}
+
+void
+TlsConnection::processPollEvent(FdPollEventMask mask)
+{
+   if (mHandshakeOffloaded)
+   {
+      // a worker has the socket; closing on error waits for it
+      if (mask & FPEM_Error)
+      {
+         Connection::processPollEvent(mask);
+      }
+      return;
+   }
+
+   if ((mTlsState == Initial || mTlsState == Handshaking) && !(mask & FPEM_Error))
+   {
+      TlsHandshakePool* pool = handshakePool();
+      if (pool && pool->submit(this))
+      {
+         mHandshakeOffloaded = true;
+         suspendPolling();
+         return;
+      }
+   }
+
+   Connection::processPollEvent(mask);
 }
 
       
@@ -576,6 +687,33 @@ TlsConnection::write( const char* buf, int count )
    return -1;
 }
 
+int
+TlsConnection::writeQueue(SendData& first, Data::size_type offset, Data::size_type budget)
+{
+   // SSL_write() never returns a partial write here, so the batch is
+   // either taken whole or retried whole.
+   if (mWriteBatch.empty())
+   {
+      SendData* next = nextBatchable(first);
+      if (!next || first.size() - offset + next->size() > budget)
+      {
+         return Connection::writeQueue(first, offset, budget);
+      }
+
+      first.appendTo(mWriteBatch, offset);
+      for (; next && mWriteBatch.size() + next->size() <= budget; next = nextBatchable(*next))
+      {
+         next->appendTo(mWriteBatch);
+      }
+   }
+
+   int ret = write(mWriteBatch.data(), int(mWriteBatch.size()));
+   if (ret != 0)
+   {
+      mWriteBatch.clear();
+   }
+   return ret;
+}
 
 bool 
 TlsConnection::hasDataToRead() // has data that can be read 
@@ -629,6 +767,10 @@ bool
 TlsConnection::isWritable() 
 {
 #if defined(USE_SSL)
+   if (mHandshakeOffloaded)
+   {
+      return false; // picked up again in finishHandshakeStep()
+   }
    switch(mTlsState)
    {
       case Handshaking:
@@ -673,6 +815,27 @@ TlsConnection::getPeerNamesData() const
 }
 
 
+Data
+TlsConnection::clientSessionKey() const
+{
+   // a session is only worth offering to the peer, and under the name,
+   // it was set up with
+   return Tuple::inet_ntop(mWho) + ":" + Data(mWho.getPort()) + ";" + 
+          Data(mWho.getType()) + ";" + mWho.getTargetDomain();
+}
+
+int
+TlsConnection::onNewSession(SSL* ssl, SSL_SESSION* session)
+{
+   TlsConnection* conn = static_cast<TlsConnection*>(SSL_get_app_data(ssl));
+   if (!conn || conn->mServer || TlsBaseTransport::MaxClientSessions == 0)
+   {
+      return 0; // server sessions live in the SSL_CTX's own cache
+   }
+   static_cast<TlsBaseTransport*>(conn->transport())->storeClientSession(conn->clientSessionKey(), session);
+   return 1;
+}
+
 void
 TlsConnection::computePeerName()
 {
@@ -725,17 +888,10 @@ TlsConnection::computePeerName()
 
    if(!mServer)
    {
-      // add the certificate to the Security store
+      // kept for the Security store, see completeHandshakeStep()
       unsigned char* buf = NULL;
       int len = i2d_X509( cert, &buf );
-      Data derCert( buf, len );
-      for(std::list<BaseSecurity::PeerName>::iterator it = mPeerNames.begin(); it != mPeerNames.end(); it++)
-      {
-         if ( !mSecurity->hasDomainCert( it->mName ) )
-         {
-            mSecurity->addDomainCertDER(it->mName,derCert);
-         }
-      }
+      mPeerCertDer = Data( buf, len );
       OPENSSL_free(buf); buf=NULL;
    }
 
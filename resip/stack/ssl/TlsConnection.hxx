@@ -28,9 +28,12 @@ namespace resip
 
 class Tuple;
 class Security;
+class TlsHandshakePool;
 
 class TlsConnection : public Connection
 {
+      friend class TlsHandshakePool;
+
    public:
       RESIP_HeapCount(TlsConnection);
 
@@ -43,6 +46,7 @@ class TlsConnection : public Connection
 
       int read( char* buf, const int count );
       int write( const char* buf, const int count );
+      virtual int writeQueue(SendData& first, Data::size_type offset, Data::size_type budget);
       virtual bool hasDataToRead(); // has data that can be read 
       virtual bool isGood(); // has valid connection
       virtual bool isWritable();
@@ -53,13 +57,31 @@ class TlsConnection : public Connection
       
       typedef enum TlsState { Initial, Broken, Handshaking, Up } TlsState;
       static const char * fromState(TlsState);
+
+      /// SSL_CTX new session callback; hands outbound sessions to the
+      /// transport so that the next connection to the same peer can resume.
+      static int onNewSession(SSL* ssl, SSL_SESSION* session);
    
+   protected:
+      virtual void processPollEvent(FdPollEventMask mask);
+
    private:
       /// No default c'tor
       TlsConnection();
       void computePeerName();
       Data getPeerNamesData() const;
       TlsState checkState();
+      Data clientSessionKey() const;
+
+      /// One SSL_do_handshake() step. Touches only this connection's own
+      /// SSL state, so may run on a TlsHandshakePool worker.
+      void handshakeStep();
+      /// Transport-thread side of the step handshakeStep() just took.
+      void completeHandshakeStep();
+      /// Picks the connection up again after a pooled handshakeStep();
+      /// may delete this.
+      void finishHandshakeStep();
+      TlsHandshakePool* handshakePool() const;
 
       bool mServer;
       Security* mSecurity;
@@ -68,10 +90,19 @@ class TlsConnection : public Connection
       
       TlsState mTlsState;
       bool mHandShakeWantsRead;
+      bool mHandShakeWantsWrite;
+      // a TlsHandshakePool worker owns mSsl; not polled until it is done
+      bool mHandshakeOffloaded;
 
       SSL* mSsl;
       BIO* mBio;
       std::list<BaseSecurity::PeerName> mPeerNames;
+      // server certificate, for the Security store once the handshake is done
+      Data mPeerCertDer;
+
+      // Queued messages packed for one SSL_write(); kept until that write
+      // goes through, since a retried SSL_write must be given the same bytes.
+      Data mWriteBatch;
 };
  
 }
@@ -0,0 +1,200 @@
+#if defined(HAVE_CONFIG_H)
+#include "config.h"
+#endif
+
+#ifdef USE_SSL
+
+#include <algorithm>
+
+#include "rutil/Lock.hxx"
+#include "rutil/Logger.hxx"
+#include "resip/stack/ssl/TlsConnection.hxx"
+#include "resip/stack/ssl/TlsHandshakePool.hxx"
+#include "rutil/WinLeakCheck.hxx"
+
+#define RESIPROCATE_SUBSYSTEM Subsystem::TRANSPORT
+
+using namespace resip;
+
+TlsHandshakePool::TlsHandshakePool(unsigned int numThreads, unsigned int maxQueued)
+   : mMaxQueued(maxQueued),
+     mShutdown(false),
+     mPollGrp(0),
+     mWakeupHandle(0)
+{
+   for (unsigned int i = 0; i < numThreads; ++i)
+   {
+      Worker* worker = new Worker(*this);
+      worker->run();
+      mWorkers.push_back(worker);
+   }
+   InfoLog(<< "Using " << mWorkers.size() << " TLS handshake threads");
+}
+
+TlsHandshakePool::~TlsHandshakePool()
+{
+   {
+      Lock lock(mMutex);
+      mShutdown = true;
+      mWork.broadcast();
+   }
+   for (std::vector<Worker*>::iterator it = mWorkers.begin(); it != mWorkers.end(); ++it)
+   {
+      (*it)->join();
+      delete *it;
+   }
+   setPollGrp(0);
+   // TlsBaseTransport closes its connections, which cancels any still
+   // queued here, before it deletes the pool.
+}
+
+void
+TlsHandshakePool::setPollGrp(FdPollGrp* grp)
+{
+   if (mPollGrp && mWakeupHandle)
+   {
+      mPollGrp->delPollItem(mWakeupHandle);
+      mWakeupHandle = 0;
+   }
+   mPollGrp = grp;
+   if (mPollGrp)
+   {
+      mWakeupHandle = mPollGrp->addPollItem(mWakeup.getReadSocket(), FPEM_Read, this);
+   }
+}
+
+bool
+TlsHandshakePool::submit(TlsConnection* conn)
+{
+   if (!mPollGrp || mWorkers.empty())
+   {
+      return false;
+   }
+
+   Lock lock(mMutex);
+   if (mPending.size() + mInProgress.size() >= mMaxQueued)
+   {
+      DebugLog(<< "TLS handshake pool full, stepping inline");
+      return false;
+   }
+   mPending.push_back(conn);
+   mWork.signal();
+   return true;
+}
+
+void
+TlsHandshakePool::cancel(TlsConnection* conn)
+{
+   Lock lock(mMutex);
+   mPending.erase(std::remove(mPending.begin(), mPending.end(), conn), mPending.end());
+   while (std::find(mInProgress.begin(), mInProgress.end(), conn) != mInProgress.end())
+   {
+      mStepFinished.wait(mMutex);
+   }
+   mCompleted.erase(std::remove(mCompleted.begin(), mCompleted.end(), conn), mCompleted.end());
+}
+
+void
+TlsHandshakePool::work()
+{
+   Lock lock(mMutex);
+   while (!mShutdown)
+   {
+      if (mPending.empty())
+      {
+         mWork.wait(mMutex);
+         continue;
+      }
+
+      TlsConnection* conn = mPending.front();
+      mPending.pop_front();
+      mInProgress.push_back(conn);
+
+      mMutex.unlock();
+      conn->handshakeStep();
+      mMutex.lock();
+
+      mInProgress.erase(std::find(mInProgress.begin(), mInProgress.end(), conn));
+      mCompleted.push_back(conn);
+      mStepFinished.broadcast();
+      mWakeup.interrupt();
+   }
+}
+
+TlsConnection*
+TlsHandshakePool::popCompleted()
+{
+   Lock lock(mMutex);
+   if (mCompleted.empty())
+   {
+      return 0;
+   }
+   TlsConnection* conn = mCompleted.front();
+   mCompleted.pop_front();
+   return conn;
+}
+
+void
+TlsHandshakePool::processPollEvent(FdPollEventMask mask)
+{
+   mWakeup.processPollEvent(mask);
+
+   // one at a time: finishing a step may close other connections, which
+   // cancel() out of mCompleted
+   while (TlsConnection* conn = popCompleted())
+   {
+      conn->finishHandshakeStep();
+   }
+}
+
+#endif /* USE_SSL */
+
+/* ====================================================================
+ * The Vovida Software License, Version 1.0 
+ * 
+ * Copyright (c) 2000 Vovida Networks, Inc.  All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 
+ * 3. The names "VOCAL", "Vovida Open Communication Application Library",
+ *    and "Vovida Open Communication Application Library (VOCAL)" must
+ *    not be used to endorse or promote products derived from this
+ *    software without prior written permission. For written
+ *    permission, please contact vocal@vovida.org.
+ *
+ * 4. Products derived from this software may not be called "VOCAL", nor
+ *    may "VOCAL" appear in their name, without prior written
+ *    permission of Vovida Networks, Inc.
+ * 
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESSED OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE, TITLE AND
+ * NON-INFRINGEMENT ARE DISCLAIMED.  IN NO EVENT SHALL VOVIDA
+ * NETWORKS, INC. OR ITS CONTRIBUTORS BE LIABLE FOR ANY DIRECT DAMAGES
+ * IN EXCESS OF $1,000, NOR FOR ANY INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE
+ * USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+ * DAMAGE.
+ * 
+ * ====================================================================
+ * 
+ * This software consists of voluntary contributions made by Vovida
+ * Networks, Inc. and many individuals on behalf of Vovida Networks,
+ * Inc.  For more information on Vovida Networks, Inc., please see
+ * <http://www.vovida.org/>.
+ *
+ */
@@ -0,0 +1,139 @@
+#if !defined(RESIP_TLSHANDSHAKEPOOL_HXX)
+#define RESIP_TLSHANDSHAKEPOOL_HXX
+
+#if defined(HAVE_CONFIG_H)
+  #include "config.h"
+#endif
+
+#include <deque>
+#include <vector>
+
+#include "rutil/Condition.hxx"
+#include "rutil/FdPoll.hxx"
+#include "rutil/Mutex.hxx"
+#include "rutil/SelectInterruptor.hxx"
+#include "rutil/ThreadIf.hxx"
+
+namespace resip
+{
+
+class TlsConnection;
+
+/**
+   @internal
+   @brief Runs TLS handshake steps for a TlsBaseTransport on worker threads.
+
+   The key exchange and certificate checks of a handshake are the costly
+   part of a TLS connection; done on the transport's thread they hold up
+   every other connection in the same FdPollGrp. When a handshaking
+   TlsConnection becomes ready, the transport thread stops polling it and
+   submit()s it here. A worker runs one SSL_do_handshake() step, plus the
+   peer-name extraction once it completes, then queues the connection back
+   and wakes the FdPollGrp through its own interruptor. processPollEvent()
+   then finishes the step on the transport thread: the connection is polled
+   again, goes Up or is closed.
+
+   Only the transport thread calls submit(), cancel() and processPollEvent().
+*/
+class TlsHandshakePool : public FdPollItemIf
+{
+   public:
+      /// starts numThreads workers; submit() refuses work once maxQueued
+      /// connections are waiting for or in a handshake step
+      TlsHandshakePool(unsigned int numThreads, unsigned int maxQueued);
+      virtual ~TlsHandshakePool();
+
+      void setPollGrp(FdPollGrp* grp);
+
+      /// Hands conn's next handshake step to a worker; false if the pool is
+      /// full or not attached to an FdPollGrp, and conn should step inline.
+      bool submit(TlsConnection* conn);
+      /// Forgets conn, waiting for a step in progress on it to finish.
+      void cancel(TlsConnection* conn);
+
+      /// Wakeup from a worker; finishes the steps that have completed.
+      virtual void processPollEvent(FdPollEventMask mask);
+
+   private:
+      class Worker : public ThreadIf
+      {
+         public:
+            Worker(TlsHandshakePool& pool) : mPool(pool) {}
+            virtual void thread() { mPool.work(); }
+
+         private:
+            TlsHandshakePool& mPool;
+      };
+
+      void work();
+      TlsConnection* popCompleted();
+
+      const unsigned int mMaxQueued;
+      std::vector<Worker*> mWorkers;
+
+      Mutex mMutex;
+      Condition mWork;          // mPending not empty, or mShutdown
+      Condition mStepFinished;  // something left mInProgress
+      std::deque<TlsConnection*> mPending;
+      std::vector<TlsConnection*> mInProgress;
+      std::deque<TlsConnection*> mCompleted;
+      bool mShutdown;
+
+      SelectInterruptor mWakeup;
+      FdPollGrp* mPollGrp;
+      FdPollItemHandle mWakeupHandle;
+};
+
+}
+
+#endif
+
+/* ====================================================================
+ * The Vovida Software License, Version 1.0 
+ * 
+ * Copyright (c) 2000 Vovida Networks, Inc.  All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 
+ * 3. The names "VOCAL", "Vovida Open Communication Application Library",
+ *    and "Vovida Open Communication Application Library (VOCAL)" must
+ *    not be used to endorse or promote products derived from this
+ *    software without prior written permission. For written
+ *    permission, please contact vocal@vovida.org.
+ *
+ * 4. Products derived from this software may not be called "VOCAL", nor
+ *    may "VOCAL" appear in their name, without prior written
+ *    permission of Vovida Networks, Inc.
+ * 
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESSED OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE, TITLE AND
+ * NON-INFRINGEMENT ARE DISCLAIMED.  IN NO EVENT SHALL VOVIDA
+ * NETWORKS, INC. OR ITS CONTRIBUTORS BE LIABLE FOR ANY DIRECT DAMAGES
+ * IN EXCESS OF $1,000, NOR FOR ANY INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE
+ * USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+ * DAMAGE.
+ * 
+ * ====================================================================
+ * 
+ * This software consists of voluntary contributions made by Vovida
+ * Networks, Inc. and many individuals on behalf of Vovida Networks,
+ * Inc.  For more information on Vovida Networks, Inc., please see
+ * <http://www.vovida.org/>.
+ *
+ */
@@ -0,0 +1,355 @@
+#include <iostream>
+#include <iomanip>
+#include <cassert>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <vector>
+#include "resip/stack/Connection.hxx"
+#include "resip/stack/ConnectionManager.hxx"
+#include "resip/stack/TcpConnection.hxx"
+#include "resip/stack/TcpTransport.hxx"
+#include "resip/stack/TransactionMessage.hxx"
+#include "rutil/Fifo.hxx"
+#include "rutil/Logger.hxx"
+#include "rutil/Random.hxx"
+#ifdef WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#include <sys/socket.h>
+#endif
+
+#ifdef WIN32
+#define usleep(x) Sleep(x/1000)
+#endif
+
+using namespace resip;
+using namespace std;
+
+// Checks that ConnectionManager finds connections by Tuple and by flow key and
+// recycles idle ones, and that a TcpConnection gets everything queued on it
+// onto the wire in order when its writes are coalesced. For each connection
+// count given on the command line (e.g. 10000 100000 1000000) it then times
+// findConnection against a std::map keyed the way the manager used to be.
+//
+// The connections get made-up socket numbers well above anything the process
+// has open; nothing is read from or written to them, and closing them on
+// teardown just fails with EBADF.
+
+static const Socket FirstFakeSocket = 0x100000;
+
+// A connection whose reads return a single CRLF, which is enough for the
+// manager to count it as used.
+class TestConnection : public Connection
+{
+   public:
+      TestConnection(Transport* transport, const Tuple& who, Socket socket)
+         : Connection(transport, who, socket, Compression::Disabled, true)
+      {}
+
+   protected:
+      virtual int read(char* buffer, const int count)
+      {
+         assert(count >= 2);
+         memcpy(buffer, "\r\n", 2);
+         return 2;
+      }
+};
+
+static Tuple
+clientTuple(unsigned int i)
+{
+   // spread clients over addresses and ports the way a NATed client
+   // population looks from an edge proxy
+   Tuple t(Data("10.") + Data((i >> 16) & 0xff) + "." + Data((i >> 8) & 0xff) + "." + Data(i & 0xff),
+           1024 + (i % 50000), V4, TCP);
+   return t;
+}
+
+static double
+elapsedMs(UInt64 startUs)
+{
+   return (Timer::getTimeMicroSec() - startUs) / 1000.0;
+}
+
+static void
+checkFindAndGc(TcpTransport& transport)
+{
+   ConnectionManager& manager = transport.getConnectionManager();
+   const unsigned int count = 1000;
+
+   std::vector<Connection*> connections;
+   for (unsigned int i = 0; i < count; ++i)
+   {
+      connections.push_back(new TestConnection(&transport, clientTuple(i), FirstFakeSocket + i));
+   }
+
+   for (unsigned int i = 0; i < count; ++i)
+   {
+      Tuple byAddr = clientTuple(i);
+      assert(manager.findConnection(byAddr) == connections[i]);
+
+      Tuple byFlow = clientTuple(i);
+      byFlow.mFlowKey = FirstFakeSocket + i;
+      assert(manager.findConnection(byFlow) == connections[i]);
+
+      // a flow key that names a different connection falls back to the address
+      Tuple wrongFlow = clientTuple(i);
+      wrongFlow.mFlowKey = FirstFakeSocket + (i + 1) % count;
+      assert(manager.findConnection(wrongFlow) == connections[i]);
+      wrongFlow.onlyUseExistingConnection = true;
+      assert(manager.findConnection(wrongFlow) == 0);
+   }
+   assert(manager.findConnection(clientTuple(count)) == 0);
+
+   // Idle connections are recycled the next time a connection is added;
+   // connections used in the meantime survive.
+   UInt64 oldAge = ConnectionManager::MinimumGcAge;
+   bool oldAgressive = ConnectionManager::EnableAgressiveGc;
+   ConnectionManager::MinimumGcAge = 200;
+   ConnectionManager::EnableAgressiveGc = true;
+
+   usleep(300*1000);
+   for (unsigned int i = 0; i < count; i += 2)
+   {
+      connections[i]->read();
+   }
+   new TestConnection(&transport, clientTuple(count), FirstFakeSocket + count);
+
+   for (unsigned int i = 0; i < count; ++i)
+   {
+      assert((manager.findConnection(clientTuple(i)) != 0) == (i % 2 == 0));
+   }
+   assert(manager.findConnection(clientTuple(count)) != 0);
+
+   // and the used ones go too, once they have been idle as long
+   usleep(300*1000);
+   new TestConnection(&transport, clientTuple(count + 1), FirstFakeSocket + count + 1);
+   for (unsigned int i = 0; i <= count; ++i)
+   {
+      assert(manager.findConnection(clientTuple(i)) == 0);
+   }
+
+   ConnectionManager::MinimumGcAge = oldAge;
+   ConnectionManager::EnableAgressiveGc = oldAgressive;
+   delete manager.findConnection(clientTuple(count + 1));
+}
+
+#ifndef WIN32
+static Data
+drain(int fd)
+{
+   Data received;
+   char buffer[8192];
+   int n;
+   while ((n = ::read(fd, buffer, sizeof(buffer))) > 0)
+   {
+      received.append(buffer, n);
+   }
+   return received;
+}
+
+static void
+checkQueuedWrites(TcpTransport& transport)
+{
+   int fds[2];
+   int rc = socketpair(AF_UNIX, SOCK_STREAM, 0, fds);
+   assert(rc == 0);
+   makeSocketNonBlocking(fds[0]);
+   makeSocketNonBlocking(fds[1]);
+   int sndbuf = 4096;
+   setsockopt(fds[0], SOL_SOCKET, SO_SNDBUF, &sndbuf, sizeof(sndbuf));
+
+   Tuple peer = clientTuple(0xfffff);
+   TcpConnection* conn = new TcpConnection(&transport, peer, fds[0], Compression::Disabled, true);
+
+   // a batch of small messages goes out in one write
+   Data expected;
+   for (int i = 0; i < 10; ++i)
+   {
+      Data msg = Data("OPTIONS sip:") + Data(i) + "@example.com SIP/2.0\r\n\r\n";
+      expected += msg;
+      conn->requestWrite(new SendData(peer, msg, Data::Empty, Data::Empty));
+   }
+   assert(conn->performWrite() == int(expected.size()));
+   assert(drain(fds[1]) == expected);
+
+   // messages bigger than the socket buffer, a fragmented one among them,
+   // come out whole and in order however the writes are cut up
+   expected.clear();
+   static const char body[] = "fragment held outside the SendData";
+   for (int i = 0; i < 200; ++i)
+   {
+      SendData* sd = new SendData(peer, Data(Data::Empty), Data::Empty, Data::Empty);
+      sd->data = Data(i) + ":" + Data(std::string(100 + Random::getRandom() % 20000, 'x'));
+      if (i % 50 == 7)
+      {
+         SendData::Fragment head = { 0, 0, sd->data.size() };
+         SendData::Fragment tail = { body, 0, sizeof(body) - 1 };
+         sd->fragments.push_back(head);
+         sd->fragments.push_back(tail);
+         expected += sd->data;
+         expected += body;
+
+         Data flat;
+         sd->appendTo(flat, 1);
+         assert(flat == expected.substr(expected.size() - sd->size() + 1));
+      }
+      else
+      {
+         expected += sd->data;
+      }
+      conn->requestWrite(sd);
+   }
+
+   Data received;
+   int writes = 0;
+   while (received.size() < expected.size())
+   {
+      assert(conn->performWrite() >= 0);
+      ++writes;
+      received += drain(fds[1]);
+      assert(writes < 100000);
+   }
+   assert(received == expected);
+   assert(conn->performWrite() == 0);
+
+   delete conn;
+   ::close(fds[1]);
+}
+#endif
+
+static void
+benchmark(TcpTransport& transport, unsigned int count)
+{
+   ConnectionManager& manager = transport.getConnectionManager();
+
+   std::vector<Tuple> tuples;
+   tuples.reserve(count);
+   for (unsigned int i = 0; i < count; ++i)
+   {
+      tuples.push_back(clientTuple(i));
+   }
+   std::vector<unsigned int> order(count);
+   for (unsigned int i = 0; i < count; ++i)
+   {
+      order[i] = Random::getRandom() % count;
+   }
+
+   UInt64 startUs = Timer::getTimeMicroSec();
+   std::vector<Connection*> connections;
+   connections.reserve(count);
+   for (unsigned int i = 0; i < count; ++i)
+   {
+      connections.push_back(new TestConnection(&transport, tuples[i], FirstFakeSocket + i));
+   }
+   double add = elapsedMs(startUs);
+
+   startUs = Timer::getTimeMicroSec();
+   unsigned int found = 0;
+   for (unsigned int i = 0; i < count; ++i)
+   {
+      found += manager.findConnection(tuples[order[i]]) != 0;
+   }
+   double findByAddr = elapsedMs(startUs);
+   assert(found == count);
+
+   std::map<Tuple, Connection*> reference;
+   for (unsigned int i = 0; i < count; ++i)
+   {
+      reference[tuples[i]] = connections[i];
+   }
+   startUs = Timer::getTimeMicroSec();
+   found = 0;
+   for (unsigned int i = 0; i < count; ++i)
+   {
+      found += reference.find(tuples[order[i]]) != reference.end();
+   }
+   double mapFind = elapsedMs(startUs);
+   assert(found == count);
+   reference.clear();
+
+   startUs = Timer::getTimeMicroSec();
+   for (unsigned int i = 0; i < count; ++i)
+   {
+      delete connections[i];
+   }
+   double remove = elapsedMs(startUs);
+
+   cerr << setw(8) << count
+        << "  add " << setw(9) << add << "ms"
+        << "  findConnection " << setw(9) << findByAddr << "ms"
+        << " (" << setw(6) << findByAddr * 1e6 / count << "ns each,"
+        << " std::map " << setw(6) << mapFind * 1e6 / count << "ns)"
+        << "  remove " << setw(9) << remove << "ms" << endl;
+}
+
+int
+main(int argc, char** argv)
+{
+   Log::initialize(Log::Cerr, Log::Err, argv[0]);
+   initNetwork();
+
+   Fifo<TransactionMessage> rxFifo;
+   TcpTransport transport(rxFifo, 5060, V4, "127.0.0.1", 0, Compression::Disabled,
+                          RESIP_TRANSPORT_FLAG_NOBIND);
+
+   checkFindAndGc(transport);
+#ifndef WIN32
+   checkQueuedWrites(transport);
+#endif
+
+   cerr << fixed << setprecision(2);
+   for (int i = 1; i < argc; ++i)
+   {
+      benchmark(transport, atoi(argv[i]));
+   }
+
+   cerr << "All OK" << endl;
+   return 0;
+}
+
+/* ====================================================================
+ * The Vovida Software License, Version 1.0
+ *
+ * Copyright (c) 2000 Vovida Networks, Inc.  All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ *
+ * 3. The names "VOCAL", "Vovida Open Communication Application Library",
+ *    and "Vovida Open Communication Application Library (VOCAL)" must
+ *    not be used to endorse or promote products derived from this
+ *    software without prior written permission. For written
+ *    permission, please contact vocal@vovida.org.
+ *
+ * 4. Products derived from this software may not be called "VOCAL", nor
+ *    may "VOCAL" appear in their name, without prior written
+ *    permission of Vovida Networks, Inc.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESSED OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE, TITLE AND
+ * NON-INFRINGEMENT ARE DISCLAIMED.  IN NO EVENT SHALL VOVIDA
+ * NETWORKS, INC. OR ITS CONTRIBUTORS BE LIABLE FOR ANY DIRECT DAMAGES
+ * IN EXCESS OF $1,000, NOR FOR ANY INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE
+ * USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+ * DAMAGE.
+ *
+ * ====================================================================
+ */
@@ -15,10 +15,14 @@
 
 #include "rutil/Lock.hxx"
 #include "rutil/Mutex.hxx"
+#include "rutil/ParseBuffer.hxx"
 #include "rutil/Socket.hxx"
+#include "rutil/Time.hxx"
+#include "rutil/Timer.hxx"
 #include "rutil/Logger.hxx"
 #include "rutil/ThreadIf.hxx"
 #include "rutil/DnsUtil.hxx"
+#include "rutil/Inserter.hxx"
 #include "resip/stack/DnsResult.hxx"
 #include "resip/stack/SipStack.hxx"
 #include "rutil/dns/RRVip.hxx"
@@ -153,26 +157,591 @@ class TestDns : public ThreadIf, public DnsStub
 
       void thread()
       {
-         while (!waitForShutdown(100))
+         while (!isShutdown())
          {
             FdSet fdset;
             buildFdSet(fdset);
-            fdset.selectMilliSeconds(1);
+            fdset.selectMilliSeconds(resipMin(getTimeTillNextProcessMS(), 25U));
             process(fdset);
          }
       }
 };
- 
+
+// Answers NAPTR, SRV and A queries for names under .test on a local UDP
+// port, so resolution can be driven hard without touching the network:
+//   domainN.test                NAPTR  -> _sip._udp.domainN.test
+//   _sip._udp.domainN.test      SRV    -> sip.domainN.test:5060
+//   sip.domainN.test            A      -> 127.0.0.1
+// Anything else gets NXDOMAIN.
+class StandInDnsServer : public ThreadIf
+{
+   public:
+      StandInDnsServer() : mFd(INVALID_SOCKET), mPort(0), mQueries(0), mDelayMs(0)
+      {
+         mFd = ::socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+         resip_assert(mFd != INVALID_SOCKET);
+         int bufSize = 4*1024*1024;
+         setsockopt(mFd, SOL_SOCKET, SO_RCVBUF, (const char*)&bufSize, sizeof(bufSize));
+         setsockopt(mFd, SOL_SOCKET, SO_SNDBUF, (const char*)&bufSize, sizeof(bufSize));
+         sockaddr_in addr;
+         memset(&addr, 0, sizeof(addr));
+         addr.sin_family = AF_INET;
+         addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+         int ret = ::bind(mFd, (sockaddr*)&addr, sizeof(addr));
+         resip_assert(ret == 0);
+         socklen_t len = sizeof(addr);
+         getsockname(mFd, (sockaddr*)&addr, &len);
+         mPort = ntohs(addr.sin_port);
+      }
+
+      ~StandInDnsServer()
+      {
+         closeSocket(mFd);
+      }
+
+      int port() const { return mPort; }
+      unsigned long queries() const { return mQueries; }
+      // holds each answer back this long, to keep queries in flight
+      void setDelayMs(unsigned int ms) { mDelayMs = ms; }
+
+      void thread()
+      {
+         unsigned char buf[512];
+         while (!isShutdown())
+         {
+            FdSet fdset;
+            fdset.setRead(mFd);
+            if (fdset.selectMilliSeconds(100) <= 0)
+            {
+               continue;
+            }
+            sockaddr_in from;
+            socklen_t fromLen = sizeof(from);
+            int len = recvfrom(mFd, (char*)buf, sizeof(buf), 0, (sockaddr*)&from, &fromLen);
+            if (len < 12)
+            {
+               continue;
+            }
+            ++mQueries;
+            if (mDelayMs)
+            {
+               sleepMs(mDelayMs);
+            }
+            std::string reply;
+            if (answer(buf, len, reply))
+            {
+               sendto(mFd, reply.data(), (int)reply.size(), 0, (sockaddr*)&from, fromLen);
+            }
+         }
+      }
+
+   private:
+      static void put16(std::string& out, unsigned int v)
+      {
+         out += (char)((v >> 8) & 0xff);
+         out += (char)(v & 0xff);
+      }
+
+      static void put32(std::string& out, unsigned long v)
+      {
+         put16(out, (v >> 16) & 0xffff);
+         put16(out, v & 0xffff);
+      }
+
+      static void putName(std::string& out, const Data& name)
+      {
+         ParseBuffer pb(name);
+         while (!pb.eof())
+         {
+            const char* start = pb.position();
+            pb.skipToChar('.');
+            out += (char)(pb.position() - start);
+            out.append(start, pb.position() - start);
+            if (!pb.eof())
+            {
+               pb.skipChar();
+            }
+         }
+         out += (char)0;
+      }
+
+      static void putString(std::string& out, const char* str)
+      {
+         out += (char)strlen(str);
+         out += str;
+      }
+
+      // appends one answer whose owner is the question name (at offset 12)
+      static void putAnswer(std::string& out, int type, const std::string& rdata)
+      {
+         put16(out, 0xc00c);
+         put16(out, type);
+         put16(out, 1); // IN
+         put32(out, 60);
+         put16(out, (unsigned int)rdata.size());
+         out += rdata;
+      }
+
+      bool answer(const unsigned char* query, int len, std::string& reply)
+      {
+         // question name, type and class
+         Data name;
+         int pos = 12;
+         while (pos < len && query[pos] != 0)
+         {
+            int labelLen = query[pos++];
+            if (pos + labelLen > len)
+            {
+               return false;
+            }
+            if (!name.empty())
+            {
+               name += '.';
+            }
+            name.append((const char*)query + pos, labelLen);
+            pos += labelLen;
+         }
+         pos += 1;
+         if (pos + 4 > len)
+         {
+            return false;
+         }
+         int type = (query[pos] << 8) | query[pos + 1];
+         pos += 4;
+         name.lowercase();
+
+         std::string rdata;
+         Data domain;
+         if (type == 35 && name.postfix(".test") && name.prefix("domain"))
+         {
+            put16(rdata, 10);
+            put16(rdata, 10);
+            putString(rdata, "S");
+            putString(rdata, "SIP+D2U");
+            putString(rdata, "");
+            putName(rdata, "_sip._udp." + name);
+         }
+         else if (type == 33 && name.prefix("_sip._udp.") && name.postfix(".test"))
+         {
+            put16(rdata, 10);
+            put16(rdata, 10);
+            put16(rdata, 5060);
+            putName(rdata, "sip." + name.substr(10));
+         }
+         else if (type == 1 && name.prefix("sip.") && name.postfix(".test"))
+         {
+            put32(rdata, 0x7f000001);
+         }
+
+         reply.assign((const char*)query, pos);
+         reply[2] = (char)(0x84 | (query[2] & 0x01)); // QR, AA, keep RD
+         reply[3] = rdata.empty() ? (char)0x83 : (char)0x80; // RA, NXDOMAIN or NOERROR
+         reply[4] = 0; reply[5] = 1; // QDCOUNT
+         reply[6] = 0; reply[7] = rdata.empty() ? 0 : 1; // ANCOUNT
+         reply[8] = reply[9] = reply[10] = reply[11] = 0;
+         if (!rdata.empty())
+         {
+            putAnswer(reply, type, rdata);
+         }
+         return true;
+      }
+
+      Socket mFd;
+      int mPort;
+      volatile unsigned long mQueries;
+      volatile unsigned int mDelayMs;
+};
+
+// Resolves NAPTR -> SRV -> A for each domain it is started on.
+class ChainSink : public DnsResultSink
+{
+   public:
+      ChainSink(DnsStub& stub) : mStub(stub), mCompleted(0), mFailed(0) {}
+
+      void start(const Data& domain)
+      {
+         mStub.lookup<RR_NAPTR>(domain, Protocol::Sip, this);
+      }
+
+      unsigned long completed() const { Lock lock(mMutex); return mCompleted; }
+      unsigned long failed() const { Lock lock(mMutex); return mFailed; }
+
+      void onDnsResult(const DNSResult<DnsNaptrRecord>& result)
+      {
+         if (result.status != 0 || result.records.empty())
+         {
+            done(false);
+            return;
+         }
+         mStub.lookup<RR_SRV>(result.records[0].replacement(), Protocol::Sip, this);
+      }
+
+      void onDnsResult(const DNSResult<DnsSrvRecord>& result)
+      {
+         if (result.status != 0 || result.records.empty())
+         {
+            done(false);
+            return;
+         }
+         mStub.lookup<RR_A>(result.records[0].target(), Protocol::Sip, this);
+      }
+
+      void onDnsResult(const DNSResult<DnsHostRecord>& result)
+      {
+         done(result.status == 0 && !result.records.empty());
+      }
+
+#ifdef USE_IPV6
+      void onDnsResult(const DNSResult<DnsAAAARecord>&) { done(false); }
+#endif
+      void onDnsResult(const DNSResult<DnsCnameRecord>&) { done(false); }
+
+   private:
+      void done(bool ok)
+      {
+         Lock lock(mMutex);
+         ++mCompleted;
+         if (!ok)
+         {
+            ++mFailed;
+         }
+      }
+
+      DnsStub& mStub;
+      mutable Mutex mMutex;
+      unsigned long mCompleted;
+      unsigned long mFailed;
+};
+
+// Counts the A results it is given. With a stub to requery, it looks the
+// name up again, straight from its callback, after the first result.
+class CountingSink : public DnsResultSink
+{
+   public:
+      CountingSink(DnsStub* requery = 0) : mRequery(requery), mResults(0), mFailed(0) {}
+
+      unsigned long results() const { Lock lock(mMutex); return mResults; }
+      unsigned long failed() const { Lock lock(mMutex); return mFailed; }
+
+      // polls rather than blocking the DnsStub's thread
+      bool waitFor(unsigned long results) const
+      {
+         UInt64 deadline = Timer::getTimeMs() + 10000;
+         while (this->results() < results)
+         {
+            if (Timer::getTimeMs() >= deadline)
+            {
+               return false;
+            }
+            sleepMs(1);
+         }
+         return true;
+      }
+
+      void onDnsResult(const DNSResult<DnsHostRecord>& result)
+      {
+         bool requery = false;
+         {
+            Lock lock(mMutex);
+            ++mResults;
+            if (result.status != 0 || result.records.empty())
+            {
+               ++mFailed;
+            }
+            requery = mRequery && mResults == 1;
+         }
+         if (requery)
+         {
+            mRequery->query<RR_A>(result.domain, Protocol::Sip, this);
+         }
+      }
+
+#ifdef USE_IPV6
+      void onDnsResult(const DNSResult<DnsAAAARecord>&) {}
+#endif
+      void onDnsResult(const DNSResult<DnsSrvRecord>&) {}
+      void onDnsResult(const DNSResult<DnsNaptrRecord>&) {}
+      void onDnsResult(const DNSResult<DnsCnameRecord>&) {}
+
+   private:
+      DnsStub* mRequery;
+      mutable Mutex mMutex;
+      unsigned long mResults;
+      unsigned long mFailed;
+};
+
 }
 
 using namespace resip;
 
+class HostSink : public DnsHostHandler
+{
+   public:
+      HostSink() : mDone(false) {}
+      void onHostResolved(const Data& host, const std::list<Data>& addresses)
+      {
+         Lock lock(mMutex);
+         mAddresses = addresses;
+         mDone = true;
+      }
+      bool done()
+      {
+         Lock lock(mMutex);
+         return mDone;
+      }
+      // polls rather than blocking the DnsStub's thread
+      std::list<Data> wait()
+      {
+         UInt64 deadline = Timer::getTimeMs() + 10000;
+         while (Timer::getTimeMs() < deadline)
+         {
+            {
+               Lock lock(mMutex);
+               if (mDone)
+               {
+                  return mAddresses;
+               }
+            }
+            usleep(1000);
+         }
+         return std::list<Data>();
+      }
+
+   private:
+      Mutex mMutex;
+      bool mDone;
+      std::list<Data> mAddresses;
+};
+
+static bool
+checkLookupHost(DnsStub& dns, const Data& host, const Data& expected)
+{
+   HostSink sink;
+   dns.lookupHost(host, &sink);
+   std::list<Data> addresses = sink.wait();
+   cout << "lookupHost(" << host << "): " << Inserter(addresses) << endl;
+   if (expected.empty())
+   {
+      return addresses.empty();
+   }
+   return addresses.size() == 1 && addresses.front() == expected;
+}
+
+static DnsStub::NameserverList
+nameserverFor(const StandInDnsServer& server)
+{
+   sockaddr_in serverAddr;
+   memset(&serverAddr, 0, sizeof(serverAddr));
+   serverAddr.sin_family = AF_INET;
+   serverAddr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+   serverAddr.sin_port = htons(server.port());
+   DnsStub::NameserverList nameServerList;
+   nameServerList.push_back(GenericIPAddress(serverAddr));
+   return nameServerList;
+}
+
+static bool
+check(bool ok, const char* what)
+{
+   cout << (ok ? "ok:     " : "FAILED: ") << what << endl;
+   return ok;
+}
+
+static bool
+testCoalescing(DnsStub& dns, StandInDnsServer& server)
+{
+   // lookups made while an identical one waits on the server share its query
+   server.setDelayMs(200);
+   unsigned long before = server.queries();
+   const int count = 10;
+   CountingSink sinks[count];
+   for (int i = 0; i < count; ++i)
+   {
+      dns.lookup<RR_A>("sip.coalesce.test", Protocol::Sip, &sinks[i]);
+   }
+   bool answered = true;
+   for (int i = 0; i < count; ++i)
+   {
+      answered = sinks[i].waitFor(1) && sinks[i].failed() == 0 && answered;
+   }
+   server.setDelayMs(0);
+   bool ok = check(answered, "coalesced lookups are all answered");
+   return check(server.queries() - before == 1, "coalesced lookups send one query") && ok;
+}
+
+static bool
+testRequeryFromCallback(DnsStub& dns, StandInDnsServer& server)
+{
+   // a name looked up again from the callback that reports its failure goes
+   // to the server again, instead of joining the query that just finished
+   unsigned long before = server.queries();
+   CountingSink sink(&dns);
+   dns.lookup<RR_A>("requery.test", Protocol::Sip, &sink);
+   bool ok = check(sink.waitFor(2) && sink.failed() == 2, "lookup repeated from its callback is answered");
+   sleepMs(100);
+   ok = check(sink.results() == 2, "each lookup is answered once") && ok;
+   return check(server.queries() - before == 2, "lookup repeated from its callback sends a new query") && ok;
+}
+
+static bool
+testPrefetch(DnsStub& dns, StandInDnsServer& server)
+{
+   // the answers' 60 second TTL is inside the window, so the entry is due
+   // once it has been hit
+   dns.setDnsCachePrefetch(120, 1);
+   unsigned long before = server.queries();
+   CountingSink sink;
+   dns.lookup<RR_A>("sip.prefetch.test", Protocol::Sip, &sink);
+   bool ok = sink.waitFor(1);
+   dns.lookup<RR_A>("sip.prefetch.test", Protocol::Sip, &sink);
+   ok = sink.waitFor(2) && ok;
+   ok = check(ok && server.queries() - before == 1, "first hit is answered from the cache") && ok;
+
+   dns.lookup<RR_A>("sip.prefetch.test", Protocol::Sip, &sink);
+   ok = check(sink.waitFor(3) && sink.failed() == 0, "entry due for prefetch is answered from the cache") && ok;
+   UInt64 deadline = Timer::getTimeMs() + 5000;
+   while (server.queries() - before < 2 && Timer::getTimeMs() < deadline)
+   {
+      sleepMs(1);
+   }
+   sleepMs(100);
+   ok = check(server.queries() - before == 2, "entry due for prefetch is refreshed in the background") && ok;
+   ok = check(sink.results() == 3, "background refresh reports to no one") && ok;
+
+   // the refresh restarted the hit count
+   dns.lookup<RR_A>("sip.prefetch.test", Protocol::Sip, &sink);
+   ok = sink.waitFor(4) && ok;
+   sleepMs(100);
+   ok = check(server.queries() - before == 2, "refreshed entry is not due again at once") && ok;
+   dns.setDnsCachePrefetch(0, 0);
+   return ok;
+}
+
+static bool
+testLookupHost(DnsStub& dns)
+{
+   bool ok = check(checkLookupHost(dns, "sip.domain0.test", "127.0.0.1"), "lookupHost() resolves a name");
+   ok = check(checkLookupHost(dns, "192.0.2.1", "192.0.2.1"), "lookupHost() passes an address through") && ok;
+   return check(checkLookupHost(dns, "nosuch.test", Data::Empty), "lookupHost() of an unknown name finds nothing") && ok;
+}
+
+static bool
+testLookupHostAtShutdown(StandInDnsServer& server)
+{
+   // a lookupHost() still waiting on the server when the stub goes is
+   // dropped with it, and never reported
+   server.setDelayMs(500);
+   HostSink sink;
+   {
+      TestDns dns(nameserverFor(server));
+      dns.run();
+      dns.lookupHost("sip.shutdown.test", &sink);
+      sleepMs(100);
+      dns.shutdown();
+      dns.join();
+   }
+   sleepMs(600);
+   server.setDelayMs(0);
+   return check(!sink.done(), "lookupHost() pending at shutdown is not reported");
+}
+
+// testDnsStub with no arguments checks query coalescing, prefetch and
+// lookupHost() against a StandInDnsServer.
+static int
+runTests(const char* name)
+{
+   Log::initialize(Log::Cout, Log::Warning, name);
+   initNetwork();
+
+   StandInDnsServer server;
+   server.run();
+   DnsStub::setDnsTimeoutAndTries(2, 3);
+   TestDns dns(nameserverFor(server));
+   dns.run();
+
+   bool ok = testCoalescing(dns, server);
+   ok = testRequeryFromCallback(dns, server) && ok;
+   ok = testPrefetch(dns, server) && ok;
+   ok = testLookupHost(dns) && ok;
+
+   dns.shutdown();
+   dns.join();
+   ok = testLookupHostAtShutdown(server) && ok;
+   server.shutdown();
+   server.join();
+
+   cout << (ok ? "All OK" : "FAILED") << endl;
+   return ok ? 0 : 1;
+}
+
+// testDnsStub --bench <chains> [resolverThreads]
+// Runs <chains> concurrent NAPTR->SRV->A resolutions of distinct domains
+// against a StandInDnsServer and reports the throughput.
+static int
+runBench(int argc, const char** argv)
+{
+   unsigned long chains = argc > 2 ? strtoul(argv[2], 0, 10) : 5000;
+   unsigned int resolverThreads = argc > 3 ? atoi(argv[3]) : 0;
+
+   Log::initialize(Log::Cout, Log::Warning, argv[0]);
+   initNetwork();
+
+   StandInDnsServer server;
+   server.run();
+
+   DnsStub::setDnsTimeoutAndTries(2, 3);
+   TestDns dns(nameserverFor(server));
+   if (resolverThreads > 0)
+   {
+      dns.startResolverThreads(resolverThreads);
+   }
+   dns.run();
+
+   ChainSink sink(dns);
+   UInt64 start = Timer::getTimeMs();
+   for (unsigned long i = 0; i < chains; ++i)
+   {
+      sink.start("domain" + Data((UInt64)i) + ".test");
+   }
+   UInt64 deadline = start + 60000;
+   while (sink.completed() < chains && Timer::getTimeMs() < deadline)
+   {
+      usleep(1000);
+   }
+   UInt64 elapsed = Timer::getTimeMs() - start;
+
+   cout << chains << " NAPTR->SRV->A chains, " << resolverThreads << " resolver threads: "
+        << sink.completed() << " completed (" << sink.failed() << " failed) in "
+        << elapsed << "ms, " << (elapsed ? sink.completed() * 1000 / elapsed : 0) << " chains/s, "
+        << server.queries() << " queries served" << endl;
+
+   dns.shutdown();
+   dns.join();
+   dns.stopResolverThreads();
+   server.shutdown();
+   server.join();
+
+   return (sink.completed() == chains && sink.failed() == 0) ? 0 : 1;
+}
+
 int 
 main(int argc, const char** argv)
 {
+   if (argc == 1)
+   {
+      return runTests(argv[0]);
+   }
+
+   if (argc > 1 && strcmp(argv[1], "--bench") == 0)
+   {
+      return runBench(argc, argv);
+   }
+
    if (argc < 3) 
    {
-      cout << "usage: " << argv[0] << " target" << " type" << endl;
+      cout << "usage: " << argv[0] << endl;
+      cout << "       " << argv[0] << " target" << " type" << endl;
+      cout << "       " << argv[0] << " --bench [chains] [resolverThreads]" << endl;
       cout << "Valid type values: " << endl;
       cout << "A Record - 1" << endl;
       cout << "CNAME - 5" << endl;
@@ -21,7 +21,6 @@
 #include "rutil/DnsUtil.hxx"
 #include "rutil/Logger.hxx"
 #include "rutil/DataStream.hxx"
-#include "resip/stack/MethodHash.hxx"
 
 using namespace resip;
 using namespace std;
@@ -1,20 +1,32 @@
 #include <assert.h>
 #include <iostream>
+#include <iomanip>
 #include <sstream>
+#include <stdexcept>
+#include <stdlib.h>
 #include <string.h>
 #include <string>
+#include <vector>
 #include "resip/stack/HeaderTypes.hxx"
-#include "resip/stack/HeaderHash.hxx"
 #include "resip/stack/MethodTypes.hxx"
-#include "resip/stack/MethodHash.hxx"
 #include "resip/stack/ParameterTypes.hxx"
-#include "resip/stack/ParameterHash.hxx"
+#include "resip/stack/ExtensionHeader.hxx"
+#include "resip/stack/SipMessage.hxx"
+#include "rutil/PerfectHash.hxx"
+#include "rutil/Timer.hxx"
 
 using namespace std;
 using namespace resip;
 
 #define RESIPROCATE_SUBSYSTEM Subsystem::TEST
 
+// Checks that every header, method and parameter name maps back to its type,
+// in any case (methods excepted), then compares the perfect hash lookups
+// with a linear scan and times unknown header lookup in a message carrying
+// many extension headers.
+//
+// usage: testGperfHash [iterations]
+
 static bool
 testHeaderHash(bool verbose)
 {
@@ -118,9 +130,312 @@ testParameterHash(bool verbose)
   return gotErrors;
 }
 
-int main()
+static Data
+flipCase(const Data& name)
+{
+  Data result(name);
+  char* p = const_cast<char*>(result.data());
+  for (Data::size_type i = 0; i < result.size(); ++i)
+  {
+    if (isalpha((unsigned char)p[i]))
+    {
+      p[i] = (i % 2) ? toupper(p[i]) : tolower(p[i]);
+    }
+  }
+  return result;
+}
+
+static bool
+testCaseAndMisses(bool verbose)
+{
+  bool gotErrors = false;
+  if (verbose)
+    cerr << "Test compact forms, case and misses" << endl;
+
+  for (int ht = 0; ht < Headers::MAX_HEADERS; ht++)
+  {
+    if (ht == Headers::RESIP_DO_NOT_USE)
+    {
+      continue;
+    }
+    Data name(flipCase(Headers::getHeaderName(ht)));
+    if (Headers::getType(name.data(), name.size()) != ht)
+    {
+      if (verbose)
+        cerr << "Header " << name << " not found" << endl;
+      gotErrors = true;
+    }
+    name.uppercase();
+    if (Headers::getType(name.data(), name.size()) != ht)
+    {
+      if (verbose)
+        cerr << "Header " << name << " not found" << endl;
+      gotErrors = true;
+    }
+    // a prefix or an extension of a known name is not that name
+    if (name.size() > 2 &&
+        Headers::getType(name.data(), name.size() - 1) == ht)
+    {
+      gotErrors = true;
+    }
+    name += "x";
+    if (Headers::getType(name.data(), name.size()) == ht)
+    {
+      gotErrors = true;
+    }
+  }
+
+  assert(Headers::getType("i", 1) == Headers::CallID);
+  assert(Headers::getType("V", 1) == Headers::Via);
+  assert(Headers::getType("m", 1) == Headers::Contact);
+  assert(Headers::getType("l", 1) == Headers::ContentLength);
+  assert(Headers::getType("o", 1) == Headers::Event);
+  assert(Headers::getType("z", 1) == Headers::UNKNOWN);
+  assert(Headers::getType("", 0) == Headers::UNKNOWN);
+  assert(Headers::getType("Hide", 4) == Headers::UNKNOWN);
+  assert(Headers::getType("X-Via", 5) == Headers::UNKNOWN);
+  assert(Headers::getType("Content-Lengt", 13) == Headers::UNKNOWN);
+  // only letters fold; '-' and '\r' are not a case of anything
+  assert(Headers::getType("Call\rID", 7) == Headers::UNKNOWN);
+  assert(Headers::getType("CALL-ID", 7) == Headers::CallID);
+  assert(Headers::getType("max-forwardS", 12) == Headers::MaxForwards);
+  assert(Headers::getType("Max-Forwards-Extended", 21) == Headers::UNKNOWN);
+
+  // methods are case sensitive
+  assert(getMethodType("INVITE", 6) == INVITE);
+  assert(getMethodType("invite", 6) == UNKNOWN);
+  assert(getMethodType("Invite", 6) == UNKNOWN);
+  assert(getMethodType("INVITES", 7) == UNKNOWN);
+  assert(getMethodType("SUBSCRIBE", 9) == SUBSCRIBE);
+
+  assert(ParameterTypes::getType("BRANCH", 6) == ParameterTypes::branch);
+  assert(ParameterTypes::getType("Tag", 3) == ParameterTypes::tag);
+  assert(ParameterTypes::getType("+sip.instance", 13) == ParameterTypes::Instance);
+  assert(ParameterTypes::getType("tags", 4) == ParameterTypes::UNKNOWN);
+
+  return gotErrors;
+}
+
+static bool
+testUnknownHeaders(bool verbose)
+{
+  if (verbose)
+    cerr << "Test unknown header lookup" << endl;
+
+  // enough extension headers that the message indexes them
+  SipMessage msg;
+  for (int i = 0; i < 200; ++i)
+  {
+    Data name("X-Header-" + Data(i));
+    msg.header(ExtensionHeader(name)).push_back(StringCategory(Data(i)));
+  }
+  for (int i = 0; i < 200; ++i)
+  {
+    Data name("x-HEADER-" + Data(i));
+    assert(msg.exists(ExtensionHeader(name)));
+    assert(msg.header(ExtensionHeader(name)).front().value() == Data(i));
+  }
+  assert(!msg.exists(ExtensionHeader("X-Header-200")));
+  assert(!msg.exists(ExtensionHeader("X-Header-")));
+
+  for (int i = 0; i < 200; i += 2)
+  {
+    msg.remove(ExtensionHeader("X-Header-" + Data(i)));
+  }
+  for (int i = 0; i < 200; ++i)
+  {
+    assert(msg.exists(ExtensionHeader("X-Header-" + Data(i))) == (i % 2 == 1));
+  }
+
+  SipMessage copy(msg);
+  for (int i = 1; i < 200; i += 2)
+  {
+    assert(copy.header(ExtensionHeader("X-HEADER-" + Data(i))).front().value() == Data(i));
+  }
+  assert(copy.getRawUnknownHeaders().size() == 100);
+
+  // parsed headers with repeated names land in the same list
+  Data text("OPTIONS sip:bob@example.com SIP/2.0\r\n"
+            "Via: SIP/2.0/UDP 192.0.2.1;branch=z9hG4bK-1\r\n"
+            "To: <sip:bob@example.com>\r\n"
+            "From: <sip:alice@example.com>;tag=1\r\n"
+            "Call-ID: 1@192.0.2.1\r\n"
+            "CSeq: 1 OPTIONS\r\n");
+  for (int i = 0; i < 40; ++i)
+  {
+    text += "X-Repeat-" + Data(i % 20) + ": " + Data(i) + "\r\n";
+  }
+  text += "Content-Length: 0\r\n\r\n";
+  std::auto_ptr<SipMessage> parsed(SipMessage::make(text));
+  assert(parsed.get());
+  assert(parsed->getRawUnknownHeaders().size() == 20);
+  for (int i = 0; i < 20; ++i)
+  {
+    const StringCategories& values = parsed->header(ExtensionHeader("x-repeat-" + Data(i)));
+    assert(values.size() == 2);
+    assert(values.front().value() == Data(i));
+    assert(values.back().value() == Data(i + 20));
+  }
+
+  return false;
+}
+
+struct NamedType
+{
+  Data name;
+  int type;
+};
+
+// what the lookups amount to without a hash: compare against each name
+static int
+linearFind(const std::vector<NamedType>& names, const char* name, size_t len)
+{
+  for (std::vector<NamedType>::const_iterator i = names.begin(); i != names.end(); ++i)
+  {
+    if (i->name.size() == len && strncasecmp(i->name.data(), name, len) == 0)
+    {
+      return i->type;
+    }
+  }
+  return Headers::UNKNOWN;
+}
+
+static bool
+testDuplicates(bool verbose)
+{
+  if (verbose)
+    cerr << "Test duplicate names" << endl;
+
+  const PerfectHash<int>::Entry entries[] = { { "Via", 1 }, { "To", 2 }, { "via", 3 } };
+  const size_t count = sizeof(entries)/sizeof(entries[0]);
+  bool gotErrors = false;
+  try
+  {
+    PerfectHash<int> noCase(entries, count);
+    if (verbose)
+      cerr << "Duplicate name not refused" << endl;
+    gotErrors = true;
+  }
+  catch (std::invalid_argument&)
+  {
+  }
+
+  // told apart by case
+  PerfectHash<int> withCase(entries, count, true);
+  if (withCase.find("Via", 3, 0) != 1 || withCase.find("via", 3, 0) != 3 ||
+      withCase.find("VIA", 3, 0) != 0)
+  {
+    gotErrors = true;
+  }
+  return gotErrors;
+}
+
+static double
+perLookupNs(UInt64 startUs, int lookups)
+{
+  return double(Timer::getTimeMicroSec() - startUs) * 1000.0 / lookups;
+}
+
+static void
+benchmark(int iterations)
+{
+  // the names as they show up on the wire, with some unknown ones
+  std::vector<NamedType> known;
+  std::vector<Data> wire;
+  for (int ht = 0; ht < Headers::MAX_HEADERS; ht++)
+  {
+    if (ht == Headers::RESIP_DO_NOT_USE)
+    {
+      continue;
+    }
+    NamedType entry;
+    entry.name = Headers::getHeaderName(ht);
+    entry.type = ht;
+    known.push_back(entry);
+    wire.push_back(entry.name);
+  }
+  const char* compact[] = { "v", "i", "m", "l", "f", "t" };
+  for (size_t i = 0; i < sizeof(compact)/sizeof(compact[0]); ++i)
+  {
+    NamedType entry;
+    entry.name = compact[i];
+    entry.type = Headers::getType(compact[i], 1);
+    known.push_back(entry);
+    wire.push_back(entry.name);
+  }
+  wire.push_back("X-Custom-Header");
+  wire.push_back("P-Unknown-Extension");
+
+  int sink = 0;
+  int lookups = 0;
+  UInt64 start = Timer::getTimeMicroSec();
+  for (int n = 0; n < iterations; ++n)
+  {
+    for (size_t w = 0; w < wire.size(); ++w)
+    {
+      sink += Headers::getType(wire[w].data(), wire[w].size());
+      ++lookups;
+    }
+  }
+  double hashed = perLookupNs(start, lookups);
+
+  start = Timer::getTimeMicroSec();
+  for (int n = 0; n < iterations; ++n)
+  {
+    for (size_t w = 0; w < wire.size(); ++w)
+    {
+      sink -= linearFind(known, wire[w].data(), wire[w].size());
+    }
+  }
+  double linear = perLookupNs(start, lookups);
+  assert(sink == 0);
+
+  start = Timer::getTimeMicroSec();
+  for (int n = 0; n < iterations; ++n)
+  {
+    for (int pt = 0; pt < ParameterTypes::MAX_PARAMETER; pt++)
+    {
+      const Data& name = ParameterTypes::ParameterNames[pt];
+      sink += ParameterTypes::getType(name.data(), name.size());
+    }
+  }
+  double parameters = perLookupNs(start, iterations * ParameterTypes::MAX_PARAMETER);
+
+  cerr << fixed << setprecision(1)
+       << "header names: perfect hash " << hashed << " ns/lookup, linear scan "
+       << linear << " ns/lookup; parameter names: " << parameters << " ns/lookup" << endl;
+
+  // unknown header lookup, indexed above a handful of distinct names
+  const int counts[] = { 4, 8, 32, 128 };
+  for (size_t c = 0; c < sizeof(counts)/sizeof(counts[0]); ++c)
+  {
+    SipMessage msg;
+    std::vector<ExtensionHeader> names;
+    for (int i = 0; i < counts[c]; ++i)
+    {
+      names.push_back(ExtensionHeader("X-Benchmark-Header-" + Data(i)));
+      msg.header(names.back()).push_back(StringCategory("value"));
+    }
+    int found = 0;
+    int rounds = iterations * 128 / counts[c];
+    start = Timer::getTimeMicroSec();
+    for (int n = 0; n < rounds; ++n)
+    {
+      for (int i = 0; i < counts[c]; ++i)
+      {
+        found += msg.exists(names[i]) ? 1 : 0;
+      }
+    }
+    assert(found == rounds * counts[c]);
+    cerr << setw(4) << counts[c] << " unknown headers: "
+         << perLookupNs(start, rounds * counts[c]) << " ns/lookup" << endl;
+  }
+}
+
+int main(int argc, char** argv)
 {
   unsigned errors = 0;
+  int iterations = argc > 1 ? atoi(argv[1]) : 2000;
 
   if (testHeaderHash(true))
     errors |= 1;
@@ -131,8 +446,21 @@ int main()
   if (testParameterHash(true))
     errors |= 4;
 
-  if (!errors)
-    cerr << "All OK" << endl;
+  if (testCaseAndMisses(true))
+    errors |= 8;
+
+  if (testUnknownHeaders(true))
+    errors |= 16;
+
+  if (testDuplicates(true))
+    errors |= 32;
+
+  if (errors)
+    return errors;
+
+  benchmark(iterations);
+
+  cerr << "All OK" << endl;
 
   return errors;
 }
@@ -0,0 +1,346 @@
+#include "resip/stack/MsgHeaderScanner.hxx"
+#include "resip/stack/SipMessage.hxx"
+#include "rutil/Data.hxx"
+#include "rutil/DataStream.hxx"
+#include "rutil/Timer.hxx"
+
+#include <cassert>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <iomanip>
+#include <vector>
+
+using namespace resip;
+using namespace std;
+
+// Checks that each SIMD level of MsgHeaderScanner scans the .dat corpus (the
+// RFC 4475 torture tests and friends) exactly like the plain state machine,
+// in one chunk and split into small ones, then reports the scanning
+// throughput of each level.
+//
+// usage: testMsgHeaderScanner [iterations [file.dat ...]]
+// Without files, the corpus is looked for in the current directory; two
+// built-in messages are always included.
+
+static const char* corpusFiles[] =
+{
+   "badaspec.dat", "badbranch.dat", "baddate.dat", "baddn.dat", "badinv01.dat",
+   "badvers.dat", "bcast.dat", "bext01.dat", "bigcode.dat", "clerr.dat",
+   "cparam01.dat", "cparam02.dat", "dblreq.dat", "esc01.dat", "esc02.dat",
+   "escnull.dat", "escruri.dat", "insuf.dat", "intmeth.dat", "inv2543.dat",
+   "invut.dat", "longreq.dat", "ltgtruri.dat", "lwsdisp.dat", "lwsruri.dat",
+   "lwsstart.dat", "mcl01.dat", "mismatch01.dat", "mismatch02.dat", "mpart01.dat",
+   "multi01.dat", "ncl.dat", "noreason.dat", "novelsc.dat", "quotbal.dat",
+   "regaut01.dat", "regbadct.dat", "regescrt.dat", "scalar02.dat", "scalarlg.dat",
+   "sdp01.dat", "semiuri.dat", "test.dat", "transports.dat", "trws.dat",
+   "unkscm.dat", "unksm2.dat", "unreason.dat", "wsinv.dat", "zeromf.dat",
+   0
+};
+
+static const char* invite =
+   "INVITE sip:bob@biloxi.example.com SIP/2.0\r\n"
+   "Via: SIP/2.0/TCP client.atlanta.example.com:5060;branch=z9hG4bK74bf9;received=192.0.2.101\r\n"
+   "Via: SIP/2.0/UDP proxy.atlanta.example.com:5060;branch=z9hG4bK2d4790.1;rport=5060\r\n"
+   "Max-Forwards: 70\r\n"
+   "From: \"Alice, from Atlanta\" <sip:alice@atlanta.example.com>;tag=9fxced76sl\r\n"
+   "To: Bob <sip:bob@biloxi.example.com>\r\n"
+   "Call-ID: 3848276298220188511@atlanta.example.com\r\n"
+   "CSeq: 1 INVITE\r\n"
+   "Contact: <sip:alice@client.atlanta.example.com;transport=tcp>;+sip.instance=\"<urn:uuid:00000000-0000-1000-8000-000A95A0E128>\"\r\n"
+   "Record-Route: <sip:proxy.atlanta.example.com;lr;ftag=9fxced76sl>, <sip:edge.atlanta.example.com;lr>\r\n"
+   "Allow: INVITE, ACK, CANCEL, OPTIONS, BYE, REFER, NOTIFY, MESSAGE, SUBSCRIBE, INFO, UPDATE\r\n"
+   "Supported: replaces, timer, 100rel, path, gruu, outbound\r\n"
+   "User-Agent: SoftPhone/2.1.4 (build 2291; Linux x86_64)\r\n"
+   "P-Asserted-Identity: \"Alice\" <sip:alice@atlanta.example.com>\r\n"
+   "Subject: A long subject line,\r\n"
+   " folded onto a second line (with a comment)\r\n"
+   "Content-Type: application/sdp\r\n"
+   "Content-Length: 151\r\n"
+   "\r\n"
+   "v=0\r\n"
+   "o=alice 2890844526 2890844526 IN IP4 client.atlanta.example.com\r\n"
+   "s=-\r\n"
+   "c=IN IP4 192.0.2.101\r\n"
+   "t=0 0\r\n"
+   "m=audio 49172 RTP/AVP 0\r\n"
+   "a=rtpmap:0 PCMU/8000\r\n";
+
+static const char* response =
+   "SIP/2.0 200 OK\r\n"
+   "Via: SIP/2.0/UDP edge.biloxi.example.com:5060;branch=z9hG4bK-524287-1---a2ee3d9bd0c7b6d6;rport=5060;received=198.51.100.7\r\n"
+   "Via: SIP/2.0/TLS core.biloxi.example.com:5061;branch=z9hG4bK-524287-1---2c7a8ab2d41b9f7e;alias\r\n"
+   "Via: SIP/2.0/UDP pc33.atlanta.example.com;branch=z9hG4bKnashds8;received=192.0.2.1\r\n"
+   "Record-Route: <sip:edge.biloxi.example.com;transport=udp;lr;drr>,<sip:core.biloxi.example.com;transport=tls;lr;drr>\r\n"
+   "To: Bob <sip:bob@biloxi.example.com>;tag=a6c85cf\r\n"
+   "From: Alice <sip:alice@atlanta.example.com>;tag=1928301774\r\n"
+   "Call-ID: a84b4c76e66710@pc33.atlanta.example.com\r\n"
+   "CSeq: 314159 INVITE\r\n"
+   "Contact: <sip:bob@192.0.2.4;ob>;expires=3600;q=0.7, <sip:bob@198.51.100.2>;expires=60\r\n"
+   "X-Custom-Header: some, thing \"quoted, with \\\"escapes\\\"\" and (parens) 100%\r\n"
+   "Content-Length: 0\r\n"
+   "\r\n";
+
+static Data
+readFile(const char* name)
+{
+   Data result;
+   FILE* fid = fopen(name, "rb");
+   if (!fid)
+   {
+      return result;
+   }
+   char buffer[1024];
+   size_t count;
+   while ((count = fread(buffer, 1, sizeof(buffer), fid)) > 0)
+   {
+      result += Data(buffer, (Data::size_type)count);
+   }
+   fclose(fid);
+   return result;
+}
+
+struct ScanOutcome
+{
+   MsgHeaderScanner::ScanChunkResult result;
+   unsigned int offset;    // of *unprocessedCharPtr from the start of the text
+   unsigned int headerCount;
+   Data headers;
+};
+
+static Data
+dumpHeaders(const SipMessage& msg)
+{
+   Data result;
+   {
+      DataStream str(result);
+      for (int type = 0; type < Headers::MAX_HEADERS; ++type)
+      {
+         const HeaderFieldValueList* hfvl = msg.getRawHeader(static_cast<Headers::Type>(type));
+         if (hfvl)
+         {
+            for (HeaderFieldValueList::const_iterator i = hfvl->begin(); i != hfvl->end(); ++i)
+            {
+               str << type << ": [" << Data(i->getBuffer(), i->getLength()) << "]\n";
+            }
+         }
+      }
+      const SipMessage::UnknownHeaders& unknowns = msg.getRawUnknownHeaders();
+      for (SipMessage::UnknownHeaders::const_iterator u = unknowns.begin(); u != unknowns.end(); ++u)
+      {
+         for (HeaderFieldValueList::const_iterator i = u->second->begin(); i != u->second->end(); ++i)
+         {
+            str << u->first << ": [" << Data(i->getBuffer(), i->getLength()) << "]\n";
+         }
+      }
+   }
+   return result;
+}
+
+// Feeds text to the scanner chunkSize characters at a time, carrying any
+// incomplete text unit over to the next chunk the way ConnectionBase does.
+static ScanOutcome
+scan(const Data& text, unsigned int chunkSize)
+{
+   SipMessage msg;
+   MsgHeaderScanner scanner;
+   scanner.prepareForMessage(&msg);
+
+   ScanOutcome outcome;
+   unsigned int position = 0;
+   const char* carryFrom = 0;
+   unsigned int carried = 0;
+   for (;;)
+   {
+      unsigned int take = text.size() - position;
+      if (take > chunkSize)
+      {
+         take = chunkSize;
+      }
+      char* buffer = MsgHeaderScanner::allocateBuffer(carried + take);
+      msg.addBuffer(buffer);
+      if (carried)
+      {
+         memcpy(buffer, carryFrom, carried);
+      }
+      memcpy(buffer + carried, text.data() + position, take);
+      const unsigned int bufferOffset = position - carried;
+      position += take;
+
+      char* unprocessed = 0;
+      outcome.result = scanner.scanChunk(buffer, carried + take, &unprocessed);
+      outcome.offset = bufferOffset + (unsigned int)(unprocessed - buffer);
+      if (outcome.result != MsgHeaderScanner::scrNextChunk || position == text.size())
+      {
+         break;
+      }
+      carried = (unsigned int)(buffer + carried + take - unprocessed);
+      carryFrom = unprocessed;
+   }
+   outcome.headerCount = scanner.getHeaderCount();
+   if (outcome.result == MsgHeaderScanner::scrEnd)
+   {
+      outcome.headers = dumpHeaders(msg);
+   }
+   return outcome;
+}
+
+static const char*
+levelName(MsgHeaderScanner::SimdLevel level)
+{
+   switch (level)
+   {
+      case MsgHeaderScanner::simdSse2:
+         return "sse2";
+      case MsgHeaderScanner::simdAvx2:
+         return "avx2";
+      default:
+         return "scalar";
+   }
+}
+
+int
+main(int argc, char** argv)
+{
+   int iterations = argc > 1 ? atoi(argv[1]) : 2000;
+
+   std::vector<Data> corpus;
+   std::vector<Data> names;
+   if (argc > 2)
+   {
+      for (int i = 2; i < argc; ++i)
+      {
+         corpus.push_back(readFile(argv[i]));
+         names.push_back(argv[i]);
+         assert(!corpus.back().empty());
+      }
+   }
+   else
+   {
+      for (const char** name = corpusFiles; *name; ++name)
+      {
+         Data text(readFile(*name));
+         if (!text.empty())
+         {
+            corpus.push_back(text);
+            names.push_back(*name);
+         }
+      }
+   }
+   corpus.push_back(invite);
+   names.push_back("built-in INVITE");
+   corpus.push_back(response);
+   names.push_back("built-in 200");
+
+   const MsgHeaderScanner::SimdLevel maxLevel = MsgHeaderScanner::getMaxSimdLevel();
+   cerr << "Corpus of " << corpus.size() << " messages; this CPU supports " << levelName(maxLevel) << endl;
+
+   const unsigned int chunkSizes[] = { 1, 2, 7, 16, 31, 64, 1 << 20 };
+   for (size_t m = 0; m < corpus.size(); ++m)
+   {
+      for (size_t c = 0; c < sizeof(chunkSizes) / sizeof(chunkSizes[0]); ++c)
+      {
+         MsgHeaderScanner::setSimdLevel(MsgHeaderScanner::simdNone);
+         ScanOutcome expected = scan(corpus[m], chunkSizes[c]);
+         for (int level = MsgHeaderScanner::simdSse2; level <= maxLevel; ++level)
+         {
+            MsgHeaderScanner::setSimdLevel(static_cast<MsgHeaderScanner::SimdLevel>(level));
+            ScanOutcome outcome = scan(corpus[m], chunkSizes[c]);
+            if (outcome.result != expected.result ||
+                outcome.offset != expected.offset ||
+                outcome.headerCount != expected.headerCount ||
+                outcome.headers != expected.headers)
+            {
+               cerr << names[m] << " scanned differently with " << levelName(static_cast<MsgHeaderScanner::SimdLevel>(level))
+                    << " in chunks of " << chunkSizes[c] << ":" << endl
+                    << expected.headers << "----" << endl << outcome.headers << endl;
+               assert(0);
+               return -1;
+            }
+         }
+      }
+   }
+   cerr << "All SIMD levels agree with the state machine" << endl;
+
+   size_t totalBytes = 0;
+   for (size_t m = 0; m < corpus.size(); ++m)
+   {
+      totalBytes += corpus[m].size();
+   }
+   for (int level = MsgHeaderScanner::simdNone; level <= maxLevel; ++level)
+   {
+      MsgHeaderScanner::setSimdLevel(static_cast<MsgHeaderScanner::SimdLevel>(level));
+      UInt64 start = Timer::getTimeMicroSec();
+      for (int i = 0; i < iterations; ++i)
+      {
+         for (size_t m = 0; m < corpus.size(); ++m)
+         {
+            scan(corpus[m], 1 << 20);
+         }
+      }
+      UInt64 elapsed = Timer::getTimeMicroSec() - start;
+      if (elapsed == 0)
+      {
+         elapsed = 1;
+      }
+      cerr << setw(7) << levelName(static_cast<MsgHeaderScanner::SimdLevel>(level)) << ": "
+           << setw(8) << elapsed / 1000 << " ms, "
+           << fixed << setprecision(1) << setw(8) << double(totalBytes) * iterations / elapsed << " MB/s "
+           << "(message construction included)" << endl;
+   }
+   MsgHeaderScanner::setSimdLevel(maxLevel);
+
+   cerr << "All OK" << endl;
+   return 0;
+}
+
+/* ====================================================================
+ * The Vovida Software License, Version 1.0 
+ * 
+ * Copyright (c) 2000 Vovida Networks, Inc.  All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 
+ * 3. The names "VOCAL", "Vovida Open Communication Application Library",
+ *    and "Vovida Open Communication Application Library (VOCAL)" must
+ *    not be used to endorse or promote products derived from this
+ *    software without prior written permission. For written
+ *    permission, please contact vocal@vovida.org.
+ *
+ * 4. Products derived from this software may not be called "VOCAL", nor
+ *    may "VOCAL" appear in their name, without prior written
+ *    permission of Vovida Networks, Inc.
+ * 
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESSED OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE, TITLE AND
+ * NON-INFRINGEMENT ARE DISCLAIMED.  IN NO EVENT SHALL VOVIDA
+ * NETWORKS, INC. OR ITS CONTRIBUTORS BE LIABLE FOR ANY DIRECT DAMAGES
+ * IN EXCESS OF $1,000, NOR FOR ANY INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE
+ * USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+ * DAMAGE.
+ * 
+ * ====================================================================
+ * 
+ * This software consists of voluntary contributions made by Vovida
+ * Networks, Inc. and many individuals on behalf of Vovida Networks,
+ * Inc.  For more information on Vovida Networks, Inc., please see
+ * <http://www.vovida.org/>.
+ *
+ */
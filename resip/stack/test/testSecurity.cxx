@@ -4,6 +4,7 @@
 
 #include <iostream>
 #include <stdexcept>
+#include <vector>
 
 #include "resip/stack/ssl/Security.hxx"
 //#include "rutil/ssl/OpenSSLInit.hxx"
@@ -14,6 +15,19 @@
 #ifdef USE_SSL
 #include <openssl/evp.h>
 #include <openssl/opensslv.h>
+#include <openssl/pem.h>
+#include <openssl/rsa.h>
+#include <openssl/x509.h>
+
+#ifndef WIN32
+#include <poll.h>
+#endif
+
+#include "resip/stack/TransactionMessage.hxx"
+#include "resip/stack/ssl/TlsTransport.hxx"
+#include "rutil/FdPoll.hxx"
+#include "rutil/Fifo.hxx"
+#include "rutil/Timer.hxx"
 #endif
 
 using namespace std;
@@ -134,6 +148,273 @@ void testSecurityMultiThread()
    t2.join();
 }
 
+#ifdef USE_SSL
+// A throwaway self-signed certificate for example.com.
+static void
+makeSelfSignedCert(X509*& cert, EVP_PKEY*& key)
+{
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+   key = EVP_RSA_gen(2048);
+   assert(key);
+#else
+   key = EVP_PKEY_new();
+   RSA* rsa = RSA_new();
+   BIGNUM* e = BN_new();
+   BN_set_word(e, RSA_F4);
+   RSA_generate_key_ex(rsa, 2048, e, 0);
+   BN_free(e);
+   EVP_PKEY_assign_RSA(key, rsa);
+#endif
+
+   cert = X509_new();
+   ASN1_INTEGER_set(X509_get_serialNumber(cert), 1);
+   X509_gmtime_adj(X509_get_notBefore(cert), 0);
+   X509_gmtime_adj(X509_get_notAfter(cert), 3600);
+   X509_set_pubkey(cert, key);
+   X509_NAME* name = X509_get_subject_name(cert);
+   X509_NAME_add_entry_by_txt(name, "CN", MBSTRING_ASC, (const unsigned char*)"example.com", -1, -1, 0);
+   X509_set_issuer_name(cert, name);
+   X509_sign(cert, key, EVP_sha256());
+}
+
+// Gives ctx a throwaway self-signed certificate so that it can act as a
+// server.
+static void
+useSelfSignedCert(SSL_CTX* ctx)
+{
+   X509* cert;
+   EVP_PKEY* key;
+   makeSelfSignedCert(cert, key);
+   int ok = SSL_CTX_use_certificate(ctx, cert) && SSL_CTX_use_PrivateKey(ctx, key);
+   assert(ok);
+   X509_free(cert);
+   EVP_PKEY_free(key);
+}
+
+// Runs a handshake over a memory BIO pair, offering *session if there is
+// one, and leaves the session the client ended up with in *session.
+// Returns true if it was resumed.
+static bool
+handshake(SSL_CTX* serverCtx, SSL_CTX* clientCtx, SSL_SESSION** session)
+{
+   SSL* server = SSL_new(serverCtx);
+   SSL* client = SSL_new(clientCtx);
+   BIO* serverBio;
+   BIO* clientBio;
+   BIO_new_bio_pair(&serverBio, 0, &clientBio, 0);
+   SSL_set_bio(server, serverBio, serverBio);
+   SSL_set_bio(client, clientBio, clientBio);
+   SSL_set_accept_state(server);
+   SSL_set_connect_state(client);
+   if (*session)
+   {
+      SSL_set_session(client, *session);
+      SSL_SESSION_free(*session);
+   }
+
+   for (int i = 0; i < 20 && !(SSL_is_init_finished(client) && SSL_is_init_finished(server)); ++i)
+   {
+      SSL_do_handshake(client);
+      SSL_do_handshake(server);
+   }
+   assert(SSL_is_init_finished(client) && SSL_is_init_finished(server));
+
+   // TLS 1.3 tickets come after the handshake
+   char c;
+   SSL_write(server, "x", 1);
+   SSL_read(client, &c, 1);
+
+   bool resumed = SSL_session_reused(client) != 0;
+   *session = SSL_get1_session(client);
+   SSL_shutdown(client);
+   SSL_shutdown(server);
+   SSL_free(client);
+   SSL_free(server);
+   return resumed;
+}
+
+void testSessionResumption()
+{
+   long oldRotation = BaseSecurity::TlsTicketKeyRotation;
+   BaseSecurity::TlsTicketKeyRotation = 1;
+   {
+      Security security;
+      SSL_CTX* serverCtx = security.getSslCtx();
+      useSelfSignedCert(serverCtx);
+
+      for (int useTickets = 1; useTickets >= 0; --useTickets)
+      {
+         SSL_CTX* clientCtx = SSL_CTX_new(SSLv23_method());
+         SSL_CTX_set_session_cache_mode(clientCtx, SSL_SESS_CACHE_CLIENT);
+         if (!useTickets)
+         {
+            // resumption by session id, which also needs the session id
+            // context since the server asks for client certificates
+            SSL_CTX_set_options(clientCtx, SSL_OP_NO_TICKET);
+#ifdef SSL_CTX_set_max_proto_version
+            SSL_CTX_set_max_proto_version(clientCtx, TLS1_2_VERSION);
+#endif
+         }
+
+         SSL_SESSION* session = 0;
+         assert(!handshake(serverCtx, clientCtx, &session));
+         assert(handshake(serverCtx, clientCtx, &session));
+
+         if (useTickets)
+         {
+            // a ticket outlives one rotation of the key it is under, but
+            // not two
+            SSL_SESSION_free(session);
+            session = 0;
+            handshake(serverCtx, clientCtx, &session);
+            sleepMs(1200);
+            assert(handshake(serverCtx, clientCtx, &session));
+
+            SSL_SESSION_free(session);
+            session = 0;
+            handshake(serverCtx, clientCtx, &session);
+            sleepMs(2500);
+            assert(!handshake(serverCtx, clientCtx, &session));
+         }
+         SSL_SESSION_free(session);
+         SSL_CTX_free(clientCtx);
+      }
+      assert(SSL_CTX_sess_hits(serverCtx) > 0);
+   }
+   BaseSecurity::TlsTicketKeyRotation = oldRotation;
+}
+
+// Connects NumClients TLS clients at once to a TlsTransport in an FdPollGrp,
+// handshaking on the given number of pool threads, and checks that each
+// connection comes back to the FdPollGrp and delivers a request.
+static void
+testConcurrentHandshakes(unsigned int handshakeThreads)
+{
+   const int NumClients = 300;
+   const char* certFile = "testSecurity-cert.pem";
+   const char* keyFile = "testSecurity-key.pem";
+   {
+      X509* cert;
+      EVP_PKEY* key;
+      makeSelfSignedCert(cert, key);
+      FILE* f = fopen(certFile, "w");
+      PEM_write_X509(f, cert);
+      fclose(f);
+      f = fopen(keyFile, "w");
+      PEM_write_PrivateKey(f, key, 0, 0, 0, 0, 0);
+      fclose(f);
+      X509_free(cert);
+      EVP_PKEY_free(key);
+   }
+
+   unsigned int oldThreads = TlsBaseTransport::HandshakeThreads;
+   TlsBaseTransport::HandshakeThreads = handshakeThreads;
+   Log::Level oldLevel = Log::level();
+   Log::setLevel(Log::Warning);
+   {
+      Security security;
+      Fifo<TransactionMessage> rxFifo;
+      TlsTransport transport(rxFifo, 0, V4, "127.0.0.1", security, "example.com",
+                             SecurityTypes::SSLv23, 0, Compression::Disabled, 0,
+                             SecurityTypes::None, false, certFile, keyFile);
+      assert((transport.getHandshakePool() != 0) == (handshakeThreads > 0));
+      FdPollGrp* pollGrp = FdPollGrp::create();
+      transport.setPollGrp(pollGrp);
+
+      sockaddr_in addr;
+      memset(&addr, 0, sizeof(addr));
+      addr.sin_family = AF_INET;
+      addr.sin_port = htons(transport.port());
+      addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+      SSL_CTX* clientCtx = SSL_CTX_new(SSLv23_method());
+      std::vector<Socket> fds;
+      std::vector<SSL*> clients;
+      std::vector<bool> sent(NumClients, false);
+      for (int i = 0; i < NumClients; ++i)
+      {
+         Socket fd = ::socket(AF_INET, SOCK_STREAM, 0);
+         assert(fd != INVALID_SOCKET);
+         makeSocketNonBlocking(fd);
+         ::connect(fd, (sockaddr*)&addr, sizeof(addr));
+         fds.push_back(fd);
+         clients.push_back(0);
+      }
+
+      const Data request("OPTIONS sip:example.com SIP/2.0\r\n"
+                         "Via: SIP/2.0/TLS 127.0.0.1:5061;branch=z9hG4bK-pool\r\n"
+                         "Max-Forwards: 70\r\n"
+                         "To: <sip:example.com>\r\n"
+                         "From: <sip:test@example.com>;tag=1\r\n"
+                         "Call-ID: pool\r\n"
+                         "CSeq: 1 OPTIONS\r\n"
+                         "Content-Length: 0\r\n\r\n");
+      int done = 0;
+      int received = 0;
+      UInt64 deadline = Timer::getTimeMs() + 60000;
+      while ((done < NumClients || received < NumClients) && Timer::getTimeMs() < deadline)
+      {
+         pollGrp->waitAndProcess(1);
+         transport.process();
+         for (int i = 0; i < NumClients; ++i)
+         {
+            if (sent[i])
+            {
+               continue;
+            }
+            if (!clients[i])
+            {
+               // start TLS once the TCP connection is through the
+               // (possibly overflowing) listen backlog
+               pollfd pfd = { fds[i], POLLOUT, 0 };
+               if (::poll(&pfd, 1, 0) != 1)
+               {
+                  continue;
+               }
+               clients[i] = SSL_new(clientCtx);
+               SSL_set_fd(clients[i], (int)fds[i]);
+               SSL_set_connect_state(clients[i]);
+            }
+            if (SSL_do_handshake(clients[i]) == 1)
+            {
+               int written = SSL_write(clients[i], request.data(), (int)request.size());
+               assert(written == (int)request.size());
+               sent[i] = true;
+               ++done;
+            }
+         }
+         while (rxFifo.messageAvailable())
+         {
+            delete rxFifo.getNext();
+            ++received;
+         }
+      }
+      cerr << done << " handshakes on " << handshakeThreads << " handshake threads, "
+           << received << " requests received" << endl;
+      assert(done == NumClients);
+      assert(received == NumClients);
+
+      unsigned int full = 0;
+      unsigned int resumed = 0;
+      unsigned int evictions = 0;
+      transport.sumTlsSessionStats(full, resumed, evictions);
+      assert(full + resumed == (unsigned int)NumClients);
+
+      transport.setPollGrp(0); // closes the server side
+      delete pollGrp;
+      for (int i = 0; i < NumClients; ++i)
+      {
+         SSL_free(clients[i]);
+         closeSocket(fds[i]);
+      }
+      SSL_CTX_free(clientCtx);
+   }
+   Log::setLevel(oldLevel);
+   TlsBaseTransport::HandshakeThreads = oldThreads;
+   remove(certFile);
+   remove(keyFile);
+}
+#endif
 
 int
 main(int argc, const char** argv)
@@ -157,6 +438,12 @@ main(int argc, const char** argv)
    }
    catch (const invalid_argument& ia) { } // ignore, expected exception
 
+#ifdef USE_SSL
+   testSessionResumption();
+   testConcurrentHandshakes(0);
+   testConcurrentHandshakes(4);
+#endif
+
 #if 0
    testMultiple();
 #else
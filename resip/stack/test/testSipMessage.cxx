@@ -3,6 +3,7 @@
 
 #include "rutil/DataStream.hxx"
 #include "resip/stack/SipMessage.hxx"
+#include "resip/stack/SendData.hxx"
 #include "resip/stack/Helper.hxx"
 #include "resip/stack/Uri.hxx"
 #include "resip/stack/Helper.hxx"
@@ -2296,6 +2297,139 @@ main(int argc, char** argv)
       assert( msg->header(h_ContentLength).value() == 0 );
    }
 
+   {
+      // A proxy style forward encoded with encodeFragments() must match
+      // encode(), referencing the unmodified values and body, and must stay
+      // valid after the message is gone.
+      Data txt("INVITE sip:bob@biloxi.example.com SIP/2.0\r\n"
+               "Via: SIP/2.0/UDP client.atlanta.example.com:5060;branch=z9hG4bK74bf9;received=192.0.2.101;rport=5060\r\n"
+               "Max-Forwards: 70\r\n"
+               "From: Alice <sip:alice@atlanta.example.com>;tag=9fxced76sl-long-enough-to-be-referenced\r\n"
+               "To: Bob <sip:bob@biloxi.example.com>\r\n"
+               "Call-ID: 3848276298220188511@atlanta.example.com\r\n"
+               "CSeq: 1 INVITE\r\n"
+               "Contact: <sip:alice@client.atlanta.example.com;transport=udp;ob>\r\n"
+               "User-Agent: Example User Agent 1.0 (with a description that runs on for a while)\r\n"
+               "Content-Type: application/sdp\r\n"
+               "Content-Length: 151\r\n"
+               "\r\n"
+               "v=0\r\n"
+               "o=alice 2890844526 2890844526 IN IP4 client.atlanta.example.com\r\n"
+               "s=-\r\n"
+               "c=IN IP4 192.0.2.101\r\n"
+               "t=0 0\r\n"
+               "m=audio 49172 RTP/AVP 0\r\n"
+               "a=rtpmap:0 PCMU/8000\r\n");
+
+      SipMessage* msg = SipMessage::make(txt, true);
+      assert(msg);
+
+      Via via;
+      via.sentHost() = "proxy.example.com";
+      via.param(p_branch).reset("z9hG4bK-proxy-1");
+      msg->header(h_Vias).push_front(via);
+      msg->header(h_MaxForwards).value()--;
+      msg->header(h_RecordRoutes).push_front(NameAddr("<sip:proxy.example.com;lr>"));
+
+      Data expected;
+      {
+         DataStream str(expected);
+         msg->encode(str);
+      }
+
+      SendData send;
+      msg->encodeFragments(send);
+      assert(send.isFragmented());
+      assert(send.fragments.size() <= SendData::MaxFragments);
+      int referenced = 0;
+      for (SendData::Fragments::const_iterator i = send.fragments.begin(); 
+           i != send.fragments.end(); ++i)
+      {
+         if (i->external)
+         {
+            ++referenced;
+         }
+      }
+      // the received Via, From, User-Agent and the body
+      assert(referenced == 4);
+      assert(send.size() == expected.size());
+      assert(send.toData() == expected);
+
+      SendData copy(send);
+      delete msg;
+      assert(copy.toData() == expected);
+      copy.flatten();
+      assert(!copy.isFragmented());
+      assert(copy.data == expected);
+
+      // nothing to reference in a message built from scratch
+      SipMessage local;
+      local.header(h_RequestLine) = RequestLine(OPTIONS);
+      local.header(h_RequestLine).uri() = Uri("sip:bob@biloxi.example.com");
+      local.header(h_CallId).value() = "local-call-id";
+      SendData localSend;
+      local.encodeFragments(localSend);
+      assert(!localSend.isFragmented());
+      Data localExpected;
+      {
+         DataStream str(localExpected);
+         local.encode(str);
+      }
+      assert(localSend.data == localExpected);
+   }
+
+   {
+      // A shared body is neither copied with the message nor by
+      // encodeFragments(), and outlives the messages that share it
+      Data text("This body is long enough to be referenced rather than copied by encodeFragments().");
+      SharedPtr<SharedRxBuffers> body(new SharedRxBuffers);
+      char* buf = new char[text.size()];
+      memcpy(buf, text.data(), text.size());
+      body->mBuffers.push_back(std::make_pair(buf, (size_t)text.size()));
+
+      SipMessage* notify = new SipMessage;
+      notify->header(h_RequestLine) = RequestLine(NOTIFY);
+      notify->header(h_RequestLine).uri() = Uri("sip:watcher@example.com");
+      notify->header(h_CallId).value() = "shared-body-call-id";
+      notify->setSharedBody(body, buf, text.size());
+      notify->header(h_ContentType) = Mime("text", "plain");
+
+      SipMessage* copy = new SipMessage(*notify);
+      assert(copy->getRawBody().getBuffer() == buf);
+      // reading the parsed body leaves it shared; a non-const access would
+      // mark it modified, and copies would then take their own
+      const PlainContents* plain = dynamic_cast<const PlainContents*>(copy->getContents());
+      assert(plain && plain->text() == text);
+      SipMessage second(*copy);
+      assert(second.getRawBody().getBuffer() == buf);
+
+      Data expected;
+      {
+         DataStream str(expected);
+         copy->encode(str);
+      }
+      assert(expected.find(text) != Data::npos);
+
+      SendData send;
+      copy->encodeFragments(send);
+      assert(send.isFragmented());
+      assert(send.fragments.back().external == buf);
+      delete notify;
+      delete copy;
+      second.setContents(0);
+      assert(send.toData() == expected);
+
+      // replacing the body stops sharing it
+      SipMessage other;
+      other.header(h_RequestLine) = RequestLine(NOTIFY);
+      other.header(h_RequestLine).uri() = Uri("sip:watcher@example.com");
+      other.setSharedBody(body, buf, text.size());
+      PlainContents replaced(Data("replaced"));
+      other.setContents(&replaced);
+      SipMessage otherCopy(other);
+      assert(otherCopy.getRawBody().getBuffer() != buf);
+   }
+
    resipCerr << "\nTEST OK" << endl;
    return 0;
 }
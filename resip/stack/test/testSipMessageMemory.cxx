@@ -1,13 +1,81 @@
 #include "resip/stack/SipMessage.hxx"
+#include "resip/stack/SdpContents.hxx"
 #include "resip/stack/Uri.hxx"
 #include "resip/stack/test/TestSupport.hxx"
+#include "rutil/Timer.hxx"
 
+#include <cstdlib>
 #include <iostream>
 #include <memory>
+#include <new>
 
 using namespace resip;
 using namespace std;
 
+// Count every heap allocation the process makes, so that we can report how
+// many it takes to receive and inspect a typical message.
+static unsigned long allocationCount = 0;
+
+void* operator new(size_t size)
+{
+   ++allocationCount;
+   void* result = malloc(size ? size : 1);
+   if (!result)
+   {
+      throw std::bad_alloc();
+   }
+   return result;
+}
+
+void operator delete(void* ptr) throw()
+{
+   free(ptr);
+}
+
+void* operator new[](size_t size)
+{
+   return operator new(size);
+}
+
+void operator delete[](void* ptr) throw()
+{
+   operator delete(ptr);
+}
+
+// Parses an INVITE the way the stack and a TU typically would (transaction
+// matching, dialog identification, routing, SDP) count times; reports the
+// heap allocations per message.
+static double
+allocationsPerMessage(const Data& txt, int count)
+{
+   UInt64 start = Timer::getTimeMicroSec();
+   unsigned long before = allocationCount;
+   for (int i = 0; i < count; ++i)
+   {
+      auto_ptr<SipMessage> msg(TestSupport::makeMessage(txt, true));
+      assert(msg->header(h_Vias).front().param(p_branch).hasMagicCookie());
+      assert(msg->header(h_Vias).back().exists(p_received));
+      assert(!msg->header(h_From).param(p_tag).empty());
+      assert(!msg->header(h_To).exists(p_tag));
+      assert(msg->header(h_To).uri().host() == "biloxi.com");
+      assert(!msg->header(h_CallId).value().empty());
+      assert(msg->header(h_CSeq).method() == INVITE);
+      assert(msg->header(h_MaxForwards).value() == 70);
+      assert(msg->header(h_Contacts).front().uri().param(p_transport) == "udp");
+      assert(msg->header(h_Contacts).front().exists(p_Instance));
+      assert(msg->header(h_RecordRoutes).front().uri().exists(p_lr));
+      assert(msg->header(h_Allows).size() == 10);
+      assert(msg->header(h_Supporteds).size() == 2);
+      SdpContents* sdp = dynamic_cast<SdpContents*>(msg->getContents());
+      assert(sdp);
+      assert(sdp->session().media().front().port() == 49172);
+   }
+   double result = double(allocationCount - before) / count;
+   resipCerr << "  " << result << " allocations per message, "
+             << (Timer::getTimeMicroSec() - start) / count << " us per message" << endl;
+   return result;
+}
+
 int
 main()
 {
@@ -69,6 +137,46 @@ main()
       assert(message1->getRawHeader(Headers::CSeq)->getParserContainer());
    }
 
+   {
+      resipCerr << "Testing allocations per message" << endl;
+
+      const Data sdp("v=0\r\n"
+                     "o=alice 2890844526 2890844526 IN IP4 pc33.atlanta.com\r\n"
+                     "s=-\r\n"
+                     "c=IN IP4 pc33.atlanta.com\r\n"
+                     "t=0 0\r\n"
+                     "m=audio 49172 RTP/AVP 0\r\n"
+                     "a=rtpmap:0 PCMU/8000\r\n");
+      Data txt("INVITE sip:bob@biloxi.com SIP/2.0\r\n"
+               "Via: SIP/2.0/UDP pc33.atlanta.com;branch=z9hG4bK776asdhds;rport\r\n"
+               "Via: SIP/2.0/UDP proxy.atlanta.com:5060;branch=z9hG4bK88ds;received=10.0.0.1\r\n"
+               "Max-Forwards: 70\r\n"
+               "To: Bob <sip:bob@biloxi.com>\r\n"
+               "From: Alice <sip:alice@atlanta.com>;tag=1928301774\r\n"
+               "Call-ID: a84b4c76e66710@pc33.atlanta.com\r\n"
+               "CSeq: 314159 INVITE\r\n"
+               "Contact: <sip:alice@pc33.atlanta.com;transport=udp>;+sip.instance=\"<urn:uuid:00000000-0000-1000-8000-000A95A0E128>\"\r\n"
+               "Record-Route: <sip:p1.example.com;lr>\r\n"
+               "Record-Route: <sip:p2.example.com;lr>\r\n"
+               "Allow: INVITE, ACK, CANCEL, OPTIONS, BYE, REFER, NOTIFY, MESSAGE, SUBSCRIBE, INFO\r\n"
+               "Supported: replaces, timer\r\n"
+               "User-Agent: testSipMessageMemory\r\n"
+               "Content-Type: application/sdp\r\n"
+               "Content-Length: ");
+      txt += Data((UInt32)sdp.size()) + "\r\n\r\n" + sdp;
+
+      const int count = 10000;
+      resipCerr << "Without arena:" << endl;
+      double heap = allocationsPerMessage(txt, count);
+
+      SipMessage::arenaMaxBytes = 64*1024;
+      resipCerr << "With arena:" << endl;
+      double arena = allocationsPerMessage(txt, count);
+      SipMessage::arenaMaxBytes = 0;
+
+      assert(arena < heap);
+   }
+
    resipCout << "All OK" << endl;
    return 0;
 }
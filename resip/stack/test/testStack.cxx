@@ -155,7 +155,9 @@ class SipStackAndThread
    public:
       SipStackAndThread(const char *tType,
         AsyncProcessHandler *notifyDn=0,
-        AsyncProcessHandler *notifyUp=0);
+        AsyncProcessHandler *notifyUp=0,
+        unsigned int tcShards=0,
+        unsigned int lockFreeFifos=0);
          ~SipStackAndThread() {
          destroy();
       }
@@ -203,7 +205,8 @@ class SipStackAndThread
 
 
 SipStackAndThread::SipStackAndThread(const char *tType,
- AsyncProcessHandler *notifyDn, AsyncProcessHandler *notifyUp)
+ AsyncProcessHandler *notifyDn, AsyncProcessHandler *notifyUp,
+ unsigned int tcShards, unsigned int lockFreeFifos)
   : mStack(0), 
       mThread(0), 
       mSelIntr(0), 
@@ -249,6 +252,8 @@ SipStackAndThread::SipStackAndThread(const char *tType,
    options.mAsyncProcessHandler = mEventIntr?mEventIntr
       :(mSelIntr?mSelIntr:notifyDn);
    options.mPollGrp = mPollGrp;
+   options.mTransactionControllerShards = tcShards;
+   options.mLockFreeFifos = lockFreeFifos;
    mStack = new SipStack(options);
    
    mStack->setFallbackPostNotify(notifyUp);
@@ -591,6 +596,10 @@ main(int argc, char* argv[])
    int portBase = 0;
    const char* threadType = "event";
    int tpFlags = 0;
+   int udpShards = 0;
+   int tcShards = 0;
+   int timerWheel = 0;
+   int lockFreeFifos = 0;
    int sendSleepMs = 0;
    int cManager=0;
    int statisticsInterval=60;
@@ -617,6 +626,10 @@ main(int argc, char* argv[])
       {"numports",    'n', POPT_ARG_INT,    &numPorts,  0, "number of parallel sessions(ports)", 0},
       {"thread-type", 't', POPT_ARG_STRING, &threadType,0, "stack thread type", threadTypeDesc},
       {"tf",          0,   POPT_ARG_INT,    &tpFlags,   0, "bit encoding of transportFlags", 0},
+      {"udp-shards",  0,   POPT_ARG_INT,    &udpShards, 0, "number of SO_REUSEPORT shards for the receiver's UDP transport", 0},
+      {"tc-shards",   0,   POPT_ARG_INT,    &tcShards,  0, "number of TransactionController shards in each stack (use with multithreadedstack)", 0},
+      {"timer-wheel", 0,   POPT_ARG_NONE,   &timerWheel,0, "keep stack timers in a timing wheel instead of a heap", 0},
+      {"lock-free-fifos",0,POPT_ARG_INT,    &lockFreeFifos,0, "bit encoding of SipStackOptions::mLockFreeFifos", 0},
       {"sleep",       0,   POPT_ARG_INT,    &sendSleepMs,0, "time (ms) to sleep after each sent request", 0},
       {"use-congestion-manager",0, POPT_ARG_NONE, &cManager ,   0, "use a CongestionManager", 0},
       {"statistics-interval",       0,   POPT_ARG_INT,    &statisticsInterval,0, "time in seconds between statistics logging", 0},
@@ -646,8 +659,17 @@ main(int argc, char* argv[])
      <<" bindIf="<<bindIfAddr
      <<" listen="<<doListen
      <<" tf="<<tpFlags
+     <<" udpShards="<<udpShards
+     <<" tcShards="<<tcShards
+     <<" timerWheel="<<timerWheel
+     <<" lockFreeFifos="<<lockFreeFifos
      <<"." << endl;
 
+   if (timerWheel)
+   {
+      TimerQueueBase::DefaultImplementation = TimerQueueBase::Wheel;
+   }
+
    const char *eachThreadType = threadType;
    SelectInterruptor *commonIntr = NULL;
    AsyncProcessHandler *notifyUp = NULL;
@@ -678,8 +700,8 @@ main(int argc, char* argv[])
    {
       notifyUp = &sharedUp;
    }
-   SipStackAndThread receiver(eachThreadType, commonIntr, notifyUp);
-   SipStackAndThread sender(eachThreadType, commonIntr, notifyUp);
+   SipStackAndThread receiver(eachThreadType, commonIntr, notifyUp, tcShards, lockFreeFifos);
+   SipStackAndThread sender(eachThreadType, commonIntr, notifyUp, tcShards, lockFreeFifos);
    receiver.getStack().setStatisticsInterval(statisticsInterval);
    sender.getStack().setStatisticsInterval(statisticsInterval);
 
@@ -734,15 +756,27 @@ main(int argc, char* argv[])
 
       // NOTE: we could also bind receive to bindIfAddr, but existing code
       // doesn't do this. Responses are sent from here, so why don't we?
-      transports.push_back(receiver->addTransport(UDP, 
-                             registrarPort+idx, 
-                             version, 
-                             StunDisabled,
-                             /*ipInterface*/Data::Empty,
-                             /*sipDomain*/Data::Empty, 
-                             /*keypass*/Data::Empty, 
-                             SecurityTypes::TLSv1,
-                             tpFlags));
+      if(udpShards > 0)
+      {
+         // runs its own TransportThreads, so not added to transports
+         receiver->addShardedUdpTransport(registrarPort+idx,
+                                          udpShards,
+                                          version,
+                                          /*ipInterface*/Data::Empty,
+                                          tpFlags);
+      }
+      else
+      {
+         transports.push_back(receiver->addTransport(UDP, 
+                                registrarPort+idx, 
+                                version, 
+                                StunDisabled,
+                                /*ipInterface*/Data::Empty,
+                                /*sipDomain*/Data::Empty, 
+                                /*keypass*/Data::Empty, 
+                                SecurityTypes::TLSv1,
+                                tpFlags));
+      }
 
       transports.push_back(receiver->addTransport(TCP, 
                              registrarPort+idx, 
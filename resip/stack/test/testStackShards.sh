@@ -0,0 +1,16 @@
+#!/bin/sh
+
+# Measures testStack throughput against the number of TransactionController
+# shards. Extra arguments are passed through to testStack, e.g.
+#   ./testStackShards.sh --protocol=udp --num-runs=50000 --invite
+#
+# Sharding only spreads work across cores when each shard has its own thread,
+# so the stacks are always run with --thread-type=multithreadedstack.
+
+SHARDS=${SHARDS:-"0 2 4 8"}
+
+for n in $SHARDS; do
+   rate=$(./testStack --thread-type=multithreadedstack --tc-shards=$n "$@" |\
+      awk '/performed in/ { print $(NF-3); }')
+   echo "shards=$n rate=$rate"
+done
@@ -19,3 +19,5 @@ echo "Running TCP REGISTER test with 50 ports"
 ./testStack --protocol=tcp --numports=50
 echo "Running TCP INVITE test"
 ./testStack --protocol=tcp --invite
+echo "Running UDP REGISTER test (threaded stack, 4 transaction shards)"
+./testStack --protocol=udp --thread-type=multithreadedstack --tc-shards=4
@@ -0,0 +1,325 @@
+#include <iostream>
+#include <iomanip>
+#include <cassert>
+#include <cstdlib>
+#include <map>
+#include <set>
+#include <vector>
+#include <queue>
+#include "resip/stack/TransactionMessage.hxx"
+#include "resip/stack/TimerQueue.hxx"
+#include "resip/stack/TimerWheel.hxx"
+#include "rutil/Fifo.hxx"
+#include "rutil/TimeLimitFifo.hxx"
+#include "rutil/Random.hxx"
+#ifdef WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+#ifdef WIN32
+#define usleep(x) Sleep(x/1000)
+#endif
+
+using namespace resip;
+using namespace std;
+
+// Exercises TimerWheel against a reference multiset with a simulated clock,
+// then, for each timer count given on the command line (e.g. 10000 100000
+// 1000000), compares it with the heap used by TimerQueue.
+
+class TestTimer
+{
+   public:
+      TestTimer(UInt64 when, unsigned int serial) : mWhen(when), mSerial(serial) {}
+      UInt64 getWhen() const { return mWhen; }
+      unsigned int getSerial() const { return mSerial; }
+   private:
+      UInt64 mWhen;
+      unsigned int mSerial;
+};
+
+static UInt64
+randomOffset()
+{
+   // mostly transaction sized timers, with a few that reach every level of
+   // the wheel and some beyond it
+   switch (Random::getRandom() % 8)
+   {
+      case 0:
+         return Random::getRandom() % 256;
+      case 1:
+         return (UInt64(Random::getRandom()) << 8) % (UInt64(1) << 34);
+      case 2:
+         return Random::getRandom() % (1 << 20);
+      default:
+         return Random::getRandom() % 64000;
+   }
+}
+
+static void
+checkAgainstReference()
+{
+   const UInt64 start = 1000000;
+   TimerWheel<TestTimer> wheel(start);
+   std::multiset<UInt64> reference;
+   std::map<unsigned int, TimerWheel<TestTimer>::Id> ids;
+   std::map<unsigned int, UInt64> whens;
+   std::set<unsigned int> cancelled;
+   unsigned int serial = 0;
+   UInt64 now = start;
+
+   assert(wheel.empty());
+   assert(wheel.peekExpired(now) == 0);
+
+   for (int round = 0; round < 2000; ++round)
+   {
+      int adds = Random::getRandom() % 20;
+      for (int i = 0; i < adds; ++i)
+      {
+         UInt64 when = now + randomOffset();
+         if (Random::getRandom() % 50 == 0)
+         {
+            // already overdue
+            when = now - (Random::getRandom() % 100);
+         }
+         TimerWheel<TestTimer>::Id id = wheel.add(TestTimer(when, ++serial));
+         assert(id != 0);
+         assert(wheel.isPending(id));
+         ids[serial] = id;
+         whens[serial] = when;
+         reference.insert(when);
+      }
+
+      if (!ids.empty() && Random::getRandom() % 3 == 0)
+      {
+         std::map<unsigned int, TimerWheel<TestTimer>::Id>::iterator i = ids.lower_bound(Random::getRandom() % (serial + 1));
+         if (i == ids.end())
+         {
+            i = ids.begin();
+         }
+         assert(wheel.find(i->second)->getSerial() == i->first);
+         assert(wheel.cancel(i->second));
+         assert(!wheel.cancel(i->second));
+         assert(!wheel.isPending(i->second));
+         reference.erase(reference.find(whens[i->first]));
+         cancelled.insert(i->first);
+         ids.erase(i);
+      }
+
+      assert(wheel.size() == reference.size());
+      if (!reference.empty())
+      {
+         assert(wheel.nextWhen() == *reference.begin());
+         assert(wheel.peekNext()->getWhen() == *reference.begin());
+      }
+
+      // jump ahead, sometimes a long way
+      now += (Random::getRandom() % 10 == 0) ? randomOffset() : Random::getRandom() % 300;
+      const TestTimer* timer;
+      while ((timer = wheel.peekExpired(now)) != 0)
+      {
+         assert(timer->getWhen() <= now);
+         assert(cancelled.count(timer->getSerial()) == 0);
+         assert(ids.count(timer->getSerial()) == 1);
+         TimerWheel<TestTimer>::Id id = ids[timer->getSerial()];
+         reference.erase(reference.find(timer->getWhen()));
+         ids.erase(timer->getSerial());
+         wheel.popExpired();
+         assert(!wheel.isPending(id));
+      }
+      // everything that was due has fired
+      assert(reference.empty() || *reference.begin() > now);
+   }
+
+   while (wheel.peekAny())
+   {
+      wheel.popAny();
+   }
+   assert(wheel.empty());
+   cerr << "TimerWheel matches reference after " << serial << " timers" << endl;
+}
+
+static void
+checkTimerQueue()
+{
+   Fifo<TimerMessage> r;
+   TransactionTimerQueue timer(r, TimerQueueBase::Wheel);
+
+   assert(timer.msTillNextTimer() == INT_MAX);
+   TransactionTimerQueue::Id a = timer.add(Timer::TimerA, "first", 20);
+   TransactionTimerQueue::Id b = timer.add(Timer::TimerB, "second", 40);
+   TransactionTimerQueue::Id c = timer.add(Timer::TimerD, "third", 32000);
+   assert(a && b && c);
+   assert(timer.size() == 3);
+   assert(timer.msTillNextTimer() <= 20);
+
+   assert(timer.cancel(a));
+   assert(!timer.cancel(a));
+   assert(timer.size() == 2);
+   assert(timer.msTillNextTimer() > 20 - 10 && timer.msTillNextTimer() <= 40);
+
+   usleep(100*1000);
+   timer.process();
+   assert(r.size() == 1);
+   TimerMessage* msg = r.getNext();
+   assert(msg->getTransactionId() == "second");
+   delete msg;
+   assert(!timer.isPending(b));
+   assert(timer.isPending(c));
+   assert(timer.size() == 1);
+
+   // payloads of cancelled and unfired timers are deleted
+   TimeLimitFifo<Message> f(0, 0);
+   TimeLimitTimerQueue appTimer(f, TimerQueueBase::Wheel);
+   TimeLimitTimerQueue::Id id = appTimer.add(10, new TimerMessage("app", Timer::TimerA, 10));
+   appTimer.add(20000, new TimerMessage("app", Timer::TimerB, 20000));
+   assert(appTimer.cancel(id));
+   assert(appTimer.size() == 1);
+   cerr << "TimerQueue wheel mode OK" << endl;
+}
+
+typedef std::priority_queue<TransactionTimer, std::vector<TransactionTimer>, std::greater<TransactionTimer> > Heap;
+
+static double
+elapsedMs(UInt64 startUs)
+{
+   return double(Timer::getTimeMicroSec() - startUs) / 1000.0;
+}
+
+static void
+benchmark(unsigned int count)
+{
+   // retransmission and transaction timers, 0-64*T1 out
+   std::vector<unsigned long> offsets(count);
+   for (unsigned int i = 0; i < count; ++i)
+   {
+      offsets[i] = Random::getRandom() % (64*Timer::T1);
+   }
+   Data tid("z9hG4bK-bench");
+
+   UInt64 base = Timer::getTimeMs();
+   UInt64 startUs = Timer::getTimeMicroSec();
+   Heap heap;
+   for (unsigned int i = 0; i < count; ++i)
+   {
+      heap.push(TransactionTimer(offsets[i], Timer::TimerA, tid));
+   }
+   double heapAdd = elapsedMs(startUs);
+
+   startUs = Timer::getTimeMicroSec();
+   unsigned int fired = 0;
+   for (UInt64 now = base; !heap.empty(); ++now)
+   {
+      while (!heap.empty() && !(heap.top().getWhen() > now))
+      {
+         heap.pop();
+         ++fired;
+      }
+   }
+   double heapExpire = elapsedMs(startUs);
+   assert(fired == count);
+
+   TimerWheel<TransactionTimer> wheel(base);
+   std::vector<TimerWheel<TransactionTimer>::Id> ids(count);
+   startUs = Timer::getTimeMicroSec();
+   for (unsigned int i = 0; i < count; ++i)
+   {
+      ids[i] = wheel.add(TransactionTimer(offsets[i], Timer::TimerA, tid));
+   }
+   double wheelAdd = elapsedMs(startUs);
+
+   // most transactions complete before their timers go off; the heap has
+   // to let those fire
+   startUs = Timer::getTimeMicroSec();
+   for (unsigned int i = 0; i < count; i += 2)
+   {
+      wheel.cancel(ids[i]);
+   }
+   double wheelCancel = elapsedMs(startUs);
+
+   startUs = Timer::getTimeMicroSec();
+   fired = 0;
+   for (UInt64 now = base; !wheel.empty(); ++now)
+   {
+      while (wheel.peekExpired(now))
+      {
+         wheel.popExpired();
+         ++fired;
+      }
+   }
+   double wheelExpire = elapsedMs(startUs);
+   assert(fired == count / 2);
+
+   cerr << setw(8) << count
+        << "  heap: add " << setw(9) << heapAdd << "ms expire " << setw(9) << heapExpire << "ms"
+        << "  wheel: add " << setw(9) << wheelAdd << "ms cancel(1/2) " << setw(9) << wheelCancel
+        << "ms expire " << setw(9) << wheelExpire << "ms" << endl;
+}
+
+int
+main(int argc, char** argv)
+{
+   checkAgainstReference();
+   checkTimerQueue();
+
+   cerr << fixed << setprecision(2);
+   for (int i = 1; i < argc; ++i)
+   {
+      benchmark(atoi(argv[i]));
+   }
+
+   cerr << "All OK" << endl;
+   return 0;
+}
+
+/* ====================================================================
+ * The Vovida Software License, Version 1.0 
+ * 
+ * Copyright (c) 2000 Vovida Networks, Inc.  All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 
+ * 3. The names "VOCAL", "Vovida Open Communication Application Library",
+ *    and "Vovida Open Communication Application Library (VOCAL)" must
+ *    not be used to endorse or promote products derived from this
+ *    software without prior written permission. For written
+ *    permission, please contact vocal@vovida.org.
+ *
+ * 4. Products derived from this software may not be called "VOCAL", nor
+ *    may "VOCAL" appear in their name, without prior written
+ *    permission of Vovida Networks, Inc.
+ * 
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESSED OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE, TITLE AND
+ * NON-INFRINGEMENT ARE DISCLAIMED.  IN NO EVENT SHALL VOVIDA
+ * NETWORKS, INC. OR ITS CONTRIBUTORS BE LIABLE FOR ANY DIRECT DAMAGES
+ * IN EXCESS OF $1,000, NOR FOR ANY INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE
+ * USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+ * DAMAGE.
+ * 
+ * ====================================================================
+ * 
+ * This software consists of voluntary contributions made by Vovida
+ * Networks, Inc. and many individuals on behalf of Vovida Networks,
+ * Inc.  For more information on Vovida Networks, Inc., please see
+ * <http://www.vovida.org/>.
+ *
+ */
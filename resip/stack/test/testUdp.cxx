@@ -20,12 +20,85 @@
 #include "rutil/DnsUtil.hxx"
 #include "rutil/Logger.hxx"
 #include "rutil/DataStream.hxx"
+#include "rutil/Timer.hxx"
 
 using namespace resip;
 using namespace std;
 
 #define RESIPROCATE_SUBSYSTEM Subsystem::SIP
 
+// Pushes more datagrams than one recvmmsg()/sendmmsg() batch holds through
+// a pair of batching transports on ephemeral ports; all of them must
+// arrive, and where the calls exist a full batch must have been counted.
+static void
+testBatch()
+{
+   const unsigned flags = RESIP_TRANSPORT_FLAG_RXBATCH | RESIP_TRANSPORT_FLAG_TXBATCH |
+                          RESIP_TRANSPORT_FLAG_RXALL | RESIP_TRANSPORT_FLAG_TXALL;
+   Fifo<TransactionMessage> txFifo;
+   UdpTransport sender(txFifo, 0, V4, StunDisabled, "127.0.0.1", 0, Compression::Disabled, flags);
+   Fifo<TransactionMessage> rxFifo;
+   UdpTransport receiver(rxFifo, 0, V4, StunDisabled, "127.0.0.1", 0, Compression::Disabled, flags);
+
+   NameAddr target;
+   target.uri().scheme() = "sip";
+   target.uri().user() = "fluffy";
+   target.uri().host() = "127.0.0.1";
+   target.uri().port() = receiver.port();
+   NameAddr from = target;
+   from.uri().port() = sender.port();
+   Tuple dest("127.0.0.1", receiver.port(), UDP);
+
+   const int count = UdpTransport::MaxBatchSize * 3 + 5;
+   for (int i = 0; i < count; ++i)
+   {
+      std::auto_ptr<SipMessage> invite(Helper::makeInvite(target, from, from));
+      invite->header(h_Vias).front().transport() = "UDP";
+      invite->header(h_Vias).front().sentHost() = "127.0.0.1";
+      invite->header(h_Vias).front().sentPort() = sender.port();
+      Data encoded;
+      {
+         DataStream strm(encoded);
+         invite->encode(strm);
+      }
+      std::auto_ptr<SendData> toSend(sender.makeSendData(dest, encoded, Data(i + 1), Data::Empty));
+      sender.send(toSend);
+   }
+
+   int received = 0;
+   UInt64 deadline = Timer::getTimeMs() + 5000;
+   while (received < count && Timer::getTimeMs() < deadline)
+   {
+      FdSet fdset;
+      sender.buildFdSet(fdset);
+      receiver.buildFdSet(fdset);
+      fdset.selectMilliSeconds(50);
+      sender.process(fdset);
+      receiver.process(fdset);
+      while (rxFifo.messageAvailable())
+      {
+         delete rxFifo.getNext();
+         ++received;
+      }
+   }
+   assert(received == count);
+   assert(txFifo.empty()); // no send failures
+
+   unsigned int rxBatches[StatisticsMessage::Payload::MaxBatchBucket] = {0};
+   unsigned int txBatches[StatisticsMessage::Payload::MaxBatchBucket] = {0};
+   sender.sumBatchSizes(rxBatches, txBatches);
+   receiver.sumBatchSizes(rxBatches, txBatches);
+   const unsigned int full = StatisticsMessage::Payload::batchBucket(UdpTransport::MaxBatchSize);
+#if defined(HAVE_SENDMMSG)
+   assert(txBatches[full] > 0);
+#endif
+#if defined(HAVE_RECVMMSG)
+   assert(rxBatches[full] > 0);
+#endif
+   cout << "batched " << count << " datagrams: " << txBatches[full] << " full send batches, "
+        << rxBatches[full] << " full receive batches" << endl;
+}
+
 int
 main(int argc, char* argv[])
 {
@@ -57,6 +130,8 @@ main(int argc, char* argv[])
    Log::initialize(logType, logLevel, argv[0]);
 #endif
 
+   testBatch();
+
    cout << "Performing " << runs << " runs." << endl;
    
    Fifo<TransactionMessage> txFifo;
@@ -8,9 +8,11 @@
 #include "rutil/Condition.hxx"
 #include "rutil/Lock.hxx"
 #include "rutil/CongestionManager.hxx"
+#include "rutil/MpscQueue.hxx"
 
 #include "rutil/compat.hxx"
 #include "rutil/Timer.hxx"
+#include "rutil/Time.hxx"
 
 namespace resip
 {
@@ -119,6 +121,12 @@ class FifoStatsInterface
    @note Users of the resip stack will not need to interact with this class 
       directly in most cases. Look at Fifo and TimeLimitFifo instead.
 
+   By default every operation takes mMutex. A fifo that is only ever read
+   from one thread can be switched to lock-free mode with setLockFree():
+   producers then push onto an MpscQueue and only touch mMutex/mCondition
+   when the fifo goes from empty to non-empty, to wake a consumer that may
+   be blocked in getNext().
+
    @ingroup message_passing
  */
 template <typename T>
@@ -134,11 +142,13 @@ class AbstractFifo : public FifoStatsInterface
             mLastSampleTakenMicroSec(0),
             mCounter(0),
             mAverageServiceTimeMicroSec(0),
-            mSize(0)
+            mSize(0),
+            mLockFree(0)
       {}
 
       virtual ~AbstractFifo()
       {
+         delete mLockFree;
       }
 
       /** 
@@ -147,6 +157,10 @@ class AbstractFifo : public FifoStatsInterface
        **/
       bool empty() const
       {
+         if (mLockFree)
+         {
+            return AtomicOps::load(mSize) == 0;
+         }
          Lock lock(mMutex); (void)lock;
          return mFifo.empty();
       }
@@ -160,6 +174,10 @@ class AbstractFifo : public FifoStatsInterface
        */
       virtual unsigned int size() const
       {
+         if (mLockFree)
+         {
+            return AtomicOps::load(mSize);
+         }
          Lock lock(mMutex); (void)lock;
          return (unsigned int)mFifo.size();
       }
@@ -171,6 +189,10 @@ class AbstractFifo : public FifoStatsInterface
        
       bool messageAvailable() const
       {
+         if (mLockFree)
+         {
+            return AtomicOps::load(mSize) != 0;
+         }
          Lock lock(mMutex); (void)lock;
          return !mFifo.empty();
       }
@@ -187,7 +209,7 @@ class AbstractFifo : public FifoStatsInterface
 
       virtual size_t getCountDepth() const
       {
-         return mSize;
+         return mLockFree ? AtomicOps::load(mSize) : mSize;
       }
 
       virtual time_t expectedWaitTimeMilliSec() const
@@ -203,7 +225,31 @@ class AbstractFifo : public FifoStatsInterface
       /// remove all elements in the queue (or not)
       virtual void clear() {};
 
+      /// @return true if setLockFree() has been called
+      bool isLockFree() const
+      {
+         return mLockFree != 0;
+      }
+
    protected:
+      /**
+         @brief Switches this fifo to lock-free mode.
+         @details After this, add() and addMultiple() may still be called from
+         any thread, but everything that removes or inspects elements must
+         be called from a single consumer thread. size() and the statistics
+         become approximate while producers are active. Must be called while
+         the fifo is empty and before it is shared between threads.
+      */
+      void setLockFree()
+      {
+         Lock lock(mMutex); (void)lock;
+         resip_assert(mFifo.empty());
+         if (!mLockFree)
+         {
+            mLockFree = new MpscQueue<T>;
+         }
+      }
+
       /** 
           @brief Returns the first message available.
           @details Returns the first message available. It will wait if no
@@ -215,6 +261,15 @@ class AbstractFifo : public FifoStatsInterface
        */
       T getNext()
       {
+         if (mLockFree)
+         {
+            onFifoPolled();
+            waitLockFree(RESIP_FIFO_FOREVER);
+            T firstMessage(popLockFree());
+            onMessagePopped();
+            return firstMessage;
+         }
+
          Lock lock(mMutex); (void)lock;
          onFifoPolled();
 
@@ -250,6 +305,18 @@ class AbstractFifo : public FifoStatsInterface
             return true;
          }
 
+         if (mLockFree)
+         {
+            onFifoPolled();
+            if (!waitLockFree(ms))
+            {
+               return false;
+            }
+            toReturn = popLockFree();
+            onMessagePopped();
+            return true;
+         }
+
          if(ms < 0)
          {
             Lock lock(mMutex); (void)lock;
@@ -258,6 +325,7 @@ class AbstractFifo : public FifoStatsInterface
               return false;
             toReturn = mFifo.front();
             mFifo.pop_front();
+            onMessagePopped();
             return true;
          }
 
@@ -301,6 +369,12 @@ class AbstractFifo : public FifoStatsInterface
 
       void getMultiple(Messages& other, unsigned int max)
       {
+         if (mLockFree)
+         {
+            getMultiple(RESIP_FIFO_FOREVER, other, max);
+            return;
+         }
+
          Lock lock(mMutex); (void)lock;
          onFifoPolled();
          resip_assert(other.empty());
@@ -328,6 +402,29 @@ class AbstractFifo : public FifoStatsInterface
 
       bool getMultiple(int ms, Messages& other, unsigned int max)
       {
+         if (mLockFree)
+         {
+            resip_assert(other.empty());
+            onFifoPolled();
+            if (!waitLockFree(ms))
+            {
+               return false;
+            }
+            // take what is there now; anything added meanwhile can wait for
+            // the next call
+            unsigned int num = AtomicOps::load(mSize);
+            if (num > max)
+            {
+               num = max;
+            }
+            for (unsigned int i = 0; i < num; ++i)
+            {
+               other.push_back(popLockFree());
+            }
+            onMessagePopped(num);
+            return true;
+         }
+
          if(ms==0)
          {
             getMultiple(other,max);
@@ -383,6 +480,17 @@ class AbstractFifo : public FifoStatsInterface
 
       size_t add(const T& item)
       {
+         if (mLockFree)
+         {
+            UInt32 size = reserveLockFree(1);
+            mLockFree->push(item);
+            if (size == 1)
+            {
+               wakeLockFree();
+            }
+            return size;
+         }
+
          Lock lock(mMutex); (void)lock;
          mFifo.push_back(item);
          mCondition.signal();
@@ -392,6 +500,26 @@ class AbstractFifo : public FifoStatsInterface
 
       size_t addMultiple(Messages& items)
       {
+         if (mLockFree)
+         {
+            UInt32 num = (UInt32)items.size();
+            if (num == 0)
+            {
+               return AtomicOps::load(mSize);
+            }
+            UInt32 size = reserveLockFree(num);
+            while (!items.empty())
+            {
+               mLockFree->push(items.front());
+               items.pop_front();
+            }
+            if (size == num)
+            {
+               wakeLockFree();
+            }
+            return size;
+         }
+
          Lock lock(mMutex); (void)lock;
          size_t size=items.size();
          if(mFifo.empty())
@@ -413,6 +541,92 @@ class AbstractFifo : public FifoStatsInterface
          return mFifo.size();
       }
 
+      /**
+         @brief Counts the items about to be pushed in lock-free mode.
+         @details Producers count an item before pushing it, so the consumer
+         never sees an item that is not yet counted.
+         @return the new size; equal to num if the fifo was empty
+      */
+      UInt32 reserveLockFree(UInt32 num)
+      {
+         UInt32 size = AtomicOps::add(mSize, num);
+         if (size == num)
+         {
+            // Fifo went from empty to non-empty; see onMessagePushed()
+            AtomicOps::store(mLastSampleTakenMicroSec, Timer::getTimeMicroSec());
+         }
+         return size;
+      }
+
+      /// wakes a consumer blocked in waitLockFree()
+      void wakeLockFree()
+      {
+         Lock lock(mMutex); (void)lock;
+         mCondition.signal();
+      }
+
+      /**
+         @brief waits until something has been added, with the getNext(ms)
+         conventions for ms.
+         @return false on timeout or interruption
+      */
+      bool waitLockFree(int ms)
+      {
+         if (AtomicOps::load(mSize) != 0)
+         {
+            return true;
+         }
+         if (ms < 0)
+         {
+            return false;
+         }
+
+         const UInt64 end(Timer::getTimeMs() + (unsigned int)(ms));
+         Lock lock(mMutex); (void)lock;
+         // producers take mMutex after counting an item, so this check
+         // cannot miss their signal
+         while (AtomicOps::load(mSize) == 0)
+         {
+            if (ms == 0)
+            {
+               mCondition.wait(mMutex);
+               continue;
+            }
+            const UInt64 now(Timer::getTimeMs());
+            if(now >= end)
+            {
+                return false;
+            }
+            if (!mCondition.wait(mMutex, (unsigned int)(end - now)))
+            {
+               return AtomicOps::load(mSize) != 0;
+            }
+         }
+         return true;
+      }
+
+      /**
+         @brief pops an item that has been counted; spins if its producer
+         has not finished pushing it yet.
+      */
+      T popLockFree()
+      {
+         for (;;)
+         {
+            for (int spin = 0; spin < 64; ++spin)
+            {
+               const T* item = mLockFree->front();
+               if (item)
+               {
+                  T result(*item);
+                  mLockFree->pop(result);
+                  return result;
+               }
+            }
+            sleepMs(0);
+         }
+      }
+
       /** @brief container for FIFO items */
       Messages mFifo;
       /** @brief access serialization lock */
@@ -420,23 +634,27 @@ class AbstractFifo : public FifoStatsInterface
       /** @brief condition for waiting on new queue items */
       Condition mCondition;
 
-      mutable UInt64 mLastSampleTakenMicroSec;
+      // set by producers in lock-free mode, so always accessed atomically
+      mutable volatile UInt64 mLastSampleTakenMicroSec;
       mutable UInt32 mCounter;
       mutable UInt32 mAverageServiceTimeMicroSec;
       // std::deque has to perform some amount of traversal to calculate its 
       // size; we maintain this count so that it can be queried without locking, 
       // in situations where it being off by a small amount is ok.
       UInt32 mSize;
+      /** @brief replaces mFifo in lock-free mode */
+      MpscQueue<T>* mLockFree;
 
       virtual void onFifoPolled()
       {
          // !bwc! TODO allow this sampling frequency to be tweaked
-         if(mLastSampleTakenMicroSec &&
+         const UInt64 lastSample = AtomicOps::load(mLastSampleTakenMicroSec);
+         if(lastSample &&
             mCounter &&
-            (mCounter >= 64 || mFifo.empty()))
+            (mCounter >= 64 || (mLockFree ? AtomicOps::load(mSize) == 0 : mFifo.empty())))
          {
             UInt64 now(Timer::getTimeMicroSec());
-            UInt64 diff = now-mLastSampleTakenMicroSec;
+            UInt64 diff = now-lastSample;
 
             if(mCounter >= 4096)
             {
@@ -451,13 +669,13 @@ class AbstractFifo : public FifoStatsInterface
                      4096U);
             }
             mCounter=0;
-            if(mFifo.empty())
+            if(mLockFree ? AtomicOps::load(mSize) == 0 : mFifo.empty())
             {
-               mLastSampleTakenMicroSec=0;
+               AtomicOps::store(mLastSampleTakenMicroSec, UInt64(0));
             }
             else
             {
-               mLastSampleTakenMicroSec=now;
+               AtomicOps::store(mLastSampleTakenMicroSec, now);
             }
          }
       }
@@ -469,7 +687,14 @@ class AbstractFifo : public FifoStatsInterface
       virtual void onMessagePopped(unsigned int num=1)
       {
          mCounter+=num;
-         mSize-=num;
+         if (mLockFree)
+         {
+            AtomicOps::sub(mSize, num);
+         }
+         else
+         {
+            mSize-=num;
+         }
       }
 
       virtual void onMessagePushed(int num)
@@ -478,7 +703,7 @@ class AbstractFifo : public FifoStatsInterface
          {
             // Fifo went from empty to non-empty. Take a timestamp, and record
             // how long it takes to process some messages.
-            mLastSampleTakenMicroSec=Timer::getTimeMicroSec();
+            AtomicOps::store(mLastSampleTakenMicroSec, Timer::getTimeMicroSec());
          }
          mSize+=num;
       }
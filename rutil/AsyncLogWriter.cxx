@@ -0,0 +1,518 @@
+#include <string.h>
+#include <algorithm>
+#include <iostream>
+
+#include "rutil/AsyncLogWriter.hxx"
+#include "rutil/Lock.hxx"
+#include "rutil/Logger.hxx"
+#include "rutil/Subsystem.hxx"
+#include "rutil/Time.hxx"
+#include "rutil/WinLeakCheck.hxx"
+
+using namespace resip;
+
+namespace
+{
+// how long the writer sleeps when every ring is empty
+const unsigned int MaxWriteDelayMs = 20;
+}
+
+// One record as stored in a Ring; the message text follows it.
+struct AsyncLogWriter::Record
+{
+   UInt32 mSize;   // of the whole record, padded; 0 marks a skip to the start of the ring
+   UInt32 mLength; // of the message text
+   UInt32 mTruncated; // bytes of the message text that did not fit
+   Log::Level mLevel;
+   int mLine;
+   time_t mSec;
+   unsigned int mUsec;
+   const Subsystem* mSubsystem;
+   const char* mFile;
+   Log::ThreadData* mLogger;
+
+   const char* message() const { return reinterpret_cast<const char*>(this + 1); }
+};
+
+// Single-producer, single-consumer ring of variable length Records. The
+// positions run freely and are masked on use, so the capacity must be a
+// power of two.
+class AsyncLogWriter::Ring
+{
+   public:
+      Ring(UInt32 capacity)
+         : mBuffer(new char[capacity]),
+           mCapacity(capacity),
+           mHead(0),
+           mTail(0),
+           mOrphaned(0),
+           mThreadId(ThreadIf::selfId()),
+           mNext(0)
+      {}
+
+      ~Ring()
+      {
+         delete [] mBuffer;
+      }
+
+      /// producer; copies as much of the message as fits in a quarter of
+      /// the ring and records how much was cut off
+      bool push(const Record& record, const char* message, unsigned int length)
+      {
+         const UInt32 maxLength = mCapacity / 4 - sizeof(Record);
+         UInt32 truncated = 0;
+         if (length > maxLength)
+         {
+            truncated = length - maxLength;
+            length = maxLength;
+         }
+         const UInt32 size = (UInt32)(sizeof(Record) + length + 7) & ~7U;
+
+         UInt32 tail = mTail;
+         UInt32 offset = tail & (mCapacity - 1);
+         const UInt32 skip = mCapacity - offset < size ? mCapacity - offset : 0;
+         if (tail + skip + size - AtomicOps::load(mHead) > mCapacity)
+         {
+            return false;
+         }
+         if (skip)
+         {
+            reinterpret_cast<Record*>(mBuffer + offset)->mSize = 0;
+            tail += skip;
+            offset = 0;
+         }
+         Record* stored = reinterpret_cast<Record*>(mBuffer + offset);
+         *stored = record;
+         stored->mSize = size;
+         stored->mLength = length;
+         stored->mTruncated = truncated;
+         memcpy(stored + 1, message, length);
+         AtomicOps::store(mTail, tail + size);
+         return true;
+      }
+
+      /// producer
+      bool moreThanHalfFull() const
+      {
+         return mTail - AtomicOps::load(mHead) > mCapacity / 2;
+      }
+
+      /// consumer; @return the oldest record before tail, or 0
+      const Record* front(UInt32 tail)
+      {
+         while (mHead != tail)
+         {
+            const UInt32 offset = mHead & (mCapacity - 1);
+            const Record* record = reinterpret_cast<const Record*>(mBuffer + offset);
+            if (record->mSize)
+            {
+               return record;
+            }
+            AtomicOps::store(mHead, mHead + mCapacity - offset);
+         }
+         return 0;
+      }
+
+      /// consumer; releases the record returned by front()
+      void pop(const Record* record)
+      {
+         AtomicOps::store(mHead, mHead + record->mSize);
+      }
+
+      UInt32 tail() const { return AtomicOps::load(mTail); }
+      bool empty() const { return mHead == AtomicOps::load(mTail); }
+
+   private:
+      char* mBuffer;
+      const UInt32 mCapacity;
+      volatile UInt32 mHead; // written by the consumer
+      volatile UInt32 mTail; // written by the producer
+
+   public:
+      volatile UInt32 mOrphaned; // set once the producer thread has exited
+      const ThreadIf::Id mThreadId;
+      Ring* mNext;
+};
+
+volatile UInt32 AsyncLogWriter::mActive = 0;
+volatile UInt32 AsyncLogWriter::mDropped = 0;
+volatile UInt32 AsyncLogWriter::mTruncated = 0;
+Log::AsyncOverflow AsyncLogWriter::mOverflow = Log::DropOnOverflow;
+unsigned int AsyncLogWriter::mBufferSize = 0;
+ThreadIf::TlsKey* AsyncLogWriter::mRingKey = 0;
+Mutex AsyncLogWriter::mRingsMutex;
+AsyncLogWriter::Ring* AsyncLogWriter::mRings = 0;
+Mutex AsyncLogWriter::mWakeMutex;
+Condition AsyncLogWriter::mWakeCondition;
+Mutex AsyncLogWriter::mControlMutex;
+AsyncLogWriter* AsyncLogWriter::mWriter = 0;
+
+void
+AsyncLogWriter::createKey()
+{
+   mRingKey = new ThreadIf::TlsKey;
+   ThreadIf::tlsKeyCreate(*mRingKey, releaseRing);
+}
+
+void
+AsyncLogWriter::deleteKey()
+{
+   ThreadIf::tlsKeyDelete(*mRingKey);
+   delete mRingKey;
+   mRingKey = 0;
+}
+
+void
+AsyncLogWriter::releaseRing(void* ring)
+{
+   // the writer frees it once it has been drained
+   AtomicOps::store(static_cast<Ring*>(ring)->mOrphaned, 1);
+}
+
+void
+AsyncLogWriter::push(Log::Level level,
+                     const Subsystem& subsystem,
+                     const char* file,
+                     int line,
+                     Log::ThreadData& logger,
+                     const char* message,
+                     unsigned int length)
+{
+   Ring* ring = static_cast<Ring*>(ThreadIf::tlsGetValue(*mRingKey));
+   if (ring == 0)
+   {
+      ring = new Ring(mBufferSize);
+      ThreadIf::tlsSetValue(*mRingKey, ring);
+      Lock lock(mRingsMutex);
+      ring->mNext = mRings;
+      mRings = ring;
+   }
+
+   Record record;
+   record.mLevel = level;
+   record.mLine = line;
+   Log::getTimeOfDay(record.mSec, record.mUsec);
+   record.mSubsystem = &subsystem;
+   record.mFile = file;
+   record.mLogger = &logger;
+
+   while (!ring->push(record, message, length))
+   {
+      if (mOverflow == Log::DropOnOverflow || !isActive())
+      {
+         AtomicOps::add(mDropped, 1);
+         return;
+      }
+      mWakeCondition.signal();
+      sleepMs(1);
+   }
+
+   if (ring->moreThanHalfFull())
+   {
+      mWakeCondition.signal();
+   }
+}
+
+void
+AsyncLogWriter::start(Log::AsyncOverflow overflow, unsigned int bufferSize)
+{
+   Lock lock(mControlMutex);
+   mOverflow = overflow;
+   if (mWriter)
+   {
+      return;
+   }
+
+   // round up to a power of two; rings already allocated keep their size
+   unsigned int size = 4096;
+   while (size < bufferSize && size < 0x40000000U)
+   {
+      size <<= 1;
+   }
+   mBufferSize = size;
+
+   mWriter = new AsyncLogWriter;
+   mWriter->run();
+   AtomicOps::store(mActive, 1);
+}
+
+void
+AsyncLogWriter::stop()
+{
+   Lock lock(mControlMutex);
+   if (!mWriter)
+   {
+      return;
+   }
+   // a record pushed while this runs may stay queued until the next start()
+   AtomicOps::store(mActive, 0);
+   mWriter->shutdown();
+   mWakeCondition.signal();
+   mWriter->join();
+   delete mWriter;
+   mWriter = 0;
+}
+
+void
+AsyncLogWriter::flush()
+{
+   Lock lock(mControlMutex);
+   if (mWriter)
+   {
+      // the second pass starts after this call, so drains everything
+      // queued before it
+      mWriter->waitForPasses(2);
+   }
+}
+
+AsyncLogWriter::AsyncLogWriter()
+   : mDroppedReported(AtomicOps::load(mDropped)),
+     mPasses(0)
+{
+}
+
+AsyncLogWriter::~AsyncLogWriter()
+{
+}
+
+void
+AsyncLogWriter::waitForPasses(unsigned int passes)
+{
+   Lock lock(mPassMutex);
+   const unsigned int target = mPasses + passes;
+   while (mPasses < target && !isShutdown())
+   {
+      mWakeCondition.signal();
+      mPassCondition.wait(mPassMutex, MaxWriteDelayMs);
+   }
+}
+
+void
+AsyncLogWriter::thread()
+{
+   while (!isShutdown())
+   {
+      if (!drain())
+      {
+         Lock lock(mWakeMutex);
+         mWakeCondition.wait(mWakeMutex, MaxWriteDelayMs);
+      }
+   }
+   drain();
+}
+
+void
+AsyncLogWriter::collectRings()
+{
+   mRingsScratch.clear();
+   Lock lock(mRingsMutex);
+   Ring** link = &mRings;
+   while (*link)
+   {
+      Ring* ring = *link;
+      if (AtomicOps::load(ring->mOrphaned) && ring->empty())
+      {
+         *link = ring->mNext;
+         delete ring;
+      }
+      else
+      {
+         mRingsScratch.push_back(ring);
+         link = &ring->mNext;
+      }
+   }
+}
+
+static bool
+olderThan(time_t sec, unsigned int usec, time_t otherSec, unsigned int otherUsec)
+{
+   return sec < otherSec || (sec == otherSec && usec < otherUsec);
+}
+
+bool
+AsyncLogWriter::drain()
+{
+   collectRings();
+
+   // only what was queued when the pass started, so a pass always ends
+   mHeads.resize(mRingsScratch.size());
+   mTails.resize(mRingsScratch.size());
+   for (size_t i = 0; i < mRingsScratch.size(); ++i)
+   {
+      mTails[i] = mRingsScratch[i]->tail();
+      mHeads[i] = mRingsScratch[i]->front(mTails[i]);
+   }
+
+   bool wrote = false;
+   {
+      Lock lock(Log::_mutex);
+
+      const UInt32 dropped = AtomicOps::load(mDropped);
+      if (dropped != mDroppedReported)
+      {
+         Data notice(Data(dropped - mDroppedReported) + " log records dropped: asynchronous log buffer full");
+         time_t sec;
+         unsigned int usec;
+         Log::getTimeOfDay(sec, usec);
+         write(Log::Warning, Subsystem::NONE, __FILE__, __LINE__, sec, usec, ThreadIf::selfId(),
+               Log::mDefaultLoggerData, notice.data(), (unsigned int)notice.size(), 0);
+         mDroppedReported = dropped;
+         wrote = true;
+      }
+
+      for (;;)
+      {
+         size_t oldest = mHeads.size();
+         for (size_t i = 0; i < mHeads.size(); ++i)
+         {
+            if (mHeads[i] &&
+                (oldest == mHeads.size() ||
+                 olderThan(mHeads[i]->mSec, mHeads[i]->mUsec, mHeads[oldest]->mSec, mHeads[oldest]->mUsec)))
+            {
+               oldest = i;
+            }
+         }
+         if (oldest == mHeads.size())
+         {
+            break;
+         }
+
+         const Record& record = *mHeads[oldest];
+         write(record.mLevel, *record.mSubsystem, record.mFile, record.mLine,
+               record.mSec, record.mUsec, mRingsScratch[oldest]->mThreadId,
+               *record.mLogger, record.message(), record.mLength, record.mTruncated);
+         mRingsScratch[oldest]->pop(mHeads[oldest]);
+         mHeads[oldest] = mRingsScratch[oldest]->front(mTails[oldest]);
+         wrote = true;
+      }
+
+      for (size_t i = 0; i < mWritten.size(); ++i)
+      {
+         mWritten[i]->flush();
+      }
+      mWritten.clear();
+   }
+
+   Lock lock(mPassMutex);
+   ++mPasses;
+   mPassCondition.broadcast();
+   return wrote;
+}
+
+void
+AsyncLogWriter::write(Log::Level level,
+                      const Subsystem& subsystem,
+                      const char* file,
+                      int line,
+                      time_t sec,
+                      unsigned int usec,
+                      ThreadIf::Id threadId,
+                      Log::ThreadData& logger,
+                      const char* message,
+                      unsigned int length,
+                      unsigned int truncated)
+{
+   const Log::Type type = logger.type();
+   Data::size_type headerLength = 0;
+   mLine.clear();
+   if (type != Log::OnlyExternalNoHeaders)
+   {
+      oDataStream strm(mLine);
+      Log::tags(level, subsystem, file, line, sec, usec, threadId, type, strm);
+      strm << Log::delim;
+      strm.flush();
+      headerLength = mLine.size();
+   }
+   mLine.append(message, length);
+   if (truncated)
+   {
+      AtomicOps::add(mTruncated, 1);
+      mLine += " ...[";
+      mLine += Data(truncated);
+      mLine += " bytes truncated]";
+   }
+
+   if (logger.mExternalLogger)
+   {
+      const Data rest(Data::Share, mLine.data() + headerLength, mLine.size() - headerLength);
+      if (!(*logger.mExternalLogger)(level, subsystem, Log::getAppName(), file, line, rest, mLine))
+      {
+         return;
+      }
+   }
+
+   switch (type)
+   {
+      case Log::OnlyExternal:
+      case Log::OnlyExternalNoHeaders:
+         return;
+      case Log::VSDebugWindow:
+         mLine += "\r\n";
+         Log::OutputToWin32DebugWindow(mLine);
+         return;
+      case Log::Syslog:
+      {
+         // endl is magic in syslog
+         std::ostream& out = logger.Instance((unsigned int)mLine.size() + 2);
+         out << level << mLine << std::endl;
+         return;
+      }
+      default:
+         logger.Instance((unsigned int)mLine.size() + 2) << mLine << '\n';
+         if (std::find(mWritten.begin(), mWritten.end(), &logger) == mWritten.end())
+         {
+            mWritten.push_back(&logger);
+         }
+         return;
+   }
+}
+
+/* ====================================================================
+ * The Vovida Software License, Version 1.0 
+ * 
+ * Copyright (c) 2000 Vovida Networks, Inc.  All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 
+ * 3. The names "VOCAL", "Vovida Open Communication Application Library",
+ *    and "Vovida Open Communication Application Library (VOCAL)" must
+ *    not be used to endorse or promote products derived from this
+ *    software without prior written permission. For written
+ *    permission, please contact vocal@vovida.org.
+ *
+ * 4. Products derived from this software may not be called "VOCAL", nor
+ *    may "VOCAL" appear in their name, without prior written
+ *    permission of Vovida Networks, Inc.
+ * 
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESSED OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE, TITLE AND
+ * NON-INFRINGEMENT ARE DISCLAIMED.  IN NO EVENT SHALL VOVIDA
+ * NETWORKS, INC. OR ITS CONTRIBUTORS BE LIABLE FOR ANY DIRECT DAMAGES
+ * IN EXCESS OF $1,000, NOR FOR ANY INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE
+ * USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+ * DAMAGE.
+ * 
+ * ====================================================================
+ * 
+ * This software consists of voluntary contributions made by Vovida
+ * Networks, Inc. and many individuals on behalf of Vovida Networks,
+ * Inc.  For more information on Vovida Networks, Inc., please see
+ * <http://www.vovida.org/>.
+ *
+ */
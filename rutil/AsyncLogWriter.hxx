@@ -0,0 +1,161 @@
+#if !defined(RESIP_ASYNCLOGWRITER_HXX)
+#define RESIP_ASYNCLOGWRITER_HXX
+
+#include <vector>
+
+#include "rutil/Log.hxx"
+#include "rutil/AtomicOps.hxx"
+#include "rutil/Condition.hxx"
+#include "rutil/Data.hxx"
+#include "rutil/Mutex.hxx"
+#include "rutil/ThreadIf.hxx"
+
+namespace resip
+{
+
+/**
+   @internal
+   @brief Writer thread behind Log's asynchronous mode; see Log::enableAsync().
+
+   Each thread that logs gets its own single-producer ring buffer. Log::Guard
+   appends the message text, together with the level, subsystem, file, line,
+   time and destination logger, as one binary record, without taking a lock.
+   The writer thread merges the rings in timestamp order, formats the
+   headers, calls any ExternalLogger and writes to the logger's stream, file
+   rotation included. Streams are flushed once per pass rather than per line.
+*/
+class AsyncLogWriter : public ThreadIf
+{
+   public:
+      static bool isActive()
+      {
+         return AtomicOps::load(mActive) != 0;
+      }
+
+      /// Called by Log::Guard on the logging thread.
+      static void push(Log::Level level,
+                       const Subsystem& subsystem,
+                       const char* file,
+                       int line,
+                       Log::ThreadData& logger,
+                       const char* message,
+                       unsigned int length);
+
+      static void start(Log::AsyncOverflow overflow, unsigned int bufferSize);
+      static void stop();
+      static void flush();
+      static unsigned int droppedCount() { return AtomicOps::load(mDropped); }
+      static unsigned int truncatedCount() { return AtomicOps::load(mTruncated); }
+
+      /// Called by LogStaticInitializer.
+      static void createKey();
+      static void deleteKey();
+
+      virtual void thread();
+
+   private:
+      AsyncLogWriter();
+      virtual ~AsyncLogWriter();
+
+      class Ring;
+      struct Record;
+
+      /// @return true if anything was written
+      bool drain();
+      void write(Log::Level level,
+                 const Subsystem& subsystem,
+                 const char* file,
+                 int line,
+                 time_t sec,
+                 unsigned int usec,
+                 ThreadIf::Id threadId,
+                 Log::ThreadData& logger,
+                 const char* message,
+                 unsigned int length,
+                 unsigned int truncated);
+      void collectRings();
+      void waitForPasses(unsigned int passes);
+
+      static void releaseRing(void* ring);
+
+      std::vector<Ring*> mRingsScratch;
+      std::vector<const Record*> mHeads;
+      std::vector<UInt32> mTails;
+      std::vector<Log::ThreadData*> mWritten;
+      Data mLine;
+      UInt32 mDroppedReported;
+
+      Mutex mPassMutex;
+      Condition mPassCondition;
+      unsigned int mPasses;
+
+      // Rings are never freed while their thread is alive, so producers
+      // touch none of the writer's state except through these statics.
+      static volatile UInt32 mActive;
+      static volatile UInt32 mDropped;
+      static volatile UInt32 mTruncated;
+      static Log::AsyncOverflow mOverflow;
+      static unsigned int mBufferSize;
+      static ThreadIf::TlsKey* mRingKey;
+      static Mutex mRingsMutex;
+      static Ring* mRings;
+      static Mutex mWakeMutex;
+      static Condition mWakeCondition;
+
+      static Mutex mControlMutex;
+      static AsyncLogWriter* mWriter;
+};
+
+}
+
+#endif
+
+/* ====================================================================
+ * The Vovida Software License, Version 1.0 
+ * 
+ * Copyright (c) 2000 Vovida Networks, Inc.  All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 
+ * 3. The names "VOCAL", "Vovida Open Communication Application Library",
+ *    and "Vovida Open Communication Application Library (VOCAL)" must
+ *    not be used to endorse or promote products derived from this
+ *    software without prior written permission. For written
+ *    permission, please contact vocal@vovida.org.
+ *
+ * 4. Products derived from this software may not be called "VOCAL", nor
+ *    may "VOCAL" appear in their name, without prior written
+ *    permission of Vovida Networks, Inc.
+ * 
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESSED OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE, TITLE AND
+ * NON-INFRINGEMENT ARE DISCLAIMED.  IN NO EVENT SHALL VOVIDA
+ * NETWORKS, INC. OR ITS CONTRIBUTORS BE LIABLE FOR ANY DIRECT DAMAGES
+ * IN EXCESS OF $1,000, NOR FOR ANY INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE
+ * USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+ * DAMAGE.
+ * 
+ * ====================================================================
+ * 
+ * This software consists of voluntary contributions made by Vovida
+ * Networks, Inc. and many individuals on behalf of Vovida Networks,
+ * Inc.  For more information on Vovida Networks, Inc., please see
+ * <http://www.vovida.org/>.
+ *
+ */
@@ -1,26 +1,17 @@
-#if !defined(RESIP_HEADERHASH_HXX)
-#define RESIP_HEADERHASH_HXX
+#include "rutil/AtomicOps.hxx"
 
-#include "rutil/compat.hxx"
+#if !defined(RESIP_HAVE_ATOMIC_OPS)
 
-namespace resip 
-{
-
-struct headers { char *name; Headers::Type type; };
-/* maximum key range = 494, duplicates = 0 */
+static resip::Mutex atomicOpsMutex;
 
-class HeaderHash
+resip::Mutex&
+resip::AtomicOps::fallbackMutex()
 {
-private:
-  static inline unsigned int hash (const char *str, GPERF_SIZE_TYPE len);
-public:
-  static const struct headers *in_word_set (const char *str, GPERF_SIZE_TYPE len);
-};
-// NOTE the cxx file for this class is AUTO GENERATED. DO NOT EDIT IT.
-// This file should match it. BUT THIS FILE IS MANUALLY GENERATED.
+   return atomicOpsMutex;
 }
 
 #endif
+
 /* ====================================================================
  * The Vovida Software License, Version 1.0 
  * 
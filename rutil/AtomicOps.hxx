@@ -0,0 +1,350 @@
+#if !defined(RESIP_ATOMICOPS_HXX)
+#define RESIP_ATOMICOPS_HXX
+
+#include "rutil/compat.hxx"
+
+#if defined(__GNUC__) || defined(WIN32)
+#define RESIP_HAVE_ATOMIC_OPS
+#else
+#include "rutil/Mutex.hxx"
+#include "rutil/Lock.hxx"
+#endif
+
+namespace resip
+{
+
+/**
+   @brief Minimal set of atomic operations on 32 bit counters, 64 bit
+   values that are only loaded and stored (like timestamps), and pointers.
+
+   Loads have acquire semantics (except loadRelaxed()), stores release
+   semantics, and the read-modify-write operations are full barriers. Only
+   what the lock-free fifo and the logger need is provided; anything more
+   elaborate should use a Mutex.
+   On compilers not covered here RESIP_HAVE_ATOMIC_OPS is left undefined and
+   every operation takes a single global Mutex instead; correct, but no
+   longer lock-free.
+*/
+namespace AtomicOps
+{
+
+#if defined(__GNUC__) && defined(__ATOMIC_ACQUIRE)
+
+/// @return the new value
+inline UInt32 add(volatile UInt32& value, UInt32 n)
+{
+   return __atomic_add_fetch(&value, n, __ATOMIC_SEQ_CST);
+}
+
+/// @return the new value
+inline UInt32 sub(volatile UInt32& value, UInt32 n)
+{
+   return __atomic_sub_fetch(&value, n, __ATOMIC_SEQ_CST);
+}
+
+inline UInt32 load(const volatile UInt32& value)
+{
+   return __atomic_load_n(&value, __ATOMIC_ACQUIRE);
+}
+
+/// no ordering; for values that are only compared, like generation counts
+inline UInt32 loadRelaxed(const volatile UInt32& value)
+{
+   return __atomic_load_n(&value, __ATOMIC_RELAXED);
+}
+
+inline void store(volatile UInt32& value, UInt32 n)
+{
+   __atomic_store_n(&value, n, __ATOMIC_RELEASE);
+}
+
+inline UInt64 load(const volatile UInt64& value)
+{
+   return __atomic_load_n(&value, __ATOMIC_ACQUIRE);
+}
+
+inline void store(volatile UInt64& value, UInt64 n)
+{
+   __atomic_store_n(&value, n, __ATOMIC_RELEASE);
+}
+
+/// @return the previous value
+template <class T>
+inline T* exchangePtr(T* volatile& ptr, T* newValue)
+{
+   return __atomic_exchange_n(&ptr, newValue, __ATOMIC_SEQ_CST);
+}
+
+template <class T>
+inline T* loadPtr(T* const volatile& ptr)
+{
+   return __atomic_load_n(&ptr, __ATOMIC_ACQUIRE);
+}
+
+template <class T>
+inline void storePtr(T* volatile& ptr, T* newValue)
+{
+   __atomic_store_n(&ptr, newValue, __ATOMIC_RELEASE);
+}
+
+#elif defined(__GNUC__)
+
+// gcc < 4.7; the __sync builtins are all full barriers
+
+inline UInt32 add(volatile UInt32& value, UInt32 n)
+{
+   return __sync_add_and_fetch(&value, n);
+}
+
+inline UInt32 sub(volatile UInt32& value, UInt32 n)
+{
+   return __sync_sub_and_fetch(&value, n);
+}
+
+inline UInt32 load(const volatile UInt32& value)
+{
+   UInt32 result = value;
+   __sync_synchronize();
+   return result;
+}
+
+inline UInt32 loadRelaxed(const volatile UInt32& value)
+{
+   return value;
+}
+
+inline void store(volatile UInt32& value, UInt32 n)
+{
+   __sync_synchronize();
+   value = n;
+}
+
+// a plain 64 bit access may be split in two on 32 bit targets
+inline UInt64 load(const volatile UInt64& value)
+{
+   return __sync_val_compare_and_swap(const_cast<volatile UInt64*>(&value), UInt64(0), UInt64(0));
+}
+
+inline void store(volatile UInt64& value, UInt64 n)
+{
+   UInt64 old = value;
+   UInt64 seen;
+   while ((seen = __sync_val_compare_and_swap(&value, old, n)) != old)
+   {
+      old = seen;
+   }
+}
+
+template <class T>
+inline T* exchangePtr(T* volatile& ptr, T* newValue)
+{
+   T* old = ptr;
+   T* seen;
+   while ((seen = __sync_val_compare_and_swap(&ptr, old, newValue)) != old)
+   {
+      old = seen;
+   }
+   return old;
+}
+
+template <class T>
+inline T* loadPtr(T* const volatile& ptr)
+{
+   T* result = ptr;
+   __sync_synchronize();
+   return result;
+}
+
+template <class T>
+inline void storePtr(T* volatile& ptr, T* newValue)
+{
+   __sync_synchronize();
+   ptr = newValue;
+}
+
+#elif defined(WIN32)
+
+inline UInt32 add(volatile UInt32& value, UInt32 n)
+{
+   return (UInt32)InterlockedExchangeAdd((volatile LONG*)&value, (LONG)n) + n;
+}
+
+inline UInt32 sub(volatile UInt32& value, UInt32 n)
+{
+   return (UInt32)InterlockedExchangeAdd((volatile LONG*)&value, -(LONG)n) - n;
+}
+
+inline UInt32 load(const volatile UInt32& value)
+{
+   UInt32 result = value;
+   MemoryBarrier();
+   return result;
+}
+
+inline UInt32 loadRelaxed(const volatile UInt32& value)
+{
+   return value;
+}
+
+inline void store(volatile UInt32& value, UInt32 n)
+{
+   MemoryBarrier();
+   value = n;
+}
+
+inline UInt64 load(const volatile UInt64& value)
+{
+   return (UInt64)InterlockedCompareExchange64((volatile LONGLONG*)&value, 0, 0);
+}
+
+inline void store(volatile UInt64& value, UInt64 n)
+{
+   InterlockedExchange64((volatile LONGLONG*)&value, (LONGLONG)n);
+}
+
+template <class T>
+inline T* exchangePtr(T* volatile& ptr, T* newValue)
+{
+   return (T*)InterlockedExchangePointer((PVOID volatile*)&ptr, (PVOID)newValue);
+}
+
+template <class T>
+inline T* loadPtr(T* const volatile& ptr)
+{
+   T* result = ptr;
+   MemoryBarrier();
+   return result;
+}
+
+template <class T>
+inline void storePtr(T* volatile& ptr, T* newValue)
+{
+   MemoryBarrier();
+   ptr = newValue;
+}
+
+#else
+
+Mutex& fallbackMutex();
+
+inline UInt32 add(volatile UInt32& value, UInt32 n)
+{
+   Lock lock(fallbackMutex()); (void)lock;
+   return value += n;
+}
+
+inline UInt32 sub(volatile UInt32& value, UInt32 n)
+{
+   Lock lock(fallbackMutex()); (void)lock;
+   return value -= n;
+}
+
+inline UInt32 load(const volatile UInt32& value)
+{
+   Lock lock(fallbackMutex()); (void)lock;
+   return value;
+}
+
+inline UInt32 loadRelaxed(const volatile UInt32& value)
+{
+   return load(value);
+}
+
+inline void store(volatile UInt32& value, UInt32 n)
+{
+   Lock lock(fallbackMutex()); (void)lock;
+   value = n;
+}
+
+inline UInt64 load(const volatile UInt64& value)
+{
+   Lock lock(fallbackMutex()); (void)lock;
+   return value;
+}
+
+inline void store(volatile UInt64& value, UInt64 n)
+{
+   Lock lock(fallbackMutex()); (void)lock;
+   value = n;
+}
+
+template <class T>
+inline T* exchangePtr(T* volatile& ptr, T* newValue)
+{
+   Lock lock(fallbackMutex()); (void)lock;
+   T* old = ptr;
+   ptr = newValue;
+   return old;
+}
+
+template <class T>
+inline T* loadPtr(T* const volatile& ptr)
+{
+   Lock lock(fallbackMutex()); (void)lock;
+   return ptr;
+}
+
+template <class T>
+inline void storePtr(T* volatile& ptr, T* newValue)
+{
+   Lock lock(fallbackMutex()); (void)lock;
+   ptr = newValue;
+}
+
+#endif
+
+}
+
+}
+
+#endif
+
+/* ====================================================================
+ * The Vovida Software License, Version 1.0 
+ * 
+ * Copyright (c) 2000 Vovida Networks, Inc.  All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 
+ * 3. The names "VOCAL", "Vovida Open Communication Application Library",
+ *    and "Vovida Open Communication Application Library (VOCAL)" must
+ *    not be used to endorse or promote products derived from this
+ *    software without prior written permission. For written
+ *    permission, please contact vocal@vovida.org.
+ *
+ * 4. Products derived from this software may not be called "VOCAL", nor
+ *    may "VOCAL" appear in their name, without prior written
+ *    permission of Vovida Networks, Inc.
+ * 
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESSED OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE, TITLE AND
+ * NON-INFRINGEMENT ARE DISCLAIMED.  IN NO EVENT SHALL VOVIDA
+ * NETWORKS, INC. OR ITS CONTRIBUTORS BE LIABLE FOR ANY DIRECT DAMAGES
+ * IN EXCESS OF $1,000, NOR FOR ANY INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE
+ * USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+ * DAMAGE.
+ * 
+ * ====================================================================
+ * 
+ * This software consists of voluntary contributions made by Vovida
+ * Networks, Inc. and many individuals on behalf of Vovida Networks,
+ * Inc.  For more information on Vovida Networks, Inc., please see
+ * <http://www.vovida.org/>.
+ *
+ */
@@ -15,13 +15,27 @@ namespace resip
    allocation will be performed, and fallback to the system new/delete will be 
    used (deallocating a pool allocated object will _not_ free up room in the 
    pool; the memory will be freed when the DinkyPool goes away).
+
+   If setArenaLimit() has been called, allocations that do not fit in the S 
+   bytes are instead carved out of heap blocks of growing size (an arena), up 
+   to the given total; the blocks are freed in one go when the DinkyPool goes 
+   away. Since deallocation does not free up room in the arena either, this 
+   is only a good idea for objects that are not modified much once built.
 */
 template<unsigned int S>
 class DinkyPool : public PoolBase
 {
    public:
-      DinkyPool() : count(0), heapBytes(0) {}
-      ~DinkyPool(){}
+      DinkyPool() : count(0), heapBytes(0), mArenaLimit(0), mArenaBytes(0), mArenaHead(0) {}
+      ~DinkyPool()
+      {
+         while(mArenaHead)
+         {
+            ArenaBlock* next=mArenaHead->next;
+            ::operator delete(mArenaHead);
+            mArenaHead=next;
+         }
+      }
 
       void* allocate(size_t size)
       {
@@ -31,6 +45,14 @@ class DinkyPool : public PoolBase
             count+=(size+7)/8;
             return result;
          }
+         if(mArenaLimit)
+         {
+            void* result=allocateFromArena(size);
+            if(result)
+            {
+               return result;
+            }
+         }
          heapBytes += size;
          return ::operator new(size);
       }
@@ -41,6 +63,13 @@ class DinkyPool : public PoolBase
          {
             return;
          }
+         for(ArenaBlock* block=mArenaHead; block; block=block->next)
+         {
+            if(ptr >= (void*)block->data() && ptr < (void*)(block->data()+block->size))
+            {
+               return;
+            }
+         }
          ::operator delete(ptr);
       }
 
@@ -49,18 +78,64 @@ class DinkyPool : public PoolBase
          return std::numeric_limits<size_t>::max();
       }
 
+      /**
+         Enables the arena, which may grow to maxBytes in total (0 disables 
+         it again for future allocations). The first block is the size of 
+         the built-in buffer, each one after that twice the previous.
+      */
+      void setArenaLimit(size_t maxBytes) { mArenaLimit=maxBytes; }
+
       size_t getHeapBytes() const { return heapBytes; }
       size_t getPoolBytes() const { return count*8; }
       size_t getPoolSizeBytes() const { return sizeof(mBuf); }
+      size_t getArenaBytes() const { return mArenaBytes; }
 
    private:
       // disabled
       DinkyPool& operator=(const DinkyPool& rhs);
       DinkyPool(const DinkyPool& other);
 
+      struct ArenaBlock
+      {
+         ArenaBlock* next;
+         size_t size;
+         size_t used;
+         // data starts at the first 8-byte boundary after the header
+         char* data() { return reinterpret_cast<char*>(this)+((sizeof(ArenaBlock)+7)&~size_t(7)); }
+      };
+
+      void* allocateFromArena(size_t size)
+      {
+         size=(size+7)&~size_t(7);
+         if(!mArenaHead || mArenaHead->used+size > mArenaHead->size)
+         {
+            size_t blockSize=mArenaHead ? 2*mArenaHead->size : ((S+7)&~7U);
+            if(blockSize < size)
+            {
+               blockSize=size;
+            }
+            if(mArenaBytes+blockSize > mArenaLimit)
+            {
+               return 0;
+            }
+            ArenaBlock* block=static_cast<ArenaBlock*>(::operator new(((sizeof(ArenaBlock)+7)&~size_t(7))+blockSize));
+            block->next=mArenaHead;
+            block->size=blockSize;
+            block->used=0;
+            mArenaHead=block;
+            mArenaBytes+=blockSize;
+         }
+         void* result=mArenaHead->data()+mArenaHead->used;
+         mArenaHead->used+=size;
+         return result;
+      }
+
       size_t count; // 8-byte chunks alloced so far
       char mBuf[(S+7)/8][8]; // 8-byte chunks for alignment
       size_t heapBytes;
+      size_t mArenaLimit;
+      size_t mArenaBytes;
+      ArenaBlock* mArenaHead; // most recent (and largest) block first
 };
 
 }
@@ -146,7 +146,8 @@ class DnsUtil
        */
       static Data canonicalizeIpV6Address(const Data& ipV6Address);
 
-      /// Used to synchronously query A records - only for test code usage
+      /// Used to synchronously query A records - only for test code usage.
+      /// Anything that resolves at runtime should use DnsStub::lookupHost.
       static std::list<Data> lookupARecords(const Data& host);
 
 };
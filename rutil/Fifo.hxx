@@ -23,6 +23,7 @@ class Fifo : public AbstractFifo<Msg*>
       using AbstractFifo<Msg*>::mCondition;
       using AbstractFifo<Msg*>::empty;
       using AbstractFifo<Msg*>::size;
+      using AbstractFifo<Msg*>::setLockFree;
 
       /// Add a message to the fifo.
       size_t add(Msg* msg);
@@ -88,6 +89,17 @@ template <class Msg>
 void
 Fifo<Msg>::clear()
 {
+   if (this->isLockFree())
+   {
+      // only safe from the consumer thread
+      Msg* msg(0);
+      while (AbstractFifo<Msg*>::getNext(RESIP_FIFO_NOWAIT, msg))
+      {
+         delete msg;
+      }
+      return;
+   }
+
    Lock lock(mMutex); (void)lock;
    while ( ! mFifo.empty() )
    {
@@ -1,26 +1,98 @@
-#if !defined(RESIP_METHODSHASH_HXX)
-#define RESIP_METHODSHASH_HXX
+#include "rutil/LatencyHistogram.hxx"
 
-#include "rutil/compat.hxx"
+using namespace resip;
 
-namespace resip 
+LatencyHistogram::LatencyHistogram()
 {
+   for (unsigned int i = 0; i < BucketCount; ++i)
+   {
+      mCounts[i] = 0;
+   }
+}
+
+void
+LatencyHistogram::reset()
+{
+   for (unsigned int i = 0; i < BucketCount; ++i)
+   {
+      AtomicOps::store(mCounts[i], 0);
+   }
+}
 
-struct methods { char *name; MethodTypes type; };
-/* maximum key range = 494, duplicates = 0 */
+void
+LatencyHistogram::snapshot(Snapshot& snap) const
+{
+   snap.mTotal = 0;
+   for (unsigned int i = 0; i < BucketCount; ++i)
+   {
+      snap.mCounts[i] = AtomicOps::load(mCounts[i]);
+      snap.mTotal += snap.mCounts[i];
+   }
+}
+
+UInt64
+LatencyHistogram::highestEquivalentValue(unsigned int bucket)
+{
+   if (bucket < SubBucketCount)
+   {
+      return bucket;
+   }
+   const unsigned int magnitude = bucket / SubBucketCount + SubBucketBits - 1;
+   const unsigned int shift = magnitude - SubBucketBits;
+   const UInt64 lowest = UInt64(SubBucketCount + bucket % SubBucketCount) << shift;
+   return lowest + (UInt64(1) << shift) - 1;
+}
+
+LatencyHistogram::Snapshot::Snapshot()
+   : mTotal(0)
+{
+   for (unsigned int i = 0; i < BucketCount; ++i)
+   {
+      mCounts[i] = 0;
+   }
+}
+
+UInt64
+LatencyHistogram::Snapshot::percentile(double p) const
+{
+   if (mTotal == 0)
+   {
+      return 0;
+   }
+   if (p > 100.0)
+   {
+      p = 100.0;
+   }
+   UInt64 rank = (UInt64)((p / 100.0) * mTotal + 0.5);
+   if (rank == 0)
+   {
+      rank = 1;
+   }
+   UInt64 seen = 0;
+   for (unsigned int i = 0; i < BucketCount; ++i)
+   {
+      seen += mCounts[i];
+      if (seen >= rank)
+      {
+         return highestEquivalentValue(i);
+      }
+   }
+   return max();
+}
 
-class MethodHash
+UInt64
+LatencyHistogram::Snapshot::max() const
 {
-private:
-  static inline unsigned int hash (const char *str, GPERF_SIZE_TYPE len);
-public:
-  static const struct methods *in_word_set (const char *str, GPERF_SIZE_TYPE len);
-};
-// NOTE the cxx file for this class is AUTO GENERATED. DO NOT EDIT IT.
-// This file should match it. BUT THIS FILE IS MANUALLY GENERATED.
+   for (unsigned int i = BucketCount; i > 0; --i)
+   {
+      if (mCounts[i - 1])
+      {
+         return highestEquivalentValue(i - 1);
+      }
+   }
+   return 0;
 }
 
-#endif
 /* ====================================================================
  * The Vovida Software License, Version 1.0 
  * 
@@ -0,0 +1,157 @@
+#if !defined(RESIP_LATENCYHISTOGRAM_HXX)
+#define RESIP_LATENCYHISTOGRAM_HXX
+
+#include "rutil/compat.hxx"
+#include "rutil/AtomicOps.hxx"
+
+namespace resip
+{
+
+/**
+   @brief A lock-free histogram of durations (or any non-negative value),
+   bucketed log-linearly in the manner of HdrHistogram.
+
+   Values below 16 have a bucket each; above that, every power of two is
+   split into 16 buckets, so a value is reported to within 1/16 (6.25%) of
+   itself. Values of 2^32 and above are counted in the last bucket. In
+   microseconds that spans about 71 minutes, at a cost of 464 counters.
+
+   record() is a single atomic increment and may be called from any number
+   of threads. Readers take a Snapshot, which may miss values recorded
+   while it is being copied but is otherwise consistent.
+*/
+class LatencyHistogram
+{
+   public:
+      enum
+      {
+         SubBucketBits = 4,
+         SubBucketCount = 1 << SubBucketBits,
+         MaxValueBits = 32,
+         BucketCount = SubBucketCount * (MaxValueBits - SubBucketBits + 1)
+      };
+
+      LatencyHistogram();
+
+      void record(UInt64 value)
+      {
+         AtomicOps::add(mCounts[bucketOf(value)], 1);
+      }
+
+      /// Not synchronized with record(); values recorded during a reset may
+      /// survive it.
+      void reset();
+
+      class Snapshot
+      {
+         public:
+            Snapshot();
+
+            UInt64 getCount() const { return mTotal; }
+            /// @return the highest value equivalent to the value at
+            /// percentile (0-100) p, or 0 if nothing was recorded
+            UInt64 percentile(double p) const;
+            UInt64 max() const;
+
+         private:
+            friend class LatencyHistogram;
+            UInt32 mCounts[BucketCount];
+            UInt64 mTotal;
+      };
+
+      void snapshot(Snapshot& snap) const;
+
+      static unsigned int bucketOf(UInt64 value)
+      {
+         if (value < SubBucketCount)
+         {
+            return (unsigned int)value;
+         }
+         if (value >> MaxValueBits)
+         {
+            return BucketCount - 1;
+         }
+         const unsigned int magnitude = highestBit((UInt32)value);
+         const unsigned int shift = magnitude - SubBucketBits;
+         return SubBucketCount * (magnitude - SubBucketBits + 1) +
+            (unsigned int)(value >> shift) - SubBucketCount;
+      }
+
+      /// @return the largest value that lands in bucket
+      static UInt64 highestEquivalentValue(unsigned int bucket);
+
+   private:
+      static unsigned int highestBit(UInt32 value)
+      {
+#if defined(__GNUC__)
+         return 31 - __builtin_clz(value);
+#else
+         unsigned int bit = 0;
+         while (value >>= 1)
+         {
+            ++bit;
+         }
+         return bit;
+#endif
+      }
+
+      volatile UInt32 mCounts[BucketCount];
+
+      // no value semantics
+      LatencyHistogram(const LatencyHistogram&);
+      LatencyHistogram& operator=(const LatencyHistogram&);
+};
+
+}
+
+#endif
+
+/* ====================================================================
+ * The Vovida Software License, Version 1.0 
+ * 
+ * Copyright (c) 2000 Vovida Networks, Inc.  All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 
+ * 3. The names "VOCAL", "Vovida Open Communication Application Library",
+ *    and "Vovida Open Communication Application Library (VOCAL)" must
+ *    not be used to endorse or promote products derived from this
+ *    software without prior written permission. For written
+ *    permission, please contact vocal@vovida.org.
+ *
+ * 4. Products derived from this software may not be called "VOCAL", nor
+ *    may "VOCAL" appear in their name, without prior written
+ *    permission of Vovida Networks, Inc.
+ * 
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESSED OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE, TITLE AND
+ * NON-INFRINGEMENT ARE DISCLAIMED.  IN NO EVENT SHALL VOVIDA
+ * NETWORKS, INC. OR ITS CONTRIBUTORS BE LIABLE FOR ANY DIRECT DAMAGES
+ * IN EXCESS OF $1,000, NOR FOR ANY INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE
+ * USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+ * DAMAGE.
+ * 
+ * ====================================================================
+ * 
+ * This software consists of voluntary contributions made by Vovida
+ * Networks, Inc. and many individuals on behalf of Vovida Networks,
+ * Inc.  For more information on Vovida Networks, Inc., please see
+ * <http://www.vovida.org/>.
+ *
+ */
@@ -15,6 +15,7 @@
 
 #include "rutil/Log.hxx"
 #include "rutil/Logger.hxx"
+#include "rutil/AsyncLogWriter.hxx"
 #include "rutil/ParseBuffer.hxx"
 #include "rutil/ThreadIf.hxx"
 #include "rutil/Subsystem.hxx"
@@ -44,6 +45,8 @@ pid_t Log::mPid=0;
 #endif
 
 volatile short Log::touchCount = 0;
+volatile UInt32 Log::mLevelGeneration = 1;
+volatile UInt32 Log::mMaxLoggerLevel = (UInt32)Log::Info;
 
 
 /// DEPRECATED! Left for backward compatibility - use localLoggers instead
@@ -95,6 +98,8 @@ LogStaticInitializer::LogStaticInitializer()
 
          Log::mLocalLoggerKey = new ThreadIf::TlsKey;
          ThreadIf::tlsKeyCreate(*Log::mLocalLoggerKey, freeLocalLogger);
+
+         AsyncLogWriter::createKey();
    }
 }
 LogStaticInitializer::~LogStaticInitializer()
@@ -108,6 +113,8 @@ LogStaticInitializer::~LogStaticInitializer()
 
       ThreadIf::tlsKeyDelete(*Log::mLocalLoggerKey);
       delete Log::mLocalLoggerKey;
+
+      AsyncLogWriter::deleteKey();
    }
 }
 
@@ -241,6 +248,7 @@ Log::initialize(Type type, Level level, const Data& appName,
    mDefaultLoggerData.reset();   
    
    mDefaultLoggerData.set(type, level, logFileName, externalLogger);
+   levelsChanged();
 
    ParseBuffer pb(appName);
    pb.skipToEnd();
@@ -297,6 +305,7 @@ Log::setLevel(Level level)
 {
    Lock lock(_mutex);
    getLoggerData().mLevel = level; 
+   levelsChanged();
 }
 
 void
@@ -306,6 +315,23 @@ Log::setLevel(Level level, Subsystem& s)
    s.setLevel(level); 
 }
 
+void
+Log::levelsChanged()
+{
+   Level level = mLocalLoggerMap.maxLevel();
+   if (mDefaultLoggerData.mLevel > level)
+   {
+      level = mDefaultLoggerData.mLevel;
+   }
+   AtomicOps::store(mMaxLoggerLevel, (UInt32)level);
+
+   // 0 in the low 24 bits would match a Subsystem's never filled cache
+   if ((AtomicOps::add(mLevelGeneration, 1) & 0xFFFFFF) == 0)
+   {
+      AtomicOps::add(mLevelGeneration, 1);
+   }
+}
+
 void
 Log::setLevel(Level level, Log::LocalLoggerId loggerId)
 {
@@ -320,12 +346,14 @@ Log::setLevel(Level level, Log::LocalLoggerId loggerId)
          // We don't need local logger instance anymore.
          mLocalLoggerMap.decreaseUseCount(loggerId);
          pData = NULL;
+         levelsChanged();
       }
    }
    else
    {
       Lock lock(_mutex);
       mDefaultLoggerData.mLevel = level;
+      levelsChanged();
    }
 }
 
@@ -495,15 +523,34 @@ Log::tags(Log::Level level,
           const char* pfile,
           int line,
           EncodeStream& strm)
+{
+   time_t sec;
+   unsigned int usec;
+   getTimeOfDay(sec, usec);
+   return tags(level, subsystem, pfile, line, sec, usec, ThreadIf::selfId(),
+               getLoggerData().type(), strm);
+}
+
+EncodeStream &
+Log::tags(Log::Level level,
+          const Subsystem& subsystem,
+          const char* pfile,
+          int line,
+          time_t sec,
+          unsigned int usec,
+          ThreadIf::Id threadId,
+          Type type,
+          EncodeStream& strm)
 {
    char buffer[256];
-   Data ts(Data::Borrow, buffer, sizeof(buffer));
+   buffer[0] = 0;
+   Data ts(Data::Borrow, buffer, 0, sizeof(buffer));
 #if defined( __APPLE__ )
   strm << mDescriptions[level+1] << Log::delim
-        << timestamp(ts) << Log::delim  
+        << timestamp(ts, sec, usec) << Log::delim  
         << mAppName << Log::delim
         << subsystem << Log::delim 
-        << pthread_self() << Log::delim
+        << threadId << Log::delim
         << pfile << ":" << line;
 #elif defined( WIN32 )
    const char* file = pfile + strlen(pfile);
@@ -517,13 +564,13 @@ Log::tags(Log::Level level,
       ++file;
    }
    strm << mDescriptions[level+1] << Log::delim
-        << timestamp(ts) << Log::delim  
+        << timestamp(ts, sec, usec) << Log::delim  
         << mAppName << Log::delim
         << subsystem << Log::delim 
-        << GetCurrentThreadId() << Log::delim
+        << threadId << Log::delim
         << file << ":" << line;
 #else // #if defined( WIN32 ) || defined( __APPLE__ )
-   if(resip::Log::getLoggerData().type() == Syslog)
+   if(type == Syslog)
    {
       strm // << mDescriptions[level+1] << Log::delim
    //        << timestamp(ts) << Log::delim
@@ -531,17 +578,17 @@ Log::tags(Log::Level level,
    //        << mAppName << Log::delim
            << subsystem << Log::delim
    //        << mPid << Log::delim
-           << pthread_self() << Log::delim
+           << threadId << Log::delim
            << pfile << ":" << line;
    }
    else
       strm << mDescriptions[level+1] << Log::delim
-           << timestamp(ts) << Log::delim  
+           << timestamp(ts, sec, usec) << Log::delim  
    //        << mHostname << Log::delim  
            << mAppName << Log::delim
            << subsystem << Log::delim 
    //        << mPid << Log::delim
-           << pthread_self() << Log::delim
+           << threadId << Log::delim
            << pfile << ":" << line;
 #endif
    return strm;
@@ -551,43 +598,64 @@ Data
 Log::timestamp()
 {
    char buffer[256];
-   Data result(Data::Borrow, buffer, sizeof(buffer));
+   buffer[0] = 0;
+   Data result(Data::Borrow, buffer, 0, sizeof(buffer));
    return timestamp(result);
 }
 
 Data&
 Log::timestamp(Data& res) 
 {
-   char* datebuf = const_cast<char*>(res.data());
-   const unsigned int datebufSize = 256;
-   res.clear();
-   
+   time_t sec;
+   unsigned int usec;
+   getTimeOfDay(sec, usec);
+   return timestamp(res, sec, usec);
+}
+
+void
+Log::getTimeOfDay(time_t& sec, unsigned int& usec)
+{
 #ifdef WIN32 
-   int result = 1; 
    SYSTEMTIME systemTime;
-   struct { time_t tv_sec; int tv_usec; } tv = {0,0};
-   time(&tv.tv_sec);
+   time(&sec);
    GetLocalTime(&systemTime);
-   tv.tv_usec = systemTime.wMilliseconds * 1000; 
+   usec = systemTime.wMilliseconds * 1000; 
 #else 
-   struct tm localTimeResult;
    struct timeval tv; 
-   int result = gettimeofday (&tv, NULL);
-#endif   
-
-   if (result == -1)
+   if (gettimeofday (&tv, NULL) == -1)
    {
       /* If we can't get the time of day, don't print a timestamp.
          Under Unix, this will never happen:  gettimeofday can fail only
          if the timezone is invalid which it can't be, since it is
          uninitialized]or if tv or tz are invalid pointers. */
+      sec = (time_t)-1;
+      usec = 0;
+      return;
+   }
+   sec = (time_t) tv.tv_sec;
+   usec = (unsigned int) tv.tv_usec;
+#endif   
+}
+
+Data&
+Log::timestamp(Data& res, time_t sec, unsigned int usec) 
+{
+   char* datebuf = const_cast<char*>(res.data());
+   const unsigned int datebufSize = 256;
+   res.clear();
+   
+   if (sec == (time_t)-1)
+   {
       datebuf [0] = 0;
    }
    else
    {
-      /* The tv_sec field represents the number of seconds passed since
-         the Epoch, which is exactly the argument gettimeofday needs. */
-      const time_t timeInSeconds = (time_t) tv.tv_sec;
+      /* sec is the number of seconds passed since the Epoch, which is
+         exactly the argument localtime needs. */
+      const time_t timeInSeconds = sec;
+#ifndef WIN32
+      struct tm localTimeResult;
+#endif
       strftime (datebuf,
                 datebufSize,
                 "%Y%m%d-%H%M%S", /* guaranteed to fit in 256 chars,
@@ -602,7 +670,7 @@ Log::timestamp(Data& res)
    char msbuf[5];
    /* Dividing (without remainder) by 1000 rounds the microseconds
       measure to the nearest millisecond. */
-   snprintf(msbuf, 5, ".%3.3ld", long(tv.tv_usec / 1000));
+   snprintf(msbuf, sizeof(msbuf), ".%3.3d", int(usec / 1000 % 1000));
 
    int datebufCharsRemaining = datebufSize - (int)strlen(datebuf);
 #if defined(WIN32) && defined(_M_ARM)
@@ -727,7 +795,9 @@ Log::LocalLoggerId Log::localLoggerCreate(Log::Type type,
                                           const char * logFileName,
                                           ExternalLogger* externalLogger)
 {
-   return mLocalLoggerMap.create(type, level, logFileName, externalLogger);
+   LocalLoggerId id = mLocalLoggerMap.create(type, level, logFileName, externalLogger);
+   levelsChanged();
+   return id;
 }
 
 int Log::localLoggerReinitialize(Log::LocalLoggerId loggerId,
@@ -736,12 +806,19 @@ int Log::localLoggerReinitialize(Log::LocalLoggerId loggerId,
                                  const char * logFileName,
                                  ExternalLogger* externalLogger)
 {
-   return mLocalLoggerMap.reinitialize(loggerId, type, level, logFileName, externalLogger);
+   // queued records still point at the logger
+   flushAsync();
+   int result = mLocalLoggerMap.reinitialize(loggerId, type, level, logFileName, externalLogger);
+   levelsChanged();
+   return result;
 }
 
 int Log::localLoggerRemove(Log::LocalLoggerId loggerId)
 {
-   return mLocalLoggerMap.remove(loggerId);
+   flushAsync();
+   int result = mLocalLoggerMap.remove(loggerId);
+   levelsChanged();
+   return result;
 }
 
 int Log::setThreadLocalLogger(Log::LocalLoggerId loggerId)
@@ -762,6 +839,36 @@ int Log::setThreadLocalLogger(Log::LocalLoggerId loggerId)
    return (loggerId == 0) || (pData != NULL)?0:1;
 }
 
+void
+Log::enableAsync(AsyncOverflow overflow, unsigned int bufferSize)
+{
+   AsyncLogWriter::start(overflow, bufferSize);
+}
+
+void
+Log::disableAsync()
+{
+   AsyncLogWriter::stop();
+}
+
+void
+Log::flushAsync()
+{
+   AsyncLogWriter::flush();
+}
+
+unsigned int
+Log::getAsyncDroppedCount()
+{
+   return AsyncLogWriter::droppedCount();
+}
+
+unsigned int
+Log::getAsyncTruncatedCount()
+{
+   return AsyncLogWriter::truncatedCount();
+}
+
 std::ostream&
 Log::Instance(unsigned int bytesToWrite)
 {
@@ -877,6 +984,21 @@ Log::ThreadData *Log::LocalLoggerMap::getData(Log::LocalLoggerId loggerId)
    return it->second.first;
 }
 
+Log::Level Log::LocalLoggerMap::maxLevel()
+{
+   Lock lock(mLoggerInstancesMapMutex);
+   Log::Level level = Log::None;
+   for (LoggerInstanceMap::const_iterator it = mLoggerInstancesMap.begin();
+        it != mLoggerInstancesMap.end(); ++it)
+   {
+      if (it->second.first->mLevel > level)
+      {
+         level = it->second.first->mLevel;
+      }
+   }
+   return level;
+}
+
 void Log::LocalLoggerMap::decreaseUseCount(Log::LocalLoggerId loggerId)
 {
    Lock lock(mLoggerInstancesMapMutex);
@@ -897,11 +1019,14 @@ Log::Guard::Guard(resip::Log::Level level,
    mSubsystem(subsystem),
    mFile(file),
    mLine(line),
+   mAsync(AsyncLogWriter::isActive()),
    mData(Data::Borrow, mBuffer, sizeof(mBuffer)),
    mStream(mData.clear())
 {
 	
-   if (resip::Log::getLoggerData().mType != resip::Log::OnlyExternalNoHeaders)
+   // the writer thread adds the headers to asynchronous records
+   if (!mAsync &&
+       resip::Log::getLoggerData().mType != resip::Log::OnlyExternalNoHeaders)
    {
       Log::tags(mLevel, mSubsystem, mFile, mLine, mStream);
       mStream << resip::Log::delim;
@@ -919,6 +1044,14 @@ Log::Guard::~Guard()
 {
    mStream.flush();
 
+   if (mAsync)
+   {
+      AsyncLogWriter::push(mLevel, mSubsystem, mFile, mLine,
+                           resip::Log::getLoggerData(),
+                           mData.data(), (unsigned int)mData.size());
+      return;
+   }
+
    if (resip::Log::getExternal())
    {
       const resip::Data rest(resip::Data::Share,
@@ -993,7 +1126,8 @@ Log::ThreadData::Instance(unsigned int bytesToWrite)
                if (keepAllLogFiles())
                {
                   char buffer[256];
-                  Data ts(Data::Borrow, buffer, sizeof(buffer));
+                  buffer[0] = 0;
+                  Data ts(Data::Borrow, buffer, 0, sizeof(buffer));
                   Data oldLogFileName(logFileName + "_" + timestamp(ts));
 
                   delete mLogger;
@@ -1029,6 +1163,26 @@ Log::ThreadData::reset()
    mLogger = NULL;
 }
 
+void
+Log::ThreadData::flush()
+{
+   switch (mType)
+   {
+      case Log::Cout:
+         std::cout.flush();
+         break;
+      case Log::Cerr:
+         std::cerr.flush();
+         break;
+      default:
+         if (mLogger)
+         {
+            mLogger->flush();
+         }
+         break;
+   }
+}
+
 #ifndef WIN32
 void
 Log::ThreadData::droppingPrivileges(uid_t uid, pid_t pid)
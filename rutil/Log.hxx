@@ -9,11 +9,13 @@
 #endif
 
 #include <set>
+#include <time.h>
 
 #include "rutil/Mutex.hxx"
 #include "rutil/Lock.hxx"
 #include "rutil/HashMap.hxx"
 #include "rutil/ThreadIf.hxx"
+#include "rutil/AtomicOps.hxx"
 #include <iostream>
 
 // !ipse! I think that this remark is no more valid with recent changes,
@@ -44,6 +46,7 @@ namespace resip
 
 class ExternalLogger;
 class Subsystem;
+class AsyncLogWriter;
 
 /**
    @brief Singleton that handles logging calls.
@@ -91,6 +94,13 @@ class Log
          Bogus = 666
       };
 
+      /// What a thread does when its asynchronous log buffer is full.
+      enum AsyncOverflow
+      {
+         DropOnOverflow,   ///< discard the record; see getAsyncDroppedCount()
+         BlockOnOverflow   ///< wait for the writer thread to make room
+      };
+
       /// Thread Local logger ID type.
       typedef int LocalLoggerId;
 
@@ -121,6 +131,7 @@ class Log
             resip::Data::size_type mHeaderLength;
             const char* mFile;
             int mLine;
+            bool mAsync;
             char mBuffer[128];
             Data mData;
             oDataStream mStream;
@@ -257,8 +268,43 @@ class Log
       static int setThreadLocalLogger(LocalLoggerId loggerId);
 
 
+      /** @brief Write log records from a background thread.
+      *
+      * Logging threads then only format the message itself and copy it,
+      * with the time and source, into a lock-free buffer of their own
+      * (bufferSize bytes, rounded up to a power of two). A writer thread
+      * adds the headers, calls the ExternalLogger if any, and writes to the
+      * logger's file, syslog or console, including MaxLineCount/MaxByteCount
+      * rotation. Records from different threads are written in time order.
+      * May be called again to change the overflow policy.
+      */
+      static void enableAsync(AsyncOverflow overflow = DropOnOverflow,
+                              unsigned int bufferSize = 256*1024);
+      /** @brief Write out what is queued, stop the writer thread and log
+      * synchronously again. */
+      static void disableAsync();
+      /** @brief Return once everything logged so far has been written.
+      * Does nothing unless asynchronous logging is enabled. */
+      static void flushAsync();
+      /** @brief Number of records dropped because a buffer was full. */
+      static unsigned int getAsyncDroppedCount();
+      /** @brief Number of records cut short because they did not fit in a
+      * quarter of their thread's buffer; such lines end in
+      * " ...[<n> bytes truncated]". */
+      static unsigned int getAsyncTruncatedCount();
+
       static std::ostream& Instance(unsigned int bytesToWrite);
       static bool isLogging(Log::Level level, const Subsystem&);
+
+      /** @internal Changes whenever any logging level does, so that each
+      * Subsystem can cache the highest level it may log at; see
+      * Subsystem::maxLevel(). Never 0 in its low 24 bits. */
+      static UInt32 levelGeneration() { return AtomicOps::loadRelaxed(mLevelGeneration); }
+      /** @internal The highest level of the default and all local loggers. */
+      static Level maxLoggerLevel() { return (Level)(int)AtomicOps::load(mMaxLoggerLevel); }
+      /** @internal Recomputes maxLoggerLevel() and bumps levelGeneration();
+      * called after any level is changed. */
+      static void levelsChanged();
       static void OutputToWin32DebugWindow(const Data& result);      
       static void reset(); ///< Frees logger stream
 #ifndef WIN32
@@ -266,8 +312,22 @@ class Log
 #endif
 
    protected:
+      static EncodeStream& tags(Log::Level level,
+                                const Subsystem& subsystem,
+                                const char* file,
+                                int line,
+                                time_t sec,
+                                unsigned int usec,
+                                ThreadIf::Id threadId,
+                                Type type,
+                                EncodeStream& strm);
+      static Data& timestamp(Data& result, time_t sec, unsigned int usec);
+      static void getTimeOfDay(time_t& sec, unsigned int& usec);
+
       static Mutex _mutex;
       static volatile short touchCount;
+      static volatile UInt32 mLevelGeneration;
+      static volatile UInt32 mMaxLoggerLevel;
       static const Data delim;
 
       static unsigned int MaxLineCount;
@@ -322,6 +382,7 @@ class Log
 
             std::ostream& Instance(unsigned int bytesToWrite); ///< Return logger stream instance, creating it if needed.
             void reset(); ///< Frees logger stream
+            void flush(); ///< Flushes logger stream, if it has been created
 #ifndef WIN32
             void droppingPrivileges(uid_t uid, pid_t pid);
 #endif
@@ -397,6 +458,9 @@ class Log
          /// Decrease use counter for given loggerId.
          void decreaseUseCount(LocalLoggerId loggerId);
 
+         /// Highest level of any local logger, or None if there are none.
+         Level maxLevel();
+
       protected:
          /// Storage for Thread Local loggers and their use-counts.
          typedef HashMap<LocalLoggerId, std::pair<ThreadData*, int> > LoggerInstanceMap;
@@ -409,6 +473,8 @@ class Log
 
       friend void ::freeLocalLogger(void* pThreadData);
       friend class LogStaticInitializer;
+      friend class AsyncLogWriter;
+      friend class Subsystem;
       static LocalLoggerMap mLocalLoggerMap;
       static ThreadIf::TlsKey* mLocalLoggerKey;
 
@@ -143,7 +143,9 @@ GenericLog(RESIPROCATE_SUBSYSTEM, resip::Log::Crit, args_)
 static inline bool
 genericLogCheckLevel(resip::Log::Level level, const resip::Subsystem& sub)
 {
-   return resip::Log::isLogging(level, sub);
+   // Subsystem::maxLevel() settles disabled levels without a call or a
+   // thread local lookup; only enabled ones need the exact check.
+   return level <= sub.maxLevel() && resip::Log::isLogging(level, sub);
 }
 
 // do/while allows a {} block in an expression
@@ -0,0 +1,165 @@
+#if !defined(RESIP_MPSCQUEUE_HXX)
+#define RESIP_MPSCQUEUE_HXX
+
+#include <new>
+
+#include "rutil/AtomicOps.hxx"
+
+namespace resip
+{
+
+/**
+   @brief Unbounded multi-producer, single-consumer queue that needs no lock.
+
+   push() may be called from any number of threads; pop(), front() and
+   empty() only from the one consumer thread. Producers link a freshly
+   allocated node after the current head with a single atomic exchange, so
+   neither side ever waits on the other. A producer that is preempted between
+   the exchange and linking its node briefly hides it (and anything pushed
+   after it) from the consumer, so pop() can return false while a push() is
+   still in progress.
+
+   @internal This is the queue behind AbstractFifo's lock-free mode; see
+   AbstractFifo::setLockFree().
+*/
+template <typename T>
+class MpscQueue
+{
+   public:
+      MpscQueue()
+         : mHead(new Node),
+           mTail(mHead)
+      {
+         mHead->mNext = 0;
+      }
+
+      ~MpscQueue()
+      {
+         Node* node = mTail->mNext;
+         delete mTail;
+         while (node)
+         {
+            Node* next = node->mNext;
+            node->value().~T();
+            delete node;
+            node = next;
+         }
+      }
+
+      void push(const T& value)
+      {
+         Node* node = new Node;
+         new (node->mStorage.mBytes) T(value);
+         node->mNext = 0;
+         Node* prev = AtomicOps::exchangePtr(mHead, node);
+         AtomicOps::storePtr(prev->mNext, node);
+      }
+
+      /// @return false if nothing is (visibly) queued
+      bool pop(T& value)
+      {
+         Node* tail = mTail;
+         Node* next = AtomicOps::loadPtr(tail->mNext);
+         if (next == 0)
+         {
+            return false;
+         }
+         value = next->value();
+         next->value().~T();
+         // next becomes the new (empty) sentinel
+         mTail = next;
+         delete tail;
+         return true;
+      }
+
+      /// @return the element pop() would return next, or 0
+      const T* front() const
+      {
+         Node* next = AtomicOps::loadPtr(mTail->mNext);
+         return next ? &next->value() : 0;
+      }
+
+      bool empty() const
+      {
+         return AtomicOps::loadPtr(mTail->mNext) == 0;
+      }
+
+   private:
+      struct Node
+      {
+         Node* volatile mNext;
+         union
+         {
+            char mBytes[sizeof(T)];
+            UInt64 mAlignInt;
+            double mAlignDouble;
+            void* mAlignPtr;
+         } mStorage;
+
+         T& value() { return *reinterpret_cast<T*>(mStorage.mBytes); }
+      };
+
+      // producers' end
+      Node* volatile mHead;
+      char mPad[64];
+      // consumer's end
+      Node* mTail;
+
+      // no value semantics
+      MpscQueue(const MpscQueue&);
+      MpscQueue& operator=(const MpscQueue&);
+};
+
+}
+
+#endif
+
+/* ====================================================================
+ * The Vovida Software License, Version 1.0 
+ * 
+ * Copyright (c) 2000 Vovida Networks, Inc.  All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 
+ * 3. The names "VOCAL", "Vovida Open Communication Application Library",
+ *    and "Vovida Open Communication Application Library (VOCAL)" must
+ *    not be used to endorse or promote products derived from this
+ *    software without prior written permission. For written
+ *    permission, please contact vocal@vovida.org.
+ *
+ * 4. Products derived from this software may not be called "VOCAL", nor
+ *    may "VOCAL" appear in their name, without prior written
+ *    permission of Vovida Networks, Inc.
+ * 
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESSED OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE, TITLE AND
+ * NON-INFRINGEMENT ARE DISCLAIMED.  IN NO EVENT SHALL VOVIDA
+ * NETWORKS, INC. OR ITS CONTRIBUTORS BE LIABLE FOR ANY DIRECT DAMAGES
+ * IN EXCESS OF $1,000, NOR FOR ANY INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE
+ * USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+ * DAMAGE.
+ * 
+ * ====================================================================
+ * 
+ * This software consists of voluntary contributions made by Vovida
+ * Networks, Inc. and many individuals on behalf of Vovida Networks,
+ * Inc.  For more information on Vovida Networks, Inc., please see
+ * <http://www.vovida.org/>.
+ *
+ */
@@ -0,0 +1,299 @@
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+
+#include "rutil/PerfectHash.hxx"
+#include "rutil/ResipAssert.h"
+
+using namespace resip;
+
+namespace
+{
+
+size_t
+nextPowerOfTwo(size_t n)
+{
+   size_t p = 1;
+   while (p < n)
+   {
+      p <<= 1;
+   }
+   return p;
+}
+
+struct BucketOrder
+{
+   BucketOrder(const std::vector<std::vector<size_t> >& buckets) : mBuckets(buckets) {}
+   bool operator()(size_t a, size_t b) const
+   {
+      return mBuckets[a].size() > mBuckets[b].size();
+   }
+   const std::vector<std::vector<size_t> >& mBuckets;
+};
+
+}
+
+PerfectHashBase::PerfectHashBase()
+   : mSeed(0),
+     mFoldCase(true),
+     mBucketMask(0),
+     mSlotMask(0),
+     mSlotCount(0),
+     mKeyCount(0),
+     mDisplacements(0),
+     mSlots(0),
+     mKeys(0),
+     mWords(0)
+{
+}
+
+PerfectHashBase::~PerfectHashBase()
+{
+   delete [] mDisplacements;
+   delete [] mSlots;
+   delete [] mKeys;
+   delete [] mWords;
+}
+
+void
+PerfectHashBase::build(const std::vector<const char*>& names, bool caseSensitive)
+{
+   mFoldCase = !caseSensitive;
+
+   // two names that are the same (ignoring case, unless caseSensitive)
+   // hash the same under every seed; no table can be built from them
+   std::vector<std::string> sorted;
+   sorted.reserve(names.size());
+   for (size_t i = 0; i < names.size(); ++i)
+   {
+      std::string name(names[i]);
+      if (mFoldCase)
+      {
+         for (size_t c = 0; c < name.size(); ++c)
+         {
+            if (name[c] >= 'A' && name[c] <= 'Z')
+            {
+               name[c] |= 0x20;
+            }
+         }
+      }
+      sorted.push_back(name);
+   }
+   std::sort(sorted.begin(), sorted.end());
+   std::vector<std::string>::const_iterator dup = std::adjacent_find(sorted.begin(), sorted.end());
+   if (dup != sorted.end())
+   {
+      throw std::invalid_argument("PerfectHash: duplicate name " + *dup);
+   }
+
+   mKeyCount = names.size();
+
+   size_t wordCount = 0;
+   for (size_t i = 0; i < names.size(); ++i)
+   {
+      wordCount += (strlen(names[i]) + 7) / 8;
+   }
+
+   // keep the key text as words, lowercased, with the bits to set on the
+   // input before comparing
+   mWords = new UInt64[2*wordCount + 1];
+   mKeys = new Key[mKeyCount + 1];
+   UInt64* out = mWords;
+   for (size_t i = 0; i < names.size(); ++i)
+   {
+      Key& key = mKeys[i];
+      key.length = strlen(names[i]);
+      key.index = (int)i;
+      const size_t words = (key.length + 7) / 8;
+      UInt64* keyWords = out;
+      UInt64* keyFolds = out + words;
+      key.words = keyWords;
+      key.folds = keyFolds;
+      out += 2*words;
+
+      std::string text(names[i], key.length);
+      std::string fold(key.length, '\0');
+      for (size_t c = 0; c < key.length; ++c)
+      {
+         char ch = text[c];
+         if (mFoldCase && ((ch >= 'a' && ch <= 'z') || (ch >= 'A' && ch <= 'Z')))
+         {
+            text[c] = ch | 0x20;
+            fold[c] = 0x20;
+         }
+      }
+      for (size_t w = 0; w < words; ++w)
+      {
+         const size_t remaining = key.length - w*8;
+         if (remaining >= 8)
+         {
+            keyWords[w] = load(text.data() + w*8);
+            keyFolds[w] = load(fold.data() + w*8);
+         }
+         else
+         {
+            keyWords[w] = loadTail(text.data() + w*8, remaining);
+            keyFolds[w] = loadTail(fold.data() + w*8, remaining);
+         }
+      }
+   }
+   // an empty slot refers to this key, which no length matches
+   mKeys[mKeyCount].length = size_t(-1);
+   mKeys[mKeyCount].index = -1;
+   mKeys[mKeyCount].words = mWords + 2*wordCount;
+   mKeys[mKeyCount].folds = mWords + 2*wordCount;
+   mWords[2*wordCount] = 0;
+
+   for (mSlotCount = nextPowerOfTwo(std::max<size_t>(2*mKeyCount, 2));
+        mSlotCount <= 64*(mKeyCount + 1);
+        mSlotCount *= 2)
+   {
+      for (int attempt = 0; attempt < 16; ++attempt)
+      {
+         mSeed = UInt64(0x9ae16a3b2f90404fULL) * UInt64(attempt + 1);
+         if (tryBuild(names))
+         {
+            return;
+         }
+      }
+   }
+   // distinct names whose full hashes collide under every seed
+   mSlotCount = 0;
+   throw std::runtime_error("PerfectHash: no seed separates the names");
+}
+
+bool
+PerfectHashBase::tryBuild(const std::vector<const char*>& names)
+{
+   const size_t bucketCount = nextPowerOfTwo(std::max<size_t>(mKeyCount, 1));
+   const UInt32 bucketMask = UInt32(bucketCount - 1);
+   const UInt32 slotMask = UInt32(mSlotCount - 1);
+
+   std::vector<UInt64> hashes(mKeyCount);
+   std::vector<std::vector<size_t> > buckets(bucketCount);
+   for (size_t i = 0; i < mKeyCount; ++i)
+   {
+      hashes[i] = hash(names[i], mKeys[i].length, mSeed, mFoldCase);
+      buckets[hashes[i] & bucketMask].push_back(i);
+   }
+
+   std::vector<size_t> order(bucketCount);
+   for (size_t b = 0; b < bucketCount; ++b)
+   {
+      order[b] = b;
+   }
+   std::stable_sort(order.begin(), order.end(), BucketOrder(buckets));
+
+   std::vector<UInt32> displacements(bucketCount, 0);
+   std::vector<size_t> slots(mSlotCount, mKeyCount);
+   std::vector<UInt32> placed;
+   for (size_t o = 0; o < bucketCount; ++o)
+   {
+      const std::vector<size_t>& bucket = buckets[order[o]];
+      if (bucket.empty())
+      {
+         break;
+      }
+
+      bool found = false;
+      for (UInt32 d = 0; !found && d < 4*mSlotCount; ++d)
+      {
+         placed.clear();
+         found = true;
+         for (size_t k = 0; k < bucket.size(); ++k)
+         {
+            UInt32 slot = slotOf(hashes[bucket[k]], d, slotMask);
+            if (slots[slot] != mKeyCount ||
+                std::find(placed.begin(), placed.end(), slot) != placed.end())
+            {
+               found = false;
+               break;
+            }
+            placed.push_back(slot);
+         }
+         if (found)
+         {
+            displacements[order[o]] = d;
+            for (size_t k = 0; k < bucket.size(); ++k)
+            {
+               slots[placed[k]] = bucket[k];
+            }
+         }
+      }
+      if (!found)
+      {
+         // two names that hash identically need a different seed
+         return false;
+      }
+   }
+
+   delete [] mDisplacements;
+   delete [] mSlots;
+   mDisplacements = new UInt32[bucketCount];
+   std::copy(displacements.begin(), displacements.end(), mDisplacements);
+   mSlots = new UInt32[mSlotCount];
+   for (size_t s = 0; s < mSlotCount; ++s)
+   {
+      mSlots[s] = UInt32(slots[s]);
+   }
+   mBucketMask = bucketMask;
+   mSlotMask = slotMask;
+
+#ifndef NDEBUG
+   for (size_t i = 0; i < mKeyCount; ++i)
+   {
+      resip_assert(findIndex(names[i], mKeys[i].length) == int(i));
+   }
+#endif
+   return true;
+}
+
+/* ====================================================================
+ * The Vovida Software License, Version 1.0 
+ * 
+ * Copyright (c) 2000 Vovida Networks, Inc.  All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 
+ * 3. The names "VOCAL", "Vovida Open Communication Application Library",
+ *    and "Vovida Open Communication Application Library (VOCAL)" must
+ *    not be used to endorse or promote products derived from this
+ *    software without prior written permission. For written
+ *    permission, please contact vocal@vovida.org.
+ *
+ * 4. Products derived from this software may not be called "VOCAL", nor
+ *    may "VOCAL" appear in their name, without prior written
+ *    permission of Vovida Networks, Inc.
+ * 
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESSED OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE, TITLE AND
+ * NON-INFRINGEMENT ARE DISCLAIMED.  IN NO EVENT SHALL VOVIDA
+ * NETWORKS, INC. OR ITS CONTRIBUTORS BE LIABLE FOR ANY DIRECT DAMAGES
+ * IN EXCESS OF $1,000, NOR FOR ANY INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE
+ * USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+ * DAMAGE.
+ * 
+ * ====================================================================
+ * 
+ * This software consists of voluntary contributions made by Vovida
+ * Networks, Inc. and many individuals on behalf of Vovida Networks,
+ * Inc.  For more information on Vovida Networks, Inc., please see
+ * <http://www.vovida.org/>.
+ *
+ */
@@ -0,0 +1,268 @@
+#if !defined(RESIP_PERFECTHASH_HXX)
+#define RESIP_PERFECTHASH_HXX
+
+#include <string.h>
+#include <vector>
+
+#include "rutil/compat.hxx"
+
+namespace resip
+{
+
+/**
+   @brief Collision-free lookup over a fixed set of names (header, parameter
+   and method names), built once from a table of name/value pairs.
+
+   Names are hashed and compared a machine word at a time. A first level of
+   buckets picks a displacement for each name's slot (hash and displace), so
+   every known name owns exactly one slot and a lookup costs one hash and one
+   compare, hit or miss. Unless the table is case-sensitive, ASCII letters
+   match regardless of case; everything else must match exactly.
+
+   The tables are meant to be built during static initialization, from
+   arrays of string literals. A table that has not been built yet (a lookup
+   from some other translation unit's static initializer) finds nothing.
+   Building from a list that names the same thing twice throws
+   std::invalid_argument.
+*/
+class PerfectHashBase
+{
+   public:
+      /// Hash of [name, name+len) that ignores the case of ASCII letters,
+      /// suitable for any table keyed on names that compare case-insensitively.
+      static UInt64 hashNoCase(const char* name, size_t len, UInt64 seed=0)
+      {
+         return hash(name, len, seed, true);
+      }
+
+      static UInt64 hash(const char* name, size_t len, UInt64 seed, bool foldCase)
+      {
+         const UInt64 fold = foldCase ? UInt64(0x2020202020202020ULL) : 0;
+         UInt64 h = seed ^ (UInt64(len) * UInt64(0x9e3779b97f4a7c15ULL));
+         while (len >= 8)
+         {
+            h = mix(h ^ (load(name) | fold));
+            name += 8;
+            len -= 8;
+         }
+         if (len)
+         {
+            h = mix(h ^ (loadTail(name, len) | fold));
+         }
+         return h ^ (h >> 31);
+      }
+
+      /// Number of slots; the table holds size() names.
+      size_t slots() const { return mSlotCount; }
+      size_t size() const { return mKeyCount; }
+
+   protected:
+      PerfectHashBase();
+      ~PerfectHashBase();
+
+      void build(const std::vector<const char*>& names, bool caseSensitive);
+
+      /// @return the position of name in the table it was built from, or -1
+      int findIndex(const char* name, size_t len) const
+      {
+         if (mSlotCount == 0)
+         {
+            return -1;
+         }
+
+         UInt64 h = hash(name, len, mSeed, mFoldCase);
+         UInt32 slot = slotOf(h, mDisplacements[h & mBucketMask], mSlotMask);
+         const Key& key = mKeys[mSlots[slot]];
+         if (key.length != len)
+         {
+            return -1;
+         }
+
+         const UInt64* word = key.words;
+         const UInt64* fold = key.folds;
+         while (len >= 8)
+         {
+            if ((load(name) | *fold++) != *word++)
+            {
+               return -1;
+            }
+            name += 8;
+            len -= 8;
+         }
+         if (len && (loadTail(name, len) | *fold) != *word)
+         {
+            return -1;
+         }
+         return key.index;
+      }
+
+   private:
+      static UInt64 load(const char* p)
+      {
+         UInt64 w;
+         memcpy(&w, p, sizeof(w));
+         return w;
+      }
+
+      // The last 1-7 bytes, without reading past them. Some bytes may be
+      // loaded twice; since keys are loaded the same way, every byte still
+      // takes part in the compare.
+      static UInt64 loadTail(const char* p, size_t len)
+      {
+         if (len >= 4)
+         {
+            UInt32 lo;
+            UInt32 hi;
+            memcpy(&lo, p, sizeof(lo));
+            memcpy(&hi, p + len - 4, sizeof(hi));
+            return UInt64(lo) | (UInt64(hi) << 32);
+         }
+         return UInt64((unsigned char)p[0]) |
+            (UInt64((unsigned char)p[len/2]) << 8) |
+            (UInt64((unsigned char)p[len - 1]) << 16);
+      }
+
+      static UInt64 mix(UInt64 h)
+      {
+         h *= UInt64(0xff51afd7ed558ccdULL);
+         return h ^ (h >> 32);
+      }
+
+      static UInt32 slotOf(UInt64 h, UInt32 displacement, UInt32 mask)
+      {
+         return (UInt32(h >> 32) + displacement * (UInt32(h >> 8) | 1)) & mask;
+      }
+
+      bool tryBuild(const std::vector<const char*>& names);
+
+      struct Key
+      {
+         size_t length;
+         int index;
+         const UInt64* words;
+         const UInt64* folds;
+      };
+
+      // These are plain pointers and counts, so a table that is still
+      // zero-initialized (not yet constructed) reads as empty.
+      UInt64 mSeed;
+      bool mFoldCase;
+      UInt32 mBucketMask;
+      UInt32 mSlotMask;
+      size_t mSlotCount;
+      size_t mKeyCount;
+      UInt32* mDisplacements;
+      UInt32* mSlots;         // index into mKeys; mKeyCount for an empty slot
+      Key* mKeys;             // one more than mKeyCount, the last one empty
+      UInt64* mWords;         // lowercased, zero padded key text and fold masks
+
+      // no value semantics
+      PerfectHashBase(const PerfectHashBase&);
+      PerfectHashBase& operator=(const PerfectHashBase&);
+};
+
+template <class T>
+class PerfectHash : public PerfectHashBase
+{
+   public:
+      struct Entry
+      {
+         const char* name;
+         T value;
+      };
+
+      PerfectHash(const Entry* entries, size_t count, bool caseSensitive=false)
+      {
+         std::vector<const char*> names;
+         names.reserve(count);
+         mValues.reserve(count);
+         for (size_t i = 0; i < count; ++i)
+         {
+            names.push_back(entries[i].name);
+            mValues.push_back(entries[i].value);
+         }
+         build(names, caseSensitive);
+      }
+
+      /// @return the value for name, or notFound
+      T find(const char* name, size_t len, T notFound) const
+      {
+         int index = findIndex(name, len);
+         return index < 0 ? notFound : mValues[index];
+      }
+
+      /// Looks name up in entries one by one. For callers that can run
+      /// before the table has been constructed.
+      static T linearFind(const Entry* entries, size_t count,
+                          const char* name, size_t len, bool caseSensitive,
+                          T notFound)
+      {
+         for (size_t i = 0; i < count; ++i)
+         {
+            if (strlen(entries[i].name) == len &&
+                (caseSensitive ? strncmp(entries[i].name, name, len) == 0
+                               : strncasecmp(entries[i].name, name, len) == 0))
+            {
+               return entries[i].value;
+            }
+         }
+         return notFound;
+      }
+
+   private:
+      std::vector<T> mValues;
+};
+
+}
+
+#endif
+
+/* ====================================================================
+ * The Vovida Software License, Version 1.0 
+ * 
+ * Copyright (c) 2000 Vovida Networks, Inc.  All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 
+ * 3. The names "VOCAL", "Vovida Open Communication Application Library",
+ *    and "Vovida Open Communication Application Library (VOCAL)" must
+ *    not be used to endorse or promote products derived from this
+ *    software without prior written permission. For written
+ *    permission, please contact vocal@vovida.org.
+ *
+ * 4. Products derived from this software may not be called "VOCAL", nor
+ *    may "VOCAL" appear in their name, without prior written
+ *    permission of Vovida Networks, Inc.
+ * 
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESSED OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE, TITLE AND
+ * NON-INFRINGEMENT ARE DISCLAIMED.  IN NO EVENT SHALL VOVIDA
+ * NETWORKS, INC. OR ITS CONTRIBUTORS BE LIABLE FOR ANY DIRECT DAMAGES
+ * IN EXCESS OF $1,000, NOR FOR ANY INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE
+ * USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+ * DAMAGE.
+ * 
+ * ====================================================================
+ * 
+ * This software consists of voluntary contributions made by Vovida
+ * Networks, Inc. and many individuals on behalf of Vovida Networks,
+ * Inc.  For more information on Vovida Networks, Inc., please see
+ * <http://www.vovida.org/>.
+ *
+ */
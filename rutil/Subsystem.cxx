@@ -21,6 +21,18 @@ const Data& Subsystem::getSubsystem() const
     return mSubsystem;
 }
 
+Log::Level
+Subsystem::refreshLevelCache() const
+{
+   // read the generation first; a change after this bumps it again
+   const UInt32 generation = AtomicOps::load(Log::mLevelGeneration) & 0xFFFFFF;
+   const Log::Level level = mLevel != Log::None ? mLevel : Log::maxLoggerLevel();
+   // anything above 254 (Bogus) may as well be 254
+   const UInt32 cached = level < 0xFE ? (UInt32)(level + 1) : 0xFF;
+   AtomicOps::store(mLevelCache, (generation << 8) | cached);
+   return level;
+}
+
 EncodeStream& 
 resip::operator<<(EncodeStream& strm, const Subsystem& ss)
 {
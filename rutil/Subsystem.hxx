@@ -50,14 +50,35 @@ class Subsystem
       
       const Data& getSubsystem() const;
       Log::Level getLevel() const { return mLevel; }
-      void setLevel(Log::Level level) { mLevel = level; }
+      void setLevel(Log::Level level) { mLevel = level; Log::levelsChanged(); }
+
+      /** @brief The highest level any thread may currently log at in this
+          subsystem; what the logging macros test before anything else.
+
+          Cached together with the Log::levelGeneration() it was computed
+          for, so this is two relaxed loads until some level changes.
+      */
+      Log::Level maxLevel() const
+      {
+         const UInt32 cached = AtomicOps::loadRelaxed(mLevelCache);
+         if ((cached >> 8) == (Log::levelGeneration() & 0xFFFFFF))
+         {
+            return (Log::Level)((int)(cached & 0xFF) - 1);
+         }
+         return refreshLevelCache();
+      }
+
    protected:
-      explicit Subsystem(const char* rhs) : mSubsystem(rhs), mLevel(Log::None) {};
-      explicit Subsystem(const Data& rhs) : mSubsystem(rhs), mLevel(Log::None) {};
+      explicit Subsystem(const char* rhs) : mSubsystem(rhs), mLevel(Log::None), mLevelCache(0) {};
+      explicit Subsystem(const Data& rhs) : mSubsystem(rhs), mLevel(Log::None), mLevelCache(0) {};
       Subsystem& operator=(const Data& rhs);
 
+      Log::Level refreshLevelCache() const;
+
       Data mSubsystem;
       Log::Level mLevel;
+      // generation << 8 | (maxLevel() + 1)
+      mutable volatile UInt32 mLevelCache;
 
       friend EncodeStream& operator<<(EncodeStream& strm, const Subsystem& ss);
 };
@@ -4,6 +4,8 @@
 #include "rutil/ResipAssert.h"
 #include <memory>
 #include "rutil/AbstractFifo.hxx"
+#include "rutil/LatencyHistogram.hxx"
+#include "rutil/Timer.hxx"
 #include <iostream>
 #if defined( WIN32 )
 #include <time.h>
@@ -24,18 +26,21 @@ template<typename Payload>
 class Timestamped
 {
    public:
-      Timestamped(const Payload& msg, time_t n)
+      Timestamped(const Payload& msg, time_t n, UInt64 queuedUs=0)
          : mMsg(msg),
-           mTime(n)
+           mTime(n),
+           mQueuedUs(queuedUs)
       {}
 
       inline const Payload& getMsg() const { return mMsg;} 
       inline void setMsg(const Payload& pMsg) { mMsg = pMsg;}
       inline const time_t& getTime() const { return mTime;} 
+      inline UInt64 getQueuedUs() const { return mQueuedUs;}
 
    private:
       Payload mMsg;
       time_t mTime;
+      UInt64 mQueuedUs; // only set when the fifo records dwell times
 };
 
 /**
@@ -105,6 +110,7 @@ class TimeLimitFifo : public AbstractFifo< Timestamped<Msg*> >
       using AbstractFifo< Timestamped<Msg*> >::empty;
       using AbstractFifo< Timestamped<Msg*> >::size;
       using AbstractFifo< Timestamped<Msg*> >::onMessagePushed;
+      using AbstractFifo< Timestamped<Msg*> >::setLockFree;
 
       /// @brief Add a message to the fifo.
       /// return true iff succeeds
@@ -206,15 +212,35 @@ class TimeLimitFifo : public AbstractFifo< Timestamped<Msg*> >
       */
       virtual void setTimeDepthTolerance(unsigned int maxSecs);
 
+      /**
+      @brief records how long each message spends in the FIFO, in
+      microseconds, into histogram (which must outlive the FIFO, or be
+      unset first); 0 stops recording
+      @note costs a clock read on add() and on getNext(); messages added
+      before the histogram was set are not recorded
+      */
+      void setDwellHistogram(LatencyHistogram* histogram) { mDwellHistogram = histogram; }
+
+   protected:
+      virtual void onMessagePopped(unsigned int num=1);
+
    private:
       time_t timeDepthInternal() const;
+      size_t countInternal() const;
       inline bool wouldAcceptInteral(DepthUsage usage) const;
+      Msg* recordDwell(const Timestamped<Msg*>& tm) const;
       TimeLimitFifo(const TimeLimitFifo& rhs);
       TimeLimitFifo& operator=(const TimeLimitFifo& rhs);
 
       time_t mMaxDurationSecs;
       unsigned int mMaxSize;
       unsigned int mUnreservedMaxSize;
+      // Lock-free mode only: timestamp of the oldest element, so producers
+      // can check the time depth without looking into the queue. Updated by
+      // the producer that makes the fifo non-empty and by the consumer as
+      // it pops; it may briefly read low while both are active.
+      UInt32 mFrontTime;
+      LatencyHistogram* mDwellHistogram;
 };
 
 template <class Msg>
@@ -223,7 +249,9 @@ TimeLimitFifo<Msg>::TimeLimitFifo(unsigned int maxDurationSecs,
    : AbstractFifo< Timestamped<Msg*> >(),
      mMaxDurationSecs(maxDurationSecs),
      mMaxSize(maxSize),
-     mUnreservedMaxSize((int)((maxSize*8)/10)) // !dlb! random guess
+     mUnreservedMaxSize((int)((maxSize*8)/10)), // !dlb! random guess
+     mFrontTime(0),
+     mDwellHistogram(0)
 {}
 
 template <class Msg>
@@ -238,12 +266,36 @@ bool
 TimeLimitFifo<Msg>::add(Msg* msg,
                         DepthUsage usage)
 {
+   if (this->isLockFree())
+   {
+      // The limits are checked without excluding other producers, so the
+      // fifo can overshoot them by up to one element per producer.
+      if (!wouldAcceptInteral(usage))
+      {
+         return false;
+      }
+      time_t n = time(0);
+      UInt64 queuedUs = mDwellHistogram ? Timer::getTimeMicroSec() : 0;
+      UInt32 size = this->reserveLockFree(1);
+      if (size == 1)
+      {
+         AtomicOps::store(mFrontTime, (UInt32)n);
+      }
+      this->mLockFree->push(Timestamped<Msg*>(msg, n, queuedUs));
+      if (size == 1)
+      {
+         this->wakeLockFree();
+      }
+      return true;
+   }
+
    Lock lock(mMutex); (void)lock;
 
    if (wouldAcceptInteral(usage))
    {
       time_t n = time(0);
-      mFifo.push_back(Timestamped<Msg*>(msg, n));
+      UInt64 queuedUs = mDwellHistogram ? Timer::getTimeMicroSec() : 0;
+      mFifo.push_back(Timestamped<Msg*>(msg, n, queuedUs));
       onMessagePushed(1);
       mCondition.signal();
       return true;
@@ -258,6 +310,11 @@ template <class Msg>
 bool
 TimeLimitFifo<Msg>::wouldAccept(DepthUsage usage) const
 {
+   if (this->isLockFree())
+   {
+      return wouldAcceptInteral(usage);
+   }
+
    Lock lock(mMutex); (void)lock;
 
    return wouldAcceptInteral(usage);
@@ -268,7 +325,7 @@ Msg*
 TimeLimitFifo<Msg>::getNext()
 {
    Timestamped<Msg*> tm(AbstractFifo< Timestamped<Msg*> >::getNext());
-   return tm.getMsg();
+   return recordDwell(tm);
 }
 
 template <class Msg>
@@ -278,15 +335,39 @@ TimeLimitFifo<Msg>::getNext(int ms)
    Timestamped<Msg*> tm(0,0);
    if(AbstractFifo< Timestamped<Msg*> >::getNext(ms, tm))
    {
-      return tm.getMsg();
+      return recordDwell(tm);
    }
    return 0;
 }
 
+template <class Msg>
+Msg*
+TimeLimitFifo<Msg>::recordDwell(const Timestamped<Msg*>& tm) const
+{
+   LatencyHistogram* histogram = mDwellHistogram;
+   if (histogram && tm.getQueuedUs())
+   {
+      UInt64 now = Timer::getTimeMicroSec();
+      histogram->record(now > tm.getQueuedUs() ? now - tm.getQueuedUs() : 0);
+   }
+   return tm.getMsg();
+}
+
 template <class Msg>
 time_t
 TimeLimitFifo<Msg>::timeDepthInternal() const
 {
+   if (this->isLockFree())
+   {
+      UInt32 front = AtomicOps::load(mFrontTime);
+      if (front == 0 || size() == 0)
+      {
+         return 0;
+      }
+      time_t depth = time(0) - (time_t)front;
+      return depth > 0 ? depth : 0;
+   }
+
    if(mFifo.empty())
    {
       return 0;
@@ -295,12 +376,20 @@ TimeLimitFifo<Msg>::timeDepthInternal() const
    return time(0) - mFifo.front().getTime();
 }
 
+template <class Msg>
+size_t
+TimeLimitFifo<Msg>::countInternal() const
+{
+   return this->isLockFree() ? size() : mFifo.size();
+}
+
 template <class Msg>
 bool
 TimeLimitFifo<Msg>::wouldAcceptInteral(DepthUsage usage) const
 {
+   const size_t count = countInternal();
    if ((mMaxSize != 0 &&
-        mFifo.size() >= mMaxSize))
+        count >= mMaxSize))
    {
       return false;
    }
@@ -311,7 +400,7 @@ TimeLimitFifo<Msg>::wouldAcceptInteral(DepthUsage usage) const
    }
 
    if (mUnreservedMaxSize != 0 &&
-       mFifo.size() >= mUnreservedMaxSize)
+       count >= mUnreservedMaxSize)
    {
       return false;
    }
@@ -323,7 +412,7 @@ TimeLimitFifo<Msg>::wouldAcceptInteral(DepthUsage usage) const
 
    resip_assert(usage == EnforceTimeDepth);
 
-   if (mFifo.size() == 0 ||
+   if (count == 0 ||
        mMaxDurationSecs == 0 ||
        timeDepthInternal() < mMaxDurationSecs)
    {
@@ -345,6 +434,17 @@ template <class Msg>
 void
 TimeLimitFifo<Msg>::clear()
 {
+   if (this->isLockFree())
+   {
+      // only safe from the consumer thread
+      Timestamped<Msg*> tm(0,0);
+      while (AbstractFifo< Timestamped<Msg*> >::getNext(RESIP_FIFO_NOWAIT, tm))
+      {
+         delete tm.getMsg();
+      }
+      return;
+   }
+
    Lock lock(mMutex); (void)lock;
 
    while (!mFifo.empty())
@@ -354,6 +454,21 @@ TimeLimitFifo<Msg>::clear()
    }
 }
 
+template <class Msg>
+void
+TimeLimitFifo<Msg>::onMessagePopped(unsigned int num)
+{
+   if (this->isLockFree())
+   {
+      // Record the new front before the count drops, so that a producer
+      // that then finds the fifo empty overwrites it rather than the
+      // other way round.
+      const Timestamped<Msg*>* front = this->mLockFree->front();
+      AtomicOps::store(mFrontTime, front ? (UInt32)front->getTime() : 0);
+   }
+   AbstractFifo< Timestamped<Msg*> >::onMessagePopped(num);
+}
+
 template <class Msg>
 size_t
 TimeLimitFifo<Msg>::getCountDepth() const
@@ -336,6 +336,28 @@ AresDns::internalInit(const std::vector<GenericIPAddress>& additionalNameservers
       optmask |= ARES_OPT_SERVERS;
       opt.nservers = (int)additionalNameservers.size();
 
+      // A channel has a single server port; honour one given with the first
+      // nameserver so a stand-in server need not own port 53.
+      unsigned short port = additionalNameservers[0].v4Address.sin_port;
+#ifdef USE_IPV6
+      if (!additionalNameservers[0].isVersion4())
+      {
+         port = additionalNameservers[0].v6Address.sin6_port;
+      }
+#endif
+      if (port != 0 && ntohs(port) != 53)
+      {
+         optmask |= ARES_OPT_UDP_PORT | ARES_OPT_TCP_PORT;
+#if defined(USE_ARES)
+         // contrib/ares wants these in network byte order
+         opt.udp_port = port;
+         opt.tcp_port = port;
+#else
+         opt.udp_port = ntohs(port);
+         opt.tcp_port = ntohs(port);
+#endif
+      }
+
 #if defined(USE_IPV6) && defined(USE_ARES)
       // With contrib/ares, you can configure IPv6 addresses for the
       // nameservers themselves.
@@ -0,0 +1,186 @@
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <vector>
+
+#include "rutil/dns/DnsResolverThread.hxx"
+#include "rutil/dns/DnsStub.hxx"
+#include "rutil/dns/ExternalDnsFactory.hxx"
+#include "rutil/FdPoll.hxx"
+#include "rutil/Logger.hxx"
+#include "rutil/WinLeakCheck.hxx"
+
+#define RESIPROCATE_SUBSYSTEM resip::Subsystem::DNS
+
+using namespace resip;
+
+namespace
+{
+
+// Carries a copy of a raw answer back to the DnsStub's thread.
+class RawResultCommand : public DnsStub::Command
+{
+   public:
+      RawResultCommand(DnsRawSink* sink, int status, const unsigned char* abuf, int alen)
+         : mSink(sink),
+           mStatus(status),
+           mAnswer(abuf && alen > 0 ? abuf : 0, abuf && alen > 0 ? abuf + alen : 0)
+      {}
+
+      void execute()
+      {
+         mSink->onDnsRaw(mStatus, mAnswer.empty() ? 0 : &mAnswer[0], (int)mAnswer.size());
+      }
+
+   private:
+      DnsRawSink* mSink;
+      int mStatus;
+      std::vector<unsigned char> mAnswer;
+};
+
+}
+
+DnsResolverThread::DnsResolverThread(DnsStub& stub)
+   : mStub(stub),
+     mDnsProvider(ExternalDnsFactory::createExternalDns()),
+     mPollGrp(FdPollGrp::create()),
+     mInterruptorHandle(0),
+     mRequests(&mSelectInterruptor)
+{
+   mInterruptorHandle = mPollGrp->addPollItem(mSelectInterruptor.getReadSocket(), FPEM_Read, &mSelectInterruptor);
+   mDnsProvider->setPollGrp(mPollGrp);
+}
+
+DnsResolverThread::~DnsResolverThread()
+{
+   mDnsProvider->setPollGrp(0);
+   mPollGrp->delPollItem(mInterruptorHandle);
+   delete mDnsProvider;
+   delete mPollGrp;
+   while (mRequests.messageAvailable())
+   {
+      delete mRequests.getNext();
+   }
+}
+
+int
+DnsResolverThread::init(const std::vector<GenericIPAddress>& additionalNameservers,
+                        AfterSocketCreationFuncPtr socketFunc,
+                        int dnsTimeout, int dnsTries, unsigned int features)
+{
+   return mDnsProvider->init(additionalNameservers, socketFunc, dnsTimeout, dnsTries, features);
+}
+
+void
+DnsResolverThread::lookup(const Data& target, unsigned short type, DnsRawSink* sink)
+{
+   mRequests.add(new Request(target, type, sink));
+}
+
+void
+DnsResolverThread::reinit(int dnsTimeout, int dnsTries, unsigned int features)
+{
+   mRequests.add(new Request(dnsTimeout, dnsTries, features));
+}
+
+void
+DnsResolverThread::shutdown()
+{
+   ThreadIf::shutdown();
+   mSelectInterruptor.interrupt();
+}
+
+void
+DnsResolverThread::processRequests()
+{
+   while (mRequests.messageAvailable())
+   {
+      Request* request = mRequests.getNext();
+      if (request->mReinit)
+      {
+         mDnsProvider->init(request->mTimeout, request->mTries, request->mFeatures);
+      }
+      else
+      {
+         mDnsProvider->lookup(request->mTarget.c_str(), request->mType, this, request->mSink);
+      }
+      delete request;
+   }
+}
+
+void
+DnsResolverThread::thread()
+{
+   while (!isShutdown())
+   {
+      try
+      {
+         processRequests();
+         mDnsProvider->processTimers();
+         mPollGrp->waitAndProcess(25);
+      }
+      catch (BaseException& e)
+      {
+         ErrLog(<< "Unhandled exception: " << e);
+      }
+   }
+}
+
+void
+DnsResolverThread::handleDnsRaw(ExternalDnsRawResult res)
+{
+   mStub.queueCommand(new RawResultCommand(reinterpret_cast<DnsRawSink*>(res.userData),
+                                           res.errorCode(), res.abuf, res.alen));
+   mDnsProvider->freeResult(res);
+}
+
+/* ====================================================================
+ * The Vovida Software License, Version 1.0 
+ * 
+ * Copyright (c) 2000 Vovida Networks, Inc.  All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 
+ * 3. The names "VOCAL", "Vovida Open Communication Application Library",
+ *    and "Vovida Open Communication Application Library (VOCAL)" must
+ *    not be used to endorse or promote products derived from this
+ *    software without prior written permission. For written
+ *    permission, please contact vocal@vovida.org.
+ *
+ * 4. Products derived from this software may not be called "VOCAL", nor
+ *    may "VOCAL" appear in their name, without prior written
+ *    permission of Vovida Networks, Inc.
+ * 
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESSED OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE, TITLE AND
+ * NON-INFRINGEMENT ARE DISCLAIMED.  IN NO EVENT SHALL VOVIDA
+ * NETWORKS, INC. OR ITS CONTRIBUTORS BE LIABLE FOR ANY DIRECT DAMAGES
+ * IN EXCESS OF $1,000, NOR FOR ANY INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE
+ * USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+ * DAMAGE.
+ * 
+ * ====================================================================
+ * 
+ * This software consists of voluntary contributions made by Vovida
+ * Networks, Inc. and many individuals on behalf of Vovida Networks,
+ * Inc.  For more information on Vovida Networks, Inc., please see
+ * <http://www.vovida.org/>.
+ *
+ */
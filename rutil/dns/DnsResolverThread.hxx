@@ -0,0 +1,135 @@
+#if !defined(RESIP_DNSRESOLVERTHREAD_HXX)
+#define RESIP_DNSRESOLVERTHREAD_HXX
+
+#include <vector>
+
+#include "rutil/Data.hxx"
+#include "rutil/FdPoll.hxx"
+#include "rutil/Fifo.hxx"
+#include "rutil/GenericIPAddress.hxx"
+#include "rutil/SelectInterruptor.hxx"
+#include "rutil/Socket.hxx"
+#include "rutil/ThreadIf.hxx"
+#include "rutil/dns/ExternalDns.hxx"
+
+namespace resip
+{
+class DnsStub;
+class DnsRawSink;
+
+/**
+   @internal
+   @brief One of DnsStub's resolver threads; see DnsStub::startResolverThreads().
+
+   Owns an ExternalDns channel and drives it from its own thread, so the
+   socket I/O and retransmissions of many outstanding queries are spread
+   over several channels and threads. Lookups are handed in through a fifo.
+   Each raw answer is copied and queued back to the DnsStub as a Command, so
+   parsing, caching and the result sinks still run on the stub's thread.
+*/
+class DnsResolverThread : public ThreadIf, public ExternalDnsHandler
+{
+   public:
+      DnsResolverThread(DnsStub& stub);
+      virtual ~DnsResolverThread();
+
+      // call before run(); returns an ExternalDns::InitResult or provider error
+      int init(const std::vector<GenericIPAddress>& additionalNameservers,
+               AfterSocketCreationFuncPtr socketFunc,
+               int dnsTimeout, int dnsTries, unsigned int features);
+
+      // thread-safe; the answer reaches sink through the DnsStub's fifo
+      void lookup(const Data& target, unsigned short type, DnsRawSink* sink);
+      // thread-safe; re-reads the system nameservers, failing queries in flight
+      void reinit(int dnsTimeout, int dnsTries, unsigned int features);
+
+      virtual void thread();
+      virtual void shutdown();
+
+      virtual void handleDnsRaw(ExternalDnsRawResult);
+
+   private:
+      class Request
+      {
+         public:
+            Request(const Data& target, unsigned short type, DnsRawSink* sink)
+               : mTarget(target), mType(type), mSink(sink),
+                 mReinit(false), mTimeout(0), mTries(0), mFeatures(0)
+            {}
+            Request(int timeout, int tries, unsigned int features)
+               : mType(0), mSink(0),
+                 mReinit(true), mTimeout(timeout), mTries(tries), mFeatures(features)
+            {}
+
+            Data mTarget;
+            unsigned short mType;
+            DnsRawSink* mSink;
+            bool mReinit;
+            int mTimeout;
+            int mTries;
+            unsigned int mFeatures;
+      };
+
+      void processRequests();
+
+      DnsStub& mStub;
+      ExternalDns* mDnsProvider;
+      FdPollGrp* mPollGrp;
+      SelectInterruptor mSelectInterruptor;
+      FdPollItemHandle mInterruptorHandle;
+      Fifo<Request> mRequests;
+};
+
+}
+
+#endif
+
+/* ====================================================================
+ * The Vovida Software License, Version 1.0 
+ * 
+ * Copyright (c) 2000 Vovida Networks, Inc.  All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 
+ * 3. The names "VOCAL", "Vovida Open Communication Application Library",
+ *    and "Vovida Open Communication Application Library (VOCAL)" must
+ *    not be used to endorse or promote products derived from this
+ *    software without prior written permission. For written
+ *    permission, please contact vocal@vovida.org.
+ *
+ * 4. Products derived from this software may not be called "VOCAL", nor
+ *    may "VOCAL" appear in their name, without prior written
+ *    permission of Vovida Networks, Inc.
+ * 
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESSED OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE, TITLE AND
+ * NON-INFRINGEMENT ARE DISCLAIMED.  IN NO EVENT SHALL VOVIDA
+ * NETWORKS, INC. OR ITS CONTRIBUTORS BE LIABLE FOR ANY DIRECT DAMAGES
+ * IN EXCESS OF $1,000, NOR FOR ANY INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE
+ * USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+ * DAMAGE.
+ * 
+ * ====================================================================
+ * 
+ * This software consists of voluntary contributions made by Vovida
+ * Networks, Inc. and many individuals on behalf of Vovida Networks,
+ * Inc.  For more information on Vovida Networks, Inc., please see
+ * <http://www.vovida.org/>.
+ *
+ */
@@ -24,8 +24,10 @@
 #include "rutil/compat.hxx"
 #include "rutil/BaseException.hxx"
 #include "rutil/Data.hxx"
+#include "rutil/DnsUtil.hxx"
 #include "rutil/Inserter.hxx"
 #include "rutil/dns/DnsStub.hxx"
+#include "rutil/dns/DnsResolverThread.hxx"
 #include "rutil/dns/ExternalDns.hxx"
 #include "rutil/dns/ExternalDnsFactory.hxx"
 #include "rutil/dns/QueryTypes.hxx"
@@ -82,13 +84,17 @@ DnsResultSink::onLogDnsResult(const DNSResult<DnsCnameRecord>& rr)
 DnsStub::DnsStub(const NameserverList& additional,
                  AfterSocketCreationFuncPtr socketFunc,
                  AsyncProcessHandler* asyncProcessHandler,
-                 FdPollGrp *pollGrp) :
+                 FdPollGrp *pollGrp,
+                 SharedPtr<RRCache> cache) :
    mInterruptorHandle(0),
    mCommandFifo(&mSelectInterruptor),
    mTransform(0),
    mDnsProvider(ExternalDnsFactory::createExternalDns()),
+   mAdditionalNameservers(additional),
+   mSocketFunc(socketFunc),
    mPollGrp(0),
-   mAsyncProcessHandler(asyncProcessHandler)
+   mAsyncProcessHandler(asyncProcessHandler),
+   mRRCache(cache.get() ? cache : SharedPtr<RRCache>(new RRCache))
 {
    setPollGrp(pollGrp);
 
@@ -111,10 +117,22 @@ DnsStub::DnsStub(const NameserverList& additional,
 
 DnsStub::~DnsStub()
 {
+   stopResolverThreads();
+   // drop answers the resolver threads queued for queries that die below
+   while (mCommandFifo.messageAvailable())
+   {
+      delete mCommandFifo.getNext();
+   }
+
    for (set<Query*>::iterator it = mQueries.begin(); it != mQueries.end(); ++it)
    {
       delete *it;
    }
+   // after the queries, which report to them
+   for (set<HostQuery*>::iterator it = mHostQueries.begin(); it != mHostQueries.end(); ++it)
+   {
+      delete *it;
+   }
 
    setPollGrp(0);
    delete mDnsProvider;
@@ -178,7 +196,7 @@ DnsStub::cache(const Data& key,
                in_addr addr)
 {
    DnsHostRecord record(key, addr);
-   mRRCache.updateCacheFromHostFile(record);
+   mRRCache->updateCacheFromHostFile(record);
 }
 
 void
@@ -226,7 +244,7 @@ DnsStub::cache(const Data& key,
    vector<RROverlay>::iterator itHigh = upper_bound(overlays.begin(), overlays.end(), *overlays.begin());
    while (itLow != overlays.end())
    {
-      mRRCache.updateCache(key, (*itLow).type(), itLow, itHigh);
+      mRRCache->updateCache(key, (*itLow).type(), itLow, itHigh);
       itLow = itHigh;
       if (itHigh != overlays.end())
       {
@@ -267,7 +285,7 @@ DnsStub::cacheTTL(const Data& key,
       return;
    }
 
-   mRRCache.cacheTTL(key, rrType, status, soa[0]);
+   mRRCache->cacheTTL(key, rrType, status, soa[0]);
 }
 
 const unsigned char*
@@ -373,6 +391,25 @@ DnsStub::removeQuery(Query* query)
    {
       mQueries.erase(it);
    }
+
+   InFlightMap::iterator f = mInFlight.find(query->key());
+   if (f != mInFlight.end() && f->second == query)
+   {
+      mInFlight.erase(f);
+   }
+}
+
+void
+DnsStub::refreshQuery(const ResultConverter& conv, const Data& target, int rrType, bool followCname, int proto)
+{
+   if (mInFlight.find(QueryKey(target, rrType, followCname, proto)) != mInFlight.end())
+   {
+      return;
+   }
+
+   Query* query = new Query(*this, mTransform, conv.clone(), target, rrType, followCname, proto, 0);
+   mQueries.insert(query);
+   query->refresh();
 }
 
 void
@@ -417,10 +454,12 @@ DnsStub::Query::Query(DnsStub& stub, ResultTransform* transform, ResultConverter
      mTarget(target),
      mProto(proto),
      mReQuery(0),
-     mSink(s),
      mFollowCname(followCname)
 {
-   resip_assert(s);
+   if (s)
+   {
+      mSinks.push_back(s);
+   }
 }
 
 DnsStub::Query::~Query()
@@ -466,10 +505,13 @@ DnsStub::Query::go()
    StackLog(<< "DNS query of:" << mTarget << " " << typeToData(mRRType));
 
    DnsResourceRecordsByPtr records;
+
+   RRCache::ResultRef recordsRef;
    int status = 0;
    bool cached = false;
+   bool refresh = false;
    Data targetToQuery = mTarget;
-   cached = mStub.mRRCache.lookup(mTarget, mRRType, mProto, records, status);
+   cached = mStub.mRRCache->lookup(mTarget, mRRType, mProto, records, recordsRef, status, refresh);
 
    if (!cached)
    {
@@ -478,7 +520,8 @@ DnsStub::Query::go()
          do
          {
             DnsResourceRecordsByPtr cnames;
-            cached = mStub.mRRCache.lookup(targetToQuery, T_CNAME, mProto, cnames, status);
+            RRCache::ResultRef cnamesRef;
+            cached = mStub.mRRCache->lookup(targetToQuery, T_CNAME, mProto, cnames, cnamesRef, status);
             if (cached)
             {
                targetToQuery = (dynamic_cast<DnsCnameRecord*>(cnames[0]))->cname();
@@ -490,7 +533,7 @@ DnsStub::Query::go()
    if (targetToQuery != mTarget)
    {
       StackLog(<< mTarget << " mapped to CNAME " << targetToQuery);
-      cached = mStub.mRRCache.lookup(targetToQuery, mRRType, mProto, records, status);
+      cached = mStub.mRRCache->lookup(targetToQuery, mRRType, mProto, records, recordsRef, status, refresh);
    }
 
    if (!cached)
@@ -504,19 +547,20 @@ DnsStub::Query::go()
          {
             mStub.cache(mTarget, address);
             DnsResourceRecordsByPtr result;
+            RRCache::ResultRef resultRef;
             int queryStatus = 0;
 
-            mStub.mRRCache.lookup(mTarget, mRRType, mProto, result, queryStatus);
+            mStub.mRRCache->lookup(mTarget, mRRType, mProto, result, resultRef, queryStatus);
             if (mTransform)
             {
                 mTransform->transform(mTarget, mRRType, result);
             }
-            mResultConverter->notifyUser(mTarget, queryStatus, mStub.errorMessage(queryStatus), result, mSink);
+            notify(queryStatus, mStub.errorMessage(queryStatus), result);
          }
          else
          {
             // Not in hosts file - return error - or.. we could fallback to doing the lookupRecords call on the local named
-            mResultConverter->notifyUser(mTarget, ARES_ENOTFOUND, mStub.errorMessage(ARES_ENOTFOUND), Empty, mSink);
+            notify(ARES_ENOTFOUND, mStub.errorMessage(ARES_ENOTFOUND), Empty);
          }
          mReQuery = 0;
          mStub.removeQuery(this);
@@ -526,7 +570,7 @@ DnsStub::Query::go()
       else
       {
          StackLog (<< targetToQuery << " not cached. Doing external dns lookup");
-         mStub.lookupRecords(targetToQuery, mRRType, this);
+         lookup(targetToQuery);
       }
    }
    else // is cached
@@ -535,13 +579,61 @@ DnsStub::Query::go()
       {
          mTransform->transform(mTarget, mRRType, records);
       }
-      mResultConverter->notifyUser(mTarget, status, mStub.errorMessage(status), records, mSink);
+      notify(status, mStub.errorMessage(status), records);
+
+      if (refresh)
+      {
+         // stale or about to expire; one background query brings it up to date
+         mStub.refreshQuery(*mResultConverter, mTarget, mRRType, mFollowCname, mProto);
+      }
 
       mStub.removeQuery(this);
       delete this;
    }
 }
 
+void
+DnsStub::Query::refresh()
+{
+   StackLog(<< "Refreshing cached " << typeToData(mRRType) << " records of " << mTarget);
+   lookup(mTarget);
+}
+
+void
+DnsStub::Query::lookup(const Data& targetToQuery)
+{
+   InFlightMap::iterator it = mStub.mInFlight.find(key());
+   if (it != mStub.mInFlight.end())
+   {
+      StackLog(<< "Joining in-flight " << typeToData(mRRType) << " query for " << mTarget);
+      it->second->mSinks.insert(it->second->mSinks.end(), mSinks.begin(), mSinks.end());
+      mStub.removeQuery(this);
+      delete this;
+      return;
+   }
+
+   mStub.mInFlight[key()] = this;
+   mStub.lookupRecords(targetToQuery, mRRType, this);
+}
+
+void
+DnsStub::Query::notify(int status, const Data& msg, const DnsResourceRecordsByPtr& src)
+{
+   // This query is finished; stop taking on sinks before calling any, since a
+   // sink may issue the same lookup again from its callback.
+   InFlightMap::iterator f = mStub.mInFlight.find(key());
+   if (f != mStub.mInFlight.end() && f->second == this)
+   {
+      mStub.mInFlight.erase(f);
+   }
+   std::vector<DnsResultSink*> sinks;
+   sinks.swap(mSinks);
+   for (std::vector<DnsResultSink*>::iterator it = sinks.begin(); it != sinks.end(); ++it)
+   {
+      mResultConverter->notifyUser(mTarget, status, msg, src, *it);
+   }
+}
+
 void
 DnsStub::Query::process(int status, const unsigned char* abuf, const int alen)
 {
@@ -563,14 +655,15 @@ DnsStub::Query::process(int status, const unsigned char* abuf, const int alen)
                   mStub.cache(mTarget, address);
                   mReQuery = 0;
                   DnsResourceRecordsByPtr result;
+                  RRCache::ResultRef resultRef;
                   int queryStatus = 0;
 
-                  mStub.mRRCache.lookup(mTarget, mRRType, mProto, result, queryStatus);
+                  mStub.mRRCache->lookup(mTarget, mRRType, mProto, result, resultRef, queryStatus);
                   if (mTransform)
                   {
                      mTransform->transform(mTarget, mRRType, result);
                   }
-                  mResultConverter->notifyUser(mTarget, queryStatus, mStub.errorMessage(queryStatus), result, mSink);
+                  notify(queryStatus, mStub.errorMessage(queryStatus), result);
                   mStub.removeQuery(this);
                   delete this;
                   return;
@@ -623,7 +716,7 @@ DnsStub::Query::process(int status, const unsigned char* abuf, const int alen)
 
       // For other error status values, we may also want to cacheTTL to delay
       // requeries. Especially if the server refuses.
-      mResultConverter->notifyUser(mTarget, status, mStub.errorMessage(status), Empty, mSink);
+      notify(status, mStub.errorMessage(status), Empty);
       mReQuery = 0;
       mStub.removeQuery(this);
       delete this;
@@ -645,7 +738,7 @@ DnsStub::Query::process(int status, const unsigned char* abuf, const int alen)
       catch (BaseException& e)
       {
          ErrLog(<< "Error parsing DNS record for " << mTarget << ": " << e.getMessage());
-         mResultConverter->notifyUser(mTarget, ARES_EFORMERR, e.getMessage(), Empty, mSink);
+         notify(ARES_EFORMERR, e.getMessage(), Empty);
          mStub.removeQuery(this);
          delete this;
          return;
@@ -655,7 +748,7 @@ DnsStub::Query::process(int status, const unsigned char* abuf, const int alen)
    int ancount = DNS_HEADER_ANCOUNT(abuf);
    if (ancount == 0)
    {
-      mResultConverter->notifyUser(mTarget, 0, mStub.errorMessage(0), Empty, mSink);
+      notify(0, mStub.errorMessage(0), Empty);
    }
    else
    {
@@ -667,15 +760,16 @@ DnsStub::Query::process(int status, const unsigned char* abuf, const int alen)
       {
          mReQuery = 0;
          DnsResourceRecordsByPtr result;
+         RRCache::ResultRef resultRef;
          int queryStatus = 0;
 
          if (mTarget != targetToQuery) DebugLog (<< mTarget << " mapped to " << targetToQuery << " and returned result");
-         mStub.mRRCache.lookup(targetToQuery, mRRType, mProto, result, queryStatus);
+         mStub.mRRCache->lookup(targetToQuery, mRRType, mProto, result, resultRef, queryStatus);
          if (mTransform)
          {
             mTransform->transform(mTarget, mRRType, result);
          }
-         mResultConverter->notifyUser(mTarget, queryStatus, mStub.errorMessage(queryStatus), result, mSink);
+         notify(queryStatus, mStub.errorMessage(queryStatus), result);
       }
    }
 
@@ -704,7 +798,7 @@ DnsStub::Query::followCname(const unsigned char* aptr, const unsigned char*abuf,
    if (ARES_SUCCESS != ares_expand_name(aptr, abuf, alen, &name, &len))
    {
       ErrLog(<< "Failed DNS preparse for " << targetToQuery);
-      mResultConverter->notifyUser(mTarget, ARES_EFORMERR, "Failed DNS preparse", Empty, mSink);
+      notify(ARES_EFORMERR, "Failed DNS preparse", Empty);
       bGotAnswers = false;
       return;
    }
@@ -719,7 +813,7 @@ DnsStub::Query::followCname(const unsigned char* aptr, const unsigned char*abuf,
    catch (BaseException& e)
    {
       ErrLog(<< "Failed to cache result for " << targetToQuery << ": " << e.getMessage());
-      mResultConverter->notifyUser(mTarget, ARES_EFORMERR, e.getMessage(), Empty, mSink);
+      notify(ARES_EFORMERR, e.getMessage(), Empty);
       bGotAnswers = false;
       return;
    }
@@ -737,7 +831,8 @@ DnsStub::Query::followCname(const unsigned char* aptr, const unsigned char*abuf,
             do
             {
                DnsResourceRecordsByPtr cnames;
-               cached = mStub.mRRCache.lookup(targetToQuery, T_CNAME, mProto, cnames, status);
+               RRCache::ResultRef cnamesRef;
+               cached = mStub.mRRCache->lookup(targetToQuery, T_CNAME, mProto, cnames, cnamesRef, status);
                if (cached)
                {
                   ++mReQuery;
@@ -746,7 +841,9 @@ DnsStub::Query::followCname(const unsigned char* aptr, const unsigned char*abuf,
             } while(mReQuery < MAX_REQUERIES && cached);
 
             DnsResourceRecordsByPtr result;
-            if (!mStub.mRRCache.lookup(targetToQuery, mRRType, mProto, result, status))
+
+            RRCache::ResultRef resultRef;
+            if (!mStub.mRRCache->lookup(targetToQuery, mRRType, mProto, result, resultRef, status))
             {
                mStub.lookupRecords(targetToQuery, mRRType, this);
                bDeleteThis = false;
@@ -756,7 +853,7 @@ DnsStub::Query::followCname(const unsigned char* aptr, const unsigned char*abuf,
          else
          {
             mReQuery = 0;
-            mResultConverter->notifyUser(mTarget, 1, mStub.errorMessage(1), Empty, mSink);
+            notify(1, mStub.errorMessage(1), Empty);
             bGotAnswers = false;
          }
       }
@@ -774,9 +871,50 @@ DnsStub::errorMessage(int status)
 void
 DnsStub::lookupRecords(const Data& target, unsigned short type, DnsRawSink* sink)
 {
+   if (!mResolverThreads.empty())
+   {
+      mResolverThreads[target.caseInsensitivehash() % mResolverThreads.size()]->lookup(target, type, sink);
+      return;
+   }
    mDnsProvider->lookup(target.c_str(), type, this, sink);
 }
 
+void
+DnsStub::startResolverThreads(unsigned int count)
+{
+   stopResolverThreads();
+   for (unsigned int i = 0; i < count; ++i)
+   {
+      DnsResolverThread* thread = new DnsResolverThread(*this);
+      int retCode = thread->init(mAdditionalNameservers, mSocketFunc, mDnsTimeout, mDnsTries, mDnsFeatures);
+      if (retCode != ExternalDns::Success)
+      {
+         Data err(Data::Take, mDnsProvider->errorMessage(retCode));
+         ErrLog(<< "Failed to initialize dns resolver thread: " << err);
+         delete thread;
+         break;
+      }
+      thread->run();
+      mResolverThreads.push_back(thread);
+   }
+   InfoLog(<< "Using " << mResolverThreads.size() << " dns resolver threads");
+}
+
+void
+DnsStub::stopResolverThreads()
+{
+   for (vector<DnsResolverThread*>::iterator it = mResolverThreads.begin(); it != mResolverThreads.end(); ++it)
+   {
+      (*it)->shutdown();
+   }
+   for (vector<DnsResolverThread*>::iterator it = mResolverThreads.begin(); it != mResolverThreads.end(); ++it)
+   {
+      (*it)->join();
+      delete *it;
+   }
+   mResolverThreads.clear();
+}
+
 void
 DnsStub::handleDnsRaw(ExternalDnsRawResult res)
 {
@@ -832,7 +970,7 @@ DnsStub::clearDnsCache()
 void
 DnsStub::doClearDnsCache()
 {
-   mRRCache.clearCache();
+   mRRCache->clearCache();
 }
 
 void
@@ -845,7 +983,7 @@ DnsStub::logDnsCache()
 void
 DnsStub::doLogDnsCache()
 {
-   mRRCache.logCache();
+   mRRCache->logCache();
 }
 
 void 
@@ -860,10 +998,84 @@ DnsStub::doGetDnsCacheDump(std::pair<unsigned long, unsigned long> key, GetDnsCa
 {
    resip_assert(handler != 0);
    Data dnsCacheDump;
-   mRRCache.getCacheDump(dnsCacheDump);
+   mRRCache->getCacheDump(dnsCacheDump);
    handler->onDnsCacheDumpRetrieved(key, dnsCacheDump);
 }
 
+void
+DnsStub::lookupHost(const Data& host, DnsHostHandler* handler)
+{
+   LookupHostCommand* command = new LookupHostCommand(*this, host, handler);
+   queueCommand(command);
+}
+
+void
+DnsStub::doLookupHost(const Data& host, DnsHostHandler* handler)
+{
+   resip_assert(handler != 0);
+   if (DnsUtil::isIpAddress(host))
+   {
+      std::list<Data> addresses;
+      addresses.push_back(host);
+      handler->onHostResolved(host, addresses);
+      return;
+   }
+
+#ifdef USE_IPV6
+   // Both counts are taken up front; either query may answer from the cache
+   // before the other has been issued.
+   HostQuery* sink = new HostQuery(*this, host, handler, 2);
+   mHostQueries.insert(sink);
+   query<RR_A>(host, Protocol::Reserved, sink);
+   query<RR_AAAA>(host, Protocol::Reserved, sink);
+#else
+   HostQuery* sink = new HostQuery(*this, host, handler, 1);
+   mHostQueries.insert(sink);
+   query<RR_A>(host, Protocol::Reserved, sink);
+#endif
+}
+
+void
+DnsStub::HostQuery::onDnsResult(const DNSResult<DnsHostRecord>& result)
+{
+   if (result.status == 0)
+   {
+      for (std::vector<DnsHostRecord>::const_iterator it = result.records.begin(); it != result.records.end(); ++it)
+      {
+         mAddresses.push_back(it->host());
+      }
+   }
+   done();
+}
+
+void
+DnsStub::HostQuery::onDnsResult(const DNSResult<DnsAAAARecord>& result)
+{
+#ifdef USE_IPV6
+   if (result.status == 0)
+   {
+      for (std::vector<DnsAAAARecord>::const_iterator it = result.records.begin(); it != result.records.end(); ++it)
+      {
+         mAddresses.push_back(DnsUtil::inet_ntop(it->v6Address()));
+      }
+   }
+#endif
+   done();
+}
+
+void
+DnsStub::HostQuery::done()
+{
+   if (--mPending > 0)
+   {
+      return;
+   }
+   DebugLog (<< "Host lookup of " << mHost << ": " << Inserter(mAddresses));
+   mHandler->onHostResolved(mHost, mAddresses);
+   mStub.mHostQueries.erase(this);
+   delete this;
+}
+
 void
 DnsStub::reloadDnsServers()
 {
@@ -880,19 +1092,47 @@ DnsStub::doReloadDnsServers()
         doClearDnsCache();
 
         mDnsProvider->init(mDnsTimeout, mDnsTries, mDnsFeatures);
+        for (vector<DnsResolverThread*>::iterator it = mResolverThreads.begin(); it != mResolverThreads.end(); ++it)
+        {
+           (*it)->reinit(mDnsTimeout, mDnsTries, mDnsFeatures);
+        }
     }
 }
 
 void
 DnsStub::setDnsCacheTTL(int ttl)
 {
-   mRRCache.setTTL(ttl);
+   mRRCache->setTTL(ttl);
 }
 
 void
 DnsStub::setDnsCacheSize(int size)
 {
-   mRRCache.setSize(size);
+   mRRCache->setSize(size);
+}
+
+void
+DnsStub::setDnsCacheMaxBytes(size_t bytes)
+{
+   mRRCache->setMaxBytes(bytes);
+}
+
+void
+DnsStub::setDnsCacheTypeQuota(int rrType, size_t bytes)
+{
+   mRRCache->setTypeQuota(rrType, bytes);
+}
+
+void
+DnsStub::setDnsCacheServeStale(int maxStaleSecs)
+{
+   mRRCache->setServeStale(maxStaleSecs);
+}
+
+void
+DnsStub::setDnsCachePrefetch(int windowSecs, unsigned int minHits)
+{
+   mRRCache->setPrefetch(windowSecs, minHits);
 }
 
 /* ====================================================================
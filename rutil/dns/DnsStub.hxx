@@ -15,6 +15,7 @@
 #include "rutil/Fifo.hxx"
 #include "rutil/GenericIPAddress.hxx"
 #include "rutil/SelectInterruptor.hxx"
+#include "rutil/SharedPtr.hxx"
 #include "rutil/Socket.hxx"
 #include "rutil/dns/DnsResourceRecord.hxx"
 #include "rutil/dns/DnsAAAARecord.hxx"
@@ -31,6 +32,7 @@
 namespace resip
 {
 class FdPollGrp;
+class DnsResolverThread;
 
 class GetDnsCacheDumpHandler
 {
@@ -106,6 +108,15 @@ class DnsRawSink
       virtual void onDnsRaw(int statuts, const unsigned char* abuf, int len) = 0;
 };
 
+class DnsHostHandler
+{
+   public:
+      virtual ~DnsHostHandler() {}
+      // addresses holds the presentation form of each A (and, with USE_IPV6,
+      // AAAA) record found; it is empty if host could not be resolved.
+      virtual void onHostResolved(const Data& host, const std::list<Data>& addresses) = 0;
+};
+
 class DnsStub : public ExternalDnsHandler
 {
    public:
@@ -141,10 +152,16 @@ class DnsStub : public ExternalDnsHandler
             const char* name() const { return "DnsStubException"; }
       };
 
+      /**
+         @param cache An RRCache to use instead of a private one.  Passing the
+                same cache to several DnsStubs (one per SipStack, say) lets them
+                share answers; the cache settings below then apply to all of them.
+      */
       DnsStub(const NameserverList& additional = EmptyNameserverList,
               AfterSocketCreationFuncPtr socketFunc = 0,
               AsyncProcessHandler* asyncProcessHandler = 0,
-              FdPollGrp *pollGrp = 0);
+              FdPollGrp *pollGrp = 0,
+              SharedPtr<RRCache> cache = SharedPtr<RRCache>());
       ~DnsStub();
 
       // call this method before you create SipStack if you'd like to change the
@@ -179,8 +196,30 @@ class DnsStub : public ExternalDnsHandler
       void getDnsCacheDump(std::pair<unsigned long, unsigned long> key, GetDnsCacheDumpHandler* handler);
       void setDnsCacheTTL(int ttl);
       void setDnsCacheSize(int size);
+      // Bound the cache by the approximate bytes its records hold, overall and
+      // per RR type (e.g. to keep large NAPTR sets from crowding out A records).
+      void setDnsCacheMaxBytes(size_t bytes);
+      void setDnsCacheTypeQuota(int rrType, size_t bytes);
+      const SharedPtr<RRCache>& getDnsCache() const { return mRRCache; }
+      // Answer from expired cache entries for up to maxStaleSecs while a single
+      // background query refreshes them; 0 (the default) disables serve-stale.
+      void setDnsCacheServeStale(int maxStaleSecs);
+      // Refresh entries hit at least minHits times since their last refresh
+      // when fewer than windowSecs remain before they expire; 0 disables.
+      void setDnsCachePrefetch(int windowSecs, unsigned int minHits);
       void reloadDnsServers();
       bool checkDnsChange();
+
+      /**
+         Spread outgoing queries over count resolver threads, each driving a
+         channel of its own; a query goes to the thread picked by hashing its
+         target.  Answers come back through the command fifo, so results are
+         still parsed, cached and delivered on the thread that processes this
+         DnsStub.  Call before the first lookup; 0 stops the threads and sends
+         queries through the stub's own channel again.
+      */
+      void startResolverThreads(unsigned int count);
+      void stopResolverThreads();
       bool supportedType(int);
 
       template<class QueryType> void lookup(const Data& target, DnsResultSink* sink)
@@ -201,6 +240,14 @@ class DnsStub : public ExternalDnsHandler
          queueCommand(command);
       }
 
+      /**
+         Resolves host to its addresses without blocking the caller; use this
+         rather than DnsUtil::lookupARecords anywhere but at startup.  handler
+         is called exactly once, from the thread that processes this DnsStub,
+         and must outlive the lookup.  An IP address is handed back as is.
+      */
+      void lookupHost(const Data& host, DnsHostHandler* handler);
+
       virtual void handleDnsRaw(ExternalDnsRawResult);
 
       virtual void process(FdSet& fdset);
@@ -228,6 +275,7 @@ class DnsStub : public ExternalDnsHandler
                                     const Data& msg,
                                     const DnsResourceRecordsByPtr& src,
                                     DnsResultSink* sink) = 0;
+            virtual ResultConverter* clone() const = 0;
             virtual ~ResultConverter() {}
       };
       
@@ -253,23 +301,57 @@ class DnsStub : public ExternalDnsHandler
                sink->onLogDnsResult(result);
                sink->onDnsResult(result);
             }
+
+            virtual ResultConverter* clone() const
+            {
+               return new ResultConverterImpl<QueryType>();
+            }
+      };
+
+      // Identifies a lookup for coalescing; target is compared case-insensitively.
+      class QueryKey
+      {
+         public:
+            QueryKey(const Data& target, int rrType, bool followCname, int proto)
+               : mTarget(Data(target).lowercase()), mRRType(rrType), mFollowCname(followCname), mProto(proto)
+            {}
+
+            bool operator<(const QueryKey& rhs) const
+            {
+               if (mRRType != rhs.mRRType) return mRRType < rhs.mRRType;
+               if (mFollowCname != rhs.mFollowCname) return mFollowCname < rhs.mFollowCname;
+               if (mProto != rhs.mProto) return mProto < rhs.mProto;
+               return mTarget < rhs.mTarget;
+            }
+
+         private:
+            Data mTarget;
+            int mRRType;
+            bool mFollowCname;
+            int mProto;
       };
 
       class Query : public DnsRawSink
       {
          public:
+            // s may be 0 for a background refresh that only updates the cache
             Query(DnsStub& stub, ResultTransform* transform, ResultConverter* resultConv, 
                   const Data& target, int rrType, bool followCname, int proto, DnsResultSink* s);
             virtual ~Query();
 
             enum {MAX_REQUERIES = 5};
 
+            QueryKey key() const { return QueryKey(mTarget, mRRType, mFollowCname, mProto); }
             void go();
+            void refresh();
             void process(int status, const unsigned char* abuf, const int alen);
             void onDnsRaw(int status, const unsigned char* abuf, int alen);
             void followCname(const unsigned char* aptr, const unsigned char*abuf, const int alen, bool& bGotAnswers, bool& bDeleteThis, Data& targetToQuery);
 
          private:
+            void lookup(const Data& targetToQuery);
+            void notify(int status, const Data& msg, const DnsResourceRecordsByPtr& src);
+
             static DnsResourceRecordsByPtr Empty;
             int mRRType;
             DnsStub& mStub;
@@ -278,7 +360,7 @@ class DnsStub : public ExternalDnsHandler
             Data mTarget;
             int mProto;
             int mReQuery;
-            DnsResultSink* mSink;
+            std::vector<DnsResultSink*> mSinks; // every caller waiting on this lookup
             bool mFollowCname;
       };
 
@@ -428,6 +510,52 @@ class DnsStub : public ExternalDnsHandler
             GetDnsCacheDumpHandler* mHandler;
       };
 
+      void doLookupHost(const Data& host, DnsHostHandler* handler);
+
+      class LookupHostCommand : public Command
+      {
+         public:
+            LookupHostCommand(DnsStub& stub, const Data& host, DnsHostHandler* handler)
+               : mStub(stub), mHost(host), mHandler(handler)
+            {}
+            ~LookupHostCommand() {}
+            void execute()
+            {
+               mStub.doLookupHost(mHost, mHandler);
+            }
+
+         private:
+            DnsStub& mStub;
+            Data mHost;
+            DnsHostHandler* mHandler;
+      };
+
+      // Collects the A and AAAA answers for one lookupHost() call, then
+      // reports them and deletes itself.  Those still waiting when the
+      // stub is destroyed are deleted with it, unreported.
+      class HostQuery : public DnsResultSink
+      {
+         public:
+            HostQuery(DnsStub& stub, const Data& host, DnsHostHandler* handler, int pending)
+               : mStub(stub), mHost(host), mHandler(handler), mPending(pending)
+            {}
+
+            void onDnsResult(const DNSResult<DnsHostRecord>&);
+            void onDnsResult(const DNSResult<DnsAAAARecord>&);
+            void onDnsResult(const DNSResult<DnsSrvRecord>&) { resip_assert(0); }
+            void onDnsResult(const DNSResult<DnsNaptrRecord>&) { resip_assert(0); }
+            void onDnsResult(const DNSResult<DnsCnameRecord>&) { resip_assert(0); }
+
+         private:
+            void done();
+
+            DnsStub& mStub;
+            Data mHost;
+            DnsHostHandler* mHandler;
+            int mPending;
+            std::list<Data> mAddresses;
+      };
+
       void doReloadDnsServers();
 
       class ReloadDnsServersCommand : public Command
@@ -460,13 +588,22 @@ class DnsStub : public ExternalDnsHandler
                                          std::vector<RROverlay>&,
                                          bool discard=false);
       void removeQuery(Query*);
+      void refreshQuery(const ResultConverter& conv, const Data& target, int rrType, bool followCname, int proto);
       void lookupRecords(const Data& target, unsigned short type, DnsRawSink* sink);
       Data errorMessage(int status);
 
       ResultTransform* mTransform;
       ExternalDns* mDnsProvider;
+      std::vector<DnsResolverThread*> mResolverThreads;
+      NameserverList mAdditionalNameservers; // for the resolver threads' channels
+      AfterSocketCreationFuncPtr mSocketFunc;
       FdPollGrp* mPollGrp;
       std::set<Query*> mQueries;
+      std::set<HostQuery*> mHostQueries;  // lookupHost() calls not yet answered
+      // queries waiting on the external resolver, so that identical lookups
+      // arriving meanwhile attach to them instead of querying again
+      typedef std::map<QueryKey, Query*> InFlightMap;
+      InFlightMap mInFlight;
 
       std::vector<Data> mEnumSuffixes; // where to do enum lookups
       std::map<Data,Data> mEnumDomains;
@@ -478,8 +615,8 @@ class DnsStub : public ExternalDnsHandler
       /// if this object exists, it gets notified when ApplicationMessage's get posted
       AsyncProcessHandler* mAsyncProcessHandler;
 
-      /// Dns Cache
-      RRCache mRRCache;
+      /// Dns Cache, possibly shared with other DnsStubs
+      SharedPtr<RRCache> mRRCache;
 };
 
 typedef DnsStub::Protocol Protocol;
@@ -30,6 +30,7 @@
 #include "rutil/ResipAssert.h"
 #include "rutil/BaseException.hxx"
 #include "rutil/Data.hxx"
+#include "rutil/Lock.hxx"
 #include "rutil/Timer.hxx"
 #include "rutil/dns/RRFactory.hxx"
 #include "rutil/dns/RROverlay.hxx"
@@ -46,11 +47,20 @@
 using namespace resip;
 using namespace std;
 
+HashValueImp(resip::RRCacheKey, data.hash());
+
 RRCache::RRCache() 
    : mHead(),
      mLruHead(LruListType::makeList(&mHead)),
+     mBytes(0),
      mUserDefinedTTL(DEFAULT_USER_DEFINED_TTL),
-     mSize(DEFAULT_SIZE)
+     mSize(DEFAULT_SIZE),
+     mMaxBytes(0),
+     mMaxStale(0),
+     mPrefetchWindow(0),
+     mPrefetchMinHits(0),
+     mHits(0),
+     mMisses(0)
 {
    mFactoryMap[T_CNAME] = &mCnameRecordFactory;
    mFactoryMap[T_NAPTR] = &mNaptrRecordFacotry;
@@ -64,28 +74,88 @@ RRCache::RRCache()
 RRCache::~RRCache()
 {
    cleanup();
+   for (TypeUsageMap::iterator it = mTypeUsage.begin(); it != mTypeUsage.end(); ++it)
+   {
+      delete it->second;
+   }
+}
+
+// The settings are read under the lock by whichever stub's thread uses the
+// cache, so they are changed under it too.
+void
+RRCache::setTTL(int ttl)
+{
+   if (ttl > 0)
+   {
+      Lock lock(mMutex);
+      mUserDefinedTTL = ttl * MIN_TO_SEC;
+   }
+}
+
+void
+RRCache::setServeStale(int maxStaleSecs)
+{
+   Lock lock(mMutex);
+   mMaxStale = maxStaleSecs > 0 ? maxStaleSecs : 0;
+}
+
+void
+RRCache::setPrefetch(int windowSecs, unsigned int minHits)
+{
+   Lock lock(mMutex);
+   mPrefetchWindow = windowSecs > 0 ? windowSecs : 0;
+   mPrefetchMinHits = minHits;
+}
+
+void
+RRCache::setSize(int size)
+{
+   Lock lock(mMutex);
+   mSize = size;
+   purge();
+}
+
+void
+RRCache::setMaxBytes(size_t bytes)
+{
+   Lock lock(mMutex);
+   mMaxBytes = bytes;
+   purge();
+}
+
+void
+RRCache::setTypeQuota(int rrType, size_t bytes)
+{
+   Lock lock(mMutex);
+   TypeUsage& typeUsage = usage(rrType);
+   typeUsage.mQuota = bytes;
+   purge(typeUsage);
+}
+
+size_t
+RRCache::bytes() const
+{
+   Lock lock(mMutex);
+   return mBytes;
 }
 
 void 
 RRCache::updateCacheFromHostFile(const DnsHostRecord &record)
 {
-   //FactoryMap::iterator it = mFactoryMap.find(T_A);
-   RRList* key = new RRList(record, 3600);         
-   RRSet::iterator lb = mRRSet.lower_bound(key);
-   if (lb != mRRSet.end() &&
-       !(mRRSet.key_comp()(key, *lb)))
+   Lock lock(mMutex);
+   RRMap::iterator it = find(record.name(), T_A);
+   if (it != mRRMap.end())
    {
-      (*lb)->update(record, 3600);
-      touch(*lb);
+      RRList* node = it->second;
+      size_t oldBytes = node->bytes();
+      node->update(record, 3600);
+      touch(node);
+      charge(node, oldBytes);
    }
    else
    {
-      RRList* val = new RRList(record, 3600);
-      mRRSet.insert(val);
-      mLruHead->push_back(val);
-      purge();
+      insert(new RRList(record, 3600));
    }
-   delete key;
 }
 
 void 
@@ -94,25 +164,23 @@ RRCache::updateCache(const Data& target,
                      Itr begin, 
                      Itr end)
 {
+   Lock lock(mMutex);
    Data domain = (*begin).domain();
-   FactoryMap::iterator it = mFactoryMap.find(rrType);
-   resip_assert(it != mFactoryMap.end());
-   RRList* key = new RRList(domain, rrType);         
-   RRSet::iterator lb = mRRSet.lower_bound(key);
-   if (lb != mRRSet.end() &&
-       !(mRRSet.key_comp()(key, *lb)))
+   FactoryMap::iterator factory = mFactoryMap.find(rrType);
+   resip_assert(factory != mFactoryMap.end());
+   RRMap::iterator it = find(domain, rrType);
+   if (it != mRRMap.end())
    {
-      (*lb)->update(it->second, begin, end, mUserDefinedTTL);
-      touch(*lb);
+      RRList* node = it->second;
+      size_t oldBytes = node->bytes();
+      node->update(factory->second, begin, end, mUserDefinedTTL);
+      touch(node);
+      charge(node, oldBytes);
    }
    else
    {
-      RRList* val = new RRList(it->second, domain, rrType, begin, end, mUserDefinedTTL);
-      mRRSet.insert(val);
-      mLruHead->push_back(val);
-      purge();
+      insert(new RRList(factory->second, domain, rrType, begin, end, mUserDefinedTTL));
    }
-   delete key;
 }
 
 void 
@@ -128,22 +196,39 @@ RRCache::cacheTTL(const Data& target,
       return;
    }
 
+   Lock lock(mMutex);
    if (ttl < mUserDefinedTTL)
    {
       ttl = mUserDefinedTTL;
    }
 
    RRList* val = new RRList(target, rrType, ttl, status);
-   RRSet::iterator it = mRRSet.find(val);
-   if (it != mRRSet.end())
+   RRMap::iterator it = find(target, rrType);
+   if (it != mRRMap.end())
    {
-      (*it)->remove();
-      delete *it;
-      mRRSet.erase(it);
+      val->copyCounters(*it->second);
+      erase(it);
    }
-   mRRSet.insert(val);
-   mLruHead->push_back(val);
-   purge();
+   insert(val);
+}
+
+RRCache::RRMap::iterator
+RRCache::find(const Data& target, const int type)
+{
+   return mRRMap.find(RRCacheKey(target, type));
+}
+
+bool
+RRCache::isDead(const RRList* node, UInt64 now) const
+{
+   // Expired entries stay in the map so that a refresh updates them in place
+   // and keeps their counters; they are only reaped once they can no longer
+   // be served, even as stale answers.
+   if (now < node->absoluteExpiry())
+   {
+      return false;
+   }
+   return node->status() != 0 || now >= node->absoluteExpiry() + mMaxStale;
 }
 
 bool 
@@ -151,57 +236,166 @@ RRCache::lookup(const Data& target,
                 const int type, 
                 const int protocol,
                 Result& records, 
+                ResultRef& ref,
                 int& status)
 {
-   records.empty();
+   Lock lock(mMutex);
+   records.clear();
+   ref.reset();
    status = 0;
-   RRList* key = new RRList(target, type);
-   RRSet::iterator it = mRRSet.find(key);
-   delete key;
-   if (it == mRRSet.end())
+   RRMap::iterator it = find(target, type);
+   if (it == mRRMap.end() || Timer::getTimeSecs() >= it->second->absoluteExpiry())
    {
       return false;
    }
-   else
+   RRList* node = it->second;
+   records = node->records(protocol);
+   ref = node->recordsRef();
+   status = node->status();
+   touch(node);
+   return true;
+}
+
+bool 
+RRCache::lookup(const Data& target, 
+                const int type, 
+                const int protocol,
+                Result& records, 
+                ResultRef& ref,
+                int& status,
+                bool& refresh)
+{
+   Lock lock(mMutex);
+   records.clear();
+   ref.reset();
+   status = 0;
+   refresh = false;
+   RRMap::iterator it = find(target, type);
+   if (it == mRRMap.end())
    {
-      if (Timer::getTimeSecs() >= (*it)->absoluteExpiry())
+      ++mMisses;
+      return false;
+   }
+
+   RRList* node = it->second;
+   UInt64 now = Timer::getTimeSecs();
+   if (now >= node->absoluteExpiry())
+   {
+      if (isDead(node, now))
       {
-         delete *it;
-         mRRSet.erase(it);
+         erase(it);
+         ++mMisses;
          return false;
       }
-      else
-      {
-         records = (*it)->records(protocol);
-         status = (*it)->status();
-         touch(*it);
-         return true;
-      }
+      refresh = true;
+   }
+   else if (mPrefetchWindow > 0 &&
+            node->absoluteExpiry() - now <= (UInt64)mPrefetchWindow &&
+            node->hitsSinceUpdate() >= mPrefetchMinHits)
+   {
+      refresh = true;
    }
+
+   ++mHits;
+   node->recordHit();
+   records = node->records(protocol);
+   ref = node->recordsRef();
+   status = node->status();
+   touch(node);
+   return true;
+}
+
+UInt64
+RRCache::hits() const
+{
+   Lock lock(mMutex);
+   return mHits;
+}
+
+UInt64
+RRCache::misses() const
+{
+   Lock lock(mMutex);
+   return mMisses;
 }
 
 void 
 RRCache::clearCache()
 {
-    cleanup();
+   Lock lock(mMutex);
+   cleanup();
+}
+
+RRCache::TypeUsage&
+RRCache::usage(int rrType)
+{
+   TypeUsage*& typeUsage = mTypeUsage[rrType];
+   if (!typeUsage)
+   {
+      typeUsage = new TypeUsage;
+   }
+   return *typeUsage;
+}
+
+void
+RRCache::insert(RRList* node)
+{
+   TypeUsage& typeUsage = usage(node->rrType());
+   mRRMap[RRCacheKey(node->key(), node->rrType())] = node;
+   mLruHead->push_back(node);
+   typeUsage.mLruHead->push_back(node);
+   mBytes += node->bytes();
+   typeUsage.mBytes += node->bytes();
+   purge(typeUsage);
+   purge();
+}
+
+void
+RRCache::erase(RRMap::iterator it)
+{
+   RRList* node = it->second;
+   TypeUsage& typeUsage = usage(node->rrType());
+   mBytes -= node->bytes();
+   typeUsage.mBytes -= node->bytes();
+   mRRMap.erase(it);
+   delete node; // unlinks itself from both LRU lists
+}
+
+void
+RRCache::charge(RRList* node, size_t oldBytes)
+{
+   TypeUsage& typeUsage = usage(node->rrType());
+   mBytes = mBytes - oldBytes + node->bytes();
+   typeUsage.mBytes = typeUsage.mBytes - oldBytes + node->bytes();
+   if (node->bytes() > oldBytes)
+   {
+      purge(typeUsage);
+      purge();
+   }
 }
 
 void 
 RRCache::touch(RRList* node)
 {
-   node->remove();
+   node->LruListType::remove();
    mLruHead->push_back(node);
+   node->TypeLruListType::remove();
+   usage(node->rrType()).mLruHead->push_back(node);
 }
 
 void 
 RRCache::cleanup()
 {
-   for (std::set<RRList*, CompareT>::iterator it = mRRSet.begin(); it != mRRSet.end(); it++)
+   for (RRMap::iterator it = mRRMap.begin(); it != mRRMap.end(); ++it)
+   {
+      delete it->second;
+   }
+   mRRMap.clear();
+   mBytes = 0;
+   for (TypeUsageMap::iterator it = mTypeUsage.begin(); it != mTypeUsage.end(); ++it)
    {
-      (*it)->remove();
-      delete *it;
+      it->second->mBytes = 0;
    }
-   mRRSet.clear();
 }
 
 int 
@@ -226,29 +420,48 @@ RRCache::getTTL(const RROverlay& overlay)
 void 
 RRCache::purge()
 {
-   if (mRRSet.size() < mSize) return;
-   RRList* lst = *(mLruHead->begin());
-   RRSet::iterator it = mRRSet.find(lst);
-   resip_assert(it != mRRSet.end());
-   lst->remove();
-   delete *it;
-   mRRSet.erase(it);
+   // always leave the most recent entry, even if it alone is over the limit
+   while (mRRMap.size() > 1 &&
+          (mRRMap.size() > mSize || (mMaxBytes > 0 && mBytes > mMaxBytes)))
+   {
+      RRList* lst = *(mLruHead->begin());
+      RRMap::iterator it = find(lst->key(), lst->rrType());
+      resip_assert(it != mRRMap.end());
+      erase(it);
+   }
+}
+
+void
+RRCache::purge(TypeUsage& typeUsage)
+{
+   while (typeUsage.mQuota > 0 && typeUsage.mBytes > typeUsage.mQuota)
+   {
+      TypeLruListType::iterator oldest = typeUsage.mLruHead->begin();
+      TypeLruListType::iterator next = oldest;
+      if (oldest == typeUsage.mLruHead->end() || ++next == typeUsage.mLruHead->end())
+      {
+         break; // leave the most recent entry of the type
+      }
+      RRMap::iterator it = find((*oldest)->key(), (*oldest)->rrType());
+      resip_assert(it != mRRMap.end());
+      erase(it);
+   }
 }
 
 void 
 RRCache::logCache()
 {
+   Lock lock(mMutex);
    UInt64 now = Timer::getTimeSecs();
-   for (std::set<RRList*, CompareT>::iterator it = mRRSet.begin(); it != mRRSet.end(); )
+   for (RRMap::iterator it = mRRMap.begin(); it != mRRMap.end(); )
    {
-      if (now >= (*it)->absoluteExpiry())
+      if (isDead(it->second, now))
       {
-         delete *it;
-         mRRSet.erase(it++);
+         erase(it++);
       }
       else
       {
-         (*it)->log();
+         it->second->log();
          ++it;
       }
    }
@@ -257,18 +470,18 @@ RRCache::logCache()
 void 
 RRCache::getCacheDump(Data& dnsCacheDump)
 {
+   Lock lock(mMutex);
    UInt64 now = Timer::getTimeSecs();
    DataStream strm(dnsCacheDump);
-   for (std::set<RRList*, CompareT>::iterator it = mRRSet.begin(); it != mRRSet.end(); )
+   for (RRMap::iterator it = mRRMap.begin(); it != mRRMap.end(); )
    {
-      if (now >= (*it)->absoluteExpiry())
+      if (isDead(it->second, now))
       {
-         delete *it;
-         mRRSet.erase(it++);
+         erase(it++);
       }
       else
       {
-         (*it)->encodeRRList(strm);
+         it->second->encodeRRList(strm);
          ++it;
       }
    }
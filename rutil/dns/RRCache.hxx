@@ -5,6 +5,8 @@
 #include <set>
 #include <memory>
 
+#include "rutil/HashMap.hxx"
+#include "rutil/Mutex.hxx"
 #include "rutil/dns/RRFactory.hxx"
 #include "rutil/dns/DnsResourceRecord.hxx"
 #include "rutil/dns/DnsAAAARecord.hxx"
@@ -18,19 +20,70 @@ namespace resip
 {
 class RROverlay;
 
+/// Index of an RRCache entry: the lowercased domain plus the RR type.
+class RRCacheKey
+{
+   public:
+      RRCacheKey(const Data& target, int rrType)
+         : mTarget(Data(target).lowercase()), mRRType(rrType)
+      {}
+
+      bool operator==(const RRCacheKey& rhs) const
+      {
+         return mRRType == rhs.mRRType && mTarget == rhs.mTarget;
+      }
+
+      size_t hash() const { return mTarget.hash() ^ (size_t)mRRType; }
+
+   private:
+      Data mTarget;
+      int mRRType;
+};
+
+}
+
+HashValue(resip::RRCacheKey);
+
+namespace resip
+{
+
+/**
+   Cache of DNS answers keyed by (domain, RR type).  Entries live in a hash
+   index and on an LRU list; the cache is bounded by entry count, by the
+   approximate bytes held by its records, and optionally by a byte quota per
+   RR type.  All public methods lock, so one cache may be shared between
+   DnsStubs (and thus SipStacks) running on different threads.
+*/
 class RRCache
 {
    public:
       typedef RRList::Protocol Protocol;
       typedef RRList::LruList LruListType;
+      typedef RRList::TypeLruList TypeLruListType;
       typedef RRList::Records Result;
+      // keeps the records of a Result alive after lookup() releases the lock
+      typedef RRList::RecordsRef ResultRef;
       typedef std::vector<RROverlay>::const_iterator Itr;
       typedef std::vector<Data> DataArr;
 
       RRCache();
       ~RRCache();
-      void setTTL(int ttl) { if (ttl > 0) mUserDefinedTTL = ttl * MIN_TO_SEC; }
-      void setSize(int size) { mSize = size; }
+      void setTTL(int ttl);
+      void setSize(int size);
+      // Evict least recently used entries once the records held exceed this
+      // many bytes; 0 (the default) leaves only the entry count limit.
+      void setMaxBytes(size_t bytes);
+      // Bound the bytes held by entries of one RR type, evicting that type's
+      // least recently used entries first; 0 removes the quota.
+      void setTypeQuota(int rrType, size_t bytes);
+      size_t bytes() const;
+      // Keep answering from expired (positive) entries for up to maxStaleSecs
+      // while the caller refreshes them; 0 disables serve-stale.
+      void setServeStale(int maxStaleSecs);
+      // Ask the caller to refresh an entry that has been hit at least minHits
+      // times since its last refresh once fewer than windowSecs remain before
+      // it expires; a windowSecs of 0 disables prefetching.
+      void setPrefetch(int windowSecs, unsigned int minHits);
       // Update existing cache record, or add a new one
       void updateCache(const Data& target,
                        const int rrType,
@@ -42,7 +95,16 @@ class RRCache
                     const int rrType,
                     const int status,
                     RROverlay overlay);
-      bool lookup(const Data& target, const int type, const int proto, Result& records, int& status);
+      // Only returns unexpired entries, and does not touch the hit/miss counters.
+      bool lookup(const Data& target, const int type, const int proto, Result& records, ResultRef& ref, int& status);
+      // Lookup on behalf of a user query: counts hits and misses, may answer
+      // from a stale entry, and sets refresh when the entry is stale or due for
+      // prefetch so the caller can start a background query. An entry that
+      // can no longer be served is removed.
+      bool lookup(const Data& target, const int type, const int proto, Result& records, ResultRef& ref, int& status, bool& refresh);
+      // Totals over the user lookups above; a stale answer counts as a hit.
+      UInt64 hits() const;
+      UInt64 misses() const;
       void clearCache();
       void logCache();
       void getCacheDump(Data& dnsCacheDump);
@@ -52,37 +114,42 @@ class RRCache
       static const int DEFAULT_USER_DEFINED_TTL = 10; // in seconds.
 
       static const int DEFAULT_SIZE = 512;
-      class CompareT  : public std::binary_function<const RRList*, const RRList*, bool>
+
+      typedef HashMap<RRCacheKey, RRList*> RRMap;
+
+      // per RR type LRU list and byte usage
+      class TypeUsage
       {
          public:
-            bool operator()(RRList* lhs, RRList* rhs) const
-            {
-               if (lhs->rrType() < rhs->rrType())
-               {
-                  return true;
-               }
-               else if (lhs->rrType() > rhs->rrType())
-               {
-                  return false;
-               }
-               else
-               {
-                  return (Data(lhs->key())).lowercase() < (Data(rhs->key())).lowercase();
-               }
-            }
+            TypeUsage() : mLruHead(TypeLruListType::makeList(&mHead)), mBytes(0), mQuota(0) {}
+            RRList mHead;
+            TypeLruListType* mLruHead;
+            size_t mBytes;
+            size_t mQuota;
       };
-
+      typedef std::map<int, TypeUsage*> TypeUsageMap;
+
+      RRMap::iterator find(const Data& target, const int type);
+      bool isDead(const RRList* node, UInt64 now) const;
+      TypeUsage& usage(int rrType);
+      void insert(RRList* node);
+      void erase(RRMap::iterator it);
+      void charge(RRList* node, size_t oldBytes);
       void touch(RRList* node);
       void cleanup();
       int getTTL(const RROverlay& overlay);
       void purge();
+      void purge(TypeUsage& usage);
+
+      mutable Mutex mMutex;
 
       RRList mHead;
       LruListType* mLruHead;                     
       Result Empty;
 
-      typedef std::set<RRList*, CompareT> RRSet;
-      RRSet mRRSet;
+      RRMap mRRMap;
+      TypeUsageMap mTypeUsage;
+      size_t mBytes;
 
       RRFactory<DnsHostRecord> mHostRecordFactory;
       RRFactory<DnsSrvRecord> mSrvRecordFactory;
@@ -95,6 +162,12 @@ class RRCache
       
       int mUserDefinedTTL; // used when the ttl in RR is 0 or less than default(60). in seconds.
       unsigned int mSize;
+      size_t mMaxBytes;
+      int mMaxStale; // seconds past expiry a positive entry may still be served
+      int mPrefetchWindow; // in seconds.
+      unsigned int mPrefetchMinHits;
+      UInt64 mHits;
+      UInt64 mMisses;
 };
 
 }
@@ -36,19 +36,24 @@ using namespace std;
 
 #define RESIPROCATE_SUBSYSTEM resip::Subsystem::DNS
 
-RRList::RRList() : mRRType(0), mStatus(0), mAbsoluteExpiry(ULONG_MAX) {}
+RRList::RRList()
+   : mRRType(0), mStatus(0), mAbsoluteExpiry(ULONG_MAX), mHits(0), mHitsSinceUpdate(0),
+     mRecords(new RecordSet), mBytes(sizeof(RRList))
+{}
 
 RRList::RRList(const Data& key, 
                const int rrtype, 
                int ttl, 
                int status)
-   : mKey(key), mRRType(rrtype), mStatus(status)
+   : mKey(key), mRRType(rrtype), mStatus(status), mHits(0), mHitsSinceUpdate(0),
+     mRecords(new RecordSet), mBytes(sizeof(RRList) + key.size())
 {
    mAbsoluteExpiry = ttl + Timer::getTimeSecs();
 }
 
 RRList::RRList(const DnsHostRecord &record, int ttl)
-   : mKey(record.name()), mRRType(T_A), mStatus(0), mAbsoluteExpiry(ULONG_MAX)
+   : mKey(record.name()), mRRType(T_A), mStatus(0), mAbsoluteExpiry(ULONG_MAX),
+     mHits(0), mHitsSinceUpdate(0), mRecords(new RecordSet), mBytes(0)
 {
    update(record, ttl);
 }
@@ -59,17 +64,27 @@ void RRList::update(const DnsHostRecord &record, int ttl)
 
    RecordItem item;
    item.record = new DnsHostRecord(record);
-   mRecords.push_back(item);
+   mRecords->mItems.push_back(item);
+   mBytes += RecordOverhead + record.name().size();
    mAbsoluteExpiry = Timer::getTimeSecs() + ttl;
+   mHitsSinceUpdate = 0;
 }
       
 RRList::RRList(const Data& key, int rrtype)
-   : mKey(key), mRRType(rrtype), mStatus(0), mAbsoluteExpiry(ULONG_MAX)
+   : mKey(key), mRRType(rrtype), mStatus(0), mAbsoluteExpiry(ULONG_MAX),
+     mHits(0), mHitsSinceUpdate(0), mRecords(new RecordSet), mBytes(sizeof(RRList) + key.size())
 {}
 
 RRList::~RRList()
 {
-   this->clear();
+}
+
+RRList::RecordSet::~RecordSet()
+{
+   for (RecordArr::iterator it = mItems.begin(); it != mItems.end(); ++it)
+   {
+      delete (*it).record;
+   }
 }
 
 RRList::RRList(const RRFactoryBase* factory, 
@@ -78,7 +93,8 @@ RRList::RRList(const RRFactoryBase* factory,
                Itr begin,
                Itr end, 
                int ttl)
-   : mKey(key), mRRType(rrType), mStatus(0)
+   : mKey(key), mRRType(rrType), mStatus(0), mHits(0), mHitsSinceUpdate(0),
+     mRecords(new RecordSet), mBytes(0)
 {
    update(factory, begin, end, ttl);
 }
@@ -87,6 +103,7 @@ void RRList::update(const RRFactoryBase* factory, Itr begin, Itr end, int ttl)
 {
    this->clear();
    mAbsoluteExpiry = ULONG_MAX;
+   mHitsSinceUpdate = 0;
    
    for (Itr it = begin; it != end; it++)
    {
@@ -94,7 +111,8 @@ void RRList::update(const RRFactoryBase* factory, Itr begin, Itr end, int ttl)
       {
          RecordItem item;
          item.record = factory->create(*it);
-         mRecords.push_back(item);
+         mRecords->mItems.push_back(item);
+         mBytes += RecordOverhead + it->nameLength() + it->dataLength();
          if ((UInt64)it->ttl() < mAbsoluteExpiry)
          {
             mAbsoluteExpiry = it->ttl();
@@ -117,34 +135,37 @@ void RRList::update(const RRFactoryBase* factory, Itr begin, Itr end, int ttl)
 RRList::Records RRList::records(const int protocol)
 {
    Records records;
-   if (mRecords.empty()) return records;
+   if (mRecords->mItems.empty()) return records;
 
-   for (std::vector<RecordItem>::iterator it = mRecords.begin(); it != mRecords.end(); ++it)
+   for (std::vector<RecordItem>::iterator it = mRecords->mItems.begin(); it != mRecords->mItems.end(); ++it)
    {
       records.push_back((*it).record);
    }
    return records;
 }
 
+void RRList::copyCounters(const RRList& other)
+{
+   mHits = other.mHits;
+}
+
 RRList::RecordItr RRList::find(const Data& value)
 {
-   for (RecordItr it = mRecords.begin(); it != mRecords.end(); ++it)
+   for (RecordItr it = mRecords->mItems.begin(); it != mRecords->mItems.end(); ++it)
    {
       if ((*it).record->isSameValue(value))
       {
          return it;
       }
    }
-   return mRecords.end();
+   return mRecords->mItems.end();
 }
 
 void RRList::clear()
 {
-   for (RecordArr::iterator it = mRecords.begin(); it != mRecords.end(); ++it)
-   {
-      delete (*it).record;
-   }
-   mRecords.clear();
+   // readers may still hold the old set; it goes away with the last of them
+   mRecords = RecordsRef(new RecordSet);
+   mBytes = sizeof(RRList) + mKey.size();
 }
 
 EncodeStream&
@@ -203,14 +224,16 @@ RRList::encodeRecordItem(RRList::RecordItem& item, EncodeStream& strm)
       break;
    }
 
-   strm << " secsToExpirey=" << (mAbsoluteExpiry - Timer::getTimeSecs()) << " status=" << mStatus;
+   // a negative value means the entry is expired and only kept for serve-stale
+   strm << " secsToExpirey=" << ((Int64)mAbsoluteExpiry - (Int64)Timer::getTimeSecs()) << " status=" << mStatus
+        << " hits=" << mHits;
    strm.flush();
    return strm;
 }
 
 void RRList::log()
 {
-   for (RecordArr::iterator it = mRecords.begin(); it != mRecords.end(); ++it)
+   for (RecordArr::iterator it = mRecords->mItems.begin(); it != mRecords->mItems.end(); ++it)
    {
       Data buffer;
       DataStream strm(buffer);
@@ -223,7 +246,7 @@ void RRList::log()
 EncodeStream&
 RRList:: encodeRRList(EncodeStream& strm)
 {
-   for (RecordArr::iterator it = mRecords.begin(); it != mRecords.end(); ++it)
+   for (RecordArr::iterator it = mRecords->mItems.begin(); it != mRecords->mItems.end(); ++it)
    {
       encodeRecordItem(*it, strm);
       strm << endl;
@@ -4,6 +4,7 @@
 #include <vector>
 
 #include "rutil/IntrusiveListElement.hxx"
+#include "rutil/SharedPtr.hxx"
 #include "rutil/dns/RRFactory.hxx"
 
 namespace resip
@@ -11,7 +12,7 @@ namespace resip
 class DnsResourceRecord;
 class DnsHostRecord;
 
-class RRList : public IntrusiveListElement<RRList*>
+class RRList : public IntrusiveListElement<RRList*>, public IntrusiveListElement1<RRList*>
 {
    public:
 
@@ -26,7 +27,8 @@ class RRList : public IntrusiveListElement<RRList*>
       };
 
       typedef std::vector<DnsResourceRecord*> Records;
-      typedef IntrusiveListElement<RRList*> LruList;
+      typedef IntrusiveListElement<RRList*> LruList;      // all entries of a cache
+      typedef IntrusiveListElement1<RRList*> TypeLruList; // entries of one RR type
       typedef std::vector<RROverlay>::const_iterator Itr;
       typedef std::vector<Data> DataArr;
 
@@ -47,16 +49,7 @@ class RRList : public IntrusiveListElement<RRList*>
       void update(const RRFactoryBase* factory, Itr begin, Itr end, int ttl);
       Records records(const int protocol);
 
-      const Data& key() const { return mKey; }
-      int status() const { return mStatus; }
-      int rrType() const { return mRRType; }
-      UInt64 absoluteExpiry() const { return mAbsoluteExpiry; }
-      UInt64& absoluteExpiry() { return mAbsoluteExpiry; }
-      void log();
-      EncodeStream& encodeRRList(EncodeStream& strm);
-
    private:
-
       struct RecordItem
       {
             DnsResourceRecord* record;
@@ -66,7 +59,47 @@ class RRList : public IntrusiveListElement<RRList*>
       typedef std::vector<RecordItem> RecordArr;
       typedef RecordArr::iterator RecordItr;
 
-      RecordArr mRecords;
+   public:
+      // The records of one answer. An update swaps in a new set rather than
+      // rewriting this one, so a RecordsRef taken at lookup keeps the raw
+      // pointers handed out by records() valid after the cache lock is gone.
+      class RecordSet
+      {
+         public:
+            RecordSet() {}
+            ~RecordSet();
+            RecordArr mItems;
+
+         private:
+            RecordSet(const RecordSet&);
+            RecordSet& operator=(const RecordSet&);
+      };
+      typedef SharedPtr<RecordSet> RecordsRef;
+
+      const RecordsRef& recordsRef() const { return mRecords; }
+      // approximate heap footprint of this entry, used for byte-bounded caches
+      size_t bytes() const { return mBytes; }
+
+      const Data& key() const { return mKey; }
+      int status() const { return mStatus; }
+      int rrType() const { return mRRType; }
+      UInt64 absoluteExpiry() const { return mAbsoluteExpiry; }
+      UInt64& absoluteExpiry() { return mAbsoluteExpiry; }
+
+      // Lookup accounting; hits counts answers served from this entry, fresh
+      // or stale.
+      void recordHit() { ++mHits; ++mHitsSinceUpdate; }
+      UInt32 hits() const { return mHits; }
+      UInt32 hitsSinceUpdate() const { return mHitsSinceUpdate; }
+      void copyCounters(const RRList& other);
+
+      void log();
+      EncodeStream& encodeRRList(EncodeStream& strm);
+
+   private:
+      // per record allowance for the record object and its Data members on
+      // top of the raw name and rdata lengths
+      static const size_t RecordOverhead = 96;
 
       Data mKey;
       int mRRType;
@@ -74,6 +107,12 @@ class RRList : public IntrusiveListElement<RRList*>
       int mStatus; // dns query status.
       UInt64 mAbsoluteExpiry;
 
+      UInt32 mHits;
+      UInt32 mHitsSinceUpdate; // reset whenever the records are refreshed
+
+      RecordsRef mRecords;
+      size_t mBytes;
+
       RecordItr find(const Data&);
       void clear();
       EncodeStream& encodeRecordItem(RRList::RecordItem& item, EncodeStream& strm);
@@ -146,6 +146,35 @@ void Producer::thread()
    }
 }
 
+class FifoProducer: public ThreadIf
+{
+  public:
+      FifoProducer(Fifo<Foo>& f, int count) : mFifo(f), mCount(count) {}
+      virtual ~FifoProducer()
+      {
+         shutdown();
+         join();
+      }
+
+      void thread()
+      {
+         for (int n = 0; n < mCount; n++)
+         {
+            mFifo.add(new Foo(Data(n)));
+            if (n % 5000 == 0)
+            {
+               // let the consumer drain the fifo now and then, so that it
+               // also blocks and gets woken up
+               sleepMS(1);
+            }
+         }
+      }
+
+   private:
+      Fifo<Foo>& mFifo;
+      int mCount;
+};
+
 bool
 isNear(int value, int reference, int epsilon=250)
 {
@@ -355,6 +384,101 @@ main()
       }
    }
    
+   {
+      cerr << "!! Test lock-free basic" << endl;
+
+      TimeLimitFifo<Foo> tlfNS(5, 10); // 5 seconds, limit 10 (2 reserved)
+      tlfNS.setLockFree();
+      assert(tlfNS.isLockFree());
+      bool c;
+
+      assert(tlfNS.empty());
+      assert(tlfNS.timeDepth() == 0);
+      for (int i = 0; i < 8; ++i)
+      {
+         c = tlfNS.add(new Foo(Data("element") + Data(i)), TimeLimitFifo<Foo>::EnforceTimeDepth);
+         assert(c);
+      }
+      c = tlfNS.add(new Foo("nope"), TimeLimitFifo<Foo>::IgnoreTimeDepth);
+      assert(!c);
+      c = tlfNS.add(new Foo("yep"), TimeLimitFifo<Foo>::InternalElement);
+      assert(c);
+      assert(tlfNS.size() == 9);
+      assert(tlfNS.getCountDepth() == 9);
+
+      sleepMS(2000);
+      assert(tlfNS.timeDepth() > 1);
+
+      Foo* fp = tlfNS.getNext();
+      assert(fp->mVal == "element0");
+      delete fp;
+      assert(tlfNS.size() == 8);
+      while (!tlfNS.empty())
+      {
+         delete tlfNS.getNext();
+      }
+      assert(tlfNS.timeDepth() == 0);
+      assert(tlfNS.getNext(-1) == 0);
+
+      // getNext(ms) times out on an empty lock-free fifo too
+      Fifo<Foo> fifo;
+      fifo.setLockFree();
+      UInt64 begin(Timer::getTimeMs());
+      assert(fifo.getNext(500) == 0);
+      assert(isNear((int)(Timer::getTimeMs() - begin), 500, 200));
+
+      fifo.add(new Foo("left behind")); // deleted by ~Fifo
+   }
+
+   {
+      cerr << "!! Test lock-free producers consumer" << endl;
+
+      const int count = 100000;
+      Fifo<Foo> fifo;
+      fifo.setLockFree();
+
+      FifoProducer prod1(fifo, count);
+      FifoProducer prod2(fifo, count);
+      FifoProducer prod3(fifo, count);
+      FifoProducer prod4(fifo, count);
+      prod1.run();
+      prod2.run();
+      prod3.run();
+      prod4.run();
+
+      int received = 0;
+      while (received < 4*count)
+      {
+         if (received % 3 == 0)
+         {
+            Fifo<Foo>::Messages batch;
+            if (fifo.getMultiple(1000, batch, 100))
+            {
+               assert(!batch.empty() && batch.size() <= 100);
+               received += (int)batch.size();
+               while (!batch.empty())
+               {
+                  delete batch.front();
+                  batch.pop_front();
+               }
+               continue;
+            }
+         }
+         Foo* foo = fifo.getNext(1000);
+         assert(foo);
+         delete foo;
+         ++received;
+      }
+
+      prod1.join();
+      prod2.join();
+      prod3.join();
+      prod4.join();
+      assert(fifo.empty());
+      assert(fifo.size() == 0);
+      assert(fifo.getCountDepth() == 0);
+   }
+
    {
       cerr << "!! Test produce consumer" << endl;
 
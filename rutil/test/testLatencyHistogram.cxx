@@ -0,0 +1,195 @@
+#include <cassert>
+#include <iostream>
+#include "rutil/LatencyHistogram.hxx"
+#include "rutil/TimeLimitFifo.hxx"
+#include "rutil/ThreadIf.hxx"
+#include "rutil/Data.hxx"
+#ifndef WIN32
+#include <unistd.h>
+#endif
+
+using namespace resip;
+using namespace std;
+
+class Recorder : public ThreadIf
+{
+   public:
+      Recorder(LatencyHistogram& histogram, unsigned int count)
+         : mHistogram(histogram), mCount(count) {}
+      virtual void thread()
+      {
+         for (unsigned int i = 0; i < mCount; ++i)
+         {
+            mHistogram.record(i % 1000);
+         }
+      }
+   private:
+      LatencyHistogram& mHistogram;
+      unsigned int mCount;
+};
+
+static void
+testBuckets()
+{
+   // every value lands in a bucket whose range contains it, and the range
+   // is within 1/16 of the value
+   UInt64 previous = 0;
+   for (UInt64 v = 0; v < (UInt64(1) << 34); v = v < 4096 ? v + 1 : v + v / 7)
+   {
+      unsigned int bucket = LatencyHistogram::bucketOf(v);
+      assert(bucket < LatencyHistogram::BucketCount);
+      assert(LatencyHistogram::bucketOf(previous) <= bucket);
+      previous = v;
+      if (v < (UInt64(1) << 32))
+      {
+         UInt64 high = LatencyHistogram::highestEquivalentValue(bucket);
+         assert(high >= v);
+         assert(high - v <= v / 16);
+         assert(LatencyHistogram::bucketOf(high) == bucket);
+         if (bucket + 1 < LatencyHistogram::BucketCount)
+         {
+            assert(LatencyHistogram::bucketOf(high + 1) == bucket + 1);
+         }
+      }
+      else
+      {
+         assert(bucket == LatencyHistogram::BucketCount - 1);
+      }
+   }
+}
+
+static void
+testPercentiles()
+{
+   LatencyHistogram histogram;
+   LatencyHistogram::Snapshot empty;
+   histogram.snapshot(empty);
+   assert(empty.getCount() == 0);
+   assert(empty.percentile(50) == 0);
+   assert(empty.max() == 0);
+
+   for (UInt64 v = 1; v <= 10000; ++v)
+   {
+      histogram.record(v);
+   }
+   LatencyHistogram::Snapshot snap;
+   histogram.snapshot(snap);
+   assert(snap.getCount() == 10000);
+   UInt64 p50 = snap.percentile(50);
+   UInt64 p99 = snap.percentile(99);
+   cerr << "p50 " << p50 << " p99 " << p99 << " max " << snap.max() << endl;
+   assert(p50 >= 5000 && p50 <= 5000 + 5000 / 16);
+   assert(p99 >= 9900 && p99 <= 9900 + 9900 / 16);
+   assert(snap.max() >= 10000 && snap.max() <= 10000 + 10000 / 16);
+   assert(snap.percentile(0) == 1);
+
+   histogram.reset();
+   histogram.snapshot(snap);
+   assert(snap.getCount() == 0);
+}
+
+static void
+testConcurrentRecord()
+{
+   LatencyHistogram histogram;
+   const unsigned int count = 200000;
+   Recorder a(histogram, count);
+   Recorder b(histogram, count);
+   Recorder c(histogram, count);
+   a.run();
+   b.run();
+   c.run();
+   a.join();
+   b.join();
+   c.join();
+
+   LatencyHistogram::Snapshot snap;
+   histogram.snapshot(snap);
+   assert(snap.getCount() == 3 * count);
+}
+
+static void
+testFifoDwell()
+{
+   TimeLimitFifo<Data> fifo(0, 0);
+   LatencyHistogram histogram;
+
+   // not recorded; queued before the histogram was set
+   fifo.add(new Data("early"), TimeLimitFifo<Data>::InternalElement);
+   fifo.setDwellHistogram(&histogram);
+   fifo.add(new Data("late"), TimeLimitFifo<Data>::InternalElement);
+#ifdef WIN32
+   Sleep(20);
+#else
+   usleep(20*1000);
+#endif
+   delete fifo.getNext();
+   delete fifo.getNext(10);
+
+   LatencyHistogram::Snapshot snap;
+   histogram.snapshot(snap);
+   assert(snap.getCount() == 1);
+   cerr << "dwell " << snap.max() << "us" << endl;
+   assert(snap.max() >= 15000);
+}
+
+int
+main(int argc, char* argv[])
+{
+   testBuckets();
+   testPercentiles();
+   testConcurrentRecord();
+   testFifoDwell();
+   cerr << "All OK" << endl;
+   return 0;
+}
+
+/* ====================================================================
+ * The Vovida Software License, Version 1.0 
+ * 
+ * Copyright (c) 2000 Vovida Networks, Inc.  All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 
+ * 3. The names "VOCAL", "Vovida Open Communication Application Library",
+ *    and "Vovida Open Communication Application Library (VOCAL)" must
+ *    not be used to endorse or promote products derived from this
+ *    software without prior written permission. For written
+ *    permission, please contact vocal@vovida.org.
+ *
+ * 4. Products derived from this software may not be called "VOCAL", nor
+ *    may "VOCAL" appear in their name, without prior written
+ *    permission of Vovida Networks, Inc.
+ * 
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESSED OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE, TITLE AND
+ * NON-INFRINGEMENT ARE DISCLAIMED.  IN NO EVENT SHALL VOVIDA
+ * NETWORKS, INC. OR ITS CONTRIBUTORS BE LIABLE FOR ANY DIRECT DAMAGES
+ * IN EXCESS OF $1,000, NOR FOR ANY INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE
+ * USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+ * DAMAGE.
+ * 
+ * ====================================================================
+ * 
+ * This software consists of voluntary contributions made by Vovida
+ * Networks, Inc. and many individuals on behalf of Vovida Networks,
+ * Inc.  For more information on Vovida Networks, Inc., please see
+ * <http://www.vovida.org/>.
+ *
+ */
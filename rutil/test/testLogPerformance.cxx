@@ -0,0 +1,256 @@
+#include <cassert>
+#include <fstream>
+#include <iostream>
+#include <stdio.h>
+#include <stdlib.h>
+#include <vector>
+
+#include "rutil/Log.hxx"
+#include "rutil/Logger.hxx"
+#include "rutil/ThreadIf.hxx"
+#include "rutil/Timer.hxx"
+#include "rutil/Data.hxx"
+
+#define RESIPROCATE_SUBSYSTEM resip::Subsystem::TEST
+
+using namespace resip;
+using namespace std;
+
+static const char* const LogFile = "testLogPerformance.log";
+
+class LogWriter : public ThreadIf
+{
+   public:
+      LogWriter(int id, unsigned int count)
+         : mId(id), mCount(count) {}
+      virtual void thread()
+      {
+         for (unsigned int i = 0; i < mCount; ++i)
+         {
+            InfoLog(<< "bench " << mId << " message " << i << " with some text to make it a typical length");
+         }
+      }
+   private:
+      int mId;
+      unsigned int mCount;
+};
+
+class CountingLogger : public ExternalLogger
+{
+   public:
+      CountingLogger() : mCount(0), mHeaders(true) {}
+      virtual bool operator()(Log::Level level,
+                              const Subsystem& subsystem,
+                              const Data& appName,
+                              const char* file,
+                              int line,
+                              const Data& message,
+                              const Data& messageWithHeaders)
+      {
+         ++mCount;
+         mHeaders = mHeaders && messageWithHeaders.size() > message.size();
+         return true;
+      }
+      unsigned int mCount;
+      bool mHeaders;
+};
+
+static unsigned int
+countLines(const char* fileName)
+{
+   unsigned int lines = 0;
+   ifstream file(fileName);
+   string line;
+   while (getline(file, line))
+   {
+      if (line.find("bench ") != string::npos)
+      {
+         ++lines;
+      }
+   }
+   return lines;
+}
+
+static void
+cleanup()
+{
+   remove(LogFile);
+   remove((Data(LogFile) + ".old").c_str());
+}
+
+// @return milliseconds the logging threads took
+static UInt64
+run(unsigned int threads, unsigned int count)
+{
+   vector<LogWriter*> writers;
+   for (unsigned int t = 0; t < threads; ++t)
+   {
+      writers.push_back(new LogWriter(t, count));
+   }
+   UInt64 start = Timer::getTimeMs();
+   for (unsigned int t = 0; t < threads; ++t)
+   {
+      writers[t]->run();
+   }
+   for (unsigned int t = 0; t < threads; ++t)
+   {
+      writers[t]->join();
+      delete writers[t];
+   }
+   return Timer::getTimeMs() - start;
+}
+
+int
+main(int argc, char* argv[])
+{
+   const unsigned int threads = 4;
+   const unsigned int count = argc > 1 ? atoi(argv[1]) : 50000;
+   const unsigned int total = threads * count;
+
+   cleanup();
+   Log::initialize(Log::File, Log::Info, argv[0], LogFile);
+   UInt64 syncMs = run(threads, count);
+   Log::reset();
+   assert(countLines(LogFile) == total);
+   cerr << "synchronous: " << total << " records in " << syncMs << "ms" << endl;
+
+   cleanup();
+   Log::initialize(Log::File, Log::Info, argv[0], LogFile);
+   Log::enableAsync(Log::BlockOnOverflow);
+   UInt64 start = Timer::getTimeMs();
+   UInt64 blockMs = run(threads, count);
+   Log::flushAsync();
+   UInt64 blockWrittenMs = Timer::getTimeMs() - start;
+   Log::disableAsync();
+   Log::reset();
+   assert(countLines(LogFile) == total);
+   cerr << "asynchronous, blocking: " << total << " records in " << blockMs 
+        << "ms (" << blockWrittenMs << "ms until written)" << endl;
+
+   cleanup();
+   Log::initialize(Log::File, Log::Info, argv[0], LogFile);
+   unsigned int droppedBefore = Log::getAsyncDroppedCount();
+   Log::enableAsync(Log::DropOnOverflow, 64*1024);
+   UInt64 dropMs = run(threads, count);
+   Log::disableAsync();
+   Log::reset();
+   unsigned int dropped = Log::getAsyncDroppedCount() - droppedBefore;
+   assert(countLines(LogFile) + dropped == total);
+   cerr << "asynchronous, dropping: " << total << " records in " << dropMs 
+        << "ms, " << dropped << " dropped" << endl;
+
+   // rotation is done by the writer thread
+   cleanup();
+   Log::initialize(Log::File, Log::Info, argv[0], LogFile);
+   Log::setMaxLineCount(1000);
+   Log::enableAsync(Log::BlockOnOverflow);
+   run(1, 2500);
+   Log::disableAsync();
+   Log::reset();
+   Log::setMaxLineCount(0);
+   assert(countLines(LogFile) == 500);
+   assert(countLines((Data(LogFile) + ".old").c_str()) == 1000);
+
+   // so are external loggers, with the headers added
+   cleanup();
+   CountingLogger counter;
+   Log::initialize(Log::File, Log::Info, argv[0], LogFile, &counter);
+   Log::enableAsync(Log::BlockOnOverflow);
+   run(2, 100);
+   Log::flushAsync();
+   assert(counter.mCount == 200);
+   assert(counter.mHeaders);
+   Log::disableAsync();
+   Log::reset();
+   assert(countLines(LogFile) == 200);
+
+   // a line too long for the ring is cut short, counted and marked
+   cleanup();
+   Log::initialize(Log::File, Log::Info, argv[0], LogFile);
+   unsigned int truncatedBefore = Log::getAsyncTruncatedCount();
+   Log::enableAsync(Log::BlockOnOverflow, 4096);
+   InfoLog(<< "bench long " << string(2000, 'x'));
+   Log::disableAsync();
+   Log::reset();
+   assert(Log::getAsyncTruncatedCount() == truncatedBefore + 1);
+   {
+      ifstream file(LogFile);
+      string line;
+      getline(file, line);
+      assert(line.find("bytes truncated]") != string::npos);
+   }
+
+   // the cost of a log statement below the current level
+   cleanup();
+   Log::initialize(Log::Cout, Log::Info, argv[0]);
+   const unsigned int checks = 10000000;
+   unsigned int enabled = 0;
+   start = Timer::getTimeMicroSec();
+   for (unsigned int i = 0; i < checks; ++i)
+   {
+      enabled += Log::isLogging(Log::Debug, Subsystem::TEST);
+   }
+   UInt64 uncachedUs = Timer::getTimeMicroSec() - start;
+   start = Timer::getTimeMicroSec();
+   for (unsigned int i = 0; i < checks; ++i)
+   {
+      enabled += genericLogCheckLevel(Log::Debug, Subsystem::TEST);
+   }
+   UInt64 cachedUs = Timer::getTimeMicroSec() - start;
+   assert(enabled == 0);
+   cerr << "disabled level check: " << uncachedUs * 1000 / checks << "ns with Log::isLogging, "
+        << cachedUs * 1000 / checks << "ns cached" << endl;
+
+   cerr << "All OK" << endl;
+   return 0;
+}
+
+/* ====================================================================
+ * The Vovida Software License, Version 1.0 
+ * 
+ * Copyright (c) 2000 Vovida Networks, Inc.  All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 
+ * 3. The names "VOCAL", "Vovida Open Communication Application Library",
+ *    and "Vovida Open Communication Application Library (VOCAL)" must
+ *    not be used to endorse or promote products derived from this
+ *    software without prior written permission. For written
+ *    permission, please contact vocal@vovida.org.
+ *
+ * 4. Products derived from this software may not be called "VOCAL", nor
+ *    may "VOCAL" appear in their name, without prior written
+ *    permission of Vovida Networks, Inc.
+ * 
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESSED OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE, TITLE AND
+ * NON-INFRINGEMENT ARE DISCLAIMED.  IN NO EVENT SHALL VOVIDA
+ * NETWORKS, INC. OR ITS CONTRIBUTORS BE LIABLE FOR ANY DIRECT DAMAGES
+ * IN EXCESS OF $1,000, NOR FOR ANY INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE
+ * USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+ * DAMAGE.
+ * 
+ * ====================================================================
+ * 
+ * This software consists of voluntary contributions made by Vovida
+ * Networks, Inc. and many individuals on behalf of Vovida Networks,
+ * Inc.  For more information on Vovida Networks, Inc., please see
+ * <http://www.vovida.org/>.
+ *
+ */
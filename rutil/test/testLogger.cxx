@@ -1,4 +1,5 @@
 
+#include <cassert>
 #include "rutil/Logger.hxx"
 #include "rutil/Data.hxx"
 #include "rutil/ThreadIf.hxx"
@@ -130,6 +131,44 @@ testThreadLocalLoggers(const char *appname)
    }
 }
 
+// the cached level check must see every kind of level change
+void
+testLevelCache(const char *appname)
+{
+   Log::initialize(Log::Cout, Log::Info, appname);
+   assert(genericLogCheckLevel(Log::Info, Subsystem::APP));
+   assert(!genericLogCheckLevel(Log::Debug, Subsystem::APP));
+
+   Log::setLevel(Log::Debug);
+   assert(genericLogCheckLevel(Log::Debug, Subsystem::APP));
+   Log::setLevel(Log::Info);
+   assert(!genericLogCheckLevel(Log::Debug, Subsystem::APP));
+
+   Log::setLevel(Log::Stack, Subsystem::APP);
+   assert(genericLogCheckLevel(Log::Stack, Subsystem::APP));
+   assert(!genericLogCheckLevel(Log::Debug, Subsystem::DUM));
+   Log::setLevel(Log::Crit, Subsystem::APP);
+   assert(!genericLogCheckLevel(Log::Info, Subsystem::APP));
+   Log::setLevel(Log::None, Subsystem::APP);
+   assert(genericLogCheckLevel(Log::Info, Subsystem::APP));
+
+   // a local logger at Debug lets its threads, and only those, log Debug
+   Log::LocalLoggerId id = Log::localLoggerCreate(Log::Cout, Log::Debug);
+   assert(Subsystem::APP.maxLevel() == Log::Debug);
+   assert(!genericLogCheckLevel(Log::Debug, Subsystem::APP));
+   Log::setThreadLocalLogger(id);
+   assert(genericLogCheckLevel(Log::Debug, Subsystem::APP));
+   Log::setLevel(Log::Err, id);
+   assert(!genericLogCheckLevel(Log::Info, Subsystem::APP));
+   Log::setThreadLocalLogger(0);
+   assert(Log::localLoggerRemove(id) == 0);
+   assert(Subsystem::APP.maxLevel() == Log::Info);
+
+   Log::initialize(Log::Cout, Log::Warning, appname);
+   assert(!genericLogCheckLevel(Log::Info, Subsystem::APP));
+   Log::initialize(Log::Cout, Log::Info, appname);
+}
+
 int
 main(int argc, char* argv[])
 {
@@ -246,6 +285,7 @@ main(int argc, char* argv[])
    InfoLog(<< "Recursive non-debug OK!: " << logsInCall());
 
    cout << endl;
+   testLevelCache(argv[0]);
    testThreadLocalLoggers(argv[0]);
 
    return 0;
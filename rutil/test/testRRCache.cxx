@@ -0,0 +1,367 @@
+#include <cassert>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "rutil/dns/AresCompat.hxx"
+#ifndef WIN32
+#include <arpa/inet.h>
+#include <arpa/nameser.h>
+#endif
+
+#include "rutil/BaseException.hxx"
+#include "rutil/Data.hxx"
+#include "rutil/ThreadIf.hxx"
+#include "rutil/Time.hxx"
+#include "rutil/dns/RRCache.hxx"
+#include "rutil/dns/RROverlay.hxx"
+#include "rutil/dns/DnsHostRecord.hxx"
+
+using namespace resip;
+using namespace std;
+
+static in_addr
+address(unsigned int n)
+{
+   in_addr addr;
+   addr.s_addr = htonl(0x0a000000 | n);
+   return addr;
+}
+
+static Data
+hostName(unsigned int n)
+{
+   return "host" + Data(n) + ".example.com";
+}
+
+static bool
+cached(RRCache& cache, const Data& name)
+{
+   RRCache::Result records;
+   RRCache::ResultRef ref;
+   int status = 0;
+   return cache.lookup(name, T_A, RRCache::Protocol::Sip, records, ref, status);
+}
+
+// lookup on behalf of a user query, as DnsStub makes it
+static bool
+userLookup(RRCache& cache, const Data& name, bool& refresh)
+{
+   RRCache::Result records;
+   RRCache::ResultRef ref;
+   int status = 0;
+   return cache.lookup(name, T_A, RRCache::Protocol::Sip, records, ref, status, refresh);
+}
+
+// caches an A record for name as if it came in a DNS answer with that TTL
+static void
+cacheAnswer(RRCache& cache, const Data& name, unsigned int ttl, unsigned int n)
+{
+   std::string rr;
+   const char* label = name.c_str();
+   while (*label)
+   {
+      const char* end = strchr(label, '.');
+      size_t len = end ? end - label : strlen(label);
+      rr += (char)len;
+      rr.append(label, len);
+      label += end ? len + 1 : len;
+   }
+   rr += (char)0;
+   const unsigned char fixed[] = { 0, T_A, 0, 1, // IN
+                                   (unsigned char)(ttl >> 24), (unsigned char)(ttl >> 16),
+                                   (unsigned char)(ttl >> 8), (unsigned char)ttl,
+                                   0, 4 };
+   rr.append((const char*)fixed, sizeof(fixed));
+   in_addr addr = address(n);
+   rr.append((const char*)&addr, sizeof(addr));
+
+   const unsigned char* buf = (const unsigned char*)rr.data();
+   std::vector<RROverlay> overlays;
+   overlays.push_back(RROverlay(buf, buf, (int)rr.size()));
+   cache.updateCache(name, T_A, overlays.begin(), overlays.end());
+}
+
+class Resolver : public ThreadIf
+{
+   public:
+      Resolver(RRCache& cache, unsigned int base) : mCache(cache), mBase(base) {}
+      virtual void thread()
+      {
+         for (unsigned int i = 0; i < 20000; ++i)
+         {
+            unsigned int n = mBase + i % 300;
+            mCache.updateCacheFromHostFile(DnsHostRecord(hostName(n), address(n)));
+            RRCache::Result records;
+            RRCache::ResultRef ref;
+            int status = 0;
+            if (mCache.lookup(hostName(n), T_A, RRCache::Protocol::Sip, records, ref, status))
+            {
+               assert(records.size() == 1);
+               assert(records[0]->name() == hostName(n));
+            }
+         }
+      }
+   private:
+      RRCache& mCache;
+      unsigned int mBase;
+};
+
+static void
+testLookup()
+{
+   RRCache cache;
+   assert(cache.bytes() == 0);
+   cache.updateCacheFromHostFile(DnsHostRecord("Host1.Example.COM", address(1)));
+   size_t oneEntry = cache.bytes();
+   assert(oneEntry > 0);
+
+   // case-insensitive, and keyed by type as well as name
+   RRCache::Result records;
+   RRCache::ResultRef ref;
+   int status = -1;
+   assert(cache.lookup("host1.example.com", T_A, RRCache::Protocol::Sip, records, ref, status));
+   assert(status == 0);
+   assert(records.size() == 1);
+   assert(dynamic_cast<DnsHostRecord*>(records[0])->host() == "10.0.0.1");
+   assert(!cache.lookup("host1.example.com", T_SRV, RRCache::Protocol::Sip, records, ref, status));
+   assert(records.empty());
+
+   // an update in place leaves records taken by an earlier lookup intact
+   cache.lookup("host1.example.com", T_A, RRCache::Protocol::Sip, records, ref, status);
+   cache.updateCacheFromHostFile(DnsHostRecord("host1.example.com", address(2)));
+   assert(dynamic_cast<DnsHostRecord*>(records[0])->host() == "10.0.0.1");
+   assert(cache.bytes() == oneEntry);
+   RRCache::Result fresh;
+   RRCache::ResultRef freshRef;
+   cache.lookup("host1.example.com", T_A, RRCache::Protocol::Sip, fresh, freshRef, status);
+   assert(dynamic_cast<DnsHostRecord*>(fresh[0])->host() == "10.0.0.2");
+
+   cache.clearCache();
+   assert(cache.bytes() == 0);
+   assert(!cached(cache, "host1.example.com"));
+   // the record survives the clear for as long as ref holds it
+   assert(dynamic_cast<DnsHostRecord*>(records[0])->host() == "10.0.0.1");
+}
+
+static void
+testByteLimit()
+{
+   RRCache cache;
+   cache.updateCacheFromHostFile(DnsHostRecord(hostName(0), address(0)));
+   size_t perEntry = cache.bytes();
+   // names past host9 are a byte longer, so leave some slack for ten of them
+   cache.setMaxBytes(perEntry * 10 + perEntry / 2);
+
+   for (unsigned int i = 1; i < 100; ++i)
+   {
+      cache.updateCacheFromHostFile(DnsHostRecord(hostName(i), address(i)));
+      if (i == 50)
+      {
+         // keep entry 0 recently used
+         cache.updateCacheFromHostFile(DnsHostRecord(hostName(0), address(0)));
+      }
+      assert(cache.bytes() <= perEntry * 10 + perEntry / 2);
+   }
+   assert(cached(cache, hostName(99)));
+   assert(cached(cache, hostName(90)));
+   assert(!cached(cache, hostName(89)));
+   assert(!cached(cache, hostName(0)));
+
+   // lowering the limit evicts straight away; the entry count limit still applies
+   cache.setMaxBytes(perEntry * 3);
+   assert(cache.bytes() <= perEntry * 3);
+   cache.setMaxBytes(0);
+   cache.setSize(5);
+   for (unsigned int i = 200; i < 220; ++i)
+   {
+      cache.updateCacheFromHostFile(DnsHostRecord(hostName(i), address(i)));
+   }
+   assert(cached(cache, hostName(219)));
+   assert(!cached(cache, hostName(214)));
+}
+
+static void
+testTypeQuota()
+{
+   RRCache cache;
+   cache.updateCacheFromHostFile(DnsHostRecord(hostName(0), address(0)));
+   size_t perEntry = cache.bytes();
+   // names past host9 are a byte longer, so leave some slack for four of them
+   cache.setTypeQuota(T_A, perEntry * 4 + perEntry / 2);
+   for (unsigned int i = 1; i < 20; ++i)
+   {
+      cache.updateCacheFromHostFile(DnsHostRecord(hostName(i), address(i)));
+   }
+   assert(cache.bytes() <= perEntry * 4 + perEntry / 2);
+   assert(cached(cache, hostName(19)));
+   assert(!cached(cache, hostName(10)));
+
+   // other types are not held to the A quota
+   cache.setTypeQuota(T_SRV, perEntry);
+   assert(cached(cache, hostName(16)));
+}
+
+static void
+testShared()
+{
+   // one cache used from several threads, as when DnsStubs share it
+   RRCache cache;
+   cache.setSize(500);
+   Resolver a(cache, 0);
+   Resolver b(cache, 100);
+   Resolver c(cache, 200);
+   a.run();
+   b.run();
+   c.run();
+   a.join();
+   b.join();
+   c.join();
+   assert(cached(cache, hostName(299)));
+   Data dump;
+   cache.getCacheDump(dump);
+   assert(dump.find("hits=") != Data::npos);
+}
+
+static void
+testPrefetch()
+{
+   RRCache cache;
+   cache.updateCacheFromHostFile(DnsHostRecord(hostName(1), address(1)));
+   // a window longer than the TTL makes the entry due as soon as it has
+   // been hit twice
+   cache.setPrefetch(7200, 2);
+   bool refresh = true;
+   assert(userLookup(cache, hostName(1), refresh) && !refresh);
+   assert(userLookup(cache, hostName(1), refresh) && !refresh);
+   assert(userLookup(cache, hostName(1), refresh) && refresh);
+   // new records start the count again
+   cache.updateCacheFromHostFile(DnsHostRecord(hostName(1), address(2)));
+   assert(userLookup(cache, hostName(1), refresh) && !refresh);
+   assert(!userLookup(cache, hostName(2), refresh) && !refresh);
+   assert(cache.hits() == 4);
+   assert(cache.misses() == 1);
+
+   // lookups made for the stub's own use are not counted
+   assert(cached(cache, hostName(1)));
+   assert(!cached(cache, hostName(2)));
+   assert(cache.hits() == 4);
+   assert(cache.misses() == 1);
+
+   cache.setPrefetch(0, 0);
+   for (int i = 0; i < 5; ++i)
+   {
+      assert(userLookup(cache, hostName(1), refresh) && !refresh);
+   }
+}
+
+static void
+testExpiry()
+{
+   // answers are kept for at least 10 seconds, whatever their TTL
+   RRCache plain;
+   RRCache stale;
+   stale.setServeStale(60);
+   cacheAnswer(plain, hostName(1), 1, 1);
+   cacheAnswer(stale, hostName(1), 1, 1);
+   size_t oneEntry = plain.bytes();
+   assert(oneEntry > 0);
+   bool refresh = true;
+   assert(userLookup(plain, hostName(1), refresh) && !refresh);
+   assert(userLookup(stale, hostName(1), refresh) && !refresh);
+
+   sleepSeconds(11);
+
+   // without serve-stale, the expired entry is a miss and is dropped
+   assert(!cached(plain, hostName(1)));
+   assert(plain.bytes() == oneEntry);
+   assert(!userLookup(plain, hostName(1), refresh) && !refresh);
+   assert(plain.bytes() == 0);
+   assert(plain.hits() == 1);
+   assert(plain.misses() == 1);
+
+   // with it, the entry still answers but asks to be refreshed
+   assert(!cached(stale, hostName(1)));
+   RRCache::Result records;
+   RRCache::ResultRef ref;
+   int status = -1;
+   assert(stale.lookup(hostName(1), T_A, RRCache::Protocol::Sip, records, ref, status, refresh));
+   assert(refresh);
+   assert(status == 0);
+   assert(records.size() == 1);
+   assert(dynamic_cast<DnsHostRecord*>(records[0])->host() == "10.0.0.1");
+   assert(stale.hits() == 2);
+   assert(stale.misses() == 0);
+
+   // the refresh updates the entry in place, keeping its hit count
+   cacheAnswer(stale, hostName(1), 3600, 2);
+   assert(userLookup(stale, hostName(1), refresh) && !refresh);
+   Data dump;
+   stale.getCacheDump(dump);
+   assert(dump.find("10.0.0.2") != Data::npos);
+   assert(dump.find("hits=3") != Data::npos);
+}
+
+int
+main(int argc, char* argv[])
+{
+   testLookup();
+   testByteLimit();
+   testTypeQuota();
+   testShared();
+   testPrefetch();
+   testExpiry();
+   cerr << "All OK" << endl;
+   return 0;
+}
+
+/* ====================================================================
+ * The Vovida Software License, Version 1.0 
+ * 
+ * Copyright (c) 2000 Vovida Networks, Inc.  All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 
+ * 3. The names "VOCAL", "Vovida Open Communication Application Library",
+ *    and "Vovida Open Communication Application Library (VOCAL)" must
+ *    not be used to endorse or promote products derived from this
+ *    software without prior written permission. For written
+ *    permission, please contact vocal@vovida.org.
+ *
+ * 4. Products derived from this software may not be called "VOCAL", nor
+ *    may "VOCAL" appear in their name, without prior written
+ *    permission of Vovida Networks, Inc.
+ * 
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESSED OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE, TITLE AND
+ * NON-INFRINGEMENT ARE DISCLAIMED.  IN NO EVENT SHALL VOVIDA
+ * NETWORKS, INC. OR ITS CONTRIBUTORS BE LIABLE FOR ANY DIRECT DAMAGES
+ * IN EXCESS OF $1,000, NOR FOR ANY INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE
+ * USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+ * DAMAGE.
+ * 
+ * ====================================================================
+ * 
+ * This software consists of voluntary contributions made by Vovida
+ * Networks, Inc. and many individuals on behalf of Vovida Networks,
+ * Inc.  For more information on Vovida Networks, Inc., please see
+ * <http://www.vovida.org/>.
+ *
+ */